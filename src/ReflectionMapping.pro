@@ -10,6 +10,7 @@ greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 TARGET = ReflectionMapping
 TEMPLATE = app
+CONFIG += c++11
 
 #QMAKE_CXXFLAGS_WARN_ON += -Wno-reorder
 
@@ -18,13 +19,62 @@ SOURCES += main.cpp\
     unitsphere.cpp \
     unitcube.cpp \
     unitplane.cpp \
-    renderer.cpp
+    renderer.cpp \
+    framescheduler.cpp \
+    gpuprofiler.cpp \
+    cpuprofiler.cpp \
+    offscreencontext.cpp \
+    benchmark.cpp \
+    inputrecorder.cpp \
+    framecapture.cpp \
+    stripedimagewriter.cpp \
+    tiledrenderer.cpp \
+    workstealingpool.cpp \
+    raytracer.cpp \
+    probebaker.cpp \
+    imagemetrics.cpp \
+    qualityharness.cpp \
+    scenedescription.cpp \
+    meshimporter.cpp \
+    scenebvh.cpp \
+    occlusionculler.cpp \
+    transformstore.cpp \
+    uniformshadowbuffer.cpp \
+    geometrybuffer.cpp \
+    gpuculler.cpp \
+    renderlist.cpp \
+    framegraph.cpp
 
 HEADERS  += mainwindow.h \
     unitsphere.h \
     unitcube.h \
     unitplane.h \
-    renderer.h
+    renderer.h \
+    framescheduler.h \
+    gpuprofiler.h \
+    cpuprofiler.h \
+    offscreencontext.h \
+    benchmark.h \
+    inputrecorder.h \
+    framecapture.h \
+    stripedimagewriter.h \
+    tiledrenderer.h \
+    workstealingpool.h \
+    raytracer.h \
+    probebaker.h \
+    imagemetrics.h \
+    qualityharness.h \
+    scenedescription.h \
+    meshimporter.h \
+    scenebvh.h \
+    occlusionculler.h \
+    transformstore.h \
+    float4.h \
+    uniformshadowbuffer.h \
+    geometrybuffer.h \
+    gpuculler.h \
+    renderlist.h \
+    framegraph.h
 
 RESOURCES += \
     shaders.qrc \
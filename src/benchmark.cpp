@@ -0,0 +1,410 @@
+//------------------------------------------------------------------------------------------
+// benchmark.cpp
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include <algorithm>
+
+#include "benchmark.h"
+
+//------------------------------------------------------------------------------------------
+Benchmark::Benchmark():
+    frameWidth(DEFAULT_BENCHMARK_WIDTH),
+    frameHeight(DEFAULT_BENCHMARK_HEIGHT)
+{
+}
+
+//------------------------------------------------------------------------------------------
+void Benchmark::setFrameSize(int _width, int _height)
+{
+    frameWidth = _width;
+    frameHeight = _height;
+}
+
+//------------------------------------------------------------------------------------------
+QVector3D Benchmark::readVector3(const QJsonValue& _value, const QVector3D& _default)
+{
+    QJsonArray array = _value.toArray();
+
+    if(array.size() != 3)
+    {
+        return _default;
+    }
+
+    return QVector3D(array[0].toDouble(), array[1].toDouble(), array[2].toDouble());
+}
+
+//------------------------------------------------------------------------------------------
+bool Benchmark::loadScenarios(const QString& _fileName)
+{
+    QFile file(_fileName);
+
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        PRINT_ERROR(QString("Cannot open scenario file %1").arg(_fileName));
+        return false;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+
+    if(document.isNull())
+    {
+        PRINT_ERROR(QString("Cannot parse scenario file %1: %2").arg(_fileName)
+                    .arg(parseError.errorString()));
+        return false;
+    }
+
+    QJsonObject root = document.object();
+    frameWidth = root.value("width").toInt(frameWidth);
+    frameHeight = root.value("height").toInt(frameHeight);
+
+    scenarios.clear();
+    QJsonArray scenarioArray = root.value("scenarios").toArray();
+
+    for(int i = 0; i < scenarioArray.size(); ++i)
+    {
+        QJsonObject scenarioObject = scenarioArray[i].toObject();
+        Scenario scenario;
+
+        scenario.name = scenarioObject.value("name").toString(QString("scenario %1").arg(i));
+        scenario.numFrames = scenarioObject.value("frames").toInt(scenario.numFrames);
+        scenario.numWarmupFrames = scenarioObject.value("warmupFrames").toInt(
+                                       scenario.numWarmupFrames);
+        scenario.enabledDynamicEnvMapping = scenarioObject.value("dynamicEnvMapping").toBool(
+                                                scenario.enabledDynamicEnvMapping);
+        scenario.enabledBackgroundRendering = scenarioObject.value("backgroundRendering").toBool(
+                                                  scenario.enabledBackgroundRendering);
+
+        QJsonArray sphereResolution = scenarioObject.value("sphereResolution").toArray();
+
+        if(sphereResolution.size() == 2)
+        {
+            scenario.sphereNumStacks = sphereResolution[0].toInt(scenario.sphereNumStacks);
+            scenario.sphereNumSlices = sphereResolution[1].toInt(scenario.sphereNumSlices);
+        }
+
+        QJsonArray keyframeArray = scenarioObject.value("keyframes").toArray();
+
+        for(int j = 0; j < keyframeArray.size(); ++j)
+        {
+            QJsonObject keyframeObject = keyframeArray[j].toObject();
+            Keyframe keyframe;
+
+            keyframe.time = keyframeObject.value("time").toDouble(0.0);
+            keyframe.cameraPosition = readVector3(keyframeObject.value("cameraPosition"),
+                                                  keyframe.cameraPosition);
+            keyframe.cameraFocus = readVector3(keyframeObject.value("cameraFocus"),
+                                               keyframe.cameraFocus);
+            keyframe.objectTranslation = readVector3(keyframeObject.value("objectTranslation"),
+                                                     keyframe.objectTranslation);
+            keyframe.objectRotation = keyframeObject.value("objectRotation").toDouble(0.0);
+            scenario.keyframes.append(keyframe);
+        }
+
+        if(scenario.keyframes.isEmpty())
+        {
+            scenario.keyframes.append(Keyframe());
+        }
+
+        std::sort(scenario.keyframes.begin(), scenario.keyframes.end(),
+                  [](const Keyframe & _a, const Keyframe & _b)
+        {
+            return _a.time < _b.time;
+        });
+
+        scenarios.append(scenario);
+    }
+
+    return !scenarios.isEmpty();
+}
+
+//------------------------------------------------------------------------------------------
+// camera orbiting around the default focus point, optionally moving the objects as well
+//------------------------------------------------------------------------------------------
+QVector<Benchmark::Keyframe> Benchmark::createOrbitPath(int _numKeyframes,
+                                                        bool _moveObjects)
+{
+    QVector<Keyframe> keyframes;
+    QVector3D eyeVector = DEFAULT_CAMERA_POSITION - DEFAULT_CAMERA_FOCUS;
+    float radius = QVector2D(eyeVector.x(), eyeVector.z()).length();
+
+    for(int i = 0; i <= _numKeyframes; ++i)
+    {
+        Keyframe keyframe;
+        keyframe.time = (float)i / (float)_numKeyframes;
+
+        float angle = keyframe.time * 2.0f * M_PI;
+        keyframe.cameraFocus = DEFAULT_CAMERA_FOCUS;
+        keyframe.cameraPosition = DEFAULT_CAMERA_FOCUS +
+                                  QVector3D(radius * sin(angle), eyeVector.y(),
+                                            radius * cos(angle));
+
+        if(_moveObjects)
+        {
+            keyframe.objectTranslation = QVector3D(3.0f * sin(2.0f * angle), 0.0f,
+                                                   2.0f * cos(angle) - 2.0f);
+            keyframe.objectRotation = keyframe.time * 360.0f;
+        }
+
+        keyframes.append(keyframe);
+    }
+
+    return keyframes;
+}
+
+//------------------------------------------------------------------------------------------
+void Benchmark::createDefaultScenarios()
+{
+    scenarios.clear();
+
+    Scenario scenario;
+    scenario.keyframes = createOrbitPath(16, false);
+
+    scenario.name = "static mapping";
+    scenarios.append(scenario);
+
+    scenario.name = "dynamic mapping";
+    scenario.enabledDynamicEnvMapping = true;
+    scenarios.append(scenario);
+
+    scenario.name = "dynamic mapping, moving objects";
+    scenario.keyframes = createOrbitPath(16, true);
+    scenarios.append(scenario);
+
+    scenario.name = "dynamic mapping, moving objects, no background";
+    scenario.enabledBackgroundRendering = false;
+    scenarios.append(scenario);
+
+    scenario.name = "dynamic mapping, moving objects, high resolution spheres";
+    scenario.enabledBackgroundRendering = true;
+    scenario.sphereNumStacks = 100;
+    scenario.sphereNumSlices = 100;
+    scenarios.append(scenario);
+}
+
+//------------------------------------------------------------------------------------------
+Benchmark::Keyframe Benchmark::interpolateKeyframes(const QVector<Keyframe>& _keyframes,
+                                                    float _time)
+{
+    if(_time <= _keyframes.first().time)
+    {
+        return _keyframes.first();
+    }
+
+    for(int i = 1; i < _keyframes.size(); ++i)
+    {
+        const Keyframe& k0 = _keyframes[i - 1];
+        const Keyframe& k1 = _keyframes[i];
+
+        if(_time > k1.time)
+        {
+            continue;
+        }
+
+        float t = (k1.time > k0.time) ? (_time - k0.time) / (k1.time - k0.time) : 1.0f;
+
+        Keyframe keyframe;
+        keyframe.time = _time;
+        keyframe.cameraPosition = (1.0f - t) * k0.cameraPosition + t * k1.cameraPosition;
+        keyframe.cameraFocus = (1.0f - t) * k0.cameraFocus + t * k1.cameraFocus;
+        keyframe.objectTranslation = (1.0f - t) * k0.objectTranslation +
+                                     t * k1.objectTranslation;
+        keyframe.objectRotation = (1.0f - t) * k0.objectRotation + t * k1.objectRotation;
+
+        return keyframe;
+    }
+
+    return _keyframes.last();
+}
+
+//------------------------------------------------------------------------------------------
+// the objects rotate around the vertical axis through the cube center
+//------------------------------------------------------------------------------------------
+void Benchmark::applyKeyframe(Renderer* _renderer, const Keyframe& _keyframe)
+{
+    QVector3D rotationCenter = 1.5f * DEFAULT_CUBE_POSITION;
+
+    QMatrix4x4 objectTransformation;
+    objectTransformation.setToIdentity();
+    objectTransformation.translate(_keyframe.objectTranslation + rotationCenter);
+    objectTransformation.rotate(_keyframe.objectRotation, 0.0f, 1.0f, 0.0f);
+    objectTransformation.translate(-rotationCenter);
+
+    _renderer->setCamera(_keyframe.cameraPosition, _keyframe.cameraFocus,
+                         QVector3D(0.0f, 1.0f, 0.0f));
+    _renderer->setObjectTransformation(objectTransformation);
+}
+
+//------------------------------------------------------------------------------------------
+void Benchmark::applyScenarioSettings(Renderer* _renderer, const Scenario& _scenario)
+{
+    _renderer->enableDynamicEnvironmentMapping(_scenario.enabledDynamicEnvMapping);
+    _renderer->enableBackgroundRendering(_scenario.enabledBackgroundRendering);
+    _renderer->changeSphereResolution(_scenario.sphereNumStacks, _scenario.sphereNumSlices);
+}
+
+//------------------------------------------------------------------------------------------
+// times in milliseconds
+//------------------------------------------------------------------------------------------
+QJsonObject Benchmark::computeFrameTimeStatistics(QVector<double> _frameTimes)
+{
+    QJsonObject statistics;
+
+    if(_frameTimes.isEmpty())
+    {
+        return statistics;
+    }
+
+    std::sort(_frameTimes.begin(), _frameTimes.end());
+
+    double totalTime = 0.0;
+
+    for(int i = 0; i < _frameTimes.size(); ++i)
+    {
+        totalTime += _frameTimes[i];
+    }
+
+    int numFrames = _frameTimes.size();
+    auto percentile = [&](double _p)
+    {
+        int index = (int)ceil(_p * (double)numFrames) - 1;
+        return _frameTimes[qBound(0, index, numFrames - 1)];
+    };
+
+    statistics.insert("mean", totalTime / (double)numFrames);
+    statistics.insert("min", _frameTimes.first());
+    statistics.insert("p50", percentile(0.50));
+    statistics.insert("p90", percentile(0.90));
+    statistics.insert("p95", percentile(0.95));
+    statistics.insert("p99", percentile(0.99));
+    statistics.insert("max", _frameTimes.last());
+
+    return statistics;
+}
+
+//------------------------------------------------------------------------------------------
+// each frame is finished (glFinish) before the timer stops, so the frame time includes
+// the GPU time and does not depend on how deep the driver queues the frames
+//------------------------------------------------------------------------------------------
+QJsonObject Benchmark::runScenario(Renderer* _renderer, QOpenGLContext* _context,
+                                   const Scenario& _scenario)
+{
+    PROFILE_ZONE("Benchmark::runScenario");
+
+    applyScenarioSettings(_renderer, _scenario);
+
+    QOpenGLFunctions* glFuncs = _context->functions();
+    QVector<double> frameTimes;
+    frameTimes.reserve(_scenario.numFrames);
+
+    QElapsedTimer frameTimer;
+    QElapsedTimer scenarioTimer;
+
+    for(int frame = -_scenario.numWarmupFrames; frame < _scenario.numFrames; ++frame)
+    {
+        if(frame == 0)
+        {
+            scenarioTimer.start();
+        }
+
+        float time = (_scenario.numFrames > 1) ?
+                     (float)qMax(frame, 0) / (float)(_scenario.numFrames - 1) : 0.0f;
+        applyKeyframe(_renderer, interpolateKeyframes(_scenario.keyframes, time));
+
+        frameTimer.start();
+        _renderer->renderHeadlessFrame();
+        glFuncs->glFinish();
+
+        if(frame >= 0)
+        {
+            frameTimes.append((double)frameTimer.nsecsElapsed() * 1e-6);
+        }
+    }
+
+    double totalTime = (double)scenarioTimer.nsecsElapsed() * 1e-9;
+
+    QJsonArray sphereResolution;
+    sphereResolution.append(_scenario.sphereNumStacks);
+    sphereResolution.append(_scenario.sphereNumSlices);
+
+    QJsonObject result;
+    result.insert("name", _scenario.name);
+    result.insert("frames", _scenario.numFrames);
+    result.insert("warmupFrames", _scenario.numWarmupFrames);
+    result.insert("dynamicEnvMapping", _scenario.enabledDynamicEnvMapping);
+    result.insert("backgroundRendering", _scenario.enabledBackgroundRendering);
+    result.insert("sphereResolution", sphereResolution);
+    result.insert("frameTimeMs", computeFrameTimeStatistics(frameTimes));
+    result.insert("totalTimeSec", totalTime);
+    result.insert("framesPerSecond", (totalTime > 0.0) ?
+                  (double)_scenario.numFrames / totalTime : 0.0);
+
+    qDebug() << "Benchmark:" << _scenario.name << "-" << _scenario.numFrames << "frames in"
+             << totalTime << "s";
+
+    return result;
+}
+
+//------------------------------------------------------------------------------------------
+// write the results to _outputFile, or to the standard output if it is empty
+//------------------------------------------------------------------------------------------
+bool Benchmark::run(const QString& _outputFile)
+{
+    if(scenarios.isEmpty())
+    {
+        createDefaultScenarios();
+    }
+
+    OffscreenContext offscreenContext;
+
+    if(!offscreenContext.create())
+    {
+        PRINT_ERROR("Cannot create the offscreen OpenGL context.");
+        return false;
+    }
+
+    Renderer renderer;
+    renderer.initializeHeadless(offscreenContext.getContext(), offscreenContext.getSurface(),
+                                frameWidth, frameHeight);
+
+    QJsonArray results;
+
+    for(int i = 0; i < scenarios.size(); ++i)
+    {
+        results.append(runScenario(&renderer, offscreenContext.getContext(), scenarios[i]));
+    }
+
+    QJsonObject report;
+    report.insert("renderer", offscreenContext.getRendererInfo());
+    report.insert("width", frameWidth);
+    report.insert("height", frameHeight);
+    report.insert("date", QDateTime::currentDateTime().toString(Qt::ISODate));
+    report.insert("scenarios", results);
+
+    QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+
+    if(_outputFile.isEmpty())
+    {
+        QTextStream(stdout) << json;
+        return true;
+    }
+
+    QFile file(_outputFile);
+
+    if(!file.open(QIODevice::WriteOnly))
+    {
+        PRINT_ERROR(QString("Cannot open output file %1").arg(_outputFile));
+        return false;
+    }
+
+    file.write(json);
+    file.close();
+
+    return true;
+}
@@ -0,0 +1,102 @@
+//------------------------------------------------------------------------------------------
+// benchmark.h
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QtGui>
+
+#include "renderer.h"
+#include "offscreencontext.h"
+
+//------------------------------------------------------------------------------------------
+#define DEFAULT_BENCHMARK_WIDTH 1280
+#define DEFAULT_BENCHMARK_HEIGHT 720
+
+//------------------------------------------------------------------------------------------
+// Render scripted scenarios offscreen and report the frame time statistics as JSON.
+// Each scenario follows a camera and object path given by keyframes (time in [0, 1] over
+// the scenario frames, linearly interpolated), with its own rendering options.
+//
+// Scenario file:
+// {
+//     "width": 1280, "height": 720,
+//     "scenarios": [
+//     {
+//         "name": "orbit", "frames": 300, "warmupFrames": 30,
+//         "dynamicEnvMapping": true, "backgroundRendering": true,
+//         "sphereResolution": [30, 30],
+//         "keyframes": [
+//             {"time": 0.0, "cameraPosition": [x, y, z], "cameraFocus": [x, y, z],
+//              "objectTranslation": [x, y, z], "objectRotation": degrees}, ...]
+//     }, ...]
+// }
+//------------------------------------------------------------------------------------------
+class Benchmark
+{
+public:
+    struct Keyframe
+    {
+        Keyframe():
+            time(0.0f),
+            cameraPosition(DEFAULT_CAMERA_POSITION),
+            cameraFocus(DEFAULT_CAMERA_FOCUS),
+            objectTranslation(0.0f, 0.0f, 0.0f),
+            objectRotation(0.0f) {}
+
+        float time;
+        QVector3D cameraPosition;
+        QVector3D cameraFocus;
+        QVector3D objectTranslation;
+        float objectRotation;
+    };
+
+    struct Scenario
+    {
+        Scenario():
+            numFrames(300),
+            numWarmupFrames(30),
+            enabledDynamicEnvMapping(false),
+            enabledBackgroundRendering(true),
+            sphereNumStacks(30),
+            sphereNumSlices(30) {}
+
+        QString name;
+        int numFrames;
+        int numWarmupFrames;
+        bool enabledDynamicEnvMapping;
+        bool enabledBackgroundRendering;
+        int sphereNumStacks;
+        int sphereNumSlices;
+        QVector<Keyframe> keyframes;
+    };
+
+    Benchmark();
+
+    void setFrameSize(int _width, int _height);
+    bool loadScenarios(const QString& _fileName);
+    void createDefaultScenarios();
+    bool run(const QString& _outputFile);
+
+    static QVector<Keyframe> createOrbitPath(int _numKeyframes, bool _moveObjects);
+    static Keyframe interpolateKeyframes(const QVector<Keyframe>& _keyframes, float _time);
+    static void applyKeyframe(Renderer* _renderer, const Keyframe& _keyframe);
+    static void applyScenarioSettings(Renderer* _renderer, const Scenario& _scenario);
+    static QJsonObject computeFrameTimeStatistics(QVector<double> _frameTimes);
+
+private:
+    QJsonObject runScenario(Renderer* _renderer, QOpenGLContext* _context,
+                            const Scenario& _scenario);
+    static QVector3D readVector3(const QJsonValue& _value, const QVector3D& _default);
+
+    int frameWidth;
+    int frameHeight;
+    QVector<Scenario> scenarios;
+};
+
+#endif // BENCHMARK_H
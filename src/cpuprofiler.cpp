@@ -0,0 +1,236 @@
+//------------------------------------------------------------------------------------------
+// cpuprofiler.cpp
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#include "cpuprofiler.h"
+
+std::atomic<bool> CPUProfiler::enabled(false);
+QMutex CPUProfiler::registryMutex;
+QVector<CPUProfiler::ThreadBuffer*> CPUProfiler::threadBuffers;
+
+//------------------------------------------------------------------------------------------
+void CPUProfiler::setEnabled(bool _state)
+{
+    // start the clock before the first zone
+    getTimestamp();
+    enabled.store(_state, std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------------------
+static QElapsedTimer startProfilerClock()
+{
+    QElapsedTimer clock;
+    clock.start();
+    return clock;
+}
+
+//------------------------------------------------------------------------------------------
+// nanoseconds since the profiler clock started
+//------------------------------------------------------------------------------------------
+qint64 CPUProfiler::getTimestamp()
+{
+    // thread-safe initialization of the local static
+    static const QElapsedTimer clock = startProfilerClock();
+    return clock.nsecsElapsed();
+}
+
+//------------------------------------------------------------------------------------------
+// Only the owner thread writes into its buffer: write the event, then publish it.
+// The buffer is marked as being written before checking that the profiler is still
+// enabled (both sequentially consistent, on the cache line of the thread only): once
+// saveChromeTrace has disabled it and seen no buffer marked, no zone still open can write
+// into the buffers.
+//------------------------------------------------------------------------------------------
+void CPUProfiler::recordZone(const char* _name, qint64 _beginTime, qint64 _endTime)
+{
+    ThreadBuffer* buffer = getThreadBuffer();
+    buffer->writing.store(true);
+
+    if(enabled.load())
+    {
+        quint64 index = buffer->numEvents.load(std::memory_order_relaxed);
+
+        ZoneEvent& event = buffer->events[index % CPU_PROFILER_BUFFER_SIZE];
+        event.name = _name;
+        event.beginTime = _beginTime;
+        event.endTime = _endTime;
+
+        buffer->numEvents.store(index + 1, std::memory_order_release);
+    }
+
+    buffer->writing.store(false, std::memory_order_release);
+}
+
+//------------------------------------------------------------------------------------------
+// stop the recording and wait for the zones being written, the registry mutex must be
+// locked (a thread registering its buffer does not mark it before)
+//------------------------------------------------------------------------------------------
+bool CPUProfiler::pause()
+{
+    bool wasEnabled = enabled.exchange(false);
+
+    for(int i = 0; i < threadBuffers.size(); ++i)
+    {
+        while(threadBuffers[i]->writing.load(std::memory_order_acquire))
+        {
+            QThread::yieldCurrentThread();
+        }
+    }
+
+    return wasEnabled;
+}
+
+//------------------------------------------------------------------------------------------
+// the thread names are set by the application, they may contain any character
+//------------------------------------------------------------------------------------------
+static QString escapeJsonString(const QString& _string)
+{
+    QString escaped;
+    escaped.reserve(_string.size());
+
+    for(int i = 0; i < _string.size(); ++i)
+    {
+        QChar c = _string[i];
+
+        if(c == '"' || c == '\\')
+        {
+            escaped += '\\';
+            escaped += c;
+        }
+        else if(c.unicode() < 0x20)
+        {
+            escaped += QString("\\u%1").arg(c.unicode(), 4, 16, QChar('0'));
+        }
+        else
+        {
+            escaped += c;
+        }
+    }
+
+    return escaped;
+}
+
+//------------------------------------------------------------------------------------------
+void CPUProfiler::setThreadName(const QString& _threadName)
+{
+    ThreadBuffer* buffer = getThreadBuffer();
+
+    QMutexLocker locker(&registryMutex);
+    buffer->threadName = _threadName;
+}
+
+//------------------------------------------------------------------------------------------
+CPUProfiler::ThreadBuffer* CPUProfiler::getThreadBuffer()
+{
+    static thread_local ThreadBuffer* threadBuffer = NULL;
+
+    if(!threadBuffer)
+    {
+        // the buffers are never freed: a thread may exit before the trace is saved
+        threadBuffer = new ThreadBuffer;
+
+        QMutexLocker locker(&registryMutex);
+        threadBuffer->threadId = threadBuffers.size() + 1;
+
+        QThread* thread = QThread::currentThread();
+
+        if(thread && !thread->objectName().isEmpty())
+        {
+            threadBuffer->threadName = thread->objectName();
+        }
+        else if(thread && QCoreApplication::instance() &&
+                thread == QCoreApplication::instance()->thread())
+        {
+            threadBuffer->threadName = "main";
+        }
+        else
+        {
+            threadBuffer->threadName = QString("thread %1").arg(threadBuffer->threadId);
+        }
+
+        threadBuffers.append(threadBuffer);
+    }
+
+    return threadBuffer;
+}
+
+//------------------------------------------------------------------------------------------
+// write the recorded zones in the Chrome trace event format (chrome://tracing, Perfetto)
+// recording is paused while saving, after the zones being written are done, so no buffer
+// wraps around while being read; the zones ending during the pause are dropped
+//------------------------------------------------------------------------------------------
+bool CPUProfiler::saveChromeTrace(const QString& _fileName)
+{
+    QFile file(_fileName);
+
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        qDebug() << "CPUProfiler: cannot open file for writing:" << _fileName;
+        return false;
+    }
+
+    QMutexLocker locker(&registryMutex);
+    bool wasEnabled = pause();
+
+    QTextStream stream(&file);
+    stream.setRealNumberNotation(QTextStream::FixedNotation);
+    stream.setRealNumberPrecision(3);
+
+    stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    bool firstEvent = true;
+
+    for(int i = 0; i < threadBuffers.size(); ++i)
+    {
+        ThreadBuffer* buffer = threadBuffers[i];
+
+        if(!firstEvent)
+        {
+            stream << ",\n";
+        }
+
+        firstEvent = false;
+        stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+               << buffer->threadId << ",\"args\":{\"name\":\""
+               << escapeJsonString(buffer->threadName) << "\"}}";
+
+        quint64 numEvents = buffer->numEvents.load(std::memory_order_acquire);
+        quint64 firstIndex = (numEvents > CPU_PROFILER_BUFFER_SIZE) ?
+                             numEvents - CPU_PROFILER_BUFFER_SIZE : 0;
+
+        for(quint64 index = firstIndex; index < numEvents; ++index)
+        {
+            const ZoneEvent& event = buffer->events[index % CPU_PROFILER_BUFFER_SIZE];
+
+            // timestamps are in microseconds
+            stream << ",\n{\"name\":\"" << event.name
+                   << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+                   << ",\"ts\":" << (double)event.beginTime * 1e-3
+                   << ",\"dur\":" << (double)(event.endTime - event.beginTime) * 1e-3
+                   << "}";
+        }
+    }
+
+    stream << "\n]}\n";
+    stream.flush();
+    file.close();
+
+    enabled.store(wasEnabled, std::memory_order_relaxed);
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+// must not be called while other threads are recording
+//------------------------------------------------------------------------------------------
+void CPUProfiler::clear()
+{
+    QMutexLocker locker(&registryMutex);
+
+    for(int i = 0; i < threadBuffers.size(); ++i)
+    {
+        threadBuffers[i]->numEvents.store(0, std::memory_order_release);
+    }
+}
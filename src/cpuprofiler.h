@@ -0,0 +1,106 @@
+//------------------------------------------------------------------------------------------
+// cpuprofiler.h
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#ifndef CPUPROFILER_H
+#define CPUPROFILER_H
+
+#include <QtCore>
+#include <atomic>
+
+//------------------------------------------------------------------------------------------
+// number of zones kept per thread, older zones are overwritten
+#define CPU_PROFILER_BUFFER_SIZE (1 << 16)
+
+//------------------------------------------------------------------------------------------
+// Usage: PROFILE_ZONE("name") at the beginning of a scope, the name must be a string
+// literal (only the pointer is stored).
+// Define NO_CPU_PROFILER to compile the zones out completely.
+//------------------------------------------------------------------------------------------
+#ifdef NO_CPU_PROFILER
+#define PROFILE_ZONE(_name)
+#else
+#define PROFILE_ZONE_CONCAT_IMPL(_a, _b) _a##_b
+#define PROFILE_ZONE_CONCAT(_a, _b) PROFILE_ZONE_CONCAT_IMPL(_a, _b)
+#define PROFILE_ZONE(_name) \
+    CPUProfileZone PROFILE_ZONE_CONCAT(profileZone, __LINE__)(_name)
+#endif
+
+//------------------------------------------------------------------------------------------
+// Record the CPU time of scoped zones and export them as Chrome/Perfetto trace JSON.
+// Each thread writes into its own ring buffer (single writer, no lock); a mutex is only
+// taken the first time a thread records a zone, to register its buffer. A zone is only
+// written if the profiler is still enabled when it ends.
+// When disabled, a zone costs one relaxed atomic load.
+//------------------------------------------------------------------------------------------
+class CPUProfiler
+{
+public:
+    static void setEnabled(bool _state);
+    static inline bool isEnabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    static qint64 getTimestamp();
+    static void recordZone(const char* _name, qint64 _beginTime, qint64 _endTime);
+    static void setThreadName(const QString& _threadName);
+
+    static bool saveChromeTrace(const QString& _fileName);
+    static void clear();
+
+private:
+    struct ZoneEvent
+    {
+        const char* name;
+        qint64 beginTime;
+        qint64 endTime;
+    };
+
+    struct ThreadBuffer
+    {
+        ThreadBuffer(): numEvents(0), writing(false), threadId(0) {}
+
+        ZoneEvent events[CPU_PROFILER_BUFFER_SIZE];
+        std::atomic<quint64> numEvents;
+        std::atomic<bool> writing; // the owner thread is inside recordZone
+        int threadId;
+        QString threadName;
+    };
+
+    static ThreadBuffer* getThreadBuffer();
+    static bool pause();
+
+    static std::atomic<bool> enabled;
+    static QMutex registryMutex;
+    static QVector<ThreadBuffer*> threadBuffers;
+};
+
+//------------------------------------------------------------------------------------------
+class CPUProfileZone
+{
+public:
+    inline explicit CPUProfileZone(const char* _name):
+        name(_name),
+        beginTime(CPUProfiler::isEnabled() ? CPUProfiler::getTimestamp() : -1)
+    {
+    }
+
+    inline ~CPUProfileZone()
+    {
+        if(beginTime >= 0)
+        {
+            CPUProfiler::recordZone(name, beginTime, CPUProfiler::getTimestamp());
+        }
+    }
+
+private:
+    const char* name;
+    qint64 beginTime;
+};
+
+#endif // CPUPROFILER_H
@@ -0,0 +1,175 @@
+//------------------------------------------------------------------------------------------
+// float4.h
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#ifndef FLOAT4_H
+#define FLOAT4_H
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FLOAT4_USE_SSE
+#include <emmintrin.h>
+#endif
+
+//------------------------------------------------------------------------------------------
+// 4-wide float vector: one lane per ray of a packet, or per transform of a batch.
+// A comparison returns a mask with all bits of a lane set where the comparison holds.
+//------------------------------------------------------------------------------------------
+#ifdef FLOAT4_USE_SSE
+struct Float4
+{
+    Float4() {}
+    Float4(__m128 _v): v(_v) {}
+    explicit Float4(float _s): v(_mm_set1_ps(_s)) {}
+    Float4(float _a, float _b, float _c, float _d): v(_mm_setr_ps(_a, _b, _c, _d)) {}
+
+    void store(float* _values) const
+    {
+        _mm_storeu_ps(_values, v);
+    }
+
+    __m128 v;
+};
+
+inline Float4 operator+(const Float4& _a, const Float4& _b)
+{
+    return _mm_add_ps(_a.v, _b.v);
+}
+inline Float4 operator-(const Float4& _a, const Float4& _b)
+{
+    return _mm_sub_ps(_a.v, _b.v);
+}
+inline Float4 operator*(const Float4& _a, const Float4& _b)
+{
+    return _mm_mul_ps(_a.v, _b.v);
+}
+inline Float4 operator/(const Float4& _a, const Float4& _b)
+{
+    return _mm_div_ps(_a.v, _b.v);
+}
+inline Float4 min4(const Float4& _a, const Float4& _b)
+{
+    return _mm_min_ps(_a.v, _b.v);
+}
+inline Float4 max4(const Float4& _a, const Float4& _b)
+{
+    return _mm_max_ps(_a.v, _b.v);
+}
+inline Float4 sqrt4(const Float4& _a)
+{
+    return _mm_sqrt_ps(_a.v);
+}
+inline Float4 lessThan(const Float4& _a, const Float4& _b)
+{
+    return _mm_cmplt_ps(_a.v, _b.v);
+}
+inline Float4 lessEqual(const Float4& _a, const Float4& _b)
+{
+    return _mm_cmple_ps(_a.v, _b.v);
+}
+inline Float4 and4(const Float4& _a, const Float4& _b)
+{
+    return _mm_and_ps(_a.v, _b.v);
+}
+inline Float4 select4(const Float4& _mask, const Float4& _a, const Float4& _b)
+{
+    return _mm_or_ps(_mm_and_ps(_mask.v, _a.v), _mm_andnot_ps(_mask.v, _b.v));
+}
+inline int moveMask(const Float4& _mask)
+{
+    return _mm_movemask_ps(_mask.v);
+}
+
+#else // scalar fallback, same interface: a mask lane is 1 where set, 0 otherwise
+struct Float4
+{
+    Float4() {}
+    explicit Float4(float _s)
+    {
+        v[0] = v[1] = v[2] = v[3] = _s;
+    }
+    Float4(float _a, float _b, float _c, float _d)
+    {
+        v[0] = _a;
+        v[1] = _b;
+        v[2] = _c;
+        v[3] = _d;
+    }
+
+    void store(float* _values) const
+    {
+        memcpy(_values, v, sizeof(v));
+    }
+
+    float v[4];
+};
+
+#define FLOAT4_LANES(_expr) \
+    Float4 result; \
+    for(int i = 0; i < 4; ++i) { result.v[i] = (_expr); } \
+    return result;
+
+inline Float4 operator+(const Float4& _a, const Float4& _b)
+{
+    FLOAT4_LANES(_a.v[i] + _b.v[i])
+}
+inline Float4 operator-(const Float4& _a, const Float4& _b)
+{
+    FLOAT4_LANES(_a.v[i] - _b.v[i])
+}
+inline Float4 operator*(const Float4& _a, const Float4& _b)
+{
+    FLOAT4_LANES(_a.v[i] * _b.v[i])
+}
+inline Float4 operator/(const Float4& _a, const Float4& _b)
+{
+    FLOAT4_LANES(_a.v[i] / _b.v[i])
+}
+inline Float4 min4(const Float4& _a, const Float4& _b)
+{
+    FLOAT4_LANES(_a.v[i] < _b.v[i] ? _a.v[i] : _b.v[i])
+}
+inline Float4 max4(const Float4& _a, const Float4& _b)
+{
+    FLOAT4_LANES(_a.v[i] > _b.v[i] ? _a.v[i] : _b.v[i])
+}
+inline Float4 sqrt4(const Float4& _a)
+{
+    FLOAT4_LANES(sqrtf(_a.v[i]))
+}
+inline Float4 lessThan(const Float4& _a, const Float4& _b)
+{
+    FLOAT4_LANES(_a.v[i] < _b.v[i] ? 1.0f : 0.0f)
+}
+inline Float4 lessEqual(const Float4& _a, const Float4& _b)
+{
+    FLOAT4_LANES(_a.v[i] <= _b.v[i] ? 1.0f : 0.0f)
+}
+inline Float4 and4(const Float4& _a, const Float4& _b)
+{
+    FLOAT4_LANES((_a.v[i] != 0.0f && _b.v[i] != 0.0f) ? 1.0f : 0.0f)
+}
+inline Float4 select4(const Float4& _mask, const Float4& _a, const Float4& _b)
+{
+    FLOAT4_LANES(_mask.v[i] != 0.0f ? _a.v[i] : _b.v[i])
+}
+inline int moveMask(const Float4& _mask)
+{
+    int mask = 0;
+
+    for(int i = 0; i < 4; ++i)
+    {
+        mask |= (_mask.v[i] != 0.0f) ? (1 << i) : 0;
+    }
+
+    return mask;
+}
+#endif // FLOAT4_USE_SSE
+
+#endif // FLOAT4_H
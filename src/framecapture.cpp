@@ -0,0 +1,498 @@
+//------------------------------------------------------------------------------------------
+// framecapture.cpp
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#include "framecapture.h"
+#include "cpuprofiler.h"
+
+//------------------------------------------------------------------------------------------
+void FrameCapture::EncodeTask::run()
+{
+    capture->encodeFrame(frame);
+}
+
+//------------------------------------------------------------------------------------------
+FrameCapture::FrameCapture():
+    glFuncs(NULL),
+    readFBO(0),
+    streamHeaderWritten(false),
+    format(PNG_SEQUENCE),
+    capturing(false),
+    streamWidth(0),
+    streamHeight(0),
+    numCapturedFrames(0),
+    numDroppedFrames(0)
+{
+    // leave one core to the render thread
+    imageEncoders.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+    streamWriter.setMaxThreadCount(1);
+}
+
+//------------------------------------------------------------------------------------------
+FrameCapture::~FrameCapture()
+{
+    imageEncoders.waitForDone();
+    streamWriter.waitForDone();
+}
+
+//------------------------------------------------------------------------------------------
+void FrameCapture::initialize(QOpenGLFunctions_4_0_Core* _glFuncs)
+{
+    destroy();
+
+    glFuncs = _glFuncs;
+    glFuncs->glGenFramebuffers(1, &readFBO);
+}
+
+//------------------------------------------------------------------------------------------
+// finish the capture, then delete the framebuffer, the pixel pack buffers and the fences
+// the context must be current
+//------------------------------------------------------------------------------------------
+void FrameCapture::destroy()
+{
+    if(glFuncs == NULL)
+    {
+        return;
+    }
+
+    stop();
+
+    for(int i = 0; i < readbackSlots.size(); ++i)
+    {
+        if(readbackSlots[i].fence != 0)
+        {
+            glFuncs->glDeleteSync(readbackSlots[i].fence);
+        }
+
+        glFuncs->glDeleteBuffers(1, &readbackSlots[i].pbo);
+    }
+
+    glFuncs->glDeleteFramebuffers(1, &readFBO);
+
+    readbackSlots.clear();
+    freeSlots.clear();
+    pendingSlots.clear();
+    readFBO = 0;
+    glFuncs = NULL;
+}
+
+//------------------------------------------------------------------------------------------
+// PNG_SEQUENCE writes <prefix>_000000.png, <prefix>_000001.png...
+// RAW_RGBA writes all the frames (top-down RGBA rows) to <prefix>.rgba
+// Y4M writes a 4:4:4 YUV4MPEG2 stream to <prefix>.y4m
+//------------------------------------------------------------------------------------------
+bool FrameCapture::start(const QString& _filePrefix, Format _format)
+{
+    stop();
+
+    filePrefix = _filePrefix;
+    format = _format;
+    numCapturedFrames = 0;
+    numDroppedFrames = 0;
+    streamWidth = 0;
+    streamHeight = 0;
+    streamHeaderWritten = false;
+
+    if(format != PNG_SEQUENCE)
+    {
+        streamFile.setFileName(filePrefix + ((format == RAW_RGBA) ? ".rgba" : ".y4m"));
+
+        if(!streamFile.open(QIODevice::WriteOnly))
+        {
+            qDebug() << "FrameCapture: cannot open file for writing:"
+                     << streamFile.fileName();
+            return false;
+        }
+    }
+
+    capturing = true;
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+// finish the readbacks in flight (waiting for the GPU this time) and the encoding
+// the context must be current
+//------------------------------------------------------------------------------------------
+void FrameCapture::stop()
+{
+    if(!capturing && pendingSlots.isEmpty())
+    {
+        return;
+    }
+
+    while(!pendingSlots.isEmpty())
+    {
+        int slotId = pendingSlots.dequeue();
+
+        if(!resolveSlot(slotId, 1000000000))
+        {
+            glFuncs->glDeleteSync(readbackSlots[slotId].fence);
+            readbackSlots[slotId].fence = 0;
+            ++numDroppedFrames;
+        }
+
+        freeSlots.append(slotId);
+    }
+
+    imageEncoders.waitForDone();
+    streamWriter.waitForDone();
+
+    if(!capturing)
+    {
+        return;
+    }
+
+    capturing = false;
+
+    if(streamFile.isOpen())
+    {
+        streamFile.close();
+    }
+
+    qDebug() << "FrameCapture:" << numCapturedFrames << "frames captured,"
+             << numDroppedFrames << "dropped, prefix:" << filePrefix;
+
+    if(format == RAW_RGBA)
+    {
+        qDebug() << "FrameCapture: raw frame size:" << streamWidth << "x" << streamHeight;
+    }
+}
+
+//------------------------------------------------------------------------------------------
+bool FrameCapture::isCapturing() const
+{
+    return capturing;
+}
+
+//------------------------------------------------------------------------------------------
+bool FrameCapture::hasPendingReads() const
+{
+    return !pendingSlots.isEmpty();
+}
+
+//------------------------------------------------------------------------------------------
+// queue the readback of the color attachment of _framebuffer
+//------------------------------------------------------------------------------------------
+void FrameCapture::captureFramebuffer(GLuint _framebuffer, int _width, int _height)
+{
+    PROFILE_ZONE("FrameCapture::captureFramebuffer");
+
+    if(!capturing)
+    {
+        return;
+    }
+
+    // a stream has a fixed frame size: frames rendered after a resize are dropped
+    if(format != PNG_SEQUENCE)
+    {
+        if(numCapturedFrames == 0)
+        {
+            streamWidth = _width;
+            streamHeight = _height;
+        }
+        else if(_width != streamWidth || _height != streamHeight)
+        {
+            ++numDroppedFrames;
+            return;
+        }
+    }
+
+    if(numQueuedFrames.load() >= FRAME_CAPTURE_MAX_QUEUED_FRAMES)
+    {
+        ++numDroppedFrames;
+        return;
+    }
+
+    int slotId = acquireSlot();
+
+    if(slotId < 0)
+    {
+        ++numDroppedFrames;
+        return;
+    }
+
+    ReadbackSlot& slot = readbackSlots[slotId];
+    slot.frameIndex = numCapturedFrames;
+    slot.fileName = (format == PNG_SEQUENCE) ?
+                    QString("%1_%2.png").arg(filePrefix).arg(numCapturedFrames, 6, 10,
+                                                             QChar('0')) :
+                    QString();
+
+    GLint previousFramebuffer;
+    glFuncs->glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glFuncs->glBindFramebuffer(GL_READ_FRAMEBUFFER, _framebuffer);
+    readPixels(slotId, _width, _height);
+    glFuncs->glBindFramebuffer(GL_READ_FRAMEBUFFER, previousFramebuffer);
+
+    ++numCapturedFrames;
+}
+
+//------------------------------------------------------------------------------------------
+// queue the readback of one face of a cube map texture, saved as a PNG image
+// _face follows the GL order: +X, -X, +Y, -Y, +Z, -Z
+//------------------------------------------------------------------------------------------
+void FrameCapture::captureCubeMapFace(GLuint _texture, int _face, int _size,
+                                      const QString& _fileName)
+{
+    int slotId = acquireSlot();
+
+    if(slotId < 0)
+    {
+        qDebug() << "FrameCapture: too many readbacks in flight, cannot capture"
+                 << _fileName;
+        return;
+    }
+
+    ReadbackSlot& slot = readbackSlots[slotId];
+    slot.frameIndex = -1;
+    slot.fileName = _fileName;
+
+    GLint previousFramebuffer;
+    glFuncs->glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glFuncs->glBindFramebuffer(GL_READ_FRAMEBUFFER, readFBO);
+    glFuncs->glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                    GL_TEXTURE_CUBE_MAP_POSITIVE_X + _face, _texture, 0);
+
+    readPixels(slotId, _size, _size);
+
+    glFuncs->glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                    GL_TEXTURE_CUBE_MAP_POSITIVE_X + _face, 0, 0);
+    glFuncs->glBindFramebuffer(GL_READ_FRAMEBUFFER, previousFramebuffer);
+}
+
+//------------------------------------------------------------------------------------------
+// hand the readbacks whose fence is signaled to the encoders, in the order they were
+// issued, without waiting for the GPU
+//------------------------------------------------------------------------------------------
+void FrameCapture::processCompletedReads()
+{
+    PROFILE_ZONE("FrameCapture::processCompletedReads");
+
+    while(!pendingSlots.isEmpty() && resolveSlot(pendingSlots.head(), 0))
+    {
+        freeSlots.append(pendingSlots.dequeue());
+    }
+}
+
+//------------------------------------------------------------------------------------------
+int FrameCapture::getNumCapturedFrames() const
+{
+    return numCapturedFrames;
+}
+
+//------------------------------------------------------------------------------------------
+int FrameCapture::getNumDroppedFrames() const
+{
+    return numDroppedFrames;
+}
+
+//------------------------------------------------------------------------------------------
+// return a free readback slot, -1 if they are all in flight
+//------------------------------------------------------------------------------------------
+int FrameCapture::acquireSlot()
+{
+    if(freeSlots.isEmpty())
+    {
+        processCompletedReads();
+    }
+
+    if(!freeSlots.isEmpty())
+    {
+        return freeSlots.takeLast();
+    }
+
+    if(readbackSlots.size() >= FRAME_CAPTURE_MAX_PENDING_READS)
+    {
+        return -1;
+    }
+
+    ReadbackSlot slot;
+    glFuncs->glGenBuffers(1, &slot.pbo);
+    readbackSlots.append(slot);
+
+    return readbackSlots.size() - 1;
+}
+
+//------------------------------------------------------------------------------------------
+// read the bound framebuffer into the pixel pack buffer of the slot, then fence it
+//------------------------------------------------------------------------------------------
+void FrameCapture::readPixels(int _slotId, int _width, int _height)
+{
+    ReadbackSlot& slot = readbackSlots[_slotId];
+    int size = _width * _height * 4;
+
+    glFuncs->glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+
+    if(slot.bufferSize != size)
+    {
+        glFuncs->glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+        slot.bufferSize = size;
+    }
+
+    glFuncs->glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glFuncs->glReadPixels(0, 0, _width, _height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    glFuncs->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = glFuncs->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.width = _width;
+    slot.height = _height;
+
+    pendingSlots.enqueue(_slotId);
+}
+
+//------------------------------------------------------------------------------------------
+// map the slot if its fence is signaled within _timeout nanoseconds, copy the pixels out
+// and queue them for encoding
+//------------------------------------------------------------------------------------------
+bool FrameCapture::resolveSlot(int _slotId, GLuint64 _timeout)
+{
+    ReadbackSlot& slot = readbackSlots[_slotId];
+    GLbitfield flags = (_timeout > 0) ? GL_SYNC_FLUSH_COMMANDS_BIT : 0;
+    GLenum status = glFuncs->glClientWaitSync(slot.fence, flags, _timeout);
+
+    if(status == GL_TIMEOUT_EXPIRED)
+    {
+        return false;
+    }
+
+    glFuncs->glDeleteSync(slot.fence);
+    slot.fence = 0;
+
+    if(status == GL_WAIT_FAILED)
+    {
+        qDebug() << "FrameCapture: waiting for the readback failed.";
+        ++numDroppedFrames;
+        return true;
+    }
+
+    glFuncs->glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    const char* data = static_cast<const char*>(
+                           glFuncs->glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                                                     slot.bufferSize, GL_MAP_READ_BIT));
+
+    if(data != NULL)
+    {
+        Frame frame;
+        frame.pixels = QByteArray(data, slot.bufferSize);
+        frame.width = slot.width;
+        frame.height = slot.height;
+        frame.frameIndex = slot.frameIndex;
+        frame.fileName = slot.fileName;
+
+        glFuncs->glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+        numQueuedFrames.ref();
+
+        if(frame.fileName.isEmpty())
+        {
+            streamWriter.start(new EncodeTask(this, frame));
+        }
+        else
+        {
+            imageEncoders.start(new EncodeTask(this, frame));
+        }
+    }
+    else
+    {
+        qDebug() << "FrameCapture: cannot map the readback buffer.";
+        ++numDroppedFrames;
+    }
+
+    glFuncs->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+// runs on the worker threads
+//------------------------------------------------------------------------------------------
+void FrameCapture::encodeFrame(const Frame& _frame)
+{
+    PROFILE_ZONE("FrameCapture::encodeFrame");
+
+    if(_frame.fileName.isEmpty())
+    {
+        writeStreamFrame(_frame);
+    }
+    else
+    {
+        // the framebuffer rows are bottom-up
+        QImage image(reinterpret_cast<const uchar*>(_frame.pixels.constData()),
+                     _frame.width, _frame.height, QImage::Format_RGBX8888);
+
+        if(!image.mirrored().save(_frame.fileName))
+        {
+            qDebug() << "FrameCapture: cannot save" << _frame.fileName;
+        }
+    }
+
+    numQueuedFrames.deref();
+}
+
+//------------------------------------------------------------------------------------------
+// runs on the single stream writer thread, so the frames are written in order
+//------------------------------------------------------------------------------------------
+void FrameCapture::writeStreamFrame(const Frame& _frame)
+{
+    int rowSize = _frame.width * 4;
+
+    if(format == RAW_RGBA)
+    {
+        for(int y = _frame.height - 1; y >= 0; --y)
+        {
+            streamFile.write(_frame.pixels.constData() + y * rowSize, rowSize);
+        }
+
+        return;
+    }
+
+    if(!streamHeaderWritten)
+    {
+        streamFile.write(QString("YUV4MPEG2 W%1 H%2 F%3:1 Ip A1:1 C444\n")
+                         .arg(_frame.width).arg(_frame.height)
+                         .arg(FRAME_CAPTURE_Y4M_FPS).toLatin1());
+        streamHeaderWritten = true;
+    }
+
+    QByteArray yuv;
+    convertToYUV444(_frame, yuv);
+
+    streamFile.write("FRAME\n");
+    streamFile.write(yuv);
+}
+
+//------------------------------------------------------------------------------------------
+// BT.601 limited range, planar Y, U, V with top-down rows
+//------------------------------------------------------------------------------------------
+void FrameCapture::convertToYUV444(const Frame& _frame, QByteArray& _yuv)
+{
+    int numPixels = _frame.width * _frame.height;
+    _yuv.resize(3 * numPixels);
+
+    uchar* yPlane = reinterpret_cast<uchar*>(_yuv.data());
+    uchar* uPlane = yPlane + numPixels;
+    uchar* vPlane = uPlane + numPixels;
+    const uchar* pixels = reinterpret_cast<const uchar*>(_frame.pixels.constData());
+
+    for(int y = 0; y < _frame.height; ++y)
+    {
+        const uchar* row = pixels + (_frame.height - 1 - y) * _frame.width * 4;
+        int offset = y * _frame.width;
+
+        for(int x = 0; x < _frame.width; ++x)
+        {
+            int r = row[4 * x];
+            int g = row[4 * x + 1];
+            int b = row[4 * x + 2];
+
+            yPlane[offset + x] = (uchar)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+            uPlane[offset + x] = (uchar)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            vPlane[offset + x] = (uchar)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+}
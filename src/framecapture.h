@@ -0,0 +1,128 @@
+//------------------------------------------------------------------------------------------
+// framecapture.h
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include <QtGui>
+#include <QOpenGLFunctions_4_0_Core>
+
+//------------------------------------------------------------------------------------------
+// maximum number of readbacks in flight on the GPU
+#define FRAME_CAPTURE_MAX_PENDING_READS 16
+// maximum number of frames waiting to be encoded, newer frames are dropped
+#define FRAME_CAPTURE_MAX_QUEUED_FRAMES 24
+// nominal frame rate written in the Y4M header
+#define FRAME_CAPTURE_Y4M_FPS 60
+
+//------------------------------------------------------------------------------------------
+// Capture framebuffers and cube map faces without stalling the rendering.
+// glReadPixels writes into a pixel pack buffer and a fence is inserted after it. The buffer
+// is mapped only once its fence is signaled (usually a couple of frames later), so the
+// readback never waits for the GPU. The pixels are then encoded on worker threads:
+// PNG frames in parallel on a thread pool, raw RGBA and Y4M streams in order on a single
+// writer thread.
+// When all the readback buffers are in flight or the encoders are too far behind, the
+// frame is dropped (and counted) instead of blocking the render thread.
+//------------------------------------------------------------------------------------------
+class FrameCapture
+{
+public:
+    enum Format
+    {
+        PNG_SEQUENCE = 0,
+        RAW_RGBA,
+        Y4M,
+        NUM_CAPTURE_FORMATS
+    };
+
+    FrameCapture();
+    ~FrameCapture();
+
+    void initialize(QOpenGLFunctions_4_0_Core* _glFuncs);
+    void destroy();
+
+    bool start(const QString& _filePrefix, Format _format);
+    void stop();
+    bool isCapturing() const;
+    bool hasPendingReads() const;
+
+    void captureFramebuffer(GLuint _framebuffer, int _width, int _height);
+    void captureCubeMapFace(GLuint _texture, int _face, int _size,
+                            const QString& _fileName);
+    void processCompletedReads();
+
+    int getNumCapturedFrames() const;
+    int getNumDroppedFrames() const;
+
+private:
+    struct ReadbackSlot
+    {
+        ReadbackSlot(): pbo(0), bufferSize(0), fence(0), width(0), height(0),
+            frameIndex(-1) {}
+
+        GLuint pbo;
+        int bufferSize;
+        GLsync fence;
+        int width;
+        int height;
+        int frameIndex;     // index in the stream, -1 for a single image
+        QString fileName;
+    };
+
+    struct Frame
+    {
+        QByteArray pixels;  // RGBA, bottom-up rows as read by glReadPixels
+        int width;
+        int height;
+        int frameIndex;
+        QString fileName;
+    };
+
+    class EncodeTask : public QRunnable
+    {
+    public:
+        EncodeTask(FrameCapture* _capture, const Frame& _frame):
+            capture(_capture), frame(_frame) {}
+
+        void run();
+
+    private:
+        FrameCapture* capture;
+        Frame frame;
+    };
+
+    int acquireSlot();
+    void readPixels(int _slotId, int _width, int _height);
+    bool resolveSlot(int _slotId, GLuint64 _timeout);
+    void encodeFrame(const Frame& _frame);
+    void writeStreamFrame(const Frame& _frame);
+    void convertToYUV444(const Frame& _frame, QByteArray& _yuv);
+
+    QOpenGLFunctions_4_0_Core* glFuncs;
+    GLuint readFBO;
+    QVector<ReadbackSlot> readbackSlots;
+    QVector<int> freeSlots;
+    QQueue<int> pendingSlots;
+
+    QThreadPool imageEncoders;
+    QThreadPool streamWriter;
+    QFile streamFile;
+    bool streamHeaderWritten;
+    QAtomicInt numQueuedFrames;
+
+    QString filePrefix;
+    Format format;
+    bool capturing;
+    int streamWidth;
+    int streamHeight;
+    int numCapturedFrames;
+    int numDroppedFrames;
+};
+
+#endif // FRAMECAPTURE_H
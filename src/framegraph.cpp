@@ -0,0 +1,449 @@
+//------------------------------------------------------------------------------------------
+// framegraph.cpp
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#include "framegraph.h"
+#include "cpuprofiler.h"
+
+//------------------------------------------------------------------------------------------
+FrameGraph::FrameGraph():
+    glFuncs(NULL),
+    frameIndex(0)
+{
+}
+
+//------------------------------------------------------------------------------------------
+void FrameGraph::initialize(QOpenGLFunctions_4_0_Core* _glFuncs)
+{
+    destroy();
+    glFuncs = _glFuncs;
+}
+
+//------------------------------------------------------------------------------------------
+void FrameGraph::destroy()
+{
+    for(int i = 0; i < pool.size(); ++i)
+    {
+        deletePhysical(pool[i]);
+    }
+
+    pool.clear();
+    passes.clear();
+    resources.clear();
+}
+
+//------------------------------------------------------------------------------------------
+// forget the passes of the last frame, the physical resources are kept for the next ones
+//------------------------------------------------------------------------------------------
+void FrameGraph::reset()
+{
+    collectIdleResources();
+
+    passes.resize(0);
+    resources.resize(0);
+    ++frameIndex;
+
+    for(int i = 0; i < pool.size(); ++i)
+    {
+        pool[i].busyUntilPass = -1;
+    }
+}
+
+//------------------------------------------------------------------------------------------
+int FrameGraph::createResource(const QString& _name, FrameResourceType _type, int _size)
+{
+    FrameResource resource;
+    resource.name = _name;
+    resource.type = _type;
+    resource.size = _size;
+    resource.output = false;
+    resource.exported = false;
+    resource.firstPass = -1;
+    resource.lastPass = -1;
+    resource.physical = -1;
+    resources.append(resource);
+
+    return resources.size() - 1;
+}
+
+//------------------------------------------------------------------------------------------
+int FrameGraph::importResource(const QString& _name)
+{
+    return createResource(_name, FRAME_RESOURCE_IMPORTED, 0);
+}
+
+//------------------------------------------------------------------------------------------
+// the passes run in the order they are added, it must respect their dependencies
+//------------------------------------------------------------------------------------------
+int FrameGraph::addPass(const QString& _name, PassFunction _execute)
+{
+    FramePass pass;
+    pass.name = _name;
+    pass.execute = _execute;
+    pass.culled = false;
+    passes.append(pass);
+
+    return passes.size() - 1;
+}
+
+//------------------------------------------------------------------------------------------
+void FrameGraph::read(int _pass, int _resource)
+{
+    passes[_pass].reads.append(_resource);
+}
+
+//------------------------------------------------------------------------------------------
+void FrameGraph::write(int _pass, int _resource)
+{
+    passes[_pass].writes.append(_resource);
+}
+
+//------------------------------------------------------------------------------------------
+// the passes writing an output are never culled
+//------------------------------------------------------------------------------------------
+void FrameGraph::markOutput(int _resource)
+{
+    resources[_resource].output = true;
+}
+
+//------------------------------------------------------------------------------------------
+// an exported resource is not an output: it survives the frame only if its pass is run
+//------------------------------------------------------------------------------------------
+void FrameGraph::exportResource(int _resource)
+{
+    Q_ASSERT(resources[_resource].type == FRAME_RESOURCE_CUBE_MAP ||
+             resources[_resource].type == FRAME_RESOURCE_DEPTH_CUBE_MAP);
+    resources[_resource].exported = true;
+}
+
+//------------------------------------------------------------------------------------------
+void FrameGraph::compile()
+{
+    PROFILE_ZONE("FrameGraph::compile");
+
+    cullPasses();
+    computeLifetimes();
+
+    // the resources are allocated in the order of their first use
+    for(int pass = 0; pass < passes.size(); ++pass)
+    {
+        if(passes[pass].culled)
+        {
+            continue;
+        }
+
+        QVector<int> used = passes[pass].writes + passes[pass].reads;
+
+        for(int i = 0; i < used.size(); ++i)
+        {
+            FrameResource& resource = resources[used[i]];
+
+            if(resource.type != FRAME_RESOURCE_IMPORTED && resource.physical < 0 &&
+               resource.firstPass == pass)
+            {
+                resource.physical = acquirePhysical(resource, pass);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------
+void FrameGraph::execute()
+{
+    PROFILE_ZONE("FrameGraph::execute");
+
+    for(int i = 0; i < passes.size(); ++i)
+    {
+        if(!passes[i].culled)
+        {
+            passes[i].execute();
+        }
+    }
+
+    for(int i = 0; i < resources.size(); ++i)
+    {
+        if(resources[i].exported && resources[i].physical >= 0)
+        {
+            pool[resources[i].physical].retained = true;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------
+bool FrameGraph::isAllocated(int _resource) const
+{
+    return (resources[_resource].physical >= 0);
+}
+
+//------------------------------------------------------------------------------------------
+QOpenGLTexture* FrameGraph::getTexture(int _resource) const
+{
+    int physical = resources[_resource].physical;
+    return (physical >= 0) ? pool[physical].texture : NULL;
+}
+
+//------------------------------------------------------------------------------------------
+GLuint FrameGraph::getBufferId(int _resource) const
+{
+    int physical = resources[_resource].physical;
+    return (physical >= 0) ? pool[physical].id : 0;
+}
+
+//------------------------------------------------------------------------------------------
+// the texture of an exported resource goes back to the pool
+//------------------------------------------------------------------------------------------
+void FrameGraph::releaseTexture(QOpenGLTexture* _texture)
+{
+    for(int i = 0; _texture != NULL && i < pool.size(); ++i)
+    {
+        if(pool[i].texture == _texture)
+        {
+            pool[i].retained = false;
+            return;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------
+int FrameGraph::getNumPasses() const
+{
+    return passes.size();
+}
+
+//------------------------------------------------------------------------------------------
+int FrameGraph::getNumCulledPasses() const
+{
+    int numCulled = 0;
+
+    for(int i = 0; i < passes.size(); ++i)
+    {
+        numCulled += passes[i].culled ? 1 : 0;
+    }
+
+    return numCulled;
+}
+
+//------------------------------------------------------------------------------------------
+// the transient resources used by this frame
+//------------------------------------------------------------------------------------------
+int FrameGraph::getNumTransientResources() const
+{
+    int numTransients = 0;
+
+    for(int i = 0; i < resources.size(); ++i)
+    {
+        numTransients += (resources[i].physical >= 0) ? 1 : 0;
+    }
+
+    return numTransients;
+}
+
+//------------------------------------------------------------------------------------------
+// the physical resources used by this frame, fewer than the transients when aliased
+//------------------------------------------------------------------------------------------
+int FrameGraph::getNumPhysicalResources() const
+{
+    int numPhysicals = 0;
+
+    for(int i = 0; i < pool.size(); ++i)
+    {
+        numPhysicals += (pool[i].lastUsedFrame == frameIndex) ? 1 : 0;
+    }
+
+    return numPhysicals;
+}
+
+//------------------------------------------------------------------------------------------
+// a pass is kept if one of its writes is an output or is read by a kept pass
+//------------------------------------------------------------------------------------------
+void FrameGraph::cullPasses()
+{
+    QVector<bool> needed(resources.size());
+
+    for(int i = 0; i < resources.size(); ++i)
+    {
+        needed[i] = resources[i].output;
+    }
+
+    for(int pass = passes.size() - 1; pass >= 0; --pass)
+    {
+        FramePass& framePass = passes[pass];
+        framePass.culled = true;
+
+        for(int i = 0; i < framePass.writes.size(); ++i)
+        {
+            if(needed[framePass.writes[i]])
+            {
+                framePass.culled = false;
+            }
+        }
+
+        for(int i = 0; !framePass.culled && i < framePass.reads.size(); ++i)
+        {
+            needed[framePass.reads[i]] = true;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------
+void FrameGraph::computeLifetimes()
+{
+    for(int pass = 0; pass < passes.size(); ++pass)
+    {
+        if(passes[pass].culled)
+        {
+            continue;
+        }
+
+        QVector<int> used = passes[pass].writes + passes[pass].reads;
+
+        for(int i = 0; i < used.size(); ++i)
+        {
+            FrameResource& resource = resources[used[i]];
+
+            if(resource.firstPass < 0)
+            {
+                resource.firstPass = pass;
+            }
+
+            resource.lastPass = pass;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// reuse a physical resource of the same type and size whose last user has already run
+//------------------------------------------------------------------------------------------
+int FrameGraph::acquirePhysical(const FrameResource& _resource, int _pass)
+{
+    int found = -1;
+
+    for(int i = 0; i < pool.size() && found < 0; ++i)
+    {
+        const PhysicalResource& physical = pool[i];
+
+        if(physical.type == _resource.type && physical.size == _resource.size &&
+           !physical.retained && physical.busyUntilPass < _pass)
+        {
+            found = i;
+        }
+    }
+
+    if(found < 0)
+    {
+        PhysicalResource physical;
+        physical.type = _resource.type;
+        physical.size = _resource.size;
+        physical.retained = false;
+        createPhysical(physical);
+        pool.append(physical);
+        found = pool.size() - 1;
+    }
+
+    // an exported resource keeps its physical resource until the end of the frame
+    pool[found].busyUntilPass = _resource.exported ? passes.size() : _resource.lastPass;
+    pool[found].lastUsedFrame = frameIndex;
+
+    return found;
+}
+
+//------------------------------------------------------------------------------------------
+void FrameGraph::createPhysical(PhysicalResource& _physical)
+{
+    _physical.texture = NULL;
+    _physical.id = 0;
+
+    switch(_physical.type)
+    {
+    case FRAME_RESOURCE_CUBE_MAP:
+        _physical.texture = new QOpenGLTexture(QOpenGLTexture::TargetCubeMap);
+        _physical.texture->create();
+        _physical.texture->setSize(_physical.size, _physical.size);
+        _physical.texture->setFormat(QOpenGLTexture::RGBA8_UNorm);
+        _physical.texture->allocateStorage();
+
+        _physical.texture->setWrapMode(QOpenGLTexture::DirectionS,
+                                       QOpenGLTexture::ClampToEdge);
+        _physical.texture->setWrapMode(QOpenGLTexture::DirectionT,
+                                       QOpenGLTexture::ClampToEdge);
+        _physical.texture->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
+        _physical.texture->setMagnificationFilter(QOpenGLTexture::LinearMipMapLinear);
+        _physical.id = _physical.texture->textureId();
+        break;
+
+    // the same format as the depth buffers, to be blitted into them
+    case FRAME_RESOURCE_DEPTH_CUBE_MAP:
+        _physical.texture = new QOpenGLTexture(QOpenGLTexture::TargetCubeMap);
+        _physical.texture->create();
+        _physical.texture->setSize(_physical.size, _physical.size);
+        _physical.texture->setFormat(QOpenGLTexture::D16);
+        _physical.texture->setMipLevels(1);
+        _physical.texture->allocateStorage();
+        _physical.texture->setMinificationFilter(QOpenGLTexture::Nearest);
+        _physical.texture->setMagnificationFilter(QOpenGLTexture::Nearest);
+        _physical.id = _physical.texture->textureId();
+        break;
+
+    case FRAME_RESOURCE_DEPTH_BUFFER:
+        glFuncs->glGenRenderbuffers(1, &_physical.id);
+        glFuncs->glBindRenderbuffer(GL_RENDERBUFFER, _physical.id);
+        glFuncs->glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16,
+                                       _physical.size, _physical.size);
+        glFuncs->glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        break;
+
+    case FRAME_RESOURCE_FRAMEBUFFER:
+        glFuncs->glGenFramebuffers(1, &_physical.id);
+        break;
+
+    default:
+        break;
+    }
+}
+
+//------------------------------------------------------------------------------------------
+void FrameGraph::deletePhysical(PhysicalResource& _physical)
+{
+    switch(_physical.type)
+    {
+    case FRAME_RESOURCE_CUBE_MAP:
+    case FRAME_RESOURCE_DEPTH_CUBE_MAP:
+        delete _physical.texture;
+        _physical.texture = NULL;
+        break;
+
+    case FRAME_RESOURCE_DEPTH_BUFFER:
+        glFuncs->glDeleteRenderbuffers(1, &_physical.id);
+        break;
+
+    case FRAME_RESOURCE_FRAMEBUFFER:
+        glFuncs->glDeleteFramebuffers(1, &_physical.id);
+        break;
+
+    default:
+        break;
+    }
+
+    _physical.id = 0;
+}
+
+//------------------------------------------------------------------------------------------
+// between two frames only: the resources refer to the physical resources by index
+//------------------------------------------------------------------------------------------
+void FrameGraph::collectIdleResources()
+{
+    for(int i = pool.size() - 1; i >= 0; --i)
+    {
+        int numIdleFrames = frameIndex - pool[i].lastUsedFrame;
+
+        if(!pool[i].retained && numIdleFrames >= FRAME_GRAPH_MAX_IDLE_FRAMES)
+        {
+            deletePhysical(pool[i]);
+            pool.remove(i);
+        }
+    }
+}
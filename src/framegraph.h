@@ -0,0 +1,123 @@
+//------------------------------------------------------------------------------------------
+// framegraph.h
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#ifndef FRAMEGRAPH_H
+#define FRAMEGRAPH_H
+
+#include <QtGui>
+#include <QOpenGLFunctions_4_0_Core>
+#include <functional>
+
+//------------------------------------------------------------------------------------------
+// a physical resource unused for this many frames is deleted
+#define FRAME_GRAPH_MAX_IDLE_FRAMES 16
+
+enum FrameResourceType
+{
+    FRAME_RESOURCE_IMPORTED = 0,   // owned outside of the graph, never allocated
+    FRAME_RESOURCE_CUBE_MAP,       // RGBA8 color cube map
+    FRAME_RESOURCE_DEPTH_CUBE_MAP, // 16 bit depth cube map
+    FRAME_RESOURCE_DEPTH_BUFFER,   // 16 bit depth renderbuffer
+    FRAME_RESOURCE_FRAMEBUFFER,    // framebuffer object, its pass attaches the buffers
+    NUM_FRAME_RESOURCE_TYPES
+};
+
+//------------------------------------------------------------------------------------------
+// The passes of a frame, declared with the resources they read and write, then run in
+// the order of declaration.
+// compile() culls the passes whose results reach no output, walking the passes backward
+// from the outputs. The transient resources of the remaining passes are then taken from a
+// pool of physical resources: two resources of the same type and size whose lifetimes
+// (from the first to the last pass using them) do not overlap share the same physical
+// resource. A physical resource is only created when a pass needs it, and deleted after
+// it has not been used for FRAME_GRAPH_MAX_IDLE_FRAMES frames.
+// An exported cube map (color or depth) outlives the frame: its texture stays reserved
+// until it is given back with releaseTexture().
+//------------------------------------------------------------------------------------------
+class FrameGraph
+{
+public:
+    typedef std::function<void()> PassFunction;
+
+    FrameGraph();
+
+    void initialize(QOpenGLFunctions_4_0_Core* _glFuncs);
+    void destroy();
+
+    // declaration, every frame
+    void reset();
+    int createResource(const QString& _name, FrameResourceType _type, int _size);
+    int importResource(const QString& _name);
+    int addPass(const QString& _name, PassFunction _execute);
+    void read(int _pass, int _resource);
+    void write(int _pass, int _resource);
+    void markOutput(int _resource);
+    void exportResource(int _resource);
+
+    void compile();
+    void execute();
+
+    // allocated if a pass which is not culled uses the resource
+    bool isAllocated(int _resource) const;
+    QOpenGLTexture* getTexture(int _resource) const;
+    GLuint getBufferId(int _resource) const;
+    void releaseTexture(QOpenGLTexture* _texture);
+
+    int getNumPasses() const;
+    int getNumCulledPasses() const;
+    int getNumTransientResources() const;
+    int getNumPhysicalResources() const;
+
+private:
+    struct FramePass
+    {
+        QString name;
+        PassFunction execute;
+        QVector<int> reads;
+        QVector<int> writes;
+        bool culled;
+    };
+
+    struct FrameResource
+    {
+        QString name;
+        FrameResourceType type;
+        int size;
+        bool output;
+        bool exported;
+        int firstPass; // the lifetime, in the passes which are not culled
+        int lastPass;
+        int physical;  // -1 if not allocated
+    };
+
+    struct PhysicalResource
+    {
+        FrameResourceType type;
+        int size;
+        QOpenGLTexture* texture; // the cube maps
+        GLuint id;               // the texture, renderbuffer or framebuffer
+        int busyUntilPass;       // the last pass of its current resource in this frame
+        bool retained;           // exported, until released
+        int lastUsedFrame;
+    };
+
+    void cullPasses();
+    void computeLifetimes();
+    int acquirePhysical(const FrameResource& _resource, int _pass);
+    void createPhysical(PhysicalResource& _physical);
+    void deletePhysical(PhysicalResource& _physical);
+    void collectIdleResources();
+
+    QOpenGLFunctions_4_0_Core* glFuncs;
+    QVector<FramePass> passes;
+    QVector<FrameResource> resources;
+    QVector<PhysicalResource> pool;
+    int frameIndex;
+};
+
+#endif // FRAMEGRAPH_H
@@ -0,0 +1,134 @@
+//------------------------------------------------------------------------------------------
+// framescheduler.cpp
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#include <cmath>
+
+#include "framescheduler.h"
+
+//------------------------------------------------------------------------------------------
+FrameScheduler::FrameScheduler():
+    pendingFrames(1),
+    continuousRendering(false),
+    fixedFrameTime(0.0f),
+    frameTime(1.0f / INERTIA_REFERENCE_FPS)
+{
+}
+
+//------------------------------------------------------------------------------------------
+void FrameScheduler::requestFrames(int _numFrames)
+{
+    if(_numFrames > pendingFrames)
+    {
+        pendingFrames = _numFrames;
+    }
+}
+
+//------------------------------------------------------------------------------------------
+void FrameScheduler::setContinuousRendering(bool _state)
+{
+    continuousRendering = _state;
+}
+
+//------------------------------------------------------------------------------------------
+bool FrameScheduler::isContinuousRendering() const
+{
+    return continuousRendering;
+}
+
+//------------------------------------------------------------------------------------------
+// simulate every frame with the same time step, regardless of the real frame time
+// (replay of recorded sessions), 0 to go back to the measured frame time
+//------------------------------------------------------------------------------------------
+void FrameScheduler::setFixedFrameTime(float _frameTime)
+{
+    fixedFrameTime = _frameTime;
+}
+
+//------------------------------------------------------------------------------------------
+// return the time elapsed since the previous frame, in seconds
+// the first frame after an idle period uses the reference frame time
+//------------------------------------------------------------------------------------------
+float FrameScheduler::beginFrame()
+{
+    if(fixedFrameTime > 0.0f)
+    {
+        frameTime = fixedFrameTime;
+
+        if(!frameTimer.isValid())
+        {
+            frameTimer.start();
+        }
+    }
+    else if(!frameTimer.isValid())
+    {
+        frameTime = 1.0f / INERTIA_REFERENCE_FPS;
+        frameTimer.start();
+    }
+    else
+    {
+        frameTime = (float)((double)frameTimer.nsecsElapsed() * 1e-9);
+        frameTimer.restart();
+
+        if(frameTime > MAX_FRAME_TIME)
+        {
+            frameTime = MAX_FRAME_TIME;
+        }
+    }
+
+    if(pendingFrames > 0)
+    {
+        --pendingFrames;
+    }
+
+    return frameTime;
+}
+
+//------------------------------------------------------------------------------------------
+// return true if another frame must be scheduled
+//------------------------------------------------------------------------------------------
+bool FrameScheduler::endFrame(bool _animating)
+{
+    if(continuousRendering || _animating || pendingFrames > 0)
+    {
+        return true;
+    }
+
+    // going idle: the next frame will be triggered by an event
+    frameTimer.invalidate();
+    return false;
+}
+
+//------------------------------------------------------------------------------------------
+float FrameScheduler::getFrameTime() const
+{
+    return frameTime;
+}
+
+//------------------------------------------------------------------------------------------
+bool FrameScheduler::isIdle() const
+{
+    return !frameTimer.isValid();
+}
+
+//------------------------------------------------------------------------------------------
+// _inertia is the decay factor per reference frame (1/INERTIA_REFERENCE_FPS second)
+// convert it to the decay factor over _frameTime, so the motion is the same at any
+// refresh rate
+//------------------------------------------------------------------------------------------
+float FrameScheduler::damping(float _inertia, float _frameTime)
+{
+    return pow(_inertia, timeScale(_frameTime));
+}
+
+//------------------------------------------------------------------------------------------
+// number of reference frames covered by _frameTime
+//------------------------------------------------------------------------------------------
+float FrameScheduler::timeScale(float _frameTime)
+{
+    return _frameTime * INERTIA_REFERENCE_FPS;
+}
@@ -0,0 +1,55 @@
+//------------------------------------------------------------------------------------------
+// framescheduler.h
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include <QElapsedTimer>
+
+//------------------------------------------------------------------------------------------
+// the reference rate at which the per-frame inertia constants were tuned
+#define INERTIA_REFERENCE_FPS 60.0f
+// clamp for the frame time, avoid huge jumps after a stall (window drag, breakpoint...)
+#define MAX_FRAME_TIME 0.1f
+
+//------------------------------------------------------------------------------------------
+// Decide whether another frame needs to be rendered.
+// Frames are rendered only while something is moving, an animation is running or somebody
+// requested a redraw. When nothing changes, no frame is scheduled and the application
+// sleeps in the event loop.
+// Multiple requests between two frames are coalesced into a single frame, since
+// QWidget::update() only posts one paint event until the widget is painted.
+//------------------------------------------------------------------------------------------
+class FrameScheduler
+{
+public:
+    FrameScheduler();
+
+    void requestFrames(int _numFrames = 1);
+    void setContinuousRendering(bool _state);
+    bool isContinuousRendering() const;
+    void setFixedFrameTime(float _frameTime);
+
+    float beginFrame();
+    bool endFrame(bool _animating);
+
+    float getFrameTime() const;
+    bool isIdle() const;
+
+    static float damping(float _inertia, float _frameTime);
+    static float timeScale(float _frameTime);
+
+private:
+    QElapsedTimer frameTimer;
+    int pendingFrames;
+    bool continuousRendering;
+    float fixedFrameTime;
+    float frameTime;
+};
+
+#endif // FRAMESCHEDULER_H
@@ -0,0 +1,288 @@
+//------------------------------------------------------------------------------------------
+// geometrybuffer.cpp
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#include "geometrybuffer.h"
+#include "cpuprofiler.h"
+
+//------------------------------------------------------------------------------------------
+GeometryBuffer::GeometryBuffer():
+    glFuncs(NULL),
+    vertexBuffer(0),
+    indexBuffer(0),
+    vao(0),
+    layoutChanged(false)
+{
+}
+
+//------------------------------------------------------------------------------------------
+void GeometryBuffer::initialize(QOpenGLFunctions_4_0_Core* _glFuncs)
+{
+    destroy();
+
+    glFuncs = _glFuncs;
+    glFuncs->glGenBuffers(1, &vertexBuffer);
+    glFuncs->glGenBuffers(1, &indexBuffer);
+    glFuncs->glGenVertexArrays(1, &vao);
+    initVertexArrayObject();
+    layoutChanged = true;
+}
+
+//------------------------------------------------------------------------------------------
+void GeometryBuffer::destroy()
+{
+    if(vao != 0)
+    {
+        glFuncs->glDeleteVertexArrays(1, &vao);
+        glFuncs->glDeleteBuffers(1, &vertexBuffer);
+        glFuncs->glDeleteBuffers(1, &indexBuffer);
+        vao = 0;
+        vertexBuffer = 0;
+        indexBuffer = 0;
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// the new meshes are empty until they are set
+//------------------------------------------------------------------------------------------
+void GeometryBuffer::resize(int _numMeshes)
+{
+    if(_numMeshes == meshVertices.size())
+    {
+        return;
+    }
+
+    meshVertices.resize(_numMeshes);
+    meshIndices.resize(_numMeshes);
+    ranges.resize(_numMeshes);
+    dirtyMeshes.resize(_numMeshes);
+    layoutChanged = true;
+}
+
+//------------------------------------------------------------------------------------------
+int GeometryBuffer::getNumMeshes() const
+{
+    return meshVertices.size();
+}
+
+//------------------------------------------------------------------------------------------
+void GeometryBuffer::setMesh(int _mesh, const GLfloat* _vertices, const GLfloat* _normals,
+                             const GLfloat* _texCoords, int _numVertices,
+                             const GLushort* _indices, int _numIndices)
+{
+    setVertices(_mesh, _vertices, _normals, _texCoords, _numVertices, _numIndices);
+
+    QVector<GLuint>& indices = meshIndices[_mesh];
+    indices.resize(_numIndices);
+
+    for(int i = 0; i < _numIndices; ++i)
+    {
+        indices[i] = _indices[i];
+    }
+}
+
+//------------------------------------------------------------------------------------------
+void GeometryBuffer::setMesh(int _mesh, const GLfloat* _vertices, const GLfloat* _normals,
+                             const GLfloat* _texCoords, int _numVertices,
+                             const GLuint* _indices, int _numIndices)
+{
+    setVertices(_mesh, _vertices, _normals, _texCoords, _numVertices, _numIndices);
+
+    QVector<GLuint>& indices = meshIndices[_mesh];
+    indices.resize(_numIndices);
+    memcpy(indices.data(), _indices, _numIndices * sizeof(GLuint));
+}
+
+//------------------------------------------------------------------------------------------
+// one glBufferData per buffer after a repack, one glBufferSubData per modified mesh
+// otherwise
+//------------------------------------------------------------------------------------------
+void GeometryBuffer::upload()
+{
+    if(vao == 0 || (!layoutChanged && !dirtyMeshes.contains(1)))
+    {
+        return;
+    }
+
+    PROFILE_ZONE("GeometryBuffer::upload");
+
+    if(layoutChanged)
+    {
+        repack();
+        return;
+    }
+
+    glFuncs->glBindVertexArray(vao);
+    glFuncs->glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+
+    for(int i = 0; i < dirtyMeshes.size(); ++i)
+    {
+        if(!dirtyMeshes[i])
+        {
+            continue;
+        }
+
+        const GeometryRange& range = ranges[i];
+        glFuncs->glBufferSubData(GL_ARRAY_BUFFER, range.baseVertex * sizeof(GeometryVertex),
+                                 range.numVertices * sizeof(GeometryVertex),
+                                 meshVertices[i].constData());
+        glFuncs->glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, range.firstIndex * sizeof(GLuint),
+                                 range.numIndices * sizeof(GLuint),
+                                 meshIndices[i].constData());
+    }
+
+    glFuncs->glBindVertexArray(0);
+    glFuncs->glBindBuffer(GL_ARRAY_BUFFER, 0);
+    dirtyMeshes.fill(0);
+}
+
+//------------------------------------------------------------------------------------------
+void GeometryBuffer::bind()
+{
+    glFuncs->glBindVertexArray(vao);
+}
+
+//------------------------------------------------------------------------------------------
+void GeometryBuffer::release()
+{
+    glFuncs->glBindVertexArray(0);
+}
+
+//------------------------------------------------------------------------------------------
+// the vertex array object must be bound
+//------------------------------------------------------------------------------------------
+void GeometryBuffer::draw(int _mesh)
+{
+    const GeometryRange& range = ranges[_mesh];
+    glFuncs->glDrawElementsBaseVertex(GL_TRIANGLES, range.numIndices, GL_UNSIGNED_INT,
+                                      (const GLvoid*)(range.firstIndex * sizeof(GLuint)),
+                                      range.baseVertex);
+}
+
+//------------------------------------------------------------------------------------------
+void GeometryBuffer::drawInstanced(int _mesh, int _numInstances)
+{
+    const GeometryRange& range = ranges[_mesh];
+    glFuncs->glDrawElementsInstancedBaseVertex(GL_TRIANGLES, range.numIndices,
+                                               GL_UNSIGNED_INT,
+                                               (const GLvoid*)(range.firstIndex *
+                                                               sizeof(GLuint)),
+                                               _numInstances, range.baseVertex);
+}
+
+//------------------------------------------------------------------------------------------
+const GeometryRange& GeometryBuffer::getRange(int _mesh) const
+{
+    return ranges[_mesh];
+}
+
+//------------------------------------------------------------------------------------------
+// interleave the vertex attributes, the ranges are kept if the sizes do not change
+//------------------------------------------------------------------------------------------
+void GeometryBuffer::setVertices(int _mesh, const GLfloat* _vertices,
+                                 const GLfloat* _normals, const GLfloat* _texCoords,
+                                 int _numVertices, int _numIndices)
+{
+    Q_ASSERT(_mesh >= 0 && _mesh < meshVertices.size());
+
+    QVector<GeometryVertex>& vertices = meshVertices[_mesh];
+
+    if(vertices.size() != _numVertices || meshIndices[_mesh].size() != _numIndices)
+    {
+        layoutChanged = true;
+    }
+
+    vertices.resize(_numVertices);
+
+    for(int i = 0; i < _numVertices; ++i)
+    {
+        GeometryVertex& vertex = vertices[i];
+        memcpy(vertex.position, _vertices + 3 * i, sizeof(vertex.position));
+        memcpy(vertex.normal, _normals + 3 * i, sizeof(vertex.normal));
+        memcpy(vertex.texCoord, _texCoords + 2 * i, sizeof(vertex.texCoord));
+    }
+
+    dirtyMeshes[_mesh] = 1;
+}
+
+//------------------------------------------------------------------------------------------
+// the meshes one after another, in both buffers
+//------------------------------------------------------------------------------------------
+void GeometryBuffer::repack()
+{
+    int numVertices = 0;
+    int numIndices = 0;
+
+    for(int i = 0; i < meshVertices.size(); ++i)
+    {
+        GeometryRange& range = ranges[i];
+        range.baseVertex = numVertices;
+        range.firstIndex = numIndices;
+        range.numVertices = meshVertices[i].size();
+        range.numIndices = meshIndices[i].size();
+
+        numVertices += range.numVertices;
+        numIndices += range.numIndices;
+    }
+
+    glFuncs->glBindVertexArray(vao);
+    glFuncs->glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glFuncs->glBufferData(GL_ARRAY_BUFFER, numVertices * sizeof(GeometryVertex), NULL,
+                          GL_STATIC_DRAW);
+    glFuncs->glBufferData(GL_ELEMENT_ARRAY_BUFFER, numIndices * sizeof(GLuint), NULL,
+                          GL_STATIC_DRAW);
+
+    for(int i = 0; i < meshVertices.size(); ++i)
+    {
+        const GeometryRange& range = ranges[i];
+        glFuncs->glBufferSubData(GL_ARRAY_BUFFER, range.baseVertex * sizeof(GeometryVertex),
+                                 range.numVertices * sizeof(GeometryVertex),
+                                 meshVertices[i].constData());
+        glFuncs->glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, range.firstIndex * sizeof(GLuint),
+                                 range.numIndices * sizeof(GLuint),
+                                 meshIndices[i].constData());
+    }
+
+    glFuncs->glBindVertexArray(0);
+    glFuncs->glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    dirtyMeshes.fill(0);
+    layoutChanged = false;
+
+    qDebug() << "GeometryBuffer:" << meshVertices.size() << "meshes," << numVertices
+             << "vertices," << numIndices << "indices";
+}
+
+//------------------------------------------------------------------------------------------
+// the per instance attribute is set by the instanced draws
+//------------------------------------------------------------------------------------------
+void GeometryBuffer::initVertexArrayObject()
+{
+    glFuncs->glBindVertexArray(vao);
+    glFuncs->glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glFuncs->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+
+    glFuncs->glEnableVertexAttribArray(GEOMETRY_ATTRIB_VERTEX);
+    glFuncs->glVertexAttribPointer(GEOMETRY_ATTRIB_VERTEX, 3, GL_FLOAT, GL_FALSE,
+                                   sizeof(GeometryVertex),
+                                   (const GLvoid*)offsetof(GeometryVertex, position));
+
+    glFuncs->glEnableVertexAttribArray(GEOMETRY_ATTRIB_NORMAL);
+    glFuncs->glVertexAttribPointer(GEOMETRY_ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE,
+                                   sizeof(GeometryVertex),
+                                   (const GLvoid*)offsetof(GeometryVertex, normal));
+
+    glFuncs->glEnableVertexAttribArray(GEOMETRY_ATTRIB_TEXCOORD);
+    glFuncs->glVertexAttribPointer(GEOMETRY_ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE,
+                                   sizeof(GeometryVertex),
+                                   (const GLvoid*)offsetof(GeometryVertex, texCoord));
+
+    // release vao before vbo and ibo
+    glFuncs->glBindVertexArray(0);
+    glFuncs->glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glFuncs->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,93 @@
+//------------------------------------------------------------------------------------------
+// geometrybuffer.h
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#ifndef GEOMETRYBUFFER_H
+#define GEOMETRYBUFFER_H
+
+#include <QtGui>
+#include <QOpenGLFunctions_4_0_Core>
+
+//------------------------------------------------------------------------------------------
+// the attribute locations, bound in all the programs before linking
+enum GeometryAttribute
+{
+    GEOMETRY_ATTRIB_VERTEX = 0,
+    GEOMETRY_ATTRIB_NORMAL,
+    GEOMETRY_ATTRIB_TEXCOORD,
+    GEOMETRY_ATTRIB_INSTANCE,
+    NUM_GEOMETRY_ATTRIBS
+};
+
+struct GeometryVertex
+{
+    GLfloat position[3];
+    GLfloat normal[3];
+    GLfloat texCoord[2];
+};
+
+// the part of the shared buffers used by a mesh, its indices start at 0
+struct GeometryRange
+{
+    GLint baseVertex;
+    GLuint firstIndex;
+    GLsizei numIndices;
+    GLsizei numVertices;
+};
+
+//------------------------------------------------------------------------------------------
+// All the meshes in one interleaved vertex buffer and one 32 bit index buffer, with a
+// single vertex array object: switching meshes only changes the index range and the base
+// vertex of the draw call.
+// The meshes are kept on the CPU. upload() repacks the buffers when a mesh changed its size
+// (or was added), otherwise it only rewrites the modified meshes in place.
+//------------------------------------------------------------------------------------------
+class GeometryBuffer
+{
+public:
+    GeometryBuffer();
+
+    void initialize(QOpenGLFunctions_4_0_Core* _glFuncs);
+    void destroy();
+
+    void resize(int _numMeshes);
+    int getNumMeshes() const;
+
+    // positions, normals and texture coordinates in separate arrays
+    void setMesh(int _mesh, const GLfloat* _vertices, const GLfloat* _normals,
+                 const GLfloat* _texCoords, int _numVertices,
+                 const GLushort* _indices, int _numIndices);
+    void setMesh(int _mesh, const GLfloat* _vertices, const GLfloat* _normals,
+                 const GLfloat* _texCoords, int _numVertices,
+                 const GLuint* _indices, int _numIndices);
+    void upload();
+
+    void bind();
+    void release();
+    void draw(int _mesh);
+    void drawInstanced(int _mesh, int _numInstances);
+    const GeometryRange& getRange(int _mesh) const;
+
+private:
+    void setVertices(int _mesh, const GLfloat* _vertices, const GLfloat* _normals,
+                     const GLfloat* _texCoords, int _numVertices, int _numIndices);
+    void repack();
+    void initVertexArrayObject();
+
+    QOpenGLFunctions_4_0_Core* glFuncs;
+    GLuint vertexBuffer;
+    GLuint indexBuffer;
+    GLuint vao;
+
+    QVector<QVector<GeometryVertex> > meshVertices;
+    QVector<QVector<GLuint> > meshIndices;
+    QVector<GeometryRange> ranges;
+    QVector<uchar> dirtyMeshes;
+    bool layoutChanged;
+};
+
+#endif // GEOMETRYBUFFER_H
@@ -0,0 +1,267 @@
+//------------------------------------------------------------------------------------------
+// gpuculler.cpp
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#include "gpuculler.h"
+#include "cpuprofiler.h"
+
+//------------------------------------------------------------------------------------------
+GPUCuller::GPUCuller():
+    glFuncs(NULL),
+    program(NULL),
+    uniFrustumPlanes(-1),
+    uniNumInstances(-1),
+    enabled(true),
+    commandTemplateBuffer(0),
+    commandBuffer(0),
+    instanceSlotBuffer(0),
+    instanceBoundsBuffer(0),
+    visibleInstanceBuffer(0)
+{
+}
+
+//------------------------------------------------------------------------------------------
+// returns false, and stays unsupported, if the context is older than GL 4.3
+//------------------------------------------------------------------------------------------
+bool GPUCuller::initialize(QOpenGLContext* _context)
+{
+    destroy();
+
+    if(_context->format().version() < qMakePair(4, 3))
+    {
+        qDebug() << "GPUCuller: OpenGL 4.3 is not available, the instances are culled on"
+                 << "the CPU.";
+        return false;
+    }
+
+    glFuncs = _context->versionFunctions<QOpenGLFunctions_4_3_Core>();
+
+    if(glFuncs == NULL || !glFuncs->initializeOpenGLFunctions())
+    {
+        glFuncs = NULL;
+        return false;
+    }
+
+    program = new QOpenGLShaderProgram;
+
+    if(!program->addShaderFromSourceFile(QOpenGLShader::Compute,
+                                         ":/shaders/cull-instances.cs.glsl") ||
+       !program->link())
+    {
+        qDebug() << "GPUCuller: cannot build the culling shader, the instances are culled"
+                 << "on the CPU.";
+        delete program;
+        program = NULL;
+        glFuncs = NULL;
+        return false;
+    }
+
+    uniFrustumPlanes = program->uniformLocation("frustumPlanes");
+    uniNumInstances = program->uniformLocation("numInstances");
+
+    glFuncs->glGenBuffers(1, &commandTemplateBuffer);
+    glFuncs->glGenBuffers(1, &commandBuffer);
+    glFuncs->glGenBuffers(1, &instanceSlotBuffer);
+    glFuncs->glGenBuffers(1, &instanceBoundsBuffer);
+    glFuncs->glGenBuffers(1, &visibleInstanceBuffer);
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+void GPUCuller::destroy()
+{
+    if(glFuncs == NULL)
+    {
+        return;
+    }
+
+    GLuint buffers[] =
+    {
+        commandTemplateBuffer, commandBuffer, instanceSlotBuffer, instanceBoundsBuffer,
+        visibleInstanceBuffer
+    };
+    glFuncs->glDeleteBuffers(sizeof(buffers) / sizeof(buffers[0]), buffers);
+
+    delete program;
+    program = NULL;
+    glFuncs = NULL;
+}
+
+//------------------------------------------------------------------------------------------
+void GPUCuller::setEnabled(bool _state)
+{
+    enabled = _state;
+}
+
+//------------------------------------------------------------------------------------------
+bool GPUCuller::isEnabled() const
+{
+    return (enabled && isSupported());
+}
+
+//------------------------------------------------------------------------------------------
+bool GPUCuller::isSupported() const
+{
+    return (glFuncs != NULL);
+}
+
+//------------------------------------------------------------------------------------------
+void GPUCuller::clear()
+{
+    commands.clear();
+    instanceSlots.clear();
+    instanceBounds.clear();
+}
+
+//------------------------------------------------------------------------------------------
+// returns the index of the draw, its instances start at the current number of instances
+//------------------------------------------------------------------------------------------
+int GPUCuller::addDraw(GLuint _numIndices, GLuint _firstIndex, GLint _baseVertex)
+{
+    DrawElementsIndirectCommand command;
+    command.count = _numIndices;
+    command.instanceCount = 0;
+    command.firstIndex = _firstIndex;
+    command.baseVertex = _baseVertex;
+    command.baseInstance = instanceBounds.size() / 2;
+    commands.append(command);
+
+    return commands.size() - 1;
+}
+
+//------------------------------------------------------------------------------------------
+void GPUCuller::addInstance(GLuint _record, const BoundingBox& _bounds)
+{
+    Q_ASSERT(!commands.isEmpty());
+
+    instanceSlots.append(commands.size() - 1);
+    instanceSlots.append(_record);
+    instanceBounds.append(QVector4D(_bounds.boxMin, 1.0f));
+    instanceBounds.append(QVector4D(_bounds.boxMax, 1.0f));
+}
+
+//------------------------------------------------------------------------------------------
+void GPUCuller::upload()
+{
+    if(!isSupported())
+    {
+        return;
+    }
+
+    PROFILE_ZONE("GPUCuller::upload");
+
+    int numInstances = instanceBounds.size() / 2;
+    int commandsSize = commands.size() * sizeof(DrawElementsIndirectCommand);
+
+    glFuncs->glBindBuffer(GL_COPY_WRITE_BUFFER, commandTemplateBuffer);
+    glFuncs->glBufferData(GL_COPY_WRITE_BUFFER, commandsSize, commands.constData(),
+                          GL_STATIC_DRAW);
+    glFuncs->glBindBuffer(GL_COPY_WRITE_BUFFER, commandBuffer);
+    glFuncs->glBufferData(GL_COPY_WRITE_BUFFER, commandsSize, NULL, GL_DYNAMIC_DRAW);
+    glFuncs->glBindBuffer(GL_COPY_WRITE_BUFFER, instanceSlotBuffer);
+    glFuncs->glBufferData(GL_COPY_WRITE_BUFFER, instanceSlots.size() * sizeof(GLuint),
+                          instanceSlots.constData(), GL_STATIC_DRAW);
+    glFuncs->glBindBuffer(GL_COPY_WRITE_BUFFER, instanceBoundsBuffer);
+    glFuncs->glBufferData(GL_COPY_WRITE_BUFFER, instanceBounds.size() * sizeof(QVector4D),
+                          instanceBounds.constData(), GL_STATIC_DRAW);
+    glFuncs->glBindBuffer(GL_COPY_WRITE_BUFFER, visibleInstanceBuffer);
+    glFuncs->glBufferData(GL_COPY_WRITE_BUFFER, numInstances * sizeof(GLuint), NULL,
+                          GL_DYNAMIC_DRAW);
+    glFuncs->glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+//------------------------------------------------------------------------------------------
+int GPUCuller::getNumDraws() const
+{
+    return commands.size();
+}
+
+//------------------------------------------------------------------------------------------
+// the results are ready for the following indirect draws, without any read back
+//------------------------------------------------------------------------------------------
+void GPUCuller::cull(const Frustum& _frustum)
+{
+    int numInstances = instanceBounds.size() / 2;
+
+    if(numInstances == 0)
+    {
+        return;
+    }
+
+    PROFILE_ZONE("GPUCuller::cull");
+
+    glFuncs->glBindBuffer(GL_COPY_READ_BUFFER, commandTemplateBuffer);
+    glFuncs->glBindBuffer(GL_COPY_WRITE_BUFFER, commandBuffer);
+    glFuncs->glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                                 commands.size() * sizeof(DrawElementsIndirectCommand));
+    glFuncs->glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glFuncs->glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    program->bind();
+    program->setUniformValueArray(uniFrustumPlanes, _frustum.planes, 6);
+    program->setUniformValue(uniNumInstances, numInstances);
+
+    glFuncs->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, instanceSlotBuffer);
+    glFuncs->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, instanceBoundsBuffer);
+    glFuncs->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, commandBuffer);
+    glFuncs->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, visibleInstanceBuffer);
+
+    glFuncs->glDispatchCompute((numInstances + GPU_CULLING_GROUP_SIZE - 1) /
+                               GPU_CULLING_GROUP_SIZE, 1, 1);
+    glFuncs->glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+
+    program->release();
+}
+
+//------------------------------------------------------------------------------------------
+// the sum of the instance counts written by the last cull(), waits for it
+//------------------------------------------------------------------------------------------
+int GPUCuller::readNumVisibleInstances()
+{
+    if(!isSupported() || commands.isEmpty())
+    {
+        return 0;
+    }
+
+    QVector<DrawElementsIndirectCommand> results(commands.size());
+
+    glFuncs->glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glFuncs->glBindBuffer(GL_COPY_READ_BUFFER, commandBuffer);
+    glFuncs->glGetBufferSubData(GL_COPY_READ_BUFFER, 0,
+                                results.size() * sizeof(DrawElementsIndirectCommand),
+                                results.data());
+    glFuncs->glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    int numVisible = 0;
+
+    for(int i = 0; i < results.size(); ++i)
+    {
+        numVisible += (int)results[i].instanceCount;
+    }
+
+    return numVisible;
+}
+
+//------------------------------------------------------------------------------------------
+// the vertex array object and the program must be bound
+//------------------------------------------------------------------------------------------
+void GPUCuller::multiDraw(int _firstDraw, int _numDraws)
+{
+    GLintptr offset = _firstDraw * sizeof(DrawElementsIndirectCommand);
+
+    glFuncs->glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    glFuncs->glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                         (const GLvoid*)offset, _numDraws, 0);
+    glFuncs->glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+//------------------------------------------------------------------------------------------
+GLuint GPUCuller::getVisibleInstanceBuffer() const
+{
+    return visibleInstanceBuffer;
+}
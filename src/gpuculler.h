@@ -0,0 +1,82 @@
+//------------------------------------------------------------------------------------------
+// gpuculler.h
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#ifndef GPUCULLER_H
+#define GPUCULLER_H
+
+#include <QtGui>
+#include <QOpenGLFunctions_4_3_Core>
+
+#include "scenebvh.h"
+
+//------------------------------------------------------------------------------------------
+#define GPU_CULLING_GROUP_SIZE 64
+
+// the layout read by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+//------------------------------------------------------------------------------------------
+// Frustum culling of the instances on the GPU, with a compute shader (GL 4.3).
+// The draws and their instances (record index and world bounds) are uploaded once. For
+// each pass, cull() resets the instance counts of the draw commands, then one thread per
+// instance tests its bounds against the frustum and appends the visible ones to the range
+// of its draw in the visible instance buffer (starting at the baseInstance of the draw).
+// multiDraw() submits a range of draws with a single glMultiDrawElementsIndirect, the
+// instance attribute must read the visible instance buffer with a divisor of 1.
+// Nothing is read back while rendering: the CPU does not know how many instances are
+// drawn. readNumVisibleInstances() stalls on the last cull, for the checks only.
+//------------------------------------------------------------------------------------------
+class GPUCuller
+{
+public:
+    GPUCuller();
+
+    bool initialize(QOpenGLContext* _context);
+    void destroy();
+    void setEnabled(bool _state);
+    bool isEnabled() const;
+    bool isSupported() const;
+
+    // the instances of a draw are added right after it
+    void clear();
+    int addDraw(GLuint _numIndices, GLuint _firstIndex, GLint _baseVertex);
+    void addInstance(GLuint _record, const BoundingBox& _bounds);
+    void upload();
+    int getNumDraws() const;
+
+    void cull(const Frustum& _frustum);
+    int readNumVisibleInstances();
+    void multiDraw(int _firstDraw, int _numDraws);
+    GLuint getVisibleInstanceBuffer() const;
+
+private:
+    QOpenGLFunctions_4_3_Core* glFuncs;
+    QOpenGLShaderProgram* program;
+    GLint uniFrustumPlanes;
+    GLint uniNumInstances;
+    bool enabled;
+
+    QVector<DrawElementsIndirectCommand> commands;
+    QVector<GLuint> instanceSlots;     // draw and record of each instance
+    QVector<QVector4D> instanceBounds; // world min and max of each instance
+
+    GLuint commandTemplateBuffer;      // the commands with no instance
+    GLuint commandBuffer;
+    GLuint instanceSlotBuffer;
+    GLuint instanceBoundsBuffer;
+    GLuint visibleInstanceBuffer;
+};
+
+#endif // GPUCULLER_H
@@ -0,0 +1,322 @@
+//------------------------------------------------------------------------------------------
+// gpuprofiler.cpp
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cmath>
+
+#include "gpuprofiler.h"
+
+//------------------------------------------------------------------------------------------
+GPUProfiler::GPUProfiler():
+    glFuncs(NULL),
+    currentFrame(0),
+    frameCounter(0),
+    numDroppedFrames(0),
+    enabled(false),
+    inFrame(false),
+    activePass(false),
+    nestedPassDepth(0)
+{
+}
+
+//------------------------------------------------------------------------------------------
+void GPUProfiler::initialize(QOpenGLFunctions_4_0_Core* _glFuncs)
+{
+    glFuncs = _glFuncs;
+}
+
+//------------------------------------------------------------------------------------------
+void GPUProfiler::setEnabled(bool _state)
+{
+    enabled = _state;
+}
+
+//------------------------------------------------------------------------------------------
+bool GPUProfiler::isEnabled() const
+{
+    return enabled;
+}
+
+//------------------------------------------------------------------------------------------
+// move to the next slot of the ring, read back the queries issued
+// GPU_PROFILER_FRAME_LATENCY frames ago
+//------------------------------------------------------------------------------------------
+void GPUProfiler::beginFrame()
+{
+    if(!enabled || !glFuncs)
+    {
+        return;
+    }
+
+    currentFrame = (currentFrame + 1) % GPU_PROFILER_FRAME_LATENCY;
+    ++frameCounter;
+
+    collectFrame(frames[currentFrame]);
+    inFrame = true;
+}
+
+//------------------------------------------------------------------------------------------
+void GPUProfiler::endFrame()
+{
+    if(activePass)
+    {
+        qDebug() << "GPUProfiler: frame ended with an active pass.";
+        glFuncs->glEndQuery(GL_TIME_ELAPSED);
+        activePass = false;
+    }
+
+    nestedPassDepth = 0;
+    inFrame = false;
+}
+
+//------------------------------------------------------------------------------------------
+void GPUProfiler::beginPass(const QString& _passName)
+{
+    if(!inFrame)
+    {
+        return;
+    }
+
+    if(activePass)
+    {
+        ++nestedPassDepth;
+        return;
+    }
+
+    FrameQueries& frame = frames[currentFrame];
+
+    if(frame.numUsedQueries == frame.queries.size())
+    {
+        GLuint query;
+        glFuncs->glGenQueries(1, &query);
+        frame.queries.append(query);
+        frame.passIds.append(-1);
+    }
+
+    frame.passIds[frame.numUsedQueries] = getPassId(_passName);
+    glFuncs->glBeginQuery(GL_TIME_ELAPSED, frame.queries[frame.numUsedQueries]);
+    ++frame.numUsedQueries;
+
+    activePass = true;
+}
+
+//------------------------------------------------------------------------------------------
+void GPUProfiler::endPass()
+{
+    if(!inFrame)
+    {
+        return;
+    }
+
+    if(nestedPassDepth > 0)
+    {
+        --nestedPassDepth;
+        return;
+    }
+
+    if(activePass)
+    {
+        glFuncs->glEndQuery(GL_TIME_ELAPSED);
+        activePass = false;
+    }
+}
+
+//------------------------------------------------------------------------------------------
+int GPUProfiler::getPassId(const QString& _passName)
+{
+    QHash<QString, int>::const_iterator it = passName2IdMap.constFind(_passName);
+
+    if(it != passName2IdMap.constEnd())
+    {
+        return it.value();
+    }
+
+    int passId = passNames.size();
+    passName2IdMap.insert(_passName, passId);
+    passNames.append(_passName);
+    passHistory.append(QVector<float>());
+    passHistory.last().reserve(GPU_PROFILER_HISTORY_SIZE);
+    passHistoryHead.append(0);
+    passLastFrame.append(frameCounter);
+
+    return passId;
+}
+
+//------------------------------------------------------------------------------------------
+// Every query of the frame must be available before any is read: GL does not guarantee
+// that the queries complete in the order they were issued. If one is not (very deep GPU
+// queue), drop the frame instead of stalling.
+//------------------------------------------------------------------------------------------
+void GPUProfiler::collectFrame(FrameQueries& _frame)
+{
+    for(int i = 0; i < _frame.numUsedQueries; ++i)
+    {
+        GLuint available = GL_FALSE;
+        glFuncs->glGetQueryObjectuiv(_frame.queries[i], GL_QUERY_RESULT_AVAILABLE,
+                                     &available);
+
+        if(available == GL_FALSE)
+        {
+            ++numDroppedFrames;
+            _frame.numUsedQueries = 0;
+            return;
+        }
+    }
+
+    for(int i = 0; i < _frame.numUsedQueries; ++i)
+    {
+        GLuint64 elapsedTime = 0;
+        glFuncs->glGetQueryObjectui64v(_frame.queries[i], GL_QUERY_RESULT, &elapsedTime);
+
+        int passId = _frame.passIds[i];
+        float time = (float)((double)elapsedTime * 1e-6);
+        QVector<float>& history = passHistory[passId];
+
+        if(history.size() < GPU_PROFILER_HISTORY_SIZE)
+        {
+            history.append(time);
+        }
+        else
+        {
+            history[passHistoryHead[passId]] = time;
+        }
+
+        passHistoryHead[passId] = (passHistoryHead[passId] + 1) % GPU_PROFILER_HISTORY_SIZE;
+        passLastFrame[passId] = frameCounter;
+    }
+
+    _frame.numUsedQueries = 0;
+}
+
+//------------------------------------------------------------------------------------------
+// times in milliseconds
+// passes which have not been rendered recently (e.g. the probes when the dynamic
+// environment mapping is disabled) are skipped
+//------------------------------------------------------------------------------------------
+QVector<GPUProfiler::PassStatistics> GPUProfiler::getStatistics() const
+{
+    QVector<PassStatistics> statistics;
+
+    for(int passId = 0; passId < passNames.size(); ++passId)
+    {
+        const QVector<float>& history = passHistory[passId];
+
+        if(history.isEmpty() ||
+           frameCounter - passLastFrame[passId] > 2 * GPU_PROFILER_FRAME_LATENCY)
+        {
+            continue;
+        }
+
+        QVector<float> samples = history;
+        std::sort(samples.begin(), samples.end());
+
+        float sum = 0.0f;
+
+        for(int i = 0; i < samples.size(); ++i)
+        {
+            sum += samples[i];
+        }
+
+        int lastSample = (passHistoryHead[passId] + history.size() - 1) % history.size();
+        int p95Index = (int)ceil(0.95f * (float)samples.size()) - 1;
+
+        PassStatistics passStatistics;
+        passStatistics.name = passNames[passId];
+        passStatistics.numSamples = samples.size();
+        passStatistics.minTime = samples.first();
+        passStatistics.avgTime = sum / (float)samples.size();
+        passStatistics.p95Time = samples[qMax(p95Index, 0)];
+        passStatistics.lastTime = history[lastSample];
+        statistics.append(passStatistics);
+    }
+
+    return statistics;
+}
+
+//------------------------------------------------------------------------------------------
+QStringList GPUProfiler::getSummary() const
+{
+    QStringList summary;
+    QVector<PassStatistics> statistics = getStatistics();
+
+    summary.append(QString("%1 %2 %3 %4").arg("GPU pass (ms)", -32)
+                   .arg("min", 7).arg("avg", 7).arg("p95", 7));
+
+    float totalTime = 0.0f;
+
+    for(int i = 0; i < statistics.size(); ++i)
+    {
+        const PassStatistics& pass = statistics[i];
+        summary.append(QString("%1 %2 %3 %4").arg(pass.name, -32)
+                       .arg(pass.minTime, 7, 'f', 3)
+                       .arg(pass.avgTime, 7, 'f', 3)
+                       .arg(pass.p95Time, 7, 'f', 3));
+        totalTime += pass.avgTime;
+    }
+
+    summary.append(QString("%1 %2").arg("total (avg)", -40).arg(totalTime, 7, 'f', 3));
+
+    if(numDroppedFrames > 0)
+    {
+        summary.append(QString("dropped frames: %1").arg(numDroppedFrames));
+    }
+
+    return summary;
+}
+
+//------------------------------------------------------------------------------------------
+bool GPUProfiler::saveCSV(const QString& _fileName) const
+{
+    QFile file(_fileName);
+
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        qDebug() << "GPUProfiler: cannot open file for writing:" << _fileName;
+        return false;
+    }
+
+    QTextStream stream(&file);
+    stream << "pass,samples,min_ms,avg_ms,p95_ms,last_ms\n";
+
+    QVector<PassStatistics> statistics = getStatistics();
+
+    for(int i = 0; i < statistics.size(); ++i)
+    {
+        const PassStatistics& pass = statistics[i];
+        stream << "\"" << pass.name << "\","
+               << pass.numSamples << ","
+               << pass.minTime << ","
+               << pass.avgTime << ","
+               << pass.p95Time << ","
+               << pass.lastTime << "\n";
+    }
+
+    file.close();
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+// clear the timings and forget the queries still in the ring (issued before a disable),
+// the query objects are kept for reuse
+//------------------------------------------------------------------------------------------
+void GPUProfiler::reset()
+{
+    for(int i = 0; i < passHistory.size(); ++i)
+    {
+        passHistory[i].clear();
+        passHistoryHead[i] = 0;
+    }
+
+    for(int i = 0; i < GPU_PROFILER_FRAME_LATENCY; ++i)
+    {
+        frames[i].numUsedQueries = 0;
+    }
+
+    currentFrame = 0;
+    numDroppedFrames = 0;
+}
@@ -0,0 +1,88 @@
+//------------------------------------------------------------------------------------------
+// gpuprofiler.h
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#ifndef GPUPROFILER_H
+#define GPUPROFILER_H
+
+#include <QtGui>
+#include <QOpenGLFunctions_4_0_Core>
+
+//------------------------------------------------------------------------------------------
+// number of frames the queries stay in flight before they are read back
+#define GPU_PROFILER_FRAME_LATENCY 4
+// number of samples kept per pass for the rolling statistics
+#define GPU_PROFILER_HISTORY_SIZE 120
+
+//------------------------------------------------------------------------------------------
+// Measure the GPU time of each render pass with GL_TIME_ELAPSED queries.
+// The queries of a frame are kept in a ring of GPU_PROFILER_FRAME_LATENCY frames and are
+// read back only when the ring wraps around, so reading the results never stalls the
+// pipeline.
+// GL_TIME_ELAPSED queries cannot be nested: a pass started while another pass is active is
+// accounted to the outer pass (e.g. the objects rendered into a cube map face).
+//------------------------------------------------------------------------------------------
+class GPUProfiler
+{
+public:
+    struct PassStatistics
+    {
+        QString name;
+        int numSamples;
+        float minTime;
+        float avgTime;
+        float p95Time;
+        float lastTime;
+    };
+
+    GPUProfiler();
+
+    void initialize(QOpenGLFunctions_4_0_Core* _glFuncs);
+    void setEnabled(bool _state);
+    bool isEnabled() const;
+
+    void beginFrame();
+    void endFrame();
+    void beginPass(const QString& _passName);
+    void endPass();
+
+    QVector<PassStatistics> getStatistics() const;
+    QStringList getSummary() const;
+    bool saveCSV(const QString& _fileName) const;
+    void reset();
+
+private:
+    struct FrameQueries
+    {
+        FrameQueries(): numUsedQueries(0) {}
+
+        QVector<GLuint> queries;
+        QVector<int> passIds;
+        int numUsedQueries;
+    };
+
+    int getPassId(const QString& _passName);
+    void collectFrame(FrameQueries& _frame);
+
+    QOpenGLFunctions_4_0_Core* glFuncs;
+    FrameQueries frames[GPU_PROFILER_FRAME_LATENCY];
+    int currentFrame;
+    int frameCounter;
+    int numDroppedFrames;
+    bool enabled;
+    bool inFrame;
+    bool activePass;
+    int nestedPassDepth;
+
+    QHash<QString, int> passName2IdMap;
+    QVector<QString> passNames;
+    QVector<QVector<float> > passHistory;
+    QVector<int> passHistoryHead;
+    QVector<int> passLastFrame;
+};
+
+#endif // GPUPROFILER_H
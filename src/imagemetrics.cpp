@@ -0,0 +1,226 @@
+//------------------------------------------------------------------------------------------
+// imagemetrics.cpp
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#include "imagemetrics.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGE_METRICS_USE_SSE
+#include <emmintrin.h>
+#endif
+
+//------------------------------------------------------------------------------------------
+// mean squared error per RGB channel, in [0, 255^2]; -1 if the sizes differ
+//------------------------------------------------------------------------------------------
+double ImageMetrics::computeMSE(const QImage& _image, const QImage& _reference)
+{
+    if(_image.isNull() || _image.size() != _reference.size())
+    {
+        qDebug() << "ImageMetrics: the images must have the same size.";
+        return -1.0;
+    }
+
+    QImage image = _image.convertToFormat(QImage::Format_RGB32);
+    QImage reference = _reference.convertToFormat(QImage::Format_RGB32);
+    int width = image.width();
+    int height = image.height();
+    qint64 sum = 0;
+
+    for(int y = 0; y < height; ++y)
+    {
+        const uchar* row = image.constScanLine(y);
+        const uchar* refRow = reference.constScanLine(y);
+        int x = 0;
+
+#ifdef IMAGE_METRICS_USE_SSE
+        // 4 pixels per iteration: the bytes are widened to 16 bits, the squared
+        // differences are summed pairwise to 32 bits (the alpha bytes are both 0xff).
+        // The 32 bit sums of one row cannot overflow below 32K pixels.
+        __m128i zero = _mm_setzero_si128();
+        __m128i rowSum = zero;
+
+        for(; x + 4 <= width; x += 4)
+        {
+            const __m128i* pixelData = reinterpret_cast<const __m128i*>(row + x * 4);
+            const __m128i* refPixelData = reinterpret_cast<const __m128i*>(refRow + x * 4);
+            __m128i pixels = _mm_loadu_si128(pixelData);
+            __m128i refPixels = _mm_loadu_si128(refPixelData);
+
+            __m128i diffLo = _mm_sub_epi16(_mm_unpacklo_epi8(pixels, zero),
+                                           _mm_unpacklo_epi8(refPixels, zero));
+            __m128i diffHi = _mm_sub_epi16(_mm_unpackhi_epi8(pixels, zero),
+                                           _mm_unpackhi_epi8(refPixels, zero));
+
+            rowSum = _mm_add_epi32(rowSum, _mm_madd_epi16(diffLo, diffLo));
+            rowSum = _mm_add_epi32(rowSum, _mm_madd_epi16(diffHi, diffHi));
+        }
+
+        qint32 lanes[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), rowSum);
+        sum += (qint64)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+
+        for(; x < width; ++x)
+        {
+            for(int channel = 0; channel < 3; ++channel)
+            {
+                int diff = (int)row[x * 4 + channel] - (int)refRow[x * 4 + channel];
+                sum += diff * diff;
+            }
+        }
+    }
+
+    return (double)sum / ((double)width * (double)height * 3.0);
+}
+
+//------------------------------------------------------------------------------------------
+double ImageMetrics::computePSNR(const QImage& _image, const QImage& _reference)
+{
+    double mse = computeMSE(_image, _reference);
+
+    if(mse < 0.0)
+    {
+        return 0.0;
+    }
+
+    if(mse == 0.0)
+    {
+        return IMAGE_METRICS_MAX_PSNR;
+    }
+
+    return qMin(IMAGE_METRICS_MAX_PSNR, 10.0 * log10(255.0 * 255.0 / mse));
+}
+
+//------------------------------------------------------------------------------------------
+// mean SSIM of the luma windows, in [-1, 1]; 0 if the sizes differ
+//------------------------------------------------------------------------------------------
+double ImageMetrics::computeSSIM(const QImage& _image, const QImage& _reference)
+{
+    if(_image.isNull() || _image.size() != _reference.size())
+    {
+        qDebug() << "ImageMetrics: the images must have the same size.";
+        return 0.0;
+    }
+
+    int width = _image.width();
+    int height = _image.height();
+
+    if(width < SSIM_WINDOW_SIZE || height < SSIM_WINDOW_SIZE)
+    {
+        return (computeMSE(_image, _reference) == 0.0) ? 1.0 : 0.0;
+    }
+
+    QVector<float> luma = computeLuma(_image);
+    QVector<float> refLuma = computeLuma(_reference);
+
+    const float c1 = (0.01f * 255.0f) * (0.01f * 255.0f);
+    const float c2 = (0.03f * 255.0f) * (0.03f * 255.0f);
+    const float numPixels = (float)(SSIM_WINDOW_SIZE * SSIM_WINDOW_SIZE);
+
+    double ssimSum = 0.0;
+    int numWindows = 0;
+
+    for(int y0 = 0; y0 + SSIM_WINDOW_SIZE <= height; y0 += SSIM_WINDOW_STRIDE)
+    {
+        for(int x0 = 0; x0 + SSIM_WINDOW_SIZE <= width; x0 += SSIM_WINDOW_STRIDE)
+        {
+            float sums[5]; // x, y, xx, yy, xy
+
+#ifdef IMAGE_METRICS_USE_SSE
+            // one window row is 2 x 4 floats
+            __m128 sumX = _mm_setzero_ps();
+            __m128 sumY = _mm_setzero_ps();
+            __m128 sumXX = _mm_setzero_ps();
+            __m128 sumYY = _mm_setzero_ps();
+            __m128 sumXY = _mm_setzero_ps();
+
+            for(int y = y0; y < y0 + SSIM_WINDOW_SIZE; ++y)
+            {
+                const float* row = luma.constData() + (qint64)y * width + x0;
+                const float* refRow = refLuma.constData() + (qint64)y * width + x0;
+
+                for(int i = 0; i < SSIM_WINDOW_SIZE; i += 4)
+                {
+                    __m128 x = _mm_loadu_ps(row + i);
+                    __m128 r = _mm_loadu_ps(refRow + i);
+
+                    sumX = _mm_add_ps(sumX, x);
+                    sumY = _mm_add_ps(sumY, r);
+                    sumXX = _mm_add_ps(sumXX, _mm_mul_ps(x, x));
+                    sumYY = _mm_add_ps(sumYY, _mm_mul_ps(r, r));
+                    sumXY = _mm_add_ps(sumXY, _mm_mul_ps(x, r));
+                }
+            }
+
+            __m128 horizontalSums[5] = {sumX, sumY, sumXX, sumYY, sumXY};
+
+            for(int i = 0; i < 5; ++i)
+            {
+                float lanes[4];
+                _mm_storeu_ps(lanes, horizontalSums[i]);
+                sums[i] = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+            }
+
+#else
+            memset(sums, 0, sizeof(sums));
+
+            for(int y = y0; y < y0 + SSIM_WINDOW_SIZE; ++y)
+            {
+                const float* row = luma.constData() + (qint64)y * width + x0;
+                const float* refRow = refLuma.constData() + (qint64)y * width + x0;
+
+                for(int i = 0; i < SSIM_WINDOW_SIZE; ++i)
+                {
+                    sums[0] += row[i];
+                    sums[1] += refRow[i];
+                    sums[2] += row[i] * row[i];
+                    sums[3] += refRow[i] * refRow[i];
+                    sums[4] += row[i] * refRow[i];
+                }
+            }
+
+#endif
+            float meanX = sums[0] / numPixels;
+            float meanY = sums[1] / numPixels;
+            float varianceX = qMax(0.0f, sums[2] / numPixels - meanX * meanX);
+            float varianceY = qMax(0.0f, sums[3] / numPixels - meanY * meanY);
+            float covariance = sums[4] / numPixels - meanX * meanY;
+
+            ssimSum += (double)((2.0f * meanX * meanY + c1) * (2.0f * covariance + c2)) /
+                       (double)((meanX * meanX + meanY * meanY + c1) *
+                                (varianceX + varianceY + c2));
+            ++numWindows;
+        }
+    }
+
+    return ssimSum / (double)numWindows;
+}
+
+//------------------------------------------------------------------------------------------
+// BT.601 luma in [0, 255]
+//------------------------------------------------------------------------------------------
+QVector<float> ImageMetrics::computeLuma(const QImage& _image)
+{
+    QImage image = _image.convertToFormat(QImage::Format_RGB32);
+    int width = image.width();
+    int height = image.height();
+    QVector<float> luma(width * height);
+
+    for(int y = 0; y < height; ++y)
+    {
+        const QRgb* row = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        float* lumaRow = luma.data() + (qint64)y * width;
+
+        for(int x = 0; x < width; ++x)
+        {
+            lumaRow[x] = 0.299f * (float)qRed(row[x]) + 0.587f * (float)qGreen(row[x]) +
+                         0.114f * (float)qBlue(row[x]);
+        }
+    }
+
+    return luma;
+}
@@ -0,0 +1,37 @@
+//------------------------------------------------------------------------------------------
+// imagemetrics.h
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#ifndef IMAGEMETRICS_H
+#define IMAGEMETRICS_H
+
+#include <QtGui>
+
+//------------------------------------------------------------------------------------------
+// PSNR of identical images
+#define IMAGE_METRICS_MAX_PSNR 100.0
+#define SSIM_WINDOW_SIZE 8
+#define SSIM_WINDOW_STRIDE 4
+
+//------------------------------------------------------------------------------------------
+// Image differences, for the comparison of the rendering configurations.
+// The images must have the same size; they are converted to RGB32 (alpha is ignored).
+// PSNR is computed on the RGB channels, SSIM on the luma of 8x8 windows every 4 pixels.
+// The inner loops use SSE2 when available.
+//------------------------------------------------------------------------------------------
+class ImageMetrics
+{
+public:
+    static double computeMSE(const QImage& _image, const QImage& _reference);
+    static double computePSNR(const QImage& _image, const QImage& _reference);
+    static double computeSSIM(const QImage& _image, const QImage& _reference);
+
+private:
+    static QVector<float> computeLuma(const QImage& _image);
+};
+
+#endif // IMAGEMETRICS_H
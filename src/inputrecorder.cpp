@@ -0,0 +1,249 @@
+//------------------------------------------------------------------------------------------
+// inputrecorder.cpp
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#include "inputrecorder.h"
+
+//------------------------------------------------------------------------------------------
+int InputEvent::getNumValues(InputEventType _type)
+{
+    switch(_type)
+    {
+    case INPUT_MOUSE_PRESS:
+    case INPUT_CUBE_COLOR:
+        return 3;
+
+    case INPUT_MOUSE_MOVE:
+    case INPUT_SPHERE_RESOLUTION:
+        return 2;
+
+    case INPUT_MOUSE_RELEASE:
+    case INPUT_RESET_CAMERA:
+    case INPUT_RESET_OBJECTS:
+        return 0;
+
+    default:
+        return 1;
+    }
+}
+
+//------------------------------------------------------------------------------------------
+static QDataStream& operator<<(QDataStream& _stream, const InputSessionState& _state)
+{
+    _stream << _state.cameraPosition << _state.cameraFocus << _state.cameraUpDirection
+            << _state.translation << _state.rotation << _state.zooming
+            << _state.cubeModelMatrix << _state.semiReflectiveSphereModelMatrix
+            << _state.cubeColor << _state.sphereReflection
+            << _state.planeSize << _state.sphereNumStacks << _state.sphereNumSlices
+            << _state.floorTextureFiltering
+            << _state.enabledDepthTest << _state.enabledZAxisRotation
+            << _state.enabledObjectTransformation << _state.enabledDynamicEnvMapping
+            << _state.enabledBackgroundRendering
+            << _state.enabledTextureAnisotropicFiltering;
+
+    return _stream;
+}
+
+//------------------------------------------------------------------------------------------
+static QDataStream& operator>>(QDataStream& _stream, InputSessionState& _state)
+{
+    _stream >> _state.cameraPosition >> _state.cameraFocus >> _state.cameraUpDirection
+            >> _state.translation >> _state.rotation >> _state.zooming
+            >> _state.cubeModelMatrix >> _state.semiReflectiveSphereModelMatrix
+            >> _state.cubeColor >> _state.sphereReflection
+            >> _state.planeSize >> _state.sphereNumStacks >> _state.sphereNumSlices
+            >> _state.floorTextureFiltering
+            >> _state.enabledDepthTest >> _state.enabledZAxisRotation
+            >> _state.enabledObjectTransformation >> _state.enabledDynamicEnvMapping
+            >> _state.enabledBackgroundRendering
+            >> _state.enabledTextureAnisotropicFiltering;
+
+    return _stream;
+}
+
+//------------------------------------------------------------------------------------------
+InputRecorder::InputRecorder():
+    numEvents(0)
+{
+}
+
+//------------------------------------------------------------------------------------------
+InputRecorder::~InputRecorder()
+{
+    stop();
+}
+
+//------------------------------------------------------------------------------------------
+bool InputRecorder::start(const QString& _fileName, const InputSessionState& _state)
+{
+    stop();
+
+    file.setFileName(_fileName);
+
+    if(!file.open(QIODevice::WriteOnly))
+    {
+        qDebug() << "InputRecorder: cannot open file for writing:" << _fileName;
+        return false;
+    }
+
+    stream.setDevice(&file);
+    stream.setVersion(QDataStream::Qt_5_4);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    stream << (quint32)INPUT_SESSION_MAGIC << (quint16)INPUT_SESSION_VERSION << _state;
+
+    numEvents = 0;
+    sessionTimer.start();
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+void InputRecorder::record(InputEvent _event)
+{
+    if(!isRecording())
+    {
+        return;
+    }
+
+    stream << sessionTimer.nsecsElapsed() << (quint8)_event.type;
+
+    for(int i = 0; i < InputEvent::getNumValues(_event.type); ++i)
+    {
+        stream << _event.values[i];
+    }
+
+    ++numEvents;
+}
+
+//------------------------------------------------------------------------------------------
+void InputRecorder::stop()
+{
+    if(!isRecording())
+    {
+        return;
+    }
+
+    stream.setDevice(NULL);
+    file.close();
+
+    qDebug() << "InputRecorder:" << numEvents << "events saved to" << file.fileName();
+}
+
+//------------------------------------------------------------------------------------------
+bool InputRecorder::isRecording() const
+{
+    return file.isOpen();
+}
+
+//------------------------------------------------------------------------------------------
+int InputRecorder::getNumEvents() const
+{
+    return numEvents;
+}
+
+//------------------------------------------------------------------------------------------
+InputReplayer::InputReplayer():
+    nextEvent(0)
+{
+}
+
+//------------------------------------------------------------------------------------------
+bool InputReplayer::load(const QString& _fileName)
+{
+    QFile file(_fileName);
+
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        qDebug() << "InputReplayer: cannot open file:" << _fileName;
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_4);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    quint32 magic;
+    quint16 version;
+    stream >> magic >> version;
+
+    if(magic != INPUT_SESSION_MAGIC || version != INPUT_SESSION_VERSION)
+    {
+        qDebug() << "InputReplayer: invalid session file:" << _fileName;
+        return false;
+    }
+
+    stream >> initialState;
+
+    events.clear();
+    nextEvent = 0;
+
+    while(!stream.atEnd())
+    {
+        qint64 timestamp;
+        quint8 type;
+        stream >> timestamp >> type;
+
+        if(stream.status() != QDataStream::Ok || type >= NUM_INPUT_EVENT_TYPES)
+        {
+            qDebug() << "InputReplayer: truncated session file:" << _fileName;
+            break;
+        }
+
+        InputEvent event(static_cast<InputEventType>(type));
+        event.timestamp = timestamp;
+
+        for(int i = 0; i < InputEvent::getNumValues(event.type); ++i)
+        {
+            stream >> event.values[i];
+        }
+
+        events.append(event);
+    }
+
+    return (stream.status() == QDataStream::Ok || !events.isEmpty());
+}
+
+//------------------------------------------------------------------------------------------
+const InputSessionState& InputReplayer::getInitialState() const
+{
+    return initialState;
+}
+
+//------------------------------------------------------------------------------------------
+// pop the events in their recorded order, the frames included
+//------------------------------------------------------------------------------------------
+bool InputReplayer::getNextEvent(InputEvent& _event)
+{
+    if(nextEvent >= events.size())
+    {
+        return false;
+    }
+
+    _event = events[nextEvent];
+    ++nextEvent;
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+bool InputReplayer::isFinished() const
+{
+    return (nextEvent >= events.size());
+}
+
+//------------------------------------------------------------------------------------------
+qint64 InputReplayer::getDuration() const
+{
+    return events.isEmpty() ? 0 : events.last().timestamp;
+}
+
+//------------------------------------------------------------------------------------------
+int InputReplayer::getNumEvents() const
+{
+    return events.size();
+}
@@ -0,0 +1,140 @@
+//------------------------------------------------------------------------------------------
+// inputrecorder.h
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#ifndef INPUTRECORDER_H
+#define INPUTRECORDER_H
+
+#include <QtGui>
+
+//------------------------------------------------------------------------------------------
+#define INPUT_SESSION_MAGIC 0x524D4953 // "RMIS"
+#define INPUT_SESSION_VERSION 2
+// simulation time step of the replayed frames after the last recorded one
+#define REPLAY_FRAME_TIME (1.0f / 60.0f)
+
+//------------------------------------------------------------------------------------------
+// Everything which changes the camera, the objects or the rendering options goes through
+// one of these events, so a session can be recorded and replayed.
+// Input events are stored at the level of the action they trigger (e.g. the wheel and the
+// +/- keys are both a zoom), GUI slots with their arguments.
+//------------------------------------------------------------------------------------------
+enum InputEventType
+{
+    INPUT_MOUSE_PRESS = 0,          // x, y, mouse button
+    INPUT_MOUSE_MOVE,               // x, y
+    INPUT_MOUSE_RELEASE,
+    INPUT_ZOOM,                     // zooming delta
+    INPUT_SPECIAL_KEY,              // special key
+    INPUT_RESET_CAMERA,
+    INPUT_RESET_OBJECTS,
+    INPUT_DEPTH_TEST,               // state
+    INPUT_Z_AXIS_ROTATION,          // state
+    INPUT_OBJECT_TRANSFORMATION,    // state
+    INPUT_DYNAMIC_ENV_MAPPING,      // state
+    INPUT_BACKGROUND_RENDERING,     // state
+    INPUT_ANISOTROPIC_FILTERING,    // state
+    INPUT_PLANE_SIZE,               // plane size
+    INPUT_SPHERE_RESOLUTION,        // stacks, slices
+    INPUT_SPHERE_REFLECTION,        // reflection percentage
+    INPUT_CUBE_COLOR,               // r, g, b
+    INPUT_FLOOR_TEXTURE_FILTERING,  // QOpenGLTexture::Filter
+    INPUT_FRAME,                    // frame time (s), at the beginning of each frame
+    NUM_INPUT_EVENT_TYPES
+};
+
+struct InputEvent
+{
+    InputEvent(InputEventType _type = INPUT_MOUSE_RELEASE, float _value0 = 0.0f,
+               float _value1 = 0.0f, float _value2 = 0.0f):
+        timestamp(0),
+        type(_type)
+    {
+        values[0] = _value0;
+        values[1] = _value1;
+        values[2] = _value2;
+    }
+
+    static int getNumValues(InputEventType _type);
+
+    qint64 timestamp; // nanoseconds since the beginning of the session
+    InputEventType type;
+    float values[3];
+};
+
+//------------------------------------------------------------------------------------------
+// state of the renderer at the beginning of a session
+//------------------------------------------------------------------------------------------
+struct InputSessionState
+{
+    QVector3D cameraPosition;
+    QVector3D cameraFocus;
+    QVector3D cameraUpDirection;
+    QVector3D translation;          // the motion still going on, by inertia
+    QVector3D rotation;
+    float zooming;
+    QMatrix4x4 cubeModelMatrix;
+    QMatrix4x4 semiReflectiveSphereModelMatrix;
+    QVector4D cubeColor;
+    float sphereReflection;
+    qint32 planeSize;
+    qint32 sphereNumStacks;
+    qint32 sphereNumSlices;
+    qint32 floorTextureFiltering;
+    bool enabledDepthTest;
+    bool enabledZAxisRotation;
+    bool enabledObjectTransformation;
+    bool enabledDynamicEnvMapping;
+    bool enabledBackgroundRendering;
+    bool enabledTextureAnisotropicFiltering;
+};
+
+//------------------------------------------------------------------------------------------
+// Binary session file:
+//   header: magic, version, initial state
+//   events: time since the beginning of the session (qint64, nanoseconds), type (quint8),
+//           then the values of the event type (float each)
+//------------------------------------------------------------------------------------------
+class InputRecorder
+{
+public:
+    InputRecorder();
+    ~InputRecorder();
+
+    bool start(const QString& _fileName, const InputSessionState& _state);
+    void record(InputEvent _event);
+    void stop();
+    bool isRecording() const;
+    int getNumEvents() const;
+
+private:
+    QFile file;
+    QDataStream stream;
+    QElapsedTimer sessionTimer;
+    int numEvents;
+};
+
+//------------------------------------------------------------------------------------------
+class InputReplayer
+{
+public:
+    InputReplayer();
+
+    bool load(const QString& _fileName);
+    const InputSessionState& getInitialState() const;
+    bool getNextEvent(InputEvent& _event);
+    bool isFinished() const;
+    qint64 getDuration() const;
+    int getNumEvents() const;
+
+private:
+    InputSessionState initialState;
+    QVector<InputEvent> events;
+    int nextEvent;
+};
+
+#endif // INPUTRECORDER_H
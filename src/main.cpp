@@ -11,22 +11,380 @@
 #include <QtOpenGL/qgl.h>
 
 #include "mainwindow.h"
+#include "cpuprofiler.h"
+#include "benchmark.h"
+#include "qualityharness.h"
+#include "tiledrenderer.h"
+#include "probebaker.h"
+#include "scenedescription.h"
+#include "offscreencontext.h"
 
+//------------------------------------------------------------------------------------------
+// the headless modes do not need any display: use the offscreen platform when there is none
+//------------------------------------------------------------------------------------------
+static void selectHeadlessPlatform(int argc, char* argv[])
+{
+    bool headless = false;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        QByteArray argument(argv[i]);
+
+        if(argument == "--benchmark" || argument == "--quality" ||
+           argument == "--tiled-render" || argument == "--reference" ||
+           argument == "--bake-probes" || argument == "--save-scene" ||
+           argument == "--check-gpu-culling")
+        {
+            headless = true;
+        }
+    }
+
+#ifdef Q_OS_LINUX
+
+    if(headless && qgetenv("QT_QPA_PLATFORM").isEmpty() &&
+       qgetenv("DISPLAY").isEmpty() && qgetenv("WAYLAND_DISPLAY").isEmpty())
+    {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+#else
+    Q_UNUSED(headless);
+#endif
+}
+
+//------------------------------------------------------------------------------------------
+static bool parseFrameSize(const QString& _str, int& _width, int& _height)
+{
+    QStringList size = _str.split('x');
+
+    if(size.size() != 2)
+    {
+        return false;
+    }
+
+    _width = size[0].toInt();
+    _height = size[1].toInt();
+
+    return (_width > 0 && _height > 0);
+}
+
+//------------------------------------------------------------------------------------------
 int main(int argc, char *argv[])
 {
+    selectHeadlessPlatform(argc, argv);
     QApplication a(argc, argv);
 
+    // record the initialization zones as well
+    if(qgetenv("REFLECTION_MAPPING_CPU_PROFILER") == "1")
+    {
+        CPUProfiler::setEnabled(true);
+    }
+
     QSurfaceFormat format;
     format.setVersion(4, 0);
     format.setSwapBehavior(QSurfaceFormat::DoubleBuffer);
     format.setProfile(QSurfaceFormat::CoreProfile);
     QSurfaceFormat::setDefaultFormat(format);
 
+    ////////////////////////////////////////////////////////////////////////////////
+    // command line
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Cube Mapping + Reflection Mapping");
+    parser.addHelpOption();
+
+    QCommandLineOption benchmarkOption("benchmark",
+                                       "Run the benchmark scenarios offscreen and exit.");
+    QCommandLineOption qualityOption("quality",
+                                     "Compare the image quality and frame time of "
+                                     "rendering configurations offscreen and exit.");
+    QCommandLineOption configurationsOption("configurations",
+                                            "Configuration file of the quality "
+                                            "comparison (JSON).",
+                                            "file");
+    QCommandLineOption scenariosOption("scenarios",
+                                       "Benchmark scenario file (JSON).", "file");
+    QCommandLineOption outputOption("output",
+                                    "Output file of the benchmark or quality results "
+                                    "(JSON).",
+                                    "file");
+    QCommandLineOption sizeOption("size", "Offscreen frame size.", "WxH");
+    QCommandLineOption tiledRenderOption("tiled-render",
+                                         "Render one image of --size tile by tile "
+                                         "(.tif or .ppm) and exit.",
+                                         "file");
+    QCommandLineOption tileSizeOption("tile-size", "Tile size of the tiled rendering.",
+                                      "pixels");
+    QCommandLineOption referenceOption("reference",
+                                       "Ray trace a reference image of --size on the CPU "
+                                       "and exit.",
+                                       "file");
+    QCommandLineOption bouncesOption("bounces",
+                                     "Maximum number of reflections of the ray tracer.",
+                                     "number");
+    QCommandLineOption sppOption("spp", "Samples per pixel of the ray tracer.", "number");
+    QCommandLineOption threadsOption("threads",
+                                     "Number of threads of the ray tracer "
+                                     "(all the cores by default).",
+                                     "number");
+    QCommandLineOption bakeProbesOption("bake-probes",
+                                        "Ray trace the cube maps of the reflective objects "
+                                        "into a directory and exit.",
+                                        "directory");
+    QCommandLineOption probeSizeOption("probe-size", "Face size of the baked cube maps.",
+                                       "pixels");
+    QCommandLineOption staticProbesOption("static-probes",
+                                          "Use the cube maps baked into a directory.",
+                                          "directory");
+    QCommandLineOption sceneOption("scene", "Load a scene file (JSON or binary).", "file");
+    QCommandLineOption saveSceneOption("save-scene",
+                                       "Save --scene, or the default scene, to a file "
+                                       "(JSON if .json, binary otherwise) and exit.",
+                                       "file");
+    QCommandLineOption spheresOption("spheres",
+                                     "Add a population of small spheres to the scene "
+                                     "saved by --save-scene.",
+                                     "number");
+    QCommandLineOption checkGPUCullingOption("check-gpu-culling",
+                                             "Compare the instances of --scene culled "
+                                             "on the CPU and on the GPU, offscreen, "
+                                             "and exit.");
+    QCommandLineOption recordOption("record",
+                                    "Record the input session to a file.", "file");
+    QCommandLineOption replayOption("replay",
+                                    "Replay a recorded input session with its frame times.",
+                                    "file");
+    QCommandLineOption exitAfterReplayOption("exit-after-replay",
+                                             "Quit when the replayed session is finished.");
+
+    parser.addOption(benchmarkOption);
+    parser.addOption(qualityOption);
+    parser.addOption(configurationsOption);
+    parser.addOption(scenariosOption);
+    parser.addOption(outputOption);
+    parser.addOption(sizeOption);
+    parser.addOption(tiledRenderOption);
+    parser.addOption(tileSizeOption);
+    parser.addOption(referenceOption);
+    parser.addOption(bouncesOption);
+    parser.addOption(sppOption);
+    parser.addOption(threadsOption);
+    parser.addOption(bakeProbesOption);
+    parser.addOption(probeSizeOption);
+    parser.addOption(staticProbesOption);
+    parser.addOption(sceneOption);
+    parser.addOption(saveSceneOption);
+    parser.addOption(spheresOption);
+    parser.addOption(checkGPUCullingOption);
+    parser.addOption(recordOption);
+    parser.addOption(replayOption);
+    parser.addOption(exitAfterReplayOption);
+    parser.process(a);
+
+    if(parser.isSet(benchmarkOption))
+    {
+        Benchmark benchmark;
+
+        if(parser.isSet(scenariosOption) &&
+           !benchmark.loadScenarios(parser.value(scenariosOption)))
+        {
+            return EXIT_FAILURE;
+        }
+
+        int width, height;
+
+        if(parser.isSet(sizeOption))
+        {
+            TRUE_OR_DIE(parseFrameSize(parser.value(sizeOption), width, height),
+                        "Invalid frame size, expected WxH.");
+            benchmark.setFrameSize(width, height);
+        }
+
+        return benchmark.run(parser.value(outputOption)) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if(parser.isSet(qualityOption))
+    {
+        QualityHarness qualityHarness;
+
+        if(parser.isSet(configurationsOption) &&
+           !qualityHarness.loadConfigurations(parser.value(configurationsOption)))
+        {
+            return EXIT_FAILURE;
+        }
+
+        int width, height;
+
+        if(parser.isSet(sizeOption))
+        {
+            TRUE_OR_DIE(parseFrameSize(parser.value(sizeOption), width, height),
+                        "Invalid frame size, expected WxH.");
+            qualityHarness.setFrameSize(width, height);
+        }
+
+        return qualityHarness.run(parser.value(outputOption)) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if(parser.isSet(tiledRenderOption))
+    {
+        TiledRenderer tiledRenderer;
+        int width, height;
+
+        TRUE_OR_DIE(parser.isSet(sizeOption) &&
+                    parseFrameSize(parser.value(sizeOption), width, height),
+                    "The tiled rendering needs the image size: --size WxH.");
+        tiledRenderer.setImageSize(width, height);
+
+        if(parser.isSet(tileSizeOption))
+        {
+            int tileSize = parser.value(tileSizeOption).toInt();
+            TRUE_OR_DIE(tileSize > 0, "Invalid tile size.");
+            tiledRenderer.setTileSize(tileSize);
+        }
+
+        return tiledRenderer.render(parser.value(tiledRenderOption)) ?
+               EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if(parser.isSet(referenceOption))
+    {
+        RayTracer rayTracer;
+        int width = DEFAULT_REFERENCE_WIDTH;
+        int height = DEFAULT_REFERENCE_HEIGHT;
+
+        if(parser.isSet(sizeOption))
+        {
+            TRUE_OR_DIE(parseFrameSize(parser.value(sizeOption), width, height),
+                        "Invalid image size, expected WxH.");
+        }
+
+        if(parser.isSet(bouncesOption))
+        {
+            rayTracer.setMaxBounces(parser.value(bouncesOption).toInt());
+        }
+
+        if(parser.isSet(sppOption))
+        {
+            rayTracer.setSamplesPerPixel(parser.value(sppOption).toInt());
+        }
+
+        if(parser.isSet(threadsOption))
+        {
+            rayTracer.setNumThreads(parser.value(threadsOption).toInt());
+        }
+
+        QImage image = rayTracer.render(width, height);
+
+        if(image.isNull() || !image.save(parser.value(referenceOption)))
+        {
+            PRINT_ERROR("Cannot save the reference image.");
+            return EXIT_FAILURE;
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+    if(parser.isSet(bakeProbesOption))
+    {
+        ProbeBaker probeBaker;
+
+        if(parser.isSet(probeSizeOption))
+        {
+            int faceSize = parser.value(probeSizeOption).toInt();
+            TRUE_OR_DIE(faceSize > 0, "Invalid probe size.");
+            probeBaker.setFaceSize(faceSize);
+        }
+
+        if(parser.isSet(bouncesOption))
+        {
+            probeBaker.setMaxBounces(parser.value(bouncesOption).toInt());
+        }
+
+        if(parser.isSet(sppOption))
+        {
+            probeBaker.setSamplesPerPixel(parser.value(sppOption).toInt());
+        }
+
+        if(parser.isSet(threadsOption))
+        {
+            probeBaker.setNumThreads(parser.value(threadsOption).toInt());
+        }
+
+        return probeBaker.bake(parser.value(bakeProbesOption)) ?
+               EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if(parser.isSet(saveSceneOption))
+    {
+        SceneDescription scene;
+
+        if(!parser.isSet(sceneOption))
+        {
+            scene.createDefaultScene();
+        }
+        else if(!scene.load(parser.value(sceneOption)))
+        {
+            return EXIT_FAILURE;
+        }
+
+        if(parser.isSet(spheresOption))
+        {
+            scene.addSpherePopulation(parser.value(spheresOption).toInt());
+        }
+
+        return scene.save(parser.value(saveSceneOption)) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if(parser.isSet(checkGPUCullingOption))
+    {
+        OffscreenContext offscreenContext;
+        TRUE_OR_DIE(offscreenContext.create(),
+                    "Cannot create the offscreen OpenGL context.");
+
+        Renderer renderer;
+        renderer.initializeHeadless(offscreenContext.getContext(),
+                                    offscreenContext.getSurface(), 512, 512);
+
+        if(parser.isSet(sceneOption))
+        {
+            TRUE_OR_DIE(renderer.loadScene(parser.value(sceneOption)),
+                        "Cannot load the scene.");
+        }
+
+        // the scene is applied by the first frame
+        renderer.renderHeadlessFrame();
+
+        return renderer.checkGPUCulling() ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     MainWindow mainWindow;
     mainWindow.show();
     mainWindow.setGeometry( QStyle::alignedRect(Qt::LeftToRight, Qt::AlignCenter,
                                               mainWindow.size(),
                                               qApp->desktop()->availableGeometry()));
 
+    if(parser.isSet(staticProbesOption))
+    {
+        TRUE_OR_DIE(mainWindow.loadStaticProbes(parser.value(staticProbesOption)),
+                    "Cannot load the static probes.");
+    }
+
+    if(parser.isSet(sceneOption))
+    {
+        TRUE_OR_DIE(mainWindow.loadScene(parser.value(sceneOption)),
+                    "Cannot load the scene.");
+    }
+
+    if(parser.isSet(replayOption))
+    {
+        TRUE_OR_DIE(mainWindow.startReplay(parser.value(replayOption),
+                                           parser.isSet(exitAfterReplayOption)),
+                    "Cannot replay the input session.");
+    }
+    else if(parser.isSet(recordOption))
+    {
+        TRUE_OR_DIE(mainWindow.startRecording(parser.value(recordOption)),
+                    "Cannot record the input session.");
+    }
+
     return a.exec();
 }
@@ -7,6 +7,7 @@
 //------------------------------------------------------------------------------------------
 
 #include "mainwindow.h"
+#include "probebaker.h"
 
 MainWindow::MainWindow(QWidget* parent) : QWidget(parent)
 {
@@ -15,11 +16,7 @@ MainWindow::MainWindow(QWidget* parent) : QWidget(parent)
     setupGUI();
     changeCubeColor();
 
-
-    // Update continuously
-    QTimer* timer = new QTimer(this);
-    connect(timer, SIGNAL(timeout()), renderer, SLOT(update()));
-    timer->start(10);
+    // the renderer schedules its own frames: it only redraws while something changes
 }
 
 //------------------------------------------------------------------------------------------
@@ -59,6 +56,14 @@ void MainWindow::keyPressEvent(QKeyEvent* e)
         chkTextureAnisotropicFiltering->toggle();
         break;
 
+    case Qt::Key_T:
+        chkGPUProfiler->toggle();
+        break;
+
+    case Qt::Key_C:
+        chkCaptureFrames->toggle();
+        break;
+
     default:
         renderer->keyPressEvent(e);
     }
@@ -262,6 +267,117 @@ void MainWindow::setupGUI()
             &Renderer::enableObjectTransformation);
 
 
+    ////////////////////////////////////////////////////////////////////////////////
+    // profiling
+    chkGPUProfiler = new QCheckBox("Show GPU Timings");
+    chkGPUProfiler->setChecked(false);
+    connect(chkGPUProfiler, &QCheckBox::toggled, renderer,
+            &Renderer::enableGPUProfiler);
+
+    QPushButton* btnSaveGPUTimings = new QPushButton("Save GPU Timings (CSV)");
+    connect(btnSaveGPUTimings, &QPushButton::clicked, this,
+            &MainWindow::saveGPUTimings);
+
+    chkCPUProfiler = new QCheckBox("Record CPU Trace");
+    chkCPUProfiler->setChecked(CPUProfiler::isEnabled());
+    connect(chkCPUProfiler, &QCheckBox::toggled, this,
+            &MainWindow::enableCPUProfiler);
+
+    QPushButton* btnSaveCPUTrace = new QPushButton("Save CPU Trace (JSON)");
+    connect(btnSaveCPUTrace, &QPushButton::clicked, this,
+            &MainWindow::saveCPUTrace);
+
+    chkRecordInput = new QCheckBox("Record Input Session");
+    chkRecordInput->setChecked(false);
+    connect(chkRecordInput, &QCheckBox::toggled, this,
+            &MainWindow::recordInputSession);
+
+    QVBoxLayout* profilingLayout = new QVBoxLayout;
+    profilingLayout->addWidget(chkGPUProfiler);
+    profilingLayout->addWidget(btnSaveGPUTimings);
+    profilingLayout->addWidget(chkCPUProfiler);
+    profilingLayout->addWidget(btnSaveCPUTrace);
+    profilingLayout->addWidget(chkRecordInput);
+    QGroupBox* profilingGroup = new QGroupBox("Profiling");
+    profilingGroup->setLayout(profilingLayout);
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // capture
+    cbCaptureFormat = new QComboBox;
+    cbCaptureFormat->addItem("PNG Sequence", FrameCapture::PNG_SEQUENCE);
+    cbCaptureFormat->addItem("Raw RGBA", FrameCapture::RAW_RGBA);
+    cbCaptureFormat->addItem("Y4M (YUV 4:4:4)", FrameCapture::Y4M);
+
+    chkCaptureFrames = new QCheckBox("Capture Frames");
+    chkCaptureFrames->setChecked(false);
+    connect(chkCaptureFrames, &QCheckBox::toggled, this,
+            &MainWindow::captureFrames);
+
+    QPushButton* btnCaptureProbeFaces = new QPushButton("Capture Probe Faces");
+    connect(btnCaptureProbeFaces, &QPushButton::clicked, this,
+            &MainWindow::captureProbeFaces);
+
+    QPushButton* btnRenderReference = new QPushButton("Render Reference Image");
+    connect(btnRenderReference, &QPushButton::clicked, this,
+            &MainWindow::renderReferenceImage);
+
+    QVBoxLayout* captureLayout = new QVBoxLayout;
+    captureLayout->addWidget(cbCaptureFormat);
+    captureLayout->addWidget(chkCaptureFrames);
+    captureLayout->addWidget(btnCaptureProbeFaces);
+    captureLayout->addWidget(btnRenderReference);
+    QGroupBox* captureGroup = new QGroupBox("Capture");
+    captureGroup->setLayout(captureLayout);
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // static probes
+    chkStaticProbes = new QCheckBox("Use Static Probes");
+    chkStaticProbes->setChecked(false);
+    connect(chkStaticProbes, &QCheckBox::toggled, this,
+            &MainWindow::enableStaticProbes);
+
+    QPushButton* btnBakeProbes = new QPushButton("Bake Static Probes");
+    connect(btnBakeProbes, &QPushButton::clicked, this,
+            &MainWindow::bakeStaticProbes);
+
+    QVBoxLayout* staticProbesLayout = new QVBoxLayout;
+    staticProbesLayout->addWidget(chkStaticProbes);
+    staticProbesLayout->addWidget(btnBakeProbes);
+    QGroupBox* staticProbesGroup = new QGroupBox("Static Probes");
+    staticProbesGroup->setLayout(staticProbesLayout);
+
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // culling and batching of the draws
+    QCheckBox* chkFrustumCulling = new QCheckBox("Frustum Culling");
+    chkFrustumCulling->setChecked(true);
+    connect(chkFrustumCulling, &QCheckBox::toggled, renderer,
+            &Renderer::enableFrustumCulling);
+
+    QCheckBox* chkOcclusionCulling = new QCheckBox("Occlusion Culling");
+    chkOcclusionCulling->setChecked(false);
+    connect(chkOcclusionCulling, &QCheckBox::toggled, renderer,
+            &Renderer::enableOcclusionCulling);
+
+    QCheckBox* chkInstancing = new QCheckBox("Instancing");
+    chkInstancing->setChecked(true);
+    connect(chkInstancing, &QCheckBox::toggled, renderer,
+            &Renderer::enableInstancing);
+
+    QCheckBox* chkGPUCulling = new QCheckBox("GPU Culling (GL 4.3)");
+    chkGPUCulling->setChecked(true);
+    connect(chkGPUCulling, &QCheckBox::toggled, renderer,
+            &Renderer::enableGPUCulling);
+
+    QVBoxLayout* cullingLayout = new QVBoxLayout;
+    cullingLayout->addWidget(chkFrustumCulling);
+    cullingLayout->addWidget(chkOcclusionCulling);
+    cullingLayout->addWidget(chkInstancing);
+    cullingLayout->addWidget(chkGPUCulling);
+    QGroupBox* cullingGroup = new QGroupBox("Culling");
+    cullingGroup->setLayout(cullingLayout);
+
+
     ////////////////////////////////////////////////////////////////////////////////
     // Add slider group to parameter group
     QVBoxLayout* parameterLayout = new QVBoxLayout;
@@ -278,6 +394,10 @@ void MainWindow::setupGUI()
 
     parameterLayout->addWidget(btnResetObjects);
     parameterLayout->addWidget(btnResetCamera);
+    parameterLayout->addWidget(cullingGroup);
+    parameterLayout->addWidget(profilingGroup);
+    parameterLayout->addWidget(captureGroup);
+    parameterLayout->addWidget(staticProbesGroup);
 
 
 
@@ -327,3 +447,252 @@ void MainWindow::changeCubeColor()
     renderer->changeCubeColor((float) r / 255.0f, (float) g / 255.0f, (float) b / 255.0f);
 }
 
+//------------------------------------------------------------------------------------------
+void MainWindow::saveGPUTimings()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, "Save GPU Timings",
+                                                    "gpu_timings.csv",
+                                                    "CSV files (*.csv)");
+
+    if(fileName.isEmpty())
+    {
+        return;
+    }
+
+    if(!renderer->saveGPUTimings(fileName))
+    {
+        QMessageBox::warning(this, "Error",
+                             QString("Cannot save GPU timings to %1").arg(fileName));
+    }
+}
+
+//------------------------------------------------------------------------------------------
+void MainWindow::enableCPUProfiler(bool _state)
+{
+    CPUProfiler::setEnabled(_state);
+}
+
+//------------------------------------------------------------------------------------------
+void MainWindow::saveCPUTrace()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, "Save CPU Trace",
+                                                    "cpu_trace.json",
+                                                    "Chrome trace files (*.json)");
+
+    if(fileName.isEmpty())
+    {
+        return;
+    }
+
+    if(!CPUProfiler::saveChromeTrace(fileName))
+    {
+        QMessageBox::warning(this, "Error",
+                             QString("Cannot save CPU trace to %1").arg(fileName));
+    }
+}
+
+//------------------------------------------------------------------------------------------
+void MainWindow::recordInputSession(bool _state)
+{
+    if(!_state)
+    {
+        renderer->stopRecording();
+        return;
+    }
+
+    QString fileName = QFileDialog::getSaveFileName(this, "Record Input Session",
+                                                    "session.rmi",
+                                                    "Input sessions (*.rmi)");
+
+    if(fileName.isEmpty() || !startRecording(fileName))
+    {
+        if(!fileName.isEmpty())
+        {
+            QMessageBox::warning(this, "Error",
+                                 QString("Cannot record the input session to %1").arg(
+                                     fileName));
+        }
+
+        chkRecordInput->blockSignals(true);
+        chkRecordInput->setChecked(false);
+        chkRecordInput->blockSignals(false);
+    }
+}
+
+//------------------------------------------------------------------------------------------
+bool MainWindow::startRecording(const QString& _fileName)
+{
+    if(!renderer->startRecording(_fileName))
+    {
+        return false;
+    }
+
+    chkRecordInput->blockSignals(true);
+    chkRecordInput->setChecked(true);
+    chkRecordInput->blockSignals(false);
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+// the GUI controls are not updated by the replayed events, they keep showing the live state
+//------------------------------------------------------------------------------------------
+bool MainWindow::startReplay(const QString& _fileName, bool _quitWhenFinished)
+{
+    return renderer->startReplay(_fileName, _quitWhenFinished);
+}
+
+//------------------------------------------------------------------------------------------
+bool MainWindow::loadScene(const QString& _fileName)
+{
+    return renderer->loadScene(_fileName);
+}
+
+//------------------------------------------------------------------------------------------
+bool MainWindow::loadStaticProbes(const QString& _directory)
+{
+    if(!renderer->loadStaticProbes(_directory))
+    {
+        return false;
+    }
+
+    chkStaticProbes->blockSignals(true);
+    chkStaticProbes->setChecked(true);
+    chkStaticProbes->blockSignals(false);
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+void MainWindow::captureFrames(bool _state)
+{
+    if(!_state)
+    {
+        renderer->stopCapture();
+        cbCaptureFormat->setEnabled(true);
+        return;
+    }
+
+    QString filePrefix = QFileDialog::getSaveFileName(this, "Capture Frames (file prefix)",
+                                                      "capture");
+    FrameCapture::Format format = static_cast<FrameCapture::Format>
+                                  (cbCaptureFormat->currentData().toInt());
+
+    if(filePrefix.isEmpty() || !renderer->startCapture(filePrefix, format))
+    {
+        if(!filePrefix.isEmpty())
+        {
+            QMessageBox::warning(this, "Error",
+                                 QString("Cannot capture frames to %1").arg(filePrefix));
+        }
+
+        chkCaptureFrames->blockSignals(true);
+        chkCaptureFrames->setChecked(false);
+        chkCaptureFrames->blockSignals(false);
+        return;
+    }
+
+    // the format of a stream cannot change while it is written
+    cbCaptureFormat->setEnabled(false);
+}
+
+//------------------------------------------------------------------------------------------
+void MainWindow::captureProbeFaces()
+{
+    QString filePrefix = QFileDialog::getSaveFileName(this,
+                                                      "Capture Probe Faces (file prefix)",
+                                                      "probe");
+
+    if(!filePrefix.isEmpty())
+    {
+        renderer->captureProbeFaces(filePrefix);
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// ray trace the current view at the size of the render window, on all the cores
+//------------------------------------------------------------------------------------------
+void MainWindow::renderReferenceImage()
+{
+    RayTracingScene scene;
+    renderer->getRayTracingScene(scene);
+
+    RayTracer rayTracer;
+    rayTracer.setScene(scene);
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    QImage image = rayTracer.render(renderer->width(), renderer->height());
+    QApplication::restoreOverrideCursor();
+
+    if(image.isNull())
+    {
+        QMessageBox::warning(this, "Error", "Cannot render the reference image.");
+        return;
+    }
+
+    QString fileName = QFileDialog::getSaveFileName(this, "Save Reference Image",
+                                                    "reference.png",
+                                                    "Images (*.png *.jpg *.bmp *.ppm)");
+
+    if(!fileName.isEmpty() && !image.save(fileName))
+    {
+        QMessageBox::warning(this, "Error",
+                              QString("Cannot save the reference image to %1")
+                              .arg(fileName));
+    }
+}
+
+//------------------------------------------------------------------------------------------
+void MainWindow::enableStaticProbes(bool _state)
+{
+    if(!_state)
+    {
+        renderer->unloadStaticProbes();
+        return;
+    }
+
+    QString directory = QFileDialog::getExistingDirectory(this, "Load Static Probes");
+
+    if(directory.isEmpty() || !loadStaticProbes(directory))
+    {
+        if(!directory.isEmpty())
+        {
+            QMessageBox::warning(this, "Error",
+                                 QString("Cannot load the static probes from %1")
+                                 .arg(directory));
+        }
+
+        chkStaticProbes->blockSignals(true);
+        chkStaticProbes->setChecked(false);
+        chkStaticProbes->blockSignals(false);
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// bake the probes of the current scene on all the cores, then use them
+//------------------------------------------------------------------------------------------
+void MainWindow::bakeStaticProbes()
+{
+    QString directory = QFileDialog::getExistingDirectory(this, "Bake Static Probes");
+
+    if(directory.isEmpty())
+    {
+        return;
+    }
+
+    RayTracingScene scene;
+    renderer->getRayTracingScene(scene);
+
+    ProbeBaker probeBaker;
+    probeBaker.setScene(scene);
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    bool success = probeBaker.bake(directory);
+    QApplication::restoreOverrideCursor();
+
+    if(!success || !loadStaticProbes(directory))
+    {
+        QMessageBox::warning(this, "Error",
+                             QString("Cannot bake the static probes to %1").arg(directory));
+    }
+}
@@ -25,6 +25,11 @@ public:
     QSize sizeHint() const;
     QSize minimumSizeHint() const;
 
+    bool startRecording(const QString& _fileName);
+    bool startReplay(const QString& _fileName, bool _quitWhenFinished);
+    bool loadStaticProbes(const QString& _directory);
+    bool loadScene(const QString& _fileName);
+
 protected:
     void keyPressEvent(QKeyEvent*);
 
@@ -34,6 +39,15 @@ public slots:
     void changeTextureFilteringMode();
     void resetObjectPositions();
     void changeCubeColor();
+    void saveGPUTimings();
+    void enableCPUProfiler(bool _state);
+    void saveCPUTrace();
+    void recordInputSession(bool _state);
+    void captureFrames(bool _state);
+    void captureProbeFaces();
+    void renderReferenceImage();
+    void enableStaticProbes(bool _state);
+    void bakeStaticProbes();
 
 private:
 
@@ -58,6 +72,12 @@ private:
     QCheckBox* chkMoveCubeWithSphere;
     QCheckBox* chkDynamicEnvMapping;
     QCheckBox* chkBackgroundRendering;
+    QCheckBox* chkGPUProfiler;
+    QCheckBox* chkCPUProfiler;
+    QCheckBox* chkRecordInput;
+    QComboBox* cbCaptureFormat;
+    QCheckBox* chkCaptureFrames;
+    QCheckBox* chkStaticProbes;
 
 };
 
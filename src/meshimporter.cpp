@@ -0,0 +1,1283 @@
+//------------------------------------------------------------------------------------------
+// meshimporter.cpp
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#include <cmath>
+#include <climits>
+
+#include "meshimporter.h"
+#include "workstealingpool.h"
+#include "cpuprofiler.h"
+
+//------------------------------------------------------------------------------------------
+// the indices of one triangle corner in an OBJ file, 0-based, -1 if missing
+struct MeshCorner
+{
+    int position;
+    int texCoord;
+    int normal;
+};
+
+struct MeshImporter::ObjChunk
+{
+    qint64 begin;
+    qint64 end;
+    int numPositions;
+    int numTexCoords;
+    int numNormals;
+    int positionBase;
+    int texCoordBase;
+    int normalBase;
+    QVector<MeshCorner> corners; // 3 per triangle
+    bool valid;
+};
+
+enum PlyType
+{
+    PLY_INT8 = 0,
+    PLY_UINT8,
+    PLY_INT16,
+    PLY_UINT16,
+    PLY_INT32,
+    PLY_UINT32,
+    PLY_FLOAT32,
+    PLY_FLOAT64,
+    PLY_INVALID_TYPE
+};
+
+struct PlyProperty
+{
+    QByteArray name;
+    PlyType type;
+    PlyType countType; // PLY_INVALID_TYPE if not a list
+    int offset;        // in the record, for the elements without list
+};
+
+struct MeshImporter::PlyElement
+{
+    QByteArray name;
+    qint64 count;
+    QVector<PlyProperty> properties;
+    int stride; // -1 with a list property
+};
+
+//------------------------------------------------------------------------------------------
+// open addressing with linear probing, the keys are stored in the order of insertion so
+// the insertion index is the vertex index in the partition
+//------------------------------------------------------------------------------------------
+class CornerHashTable
+{
+public:
+    CornerHashTable(): mask(0) {}
+
+    void reserve(int _numKeys)
+    {
+        int capacity = 16;
+
+        while(capacity < 2 * _numKeys)
+        {
+            capacity *= 2;
+        }
+
+        slots.fill(-1, capacity);
+        mask = capacity - 1;
+        keys.reserve(_numKeys);
+    }
+
+    int insert(const MeshCorner& _corner, quint32 _hash)
+    {
+        if(2 * (keys.size() + 1) > slots.size())
+        {
+            grow();
+        }
+
+        quint32 slot = _hash & mask;
+
+        while(slots[slot] >= 0)
+        {
+            const MeshCorner& key = keys[slots[slot]];
+
+            if(key.position == _corner.position && key.texCoord == _corner.texCoord &&
+               key.normal == _corner.normal)
+            {
+                return slots[slot];
+            }
+
+            slot = (slot + 1) & mask;
+        }
+
+        slots[slot] = keys.size();
+        keys.append(_corner);
+
+        return slots[slot];
+    }
+
+    static quint32 hash(const MeshCorner& _corner)
+    {
+        quint32 h = (quint32)_corner.position * 0x9e3779b1u;
+        h ^= ((quint32)_corner.texCoord + 0x7f4a7c15u) * 0x85ebca77u;
+        h ^= ((quint32)_corner.normal + 0x165667b1u) * 0xc2b2ae3du;
+
+        return h ^ (h >> 15);
+    }
+
+    QVector<MeshCorner> keys;
+
+private:
+    void grow()
+    {
+        QVector<int> oldSlots = slots;
+        reserve(slots.size());
+
+        for(int i = 0; i < keys.size(); ++i)
+        {
+            quint32 slot = hash(keys[i]) & mask;
+
+            while(slots[slot] >= 0)
+            {
+                slot = (slot + 1) & mask;
+            }
+
+            slots[slot] = i;
+        }
+    }
+
+    QVector<int> slots;
+    quint32 mask;
+};
+
+//------------------------------------------------------------------------------------------
+// the partition is taken from the high bits, the slot from the low bits
+static int getPartition(quint32 _hash, int _numPartitions)
+{
+    return (int)(((quint64)_hash * (quint64)_numPartitions) >> 32);
+}
+
+//------------------------------------------------------------------------------------------
+static inline bool isSpace(char _c)
+{
+    return (_c == ' ' || _c == '\t' || _c == '\r');
+}
+
+//------------------------------------------------------------------------------------------
+// decimal float without locale, stops at the first character which is not part of it
+//------------------------------------------------------------------------------------------
+static const char* parseFloat(const char* _p, const char* _end, float& _value)
+{
+    static const double powersOf10[] =
+    {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    while(_p < _end && isSpace(*_p))
+    {
+        ++_p;
+    }
+
+    bool negative = false;
+
+    if(_p < _end && (*_p == '-' || *_p == '+'))
+    {
+        negative = (*_p == '-');
+        ++_p;
+    }
+
+    quint64 mantissa = 0;
+    int numDigits = 0;
+    int exponent = 0;
+
+    for(; _p < _end && *_p >= '0' && *_p <= '9'; ++_p)
+    {
+        if(numDigits < 18)
+        {
+            mantissa = mantissa * 10 + (quint64)(*_p - '0');
+            numDigits += (mantissa > 0) ? 1 : 0;
+        }
+        else
+        {
+            ++exponent;
+        }
+    }
+
+    if(_p < _end && *_p == '.')
+    {
+        for(++_p; _p < _end && *_p >= '0' && *_p <= '9'; ++_p)
+        {
+            if(numDigits < 18)
+            {
+                mantissa = mantissa * 10 + (quint64)(*_p - '0');
+                numDigits += (mantissa > 0) ? 1 : 0;
+                --exponent;
+            }
+        }
+    }
+
+    if(_p < _end && (*_p == 'e' || *_p == 'E'))
+    {
+        const char* p = _p + 1;
+        bool negativeExponent = false;
+        int value = 0;
+
+        if(p < _end && (*p == '-' || *p == '+'))
+        {
+            negativeExponent = (*p == '-');
+            ++p;
+        }
+
+        if(p < _end && *p >= '0' && *p <= '9')
+        {
+            for(; p < _end && *p >= '0' && *p <= '9'; ++p)
+            {
+                value = qMin(value * 10 + (*p - '0'), 1000);
+            }
+
+            exponent += negativeExponent ? -value : value;
+            _p = p;
+        }
+    }
+
+    double result = (double)mantissa;
+
+    if(exponent >= 0)
+    {
+        result *= (exponent <= 22) ? powersOf10[exponent] : pow(10.0, exponent);
+    }
+    else
+    {
+        result /= (exponent >= -22) ? powersOf10[-exponent] : pow(10.0, -exponent);
+    }
+
+    _value = (float)(negative ? -result : result);
+
+    return _p;
+}
+
+//------------------------------------------------------------------------------------------
+static const char* parseInt(const char* _p, const char* _end, int& _value)
+{
+    bool negative = false;
+
+    if(_p < _end && *_p == '-')
+    {
+        negative = true;
+        ++_p;
+    }
+
+    int value = 0;
+
+    for(; _p < _end && *_p >= '0' && *_p <= '9'; ++_p)
+    {
+        value = value * 10 + (*_p - '0');
+    }
+
+    _value = negative ? -value : value;
+
+    return _p;
+}
+
+//------------------------------------------------------------------------------------------
+// OBJ indices are 1-based, or relative to the end of the list when negative
+static int resolveObjIndex(int _index, int _numDefined)
+{
+    if(_index > 0)
+    {
+        return _index - 1;
+    }
+
+    return (_index < 0) ? _numDefined + _index : -1;
+}
+
+//------------------------------------------------------------------------------------------
+static int getPlyTypeSize(PlyType _type)
+{
+    static const int sizes[] = {1, 1, 2, 2, 4, 4, 4, 8, 0};
+
+    return sizes[_type];
+}
+
+//------------------------------------------------------------------------------------------
+static PlyType getPlyType(const QByteArray& _name)
+{
+    static const char* names[][2] =
+    {
+        {"char", "int8"}, {"uchar", "uint8"}, {"short", "int16"}, {"ushort", "uint16"},
+        {"int", "int32"}, {"uint", "uint32"}, {"float", "float32"}, {"double", "float64"}
+    };
+
+    for(int i = 0; i < PLY_INVALID_TYPE; ++i)
+    {
+        if(_name == names[i][0] || _name == names[i][1])
+        {
+            return static_cast<PlyType>(i);
+        }
+    }
+
+    return PLY_INVALID_TYPE;
+}
+
+//------------------------------------------------------------------------------------------
+static double readPlyValue(const char* _data, PlyType _type, bool _bigEndian)
+{
+    uchar bytes[8];
+    int size = getPlyTypeSize(_type);
+
+    for(int i = 0; i < size; ++i)
+    {
+        bytes[i] = (uchar)_data[_bigEndian ? size - 1 - i : i];
+    }
+
+    switch(_type)
+    {
+    case PLY_INT8:
+        return (double)(qint8)bytes[0];
+
+    case PLY_UINT8:
+        return (double)bytes[0];
+
+    case PLY_INT16:
+        return (double)qFromLittleEndian<qint16>(bytes);
+
+    case PLY_UINT16:
+        return (double)qFromLittleEndian<quint16>(bytes);
+
+    case PLY_INT32:
+        return (double)qFromLittleEndian<qint32>(bytes);
+
+    case PLY_UINT32:
+        return (double)qFromLittleEndian<quint32>(bytes);
+
+    case PLY_FLOAT32:
+    {
+        float value;
+        memcpy(&value, bytes, sizeof(value));
+        return (double)value;
+    }
+
+    case PLY_FLOAT64:
+    {
+        double value;
+        memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    default:
+        return 0.0;
+    }
+}
+
+//------------------------------------------------------------------------------------------
+MeshImporter::MeshImporter():
+    numVertices(0),
+    numThreads(0),
+    importTime(0.0)
+{
+}
+
+//------------------------------------------------------------------------------------------
+// 0: all the cores
+//------------------------------------------------------------------------------------------
+void MeshImporter::setNumThreads(int _numThreads)
+{
+    numThreads = _numThreads;
+}
+
+//------------------------------------------------------------------------------------------
+bool MeshImporter::import(const QString& _fileName)
+{
+    PROFILE_ZONE("MeshImporter::import");
+
+    QElapsedTimer timer;
+    timer.start();
+    clear();
+
+    QFile file(_fileName);
+
+    if(!file.open(QIODevice::ReadOnly) || file.size() == 0)
+    {
+        qDebug() << "MeshImporter: cannot open" << _fileName;
+        return false;
+    }
+
+    const char* data = reinterpret_cast<const char*>(file.map(0, file.size()));
+
+    if(data == NULL)
+    {
+        qDebug() << "MeshImporter: cannot map" << _fileName;
+        return false;
+    }
+
+    bool success = false;
+
+    if(file.size() >= 4 && memcmp(data, "ply", 3) == 0)
+    {
+        success = importPly(data, file.size());
+    }
+    else if(_fileName.endsWith(".obj", Qt::CaseInsensitive))
+    {
+        success = importObj(data, file.size());
+    }
+    else
+    {
+        qDebug() << "MeshImporter: unknown file format" << _fileName;
+    }
+
+    file.unmap(reinterpret_cast<uchar*>(const_cast<char*>(data)));
+    objPositions.clear();
+    objTexCoords.clear();
+    objNormals.clear();
+
+    if(!success)
+    {
+        qDebug() << "MeshImporter: cannot import" << _fileName;
+        clear();
+        return false;
+    }
+
+    computeBounds();
+    importTime = (double)timer.nsecsElapsed() * 1e-6;
+
+    qDebug() << "MeshImporter:" << _fileName << numVertices << "vertices,"
+             << indices.size() / 3 << "triangles in" << importTime << "ms";
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+void MeshImporter::clear()
+{
+    vertexData.clear();
+    indices.clear();
+    numVertices = 0;
+    boundsMin = QVector3D(0.0f, 0.0f, 0.0f);
+    boundsMax = QVector3D(0.0f, 0.0f, 0.0f);
+}
+
+//------------------------------------------------------------------------------------------
+int MeshImporter::getNumVertices() const
+{
+    return numVertices;
+}
+
+//------------------------------------------------------------------------------------------
+int MeshImporter::getNumIndices() const
+{
+    return indices.size();
+}
+
+//------------------------------------------------------------------------------------------
+// size of the positions in bytes, the normals are stored after them
+//------------------------------------------------------------------------------------------
+int MeshImporter::getVertexOffset() const
+{
+    return numVertices * 3 * sizeof(GLfloat);
+}
+
+//------------------------------------------------------------------------------------------
+int MeshImporter::getTexCoordOffset() const
+{
+    return numVertices * 2 * sizeof(GLfloat);
+}
+
+//------------------------------------------------------------------------------------------
+int MeshImporter::getIndexOffset() const
+{
+    return indices.size() * sizeof(GLuint);
+}
+
+//------------------------------------------------------------------------------------------
+// 2 * getVertexOffset() + getTexCoordOffset() bytes, ready to be uploaded
+//------------------------------------------------------------------------------------------
+const GLfloat* MeshImporter::getVertexData() const
+{
+    return vertexData.constData();
+}
+
+//------------------------------------------------------------------------------------------
+const GLuint* MeshImporter::getIndices() const
+{
+    return indices.constData();
+}
+
+//------------------------------------------------------------------------------------------
+QVector3D MeshImporter::getBoundsMin() const
+{
+    return boundsMin;
+}
+
+//------------------------------------------------------------------------------------------
+QVector3D MeshImporter::getBoundsMax() const
+{
+    return boundsMax;
+}
+
+//------------------------------------------------------------------------------------------
+double MeshImporter::getImportTime() const
+{
+    return importTime;
+}
+
+//------------------------------------------------------------------------------------------
+// 1. count the attributes of each chunk to place them in the global arrays
+// 2. parse the chunks, the faces are triangulated as fans of corners
+// 3. deduplicate the corners, one hash table partition per worker
+// 4. write the vertices and offset the indices by their partition
+//------------------------------------------------------------------------------------------
+bool MeshImporter::importObj(const char* _data, qint64 _size)
+{
+    PROFILE_ZONE("MeshImporter::importObj");
+
+    WorkStealingPool pool(numThreads);
+    int numWorkers = pool.getNumWorkers();
+
+    /////////////////////////////////////////////////////////////////
+    // chunks, split at line boundaries
+    int numChunks = (int)qBound((qint64)1, _size / MESH_IMPORTER_MIN_CHUNK_SIZE,
+                                (qint64)(numWorkers * MESH_IMPORTER_CHUNKS_PER_WORKER));
+    QVector<ObjChunk> chunks(numChunks);
+    qint64 chunkBegin = 0;
+
+    for(int i = 0; i < numChunks; ++i)
+    {
+        qint64 chunkEnd = (i == numChunks - 1) ? _size : qMax(chunkBegin, _size * (i + 1) /
+                                                               numChunks);
+
+        while(chunkEnd < _size && _data[chunkEnd - 1] != '\n')
+        {
+            ++chunkEnd;
+        }
+
+        chunks[i].begin = chunkBegin;
+        chunks[i].end = chunkEnd;
+        chunks[i].valid = true;
+        chunkBegin = chunkEnd;
+    }
+
+    pool.run(numChunks, [&](int _task, int)
+    {
+        parseObjChunk(chunks[_task], _data, true);
+    });
+
+    int numPositions = 0;
+    int numTexCoords = 0;
+    int numNormals = 0;
+
+    for(int i = 0; i < numChunks; ++i)
+    {
+        chunks[i].positionBase = numPositions;
+        chunks[i].texCoordBase = numTexCoords;
+        chunks[i].normalBase = numNormals;
+        numPositions += chunks[i].numPositions;
+        numTexCoords += chunks[i].numTexCoords;
+        numNormals += chunks[i].numNormals;
+    }
+
+    objPositions.resize(numPositions * 3);
+    objTexCoords.resize(numTexCoords * 2);
+    objNormals.resize(numNormals * 3);
+
+    /////////////////////////////////////////////////////////////////
+    // attributes and faces
+    pool.run(numChunks, [&](int _task, int)
+    {
+        parseObjChunk(chunks[_task], _data, false);
+    });
+
+    QVector<qint64> cornerBases(numChunks + 1, 0);
+
+    for(int i = 0; i < numChunks; ++i)
+    {
+        if(!chunks[i].valid)
+        {
+            qDebug() << "MeshImporter: invalid face index";
+            return false;
+        }
+
+        cornerBases[i + 1] = cornerBases[i] + chunks[i].corners.size();
+    }
+
+    if(cornerBases[numChunks] == 0 || cornerBases[numChunks] > (qint64)INT_MAX)
+    {
+        qDebug() << "MeshImporter: no face, or too many faces";
+        return false;
+    }
+
+    indices.resize((int)cornerBases[numChunks]);
+
+    /////////////////////////////////////////////////////////////////
+    // deduplication: each partition numbers its own vertices from 0
+    int numPartitions = numWorkers;
+    QVector<CornerHashTable> tables(numPartitions);
+
+    pool.run(numPartitions, [&](int _partition, int)
+    {
+        CornerHashTable& table = tables[_partition];
+        table.reserve((int)(cornerBases[numChunks] / (2 * numPartitions)));
+
+        for(int i = 0; i < numChunks; ++i)
+        {
+            const MeshCorner* corners = chunks[i].corners.constData();
+            GLuint* chunkIndices = indices.data() + cornerBases[i];
+
+            for(int j = 0; j < chunks[i].corners.size(); ++j)
+            {
+                quint32 hash = CornerHashTable::hash(corners[j]);
+
+                if(getPartition(hash, numPartitions) == _partition)
+                {
+                    chunkIndices[j] = (GLuint)table.insert(corners[j], hash);
+                }
+            }
+        }
+    });
+
+    QVector<int> partitionBases(numPartitions + 1, 0);
+
+    for(int i = 0; i < numPartitions; ++i)
+    {
+        partitionBases[i + 1] = partitionBases[i] + tables[i].keys.size();
+    }
+
+    allocateVertices(partitionBases[numPartitions]);
+
+    /////////////////////////////////////////////////////////////////
+    // vertices
+    QVector<int> vertexPositions(numVertices);
+    QAtomicInt numMissingNormals(0);
+    GLfloat* positions = getPositions();
+    GLfloat* normals = getNormals();
+    GLfloat* texCoords = getTexCoords();
+
+    pool.run(numPartitions, [&](int _partition, int)
+    {
+        const QVector<MeshCorner>& keys = tables[_partition].keys;
+        int missingNormals = 0;
+
+        for(int i = 0; i < keys.size(); ++i)
+        {
+            int vertex = partitionBases[_partition] + i;
+            const MeshCorner& corner = keys[i];
+
+            memcpy(positions + vertex * 3, objPositions.constData() + corner.position * 3,
+                   3 * sizeof(GLfloat));
+            vertexPositions[vertex] = corner.position;
+
+            if(corner.normal >= 0)
+            {
+                memcpy(normals + vertex * 3, objNormals.constData() + corner.normal * 3,
+                       3 * sizeof(GLfloat));
+            }
+            else
+            {
+                ++missingNormals;
+            }
+
+            if(corner.texCoord >= 0)
+            {
+                memcpy(texCoords + vertex * 2,
+                       objTexCoords.constData() + corner.texCoord * 2, 2 * sizeof(GLfloat));
+            }
+        }
+
+        numMissingNormals.fetchAndAddRelaxed(missingNormals);
+    });
+
+    pool.run(numChunks, [&](int _task, int)
+    {
+        const MeshCorner* corners = chunks[_task].corners.constData();
+        GLuint* chunkIndices = indices.data() + cornerBases[_task];
+
+        for(int j = 0; j < chunks[_task].corners.size(); ++j)
+        {
+            quint32 hash = CornerHashTable::hash(corners[j]);
+            chunkIndices[j] += (GLuint)partitionBases[getPartition(hash, numPartitions)];
+        }
+    });
+
+    if(numMissingNormals.load() > 0)
+    {
+        computeNormals(vertexPositions);
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+// the vertices of a binary PLY file are already shared: they are converted in parallel,
+// the faces are read sequentially (their size varies)
+//------------------------------------------------------------------------------------------
+bool MeshImporter::importPly(const char* _data, qint64 _size)
+{
+    PROFILE_ZONE("MeshImporter::importPly");
+
+    /////////////////////////////////////////////////////////////////
+    // header
+    qint64 headerSize = 0;
+
+    while(headerSize + 10 < _size && headerSize < MESH_IMPORTER_MAX_PLY_HEADER_SIZE &&
+          memcmp(_data + headerSize, "end_header", 10) != 0)
+    {
+        ++headerSize;
+    }
+
+    if(headerSize >= MESH_IMPORTER_MAX_PLY_HEADER_SIZE)
+    {
+        qDebug() << "MeshImporter: the PLY header is longer than"
+                 << MESH_IMPORTER_MAX_PLY_HEADER_SIZE << "bytes";
+        return false;
+    }
+
+    if(headerSize + 10 >= _size)
+    {
+        qDebug() << "MeshImporter: invalid PLY header";
+        return false;
+    }
+
+    QList<QByteArray> lines = QByteArray(_data, headerSize).split('\n');
+    qint64 offset = headerSize + 10;
+
+    while(offset < _size && _data[offset] != '\n')
+    {
+        ++offset;
+    }
+
+    ++offset;
+
+    bool bigEndian = false;
+    QVector<PlyElement> elements;
+
+    for(int i = 0; i < lines.size(); ++i)
+    {
+        QList<QByteArray> words = lines[i].simplified().split(' ');
+
+        if(words[0] == "format")
+        {
+            if(words.size() < 2 || words[1] == "ascii")
+            {
+                qDebug() << "MeshImporter: only the binary PLY files are supported";
+                return false;
+            }
+
+            bigEndian = (words[1] == "binary_big_endian");
+        }
+        else if(words[0] == "element" && words.size() >= 3)
+        {
+            PlyElement element;
+            element.name = words[1];
+            element.count = words[2].toLongLong();
+            element.stride = 0;
+
+            if(element.count < 0)
+            {
+                qDebug() << "MeshImporter: invalid PLY element count in" << lines[i];
+                return false;
+            }
+
+            elements.append(element);
+        }
+        else if(words[0] == "property" && !elements.isEmpty())
+        {
+            PlyElement& element = elements.last();
+            PlyProperty property;
+            property.offset = element.stride;
+
+            if(words.size() >= 5 && words[1] == "list")
+            {
+                property.countType = getPlyType(words[2]);
+                property.type = getPlyType(words[3]);
+                property.name = words[4];
+                element.stride = -1;
+            }
+            else if(words.size() >= 3)
+            {
+                property.countType = PLY_INVALID_TYPE;
+                property.type = getPlyType(words[1]);
+                property.name = words[2];
+
+                if(element.stride >= 0)
+                {
+                    element.stride += getPlyTypeSize(property.type);
+                }
+            }
+
+            if(property.type == PLY_INVALID_TYPE)
+            {
+                qDebug() << "MeshImporter: unknown PLY property type in" << lines[i];
+                return false;
+            }
+
+            element.properties.append(property);
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////
+    // elements
+    WorkStealingPool pool(numThreads);
+    bool hasNormals = false;
+    bool hasVertices = false;
+
+    for(int e = 0; e < elements.size(); ++e)
+    {
+        const PlyElement& element = elements[e];
+
+        if(element.name == "vertex")
+        {
+            if(element.stride < 0 || element.count > (qint64)INT_MAX / 3 ||
+               offset + element.count * element.stride > _size)
+            {
+                qDebug() << "MeshImporter: invalid PLY vertices";
+                return false;
+            }
+
+            // x y z nx ny nz u v
+            static const char* names[8][3] =
+            {
+                {"x", "x", "x"}, {"y", "y", "y"}, {"z", "z", "z"},
+                {"nx", "nx", "nx"}, {"ny", "ny", "ny"}, {"nz", "nz", "nz"},
+                {"u", "s", "texture_u"}, {"v", "t", "texture_v"}
+            };
+            const PlyProperty* attributes[8] = {NULL};
+
+            for(int i = 0; i < element.properties.size(); ++i)
+            {
+                for(int a = 0; a < 8; ++a)
+                {
+                    for(int n = 0; n < 3; ++n)
+                    {
+                        if(element.properties[i].name == names[a][n])
+                        {
+                            attributes[a] = &element.properties[i];
+                        }
+                    }
+                }
+            }
+
+            if(attributes[0] == NULL || attributes[1] == NULL || attributes[2] == NULL)
+            {
+                qDebug() << "MeshImporter: the PLY vertices have no position";
+                return false;
+            }
+
+            hasNormals = (attributes[3] != NULL && attributes[4] != NULL &&
+                          attributes[5] != NULL);
+            hasVertices = true;
+            allocateVertices((int)element.count);
+
+            GLfloat* positions = getPositions();
+            GLfloat* normals = getNormals();
+            GLfloat* texCoords = getTexCoords();
+            const char* vertexData = _data + offset;
+            int numTasks = qMax(1, qMin(numVertices / 4096,
+                                        pool.getNumWorkers() *
+                                        MESH_IMPORTER_CHUNKS_PER_WORKER));
+
+            pool.run(numTasks, [&](int _task, int)
+            {
+                int begin = (int)((qint64)numVertices * _task / numTasks);
+                int end = (int)((qint64)numVertices * (_task + 1) / numTasks);
+                GLfloat* outputs[8] =
+                {
+                    positions, positions + 1, positions + 2,
+                    normals, normals + 1, normals + 2,
+                    texCoords, texCoords + 1
+                };
+                int outputStrides[8] = {3, 3, 3, 3, 3, 3, 2, 2};
+
+                for(int a = 0; a < 8; ++a)
+                {
+                    if(attributes[a] == NULL)
+                    {
+                        continue;
+                    }
+
+                    const char* input = vertexData + (qint64)begin * element.stride +
+                                        attributes[a]->offset;
+                    GLfloat* output = outputs[a] + begin * outputStrides[a];
+
+                    if(attributes[a]->type == PLY_FLOAT32 && !bigEndian)
+                    {
+                        for(int i = begin; i < end; ++i)
+                        {
+                            memcpy(output, input, sizeof(GLfloat));
+                            input += element.stride;
+                            output += outputStrides[a];
+                        }
+                    }
+                    else
+                    {
+                        for(int i = begin; i < end; ++i)
+                        {
+                            *output = (GLfloat)readPlyValue(input, attributes[a]->type,
+                                                            bigEndian);
+                            input += element.stride;
+                            output += outputStrides[a];
+                        }
+                    }
+                }
+            });
+
+            offset += element.count * element.stride;
+        }
+        else if(element.name == "face")
+        {
+            indices.reserve((int)qMin(element.count * 3, (qint64)INT_MAX));
+
+            for(qint64 f = 0; f < element.count; ++f)
+            {
+                for(int p = 0; p < element.properties.size(); ++p)
+                {
+                    const PlyProperty& property = element.properties[p];
+                    int itemSize = getPlyTypeSize(property.type);
+
+                    if(property.countType == PLY_INVALID_TYPE)
+                    {
+                        offset += itemSize;
+                        continue;
+                    }
+
+                    if(offset + getPlyTypeSize(property.countType) > _size)
+                    {
+                        qDebug() << "MeshImporter: truncated PLY faces";
+                        return false;
+                    }
+
+                    // a signed count type can hold a negative count
+                    double countValue = readPlyValue(_data + offset, property.countType,
+                                                     bigEndian);
+                    offset += getPlyTypeSize(property.countType);
+
+                    if(countValue < 0.0 || countValue > (double)INT_MAX)
+                    {
+                        qDebug() << "MeshImporter: invalid PLY list count" << countValue;
+                        return false;
+                    }
+
+                    int count = (int)countValue;
+
+                    if(offset + (qint64)count * itemSize > _size)
+                    {
+                        qDebug() << "MeshImporter: truncated PLY faces";
+                        return false;
+                    }
+
+                    if(property.name == "vertex_indices" || property.name == "vertex_index")
+                    {
+                        const char* items = _data + offset;
+                        GLuint first = (GLuint)readPlyValue(items, property.type,
+                                                            bigEndian);
+
+                        for(int i = 2; i < count; ++i)
+                        {
+                            indices.append(first);
+                            indices.append((GLuint)readPlyValue(items + (i - 1) * itemSize,
+                                                                property.type, bigEndian));
+                            indices.append((GLuint)readPlyValue(items + i * itemSize,
+                                                                property.type, bigEndian));
+                        }
+                    }
+
+                    offset += (qint64)count * itemSize;
+                }
+            }
+        }
+        else
+        {
+            // skip the other elements, without reading past the file
+            for(qint64 r = 0; r < element.count && element.stride < 0; ++r)
+            {
+                for(int p = 0; p < element.properties.size(); ++p)
+                {
+                    const PlyProperty& property = element.properties[p];
+
+                    if(property.countType == PLY_INVALID_TYPE)
+                    {
+                        offset += getPlyTypeSize(property.type);
+                        continue;
+                    }
+
+                    if(offset + getPlyTypeSize(property.countType) > _size)
+                    {
+                        qDebug() << "MeshImporter: truncated PLY element" << element.name;
+                        return false;
+                    }
+
+                    double count = readPlyValue(_data + offset, property.countType,
+                                                bigEndian);
+                    offset += getPlyTypeSize(property.countType);
+
+                    if(count < 0.0)
+                    {
+                        qDebug() << "MeshImporter: invalid PLY list count" << count;
+                        return false;
+                    }
+
+                    offset += (qint64)count * getPlyTypeSize(property.type);
+                }
+            }
+
+            if(offset > _size ||
+               (element.stride > 0 && element.count > (_size - offset) / element.stride))
+            {
+                qDebug() << "MeshImporter: truncated PLY element" << element.name;
+                return false;
+            }
+
+            if(element.stride >= 0)
+            {
+                offset += element.count * element.stride;
+            }
+        }
+    }
+
+    if(!hasVertices || indices.isEmpty())
+    {
+        qDebug() << "MeshImporter: the PLY file has no vertex or no face";
+        return false;
+    }
+
+    for(int i = 0; i < indices.size(); ++i)
+    {
+        if(indices[i] >= (GLuint)numVertices)
+        {
+            qDebug() << "MeshImporter: invalid PLY face index" << indices[i];
+            return false;
+        }
+    }
+
+    if(!hasNormals)
+    {
+        computeNormals(QVector<int>());
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+// count the attributes, or read them and the faces
+//------------------------------------------------------------------------------------------
+void MeshImporter::parseObjChunk(ObjChunk& _chunk, const char* _data, bool _countOnly)
+{
+    const char* p = _data + _chunk.begin;
+    const char* end = _data + _chunk.end;
+    int numPositions = 0;
+    int numTexCoords = 0;
+    int numNormals = 0;
+
+    GLfloat* positions = objPositions.data();
+    GLfloat* texCoords = objTexCoords.data();
+    GLfloat* normals = objNormals.data();
+    QVarLengthArray<MeshCorner, 16> polygon;
+
+    while(p < end)
+    {
+        const char* lineEnd = reinterpret_cast<const char*>(memchr(p, '\n', end - p));
+        lineEnd = (lineEnd != NULL) ? lineEnd : end;
+
+        while(p < lineEnd && isSpace(*p))
+        {
+            ++p;
+        }
+
+        if(lineEnd - p >= 2 && p[0] == 'v' && isSpace(p[1]))
+        {
+            if(!_countOnly)
+            {
+                GLfloat* position = positions + (_chunk.positionBase + numPositions) * 3;
+                const char* q = parseFloat(p + 2, lineEnd, position[0]);
+                q = parseFloat(q, lineEnd, position[1]);
+                parseFloat(q, lineEnd, position[2]);
+            }
+
+            ++numPositions;
+        }
+        else if(lineEnd - p >= 3 && p[0] == 'v' && p[1] == 't' && isSpace(p[2]))
+        {
+            if(!_countOnly)
+            {
+                GLfloat* texCoord = texCoords + (_chunk.texCoordBase + numTexCoords) * 2;
+                const char* q = parseFloat(p + 3, lineEnd, texCoord[0]);
+                parseFloat(q, lineEnd, texCoord[1]);
+            }
+
+            ++numTexCoords;
+        }
+        else if(lineEnd - p >= 3 && p[0] == 'v' && p[1] == 'n' && isSpace(p[2]))
+        {
+            if(!_countOnly)
+            {
+                GLfloat* normal = normals + (_chunk.normalBase + numNormals) * 3;
+                const char* q = parseFloat(p + 3, lineEnd, normal[0]);
+                q = parseFloat(q, lineEnd, normal[1]);
+                parseFloat(q, lineEnd, normal[2]);
+            }
+
+            ++numNormals;
+        }
+        else if(!_countOnly && lineEnd - p >= 2 && p[0] == 'f' && isSpace(p[1]))
+        {
+            // v, v/vt, v//vn or v/vt/vn
+            polygon.clear();
+            p += 2;
+
+            while(true)
+            {
+                while(p < lineEnd && isSpace(*p))
+                {
+                    ++p;
+                }
+
+                if(p >= lineEnd || *p == '#')
+                {
+                    break;
+                }
+
+                int values[3] = {0, 0, 0};
+                p = parseInt(p, lineEnd, values[0]);
+
+                for(int i = 1; i < 3 && p < lineEnd && *p == '/'; ++i)
+                {
+                    p = parseInt(p + 1, lineEnd, values[i]);
+                }
+
+                while(p < lineEnd && !isSpace(*p))
+                {
+                    ++p;
+                }
+
+                MeshCorner corner;
+                corner.position = resolveObjIndex(values[0],
+                                                  _chunk.positionBase + numPositions);
+                corner.texCoord = resolveObjIndex(values[1],
+                                                  _chunk.texCoordBase + numTexCoords);
+                corner.normal = resolveObjIndex(values[2], _chunk.normalBase + numNormals);
+                polygon.append(corner);
+
+                if(corner.position < 0 || corner.position >= objPositions.size() / 3 ||
+                   corner.texCoord >= objTexCoords.size() / 2 ||
+                   corner.normal >= objNormals.size() / 3)
+                {
+                    _chunk.valid = false;
+                }
+            }
+
+            for(int i = 2; i < polygon.size(); ++i)
+            {
+                _chunk.corners.append(polygon[0]);
+                _chunk.corners.append(polygon[i - 1]);
+                _chunk.corners.append(polygon[i]);
+            }
+        }
+
+        p = lineEnd + 1;
+    }
+
+    _chunk.numPositions = numPositions;
+    _chunk.numTexCoords = numTexCoords;
+    _chunk.numNormals = numNormals;
+}
+
+//------------------------------------------------------------------------------------------
+void MeshImporter::allocateVertices(int _numVertices)
+{
+    numVertices = _numVertices;
+    vertexData.fill(0.0f, numVertices * 8);
+}
+
+//------------------------------------------------------------------------------------------
+// Area weighted face normals, summed over the vertices sharing the same position
+// (_vertexPositions, or the vertex itself if empty). Only the missing normals (still 0)
+// are replaced.
+//------------------------------------------------------------------------------------------
+void MeshImporter::computeNormals(const QVector<int>& _vertexPositions)
+{
+    PROFILE_ZONE("MeshImporter::computeNormals");
+
+    const GLfloat* positions = getPositions();
+    GLfloat* normals = getNormals();
+    int numKeys = _vertexPositions.isEmpty() ? numVertices : objPositions.size() / 3;
+    QVector<QVector3D> sums(numKeys, QVector3D(0.0f, 0.0f, 0.0f));
+
+    for(int i = 0; i + 2 < indices.size(); i += 3)
+    {
+        QVector3D corners[3];
+
+        for(int j = 0; j < 3; ++j)
+        {
+            const GLfloat* position = positions + indices[i + j] * 3;
+            corners[j] = QVector3D(position[0], position[1], position[2]);
+        }
+
+        QVector3D faceNormal = QVector3D::crossProduct(corners[1] - corners[0],
+                                                       corners[2] - corners[0]);
+
+        for(int j = 0; j < 3; ++j)
+        {
+            int vertex = indices[i + j];
+            int key = _vertexPositions.isEmpty() ? vertex : _vertexPositions[vertex];
+            sums[key] += faceNormal;
+        }
+    }
+
+    for(int i = 0; i < numVertices; ++i)
+    {
+        GLfloat* normal = normals + i * 3;
+
+        if(normal[0] != 0.0f || normal[1] != 0.0f || normal[2] != 0.0f)
+        {
+            continue;
+        }
+
+        int key = _vertexPositions.isEmpty() ? i : _vertexPositions[i];
+        QVector3D sum = sums[key].normalized();
+        normal[0] = sum.x();
+        normal[1] = sum.y();
+        normal[2] = sum.z();
+    }
+}
+
+//------------------------------------------------------------------------------------------
+void MeshImporter::computeBounds()
+{
+    const GLfloat* positions = getPositions();
+
+    if(numVertices == 0)
+    {
+        return;
+    }
+
+    boundsMin = QVector3D(positions[0], positions[1], positions[2]);
+    boundsMax = boundsMin;
+
+    for(int i = 1; i < numVertices; ++i)
+    {
+        QVector3D position(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]);
+        boundsMin = QVector3D(qMin(boundsMin.x(), position.x()),
+                              qMin(boundsMin.y(), position.y()),
+                              qMin(boundsMin.z(), position.z()));
+        boundsMax = QVector3D(qMax(boundsMax.x(), position.x()),
+                              qMax(boundsMax.y(), position.y()),
+                              qMax(boundsMax.z(), position.z()));
+    }
+}
+
+//------------------------------------------------------------------------------------------
+GLfloat* MeshImporter::getPositions()
+{
+    return vertexData.data();
+}
+
+//------------------------------------------------------------------------------------------
+GLfloat* MeshImporter::getNormals()
+{
+    return vertexData.data() + numVertices * 3;
+}
+
+//------------------------------------------------------------------------------------------
+GLfloat* MeshImporter::getTexCoords()
+{
+    return vertexData.data() + numVertices * 6;
+}
@@ -0,0 +1,78 @@
+//------------------------------------------------------------------------------------------
+// meshimporter.h
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#ifndef MESHIMPORTER_H
+#define MESHIMPORTER_H
+
+#include <QtGui>
+
+//------------------------------------------------------------------------------------------
+#define MESH_IMPORTER_CHUNKS_PER_WORKER 8
+#define MESH_IMPORTER_MIN_CHUNK_SIZE (256 * 1024)
+#define MESH_IMPORTER_MAX_PLY_HEADER_SIZE (64 * 1024)
+
+//------------------------------------------------------------------------------------------
+// Import a triangle mesh from an OBJ or a binary PLY file.
+// The file is mapped and parsed in chunks by all the cores. The OBJ corners (position,
+// texture coordinate and normal indices) are deduplicated by an open-addressing hash table
+// per worker, each worker owning the corners whose hash falls into its partition.
+// The result has the layout of the vertex buffers of the renderer: all the positions,
+// then all the normals, then all the texture coordinates, with 32 bit indices.
+// The missing normals are computed from the faces, the missing texture coordinates are 0.
+//------------------------------------------------------------------------------------------
+class MeshImporter
+{
+public:
+    MeshImporter();
+
+    void setNumThreads(int _numThreads);
+    bool import(const QString& _fileName);
+    void clear();
+
+    int getNumVertices() const;
+    int getNumIndices() const;
+    int getVertexOffset() const;
+    int getTexCoordOffset() const;
+    int getIndexOffset() const;
+    const GLfloat* getVertexData() const;
+    const GLuint* getIndices() const;
+    QVector3D getBoundsMin() const;
+    QVector3D getBoundsMax() const;
+    double getImportTime() const;
+
+private:
+    struct ObjChunk;
+    struct PlyElement;
+
+    bool importObj(const char* _data, qint64 _size);
+    bool importPly(const char* _data, qint64 _size);
+    void parseObjChunk(ObjChunk& _chunk, const char* _data, bool _countOnly);
+    void allocateVertices(int _numVertices);
+    void computeNormals(const QVector<int>& _vertexPositions);
+    void computeBounds();
+
+    GLfloat* getPositions();
+    GLfloat* getNormals();
+    GLfloat* getTexCoords();
+
+    QVector<GLfloat> vertexData;
+    QVector<GLuint> indices;
+    int numVertices;
+    int numThreads;
+
+    // the attributes of the OBJ file, before deduplication
+    QVector<GLfloat> objPositions;
+    QVector<GLfloat> objTexCoords;
+    QVector<GLfloat> objNormals;
+
+    QVector3D boundsMin;
+    QVector3D boundsMax;
+    double importTime;
+};
+
+#endif // MESHIMPORTER_H
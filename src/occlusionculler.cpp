@@ -0,0 +1,163 @@
+//------------------------------------------------------------------------------------------
+// occlusionculler.cpp
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#include "occlusionculler.h"
+
+//------------------------------------------------------------------------------------------
+OcclusionCuller::OcclusionCuller():
+    glFuncs(NULL),
+    enabled(false),
+    numOccluded(0)
+{
+}
+
+//------------------------------------------------------------------------------------------
+void OcclusionCuller::initialize(QOpenGLFunctions_4_0_Core* _glFuncs)
+{
+    glFuncs = _glFuncs;
+}
+
+//------------------------------------------------------------------------------------------
+void OcclusionCuller::setEnabled(bool _state)
+{
+    enabled = _state;
+
+    if(!enabled)
+    {
+        occludedObjects.fill(0, occludedObjects.size());
+        issuedQueries.fill(0, issuedQueries.size());
+        numOccluded = 0;
+    }
+}
+
+//------------------------------------------------------------------------------------------
+bool OcclusionCuller::isEnabled() const
+{
+    return (enabled && glFuncs != NULL);
+}
+
+//------------------------------------------------------------------------------------------
+// one query per object, all the objects are visible until their first result
+//------------------------------------------------------------------------------------------
+void OcclusionCuller::resize(int _numObjects)
+{
+    if(glFuncs == NULL)
+    {
+        return;
+    }
+
+    if(_numObjects != queries.size())
+    {
+        destroyQueries();
+        queries.resize(_numObjects);
+
+        if(_numObjects > 0)
+        {
+            glFuncs->glGenQueries(_numObjects, queries.data());
+        }
+    }
+
+    issuedQueries.fill(0, _numObjects);
+    occludedObjects.fill(0, _numObjects);
+    numOccluded = 0;
+}
+
+//------------------------------------------------------------------------------------------
+// read back the queries of the last frame whose result is ready, the other objects keep
+// their previous state
+//------------------------------------------------------------------------------------------
+void OcclusionCuller::collectResults()
+{
+    if(!isEnabled())
+    {
+        return;
+    }
+
+    for(int i = 0; i < queries.size(); ++i)
+    {
+        if(!issuedQueries[i])
+        {
+            continue;
+        }
+
+        GLuint available = GL_FALSE;
+        glFuncs->glGetQueryObjectuiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+
+        if(!available)
+        {
+            continue;
+        }
+
+        GLuint anySamplesPassed = GL_TRUE;
+        glFuncs->glGetQueryObjectuiv(queries[i], GL_QUERY_RESULT, &anySamplesPassed);
+
+        numOccluded += (anySamplesPassed ? 0 : 1) - occludedObjects[i];
+        occludedObjects[i] = anySamplesPassed ? 0 : 1;
+        issuedQueries[i] = 0;
+    }
+}
+
+//------------------------------------------------------------------------------------------
+void OcclusionCuller::beginQuery(int _object)
+{
+    glFuncs->glBeginQuery(GL_ANY_SAMPLES_PASSED, queries[_object]);
+    issuedQueries[_object] = 1;
+}
+
+//------------------------------------------------------------------------------------------
+void OcclusionCuller::endQuery()
+{
+    glFuncs->glEndQuery(GL_ANY_SAMPLES_PASSED);
+}
+
+//------------------------------------------------------------------------------------------
+// draw anyway if the result is not ready yet
+//------------------------------------------------------------------------------------------
+void OcclusionCuller::beginConditionalRender(int _object)
+{
+    glFuncs->glBeginConditionalRender(queries[_object], GL_QUERY_NO_WAIT);
+}
+
+//------------------------------------------------------------------------------------------
+void OcclusionCuller::endConditionalRender()
+{
+    glFuncs->glEndConditionalRender();
+}
+
+//------------------------------------------------------------------------------------------
+// the object could not be tested (e.g. the camera is inside its bounds)
+//------------------------------------------------------------------------------------------
+void OcclusionCuller::setVisible(int _object)
+{
+    numOccluded -= occludedObjects[_object];
+    occludedObjects[_object] = 0;
+    issuedQueries[_object] = 0;
+}
+
+//------------------------------------------------------------------------------------------
+bool OcclusionCuller::isOccluded(int _object) const
+{
+    return (_object < occludedObjects.size() && occludedObjects[_object]);
+}
+
+//------------------------------------------------------------------------------------------
+int OcclusionCuller::getNumOccluded() const
+{
+    return numOccluded;
+}
+
+//------------------------------------------------------------------------------------------
+void OcclusionCuller::destroyQueries()
+{
+    if(!queries.isEmpty())
+    {
+        glFuncs->glDeleteQueries(queries.size(), queries.data());
+    }
+
+    queries.clear();
+}
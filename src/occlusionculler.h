@@ -0,0 +1,57 @@
+//------------------------------------------------------------------------------------------
+// occlusionculler.h
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#ifndef OCCLUSIONCULLER_H
+#define OCCLUSIONCULLER_H
+
+#include <QtGui>
+#include <QOpenGLFunctions_4_0_Core>
+
+//------------------------------------------------------------------------------------------
+// Hardware occlusion queries on the bounding boxes of the scene objects.
+// Each object has one GL_ANY_SAMPLES_PASSED query, issued on its bounding box right before
+// the object is drawn, and the object is drawn inside glBeginConditionalRender on that
+// query: the GPU skips it without a CPU round trip when no sample of the box passed.
+// The same queries are read back at the beginning of the next frame, only if their result
+// is available (never stalling), so the CPU can skip the work of the objects which were
+// hidden in the previous frame (e.g. the cube map update of a reflective object).
+//------------------------------------------------------------------------------------------
+class OcclusionCuller
+{
+public:
+    OcclusionCuller();
+
+    void initialize(QOpenGLFunctions_4_0_Core* _glFuncs);
+    void setEnabled(bool _state);
+    bool isEnabled() const;
+
+    void resize(int _numObjects);
+    void collectResults();
+
+    void beginQuery(int _object);
+    void endQuery();
+    void beginConditionalRender(int _object);
+    void endConditionalRender();
+    void setVisible(int _object);
+
+    bool isOccluded(int _object) const;
+    int getNumOccluded() const;
+
+private:
+    void destroyQueries();
+
+    QOpenGLFunctions_4_0_Core* glFuncs;
+    bool enabled;
+
+    QVector<GLuint> queries;
+    QVector<uchar> issuedQueries;   // in the last frame
+    QVector<uchar> occludedObjects; // by the last available results
+    int numOccluded;
+};
+
+#endif // OCCLUSIONCULLER_H
@@ -0,0 +1,98 @@
+//------------------------------------------------------------------------------------------
+// offscreencontext.cpp
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#include "offscreencontext.h"
+
+//------------------------------------------------------------------------------------------
+OffscreenContext::OffscreenContext():
+    surface(NULL),
+    context(NULL)
+{
+}
+
+//------------------------------------------------------------------------------------------
+OffscreenContext::~OffscreenContext()
+{
+    if(context)
+    {
+        context->doneCurrent();
+        delete context;
+    }
+
+    if(surface)
+    {
+        surface->destroy();
+        delete surface;
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// use the default surface format (OpenGL 4.0 core profile, set in main)
+//------------------------------------------------------------------------------------------
+bool OffscreenContext::create()
+{
+    QSurfaceFormat format = QSurfaceFormat::defaultFormat();
+
+    surface = new QOffscreenSurface;
+    surface->setFormat(format);
+    surface->create();
+
+    if(!surface->isValid())
+    {
+        qDebug() << "OffscreenContext: cannot create the offscreen surface.";
+        return false;
+    }
+
+    context = new QOpenGLContext;
+    context->setFormat(format);
+
+    if(!context->create())
+    {
+        qDebug() << "OffscreenContext: cannot create the OpenGL context.";
+        return false;
+    }
+
+    return makeCurrent();
+}
+
+//------------------------------------------------------------------------------------------
+bool OffscreenContext::makeCurrent()
+{
+    return context->makeCurrent(surface);
+}
+
+//------------------------------------------------------------------------------------------
+void OffscreenContext::doneCurrent()
+{
+    context->doneCurrent();
+}
+
+//------------------------------------------------------------------------------------------
+QOpenGLContext* OffscreenContext::getContext()
+{
+    return context;
+}
+
+//------------------------------------------------------------------------------------------
+QSurface* OffscreenContext::getSurface()
+{
+    return surface;
+}
+
+//------------------------------------------------------------------------------------------
+// must be called with the context current
+//------------------------------------------------------------------------------------------
+QString OffscreenContext::getRendererInfo()
+{
+    QOpenGLFunctions* glFuncs = context->functions();
+
+    return QString("%1, %2, OpenGL %3")
+           .arg((const char*)glFuncs->glGetString(GL_VENDOR))
+           .arg((const char*)glFuncs->glGetString(GL_RENDERER))
+           .arg((const char*)glFuncs->glGetString(GL_VERSION));
+}
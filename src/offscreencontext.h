@@ -0,0 +1,39 @@
+//------------------------------------------------------------------------------------------
+// offscreencontext.h
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#ifndef OFFSCREENCONTEXT_H
+#define OFFSCREENCONTEXT_H
+
+#include <QtGui>
+
+//------------------------------------------------------------------------------------------
+// OpenGL context bound to an offscreen surface, for rendering without any window
+// (benchmarks, offline rendering). The rendering goes to framebuffer objects.
+// On a machine without display, run with QT_QPA_PLATFORM=offscreen; the software
+// rasterizer of Mesa (llvmpipe) is selected with LIBGL_ALWAYS_SOFTWARE=1
+//------------------------------------------------------------------------------------------
+class OffscreenContext
+{
+public:
+    OffscreenContext();
+    ~OffscreenContext();
+
+    bool create();
+    bool makeCurrent();
+    void doneCurrent();
+
+    QOpenGLContext* getContext();
+    QSurface* getSurface();
+    QString getRendererInfo();
+
+private:
+    QOffscreenSurface* surface;
+    QOpenGLContext* context;
+};
+
+#endif // OFFSCREENCONTEXT_H
@@ -0,0 +1,126 @@
+//------------------------------------------------------------------------------------------
+// probebaker.cpp
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#include "probebaker.h"
+
+//------------------------------------------------------------------------------------------
+static const RayTracingObject probeObjects[NUM_REFLECTIVE_OBJECTS] =
+{
+    RT_SEMI_REFLECTIVE_SPHERE,
+    RT_REFLECTIVE_SPHERE
+};
+
+static const char* probeNames[NUM_REFLECTIVE_OBJECTS] =
+{
+    "semi_reflective_sphere",
+    "reflective_sphere"
+};
+
+static const char* faceNames[6] = {"posx", "negx", "posy", "negy", "posz", "negz"};
+
+//------------------------------------------------------------------------------------------
+ProbeBaker::ProbeBaker():
+    faceSize(DEFAULT_PROBE_FACE_SIZE)
+{
+}
+
+//------------------------------------------------------------------------------------------
+void ProbeBaker::setScene(const RayTracingScene& _scene)
+{
+    scene = _scene;
+}
+
+//------------------------------------------------------------------------------------------
+void ProbeBaker::setFaceSize(int _faceSize)
+{
+    faceSize = _faceSize;
+}
+
+//------------------------------------------------------------------------------------------
+void ProbeBaker::setMaxBounces(int _maxBounces)
+{
+    rayTracer.setMaxBounces(_maxBounces);
+}
+
+//------------------------------------------------------------------------------------------
+void ProbeBaker::setSamplesPerPixel(int _samplesPerPixel)
+{
+    rayTracer.setSamplesPerPixel(_samplesPerPixel);
+}
+
+//------------------------------------------------------------------------------------------
+void ProbeBaker::setNumThreads(int _numThreads)
+{
+    rayTracer.setNumThreads(_numThreads);
+}
+
+//------------------------------------------------------------------------------------------
+// as in the GL renderer, a probe is placed at the object center and does not see the
+// object itself
+//------------------------------------------------------------------------------------------
+bool ProbeBaker::bake(const QString& _directory)
+{
+    PROFILE_ZONE("ProbeBaker::bake");
+
+    QVector<CubeMapProbe> probes;
+
+    for(int i = 0; i < NUM_REFLECTIVE_OBJECTS; ++i)
+    {
+        RayTracingObject object = probeObjects[i];
+        QVector3D center = scene.modelMatrices[object].map(QVector3D(0.0f, 0.0f, 0.0f));
+        probes.append(CubeMapProbe(center, object));
+    }
+
+    rayTracer.setScene(scene);
+    QVector<QImage> faces = rayTracer.renderCubeMaps(probes, faceSize);
+
+    if(faces.size() != 6 * NUM_REFLECTIVE_OBJECTS)
+    {
+        PRINT_ERROR("Cannot bake the probes.");
+        return false;
+    }
+
+    for(int i = 0; i < NUM_REFLECTIVE_OBJECTS; ++i)
+    {
+        ReflectiveObjects object = static_cast<ReflectiveObjects>(i);
+        QString probeDirectory = QFileInfo(getFaceFileName(_directory, object, 0)).path();
+
+        if(!QDir().mkpath(probeDirectory))
+        {
+            PRINT_ERROR(QString("Cannot create the directory %1").arg(probeDirectory));
+            return false;
+        }
+
+        for(int face = 0; face < 6; ++face)
+        {
+            QString fileName = getFaceFileName(_directory, object, face);
+
+            if(!faces[i * 6 + face].save(fileName))
+            {
+                PRINT_ERROR(QString("Cannot save the probe face %1").arg(fileName));
+                return false;
+            }
+        }
+    }
+
+    qDebug() << "ProbeBaker:" << NUM_REFLECTIVE_OBJECTS << "probes of" << faceSize << "x"
+             << faceSize << "texels baked in" << rayTracer.getRenderTime() << "s,"
+             << rayTracer.getNumRays() << "rays,"
+             << (double)rayTracer.getNumRays() / rayTracer.getRenderTime() * 1e-6
+             << "Mrays/s, saved to" << _directory;
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+QString ProbeBaker::getFaceFileName(const QString& _directory, ReflectiveObjects _object,
+                                    int _face)
+{
+    return QString("%1/%2/%3.png").arg(_directory).arg(probeNames[_object])
+           .arg(faceNames[_face]);
+}
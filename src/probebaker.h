@@ -0,0 +1,48 @@
+//------------------------------------------------------------------------------------------
+// probebaker.h
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#ifndef PROBEBAKER_H
+#define PROBEBAKER_H
+
+#include <QtGui>
+
+#include "raytracer.h"
+
+//------------------------------------------------------------------------------------------
+#define DEFAULT_PROBE_FACE_SIZE CUBE_MAP_SIZE
+
+//------------------------------------------------------------------------------------------
+// Bake the cube maps of the reflective objects offline with the CPU ray tracer, instead of
+// rendering them every frame on the GPU (see Renderer::createDynamicCubeMapTexture()).
+// The 6 faces of all the probes are traced by the same work stealing pool, tile by tile.
+// Each probe is saved as <directory>/<object>/{posx,negx,posy,negy,posz,negz}.png, the
+// layout of the sky cube map, and loaded back with Renderer::loadStaticProbes().
+//------------------------------------------------------------------------------------------
+class ProbeBaker
+{
+public:
+    ProbeBaker();
+
+    void setScene(const RayTracingScene& _scene);
+    void setFaceSize(int _faceSize);
+    void setMaxBounces(int _maxBounces);
+    void setSamplesPerPixel(int _samplesPerPixel);
+    void setNumThreads(int _numThreads);
+
+    bool bake(const QString& _directory);
+
+    static QString getFaceFileName(const QString& _directory, ReflectiveObjects _object,
+                                   int _face);
+
+private:
+    RayTracingScene scene;
+    RayTracer rayTracer;
+    int faceSize;
+};
+
+#endif // PROBEBAKER_H
@@ -0,0 +1,483 @@
+//------------------------------------------------------------------------------------------
+// qualityharness.cpp
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#include <algorithm>
+
+#include "qualityharness.h"
+
+//------------------------------------------------------------------------------------------
+static QString filterToString(QOpenGLTexture::Filter _filter)
+{
+    switch(_filter)
+    {
+    case QOpenGLTexture::Nearest:
+        return "nearest";
+
+    case QOpenGLTexture::Linear:
+        return "linear";
+
+    default:
+        return "trilinear";
+    }
+}
+
+//------------------------------------------------------------------------------------------
+static QOpenGLTexture::Filter filterFromString(const QString& _str,
+                                               QOpenGLTexture::Filter _default)
+{
+    if(_str == "nearest")
+    {
+        return QOpenGLTexture::Nearest;
+    }
+
+    if(_str == "linear")
+    {
+        return QOpenGLTexture::Linear;
+    }
+
+    if(_str == "trilinear")
+    {
+        return QOpenGLTexture::LinearMipMapLinear;
+    }
+
+    return _default;
+}
+
+//------------------------------------------------------------------------------------------
+QualityHarness::QualityHarness():
+    frameWidth(DEFAULT_BENCHMARK_WIDTH),
+    frameHeight(DEFAULT_BENCHMARK_HEIGHT),
+    numFrames(DEFAULT_QUALITY_FRAMES),
+    numComparedFrames(DEFAULT_QUALITY_COMPARED_FRAMES)
+{
+    reference.name = "reference";
+    reference.cubeMapSize = 2048;
+    reference.sphereNumStacks = 200;
+    reference.sphereNumSlices = 200;
+
+    keyframes = Benchmark::createOrbitPath(16, true);
+}
+
+//------------------------------------------------------------------------------------------
+void QualityHarness::setFrameSize(int _width, int _height)
+{
+    frameWidth = _width;
+    frameHeight = _height;
+}
+
+//------------------------------------------------------------------------------------------
+QualityHarness::Configuration
+QualityHarness::readConfiguration(const QJsonObject& _object, const Configuration& _default)
+{
+    Configuration configuration = _default;
+
+    configuration.name = _object.value("name").toString(_default.name);
+    configuration.cubeMapSize = _object.value("cubeMapSize").toInt(_default.cubeMapSize);
+    configuration.probeUpdateInterval = _object.value("probeUpdateInterval").toInt(
+                                            _default.probeUpdateInterval);
+    configuration.floorTextureFiltering =
+        filterFromString(_object.value("floorTextureFiltering").toString(),
+                         _default.floorTextureFiltering);
+    configuration.enabledAnisotropicFiltering =
+        _object.value("anisotropicFiltering").toBool(_default.enabledAnisotropicFiltering);
+    configuration.enabledDynamicEnvMapping = _object.value("dynamicEnvMapping").toBool(
+                                                 _default.enabledDynamicEnvMapping);
+
+    QJsonArray sphereResolution = _object.value("sphereResolution").toArray();
+
+    if(sphereResolution.size() == 2)
+    {
+        configuration.sphereNumStacks = sphereResolution[0].toInt(_default.sphereNumStacks);
+        configuration.sphereNumSlices = sphereResolution[1].toInt(_default.sphereNumSlices);
+    }
+
+    return configuration;
+}
+
+//------------------------------------------------------------------------------------------
+QJsonObject QualityHarness::configurationToJson(const Configuration& _configuration)
+{
+    QJsonArray sphereResolution;
+    sphereResolution.append(_configuration.sphereNumStacks);
+    sphereResolution.append(_configuration.sphereNumSlices);
+
+    QJsonObject object;
+    object.insert("name", _configuration.name);
+    object.insert("cubeMapSize", _configuration.cubeMapSize);
+    object.insert("sphereResolution", sphereResolution);
+    object.insert("probeUpdateInterval", _configuration.probeUpdateInterval);
+    object.insert("floorTextureFiltering",
+                  filterToString(_configuration.floorTextureFiltering));
+    object.insert("anisotropicFiltering", _configuration.enabledAnisotropicFiltering);
+    object.insert("dynamicEnvMapping", _configuration.enabledDynamicEnvMapping);
+
+    return object;
+}
+
+//------------------------------------------------------------------------------------------
+bool QualityHarness::loadConfigurations(const QString& _fileName)
+{
+    QFile file(_fileName);
+
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        PRINT_ERROR(QString("Cannot open configuration file %1").arg(_fileName));
+        return false;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+
+    if(document.isNull())
+    {
+        PRINT_ERROR(QString("Cannot parse configuration file %1: %2").arg(_fileName)
+                    .arg(parseError.errorString()));
+        return false;
+    }
+
+    QJsonObject root = document.object();
+    frameWidth = root.value("width").toInt(frameWidth);
+    frameHeight = root.value("height").toInt(frameHeight);
+    numFrames = qMax(1, root.value("frames").toInt(numFrames));
+    numComparedFrames = qBound(1, root.value("comparedFrames").toInt(numComparedFrames),
+                               numFrames);
+
+    if(root.contains("reference"))
+    {
+        reference = readConfiguration(root.value("reference").toObject(), reference);
+    }
+
+    configurations.clear();
+    QJsonArray configurationArray = root.value("configurations").toArray();
+
+    for(int i = 0; i < configurationArray.size(); ++i)
+    {
+        Configuration configuration;
+        configuration.name = QString("configuration %1").arg(i);
+        configurations.append(readConfiguration(configurationArray[i].toObject(),
+                                                 configuration));
+    }
+
+    return !configurations.isEmpty();
+}
+
+//------------------------------------------------------------------------------------------
+// vary one setting at a time from the default settings of the renderer
+//------------------------------------------------------------------------------------------
+void QualityHarness::createDefaultConfigurations()
+{
+    configurations.clear();
+
+    Configuration configuration;
+    configuration.name = "default";
+    configurations.append(configuration);
+
+    int cubeMapSizes[] = {128, 256, 1024};
+
+    for(int i = 0; i < 3; ++i)
+    {
+        configuration = Configuration();
+        configuration.cubeMapSize = cubeMapSizes[i];
+        configuration.name = QString("cube map %1").arg(cubeMapSizes[i]);
+        configurations.append(configuration);
+    }
+
+    int sphereResolutions[] = {10, 20, 60};
+
+    for(int i = 0; i < 3; ++i)
+    {
+        configuration = Configuration();
+        configuration.sphereNumStacks = sphereResolutions[i];
+        configuration.sphereNumSlices = sphereResolutions[i];
+        configuration.name = QString("sphere %1x%1").arg(sphereResolutions[i]);
+        configurations.append(configuration);
+    }
+
+    int updateIntervals[] = {2, 4, 8};
+
+    for(int i = 0; i < 3; ++i)
+    {
+        configuration = Configuration();
+        configuration.probeUpdateInterval = updateIntervals[i];
+        configuration.name = QString("probes every %1 frames").arg(updateIntervals[i]);
+        configurations.append(configuration);
+    }
+
+    configuration = Configuration();
+    configuration.floorTextureFiltering = QOpenGLTexture::Linear;
+    configuration.name = "floor linear";
+    configurations.append(configuration);
+
+    configuration.floorTextureFiltering = QOpenGLTexture::Nearest;
+    configuration.name = "floor nearest";
+    configurations.append(configuration);
+
+    configuration = Configuration();
+    configuration.enabledAnisotropicFiltering = false;
+    configuration.name = "no anisotropic filtering";
+    configurations.append(configuration);
+
+    configuration = Configuration();
+    configuration.enabledDynamicEnvMapping = false;
+    configuration.name = "static mapping";
+    configurations.append(configuration);
+
+    configuration = Configuration();
+    configuration.cubeMapSize = 256;
+    configuration.sphereNumStacks = 20;
+    configuration.sphereNumSlices = 20;
+    configuration.probeUpdateInterval = 2;
+    configuration.name = "cube map 256, sphere 20x20, probes every 2 frames";
+    configurations.append(configuration);
+}
+
+//------------------------------------------------------------------------------------------
+void QualityHarness::applyConfiguration(Renderer* _renderer,
+                                        const Configuration& _configuration)
+{
+    _renderer->setCubeMapSize(_configuration.cubeMapSize);
+    _renderer->setProbeUpdateInterval(_configuration.probeUpdateInterval);
+    _renderer->changeSphereResolution(_configuration.sphereNumStacks,
+                                      _configuration.sphereNumSlices);
+    _renderer->changeFloorTextureFilteringMode(_configuration.floorTextureFiltering);
+    _renderer->enableTextureAnisotropicFiltering(
+        _configuration.enabledAnisotropicFiltering);
+    _renderer->enableDynamicEnvironmentMapping(_configuration.enabledDynamicEnvMapping);
+}
+
+//------------------------------------------------------------------------------------------
+// evenly spaced over the frames
+//------------------------------------------------------------------------------------------
+bool QualityHarness::isComparedFrame(int _frame) const
+{
+    int step = qMax(1, numFrames / numComparedFrames);
+
+    return (_frame % step == 0) && (_frame / step < numComparedFrames);
+}
+
+//------------------------------------------------------------------------------------------
+// same frame timing as the benchmark: each frame is finished before the timer stops, the
+// compared frames are read back after that
+//------------------------------------------------------------------------------------------
+QVector<double> QualityHarness::renderFrames(Renderer* _renderer, QOpenGLContext* _context,
+                                             const Configuration& _configuration,
+                                             QVector<QImage>& _comparedFrames)
+{
+    PROFILE_ZONE("QualityHarness::renderFrames");
+
+    applyConfiguration(_renderer, _configuration);
+
+    QOpenGLFunctions* glFuncs = _context->functions();
+    QVector<double> frameTimes;
+    QElapsedTimer frameTimer;
+
+    for(int frame = -DEFAULT_QUALITY_WARMUP_FRAMES; frame < numFrames; ++frame)
+    {
+        float time = (numFrames > 1) ?
+                     (float)qMax(frame, 0) / (float)(numFrames - 1) : 0.0f;
+        Benchmark::applyKeyframe(_renderer,
+                                 Benchmark::interpolateKeyframes(keyframes, time));
+
+        frameTimer.start();
+        _renderer->renderHeadlessFrame();
+        glFuncs->glFinish();
+
+        if(frame < 0)
+        {
+            continue;
+        }
+
+        frameTimes.append((double)frameTimer.nsecsElapsed() * 1e-6);
+
+        if(isComparedFrame(frame))
+        {
+            _comparedFrames.append(_renderer->grabHeadlessFrame());
+        }
+    }
+
+    return frameTimes;
+}
+
+//------------------------------------------------------------------------------------------
+QualityHarness::Result
+QualityHarness::compareConfiguration(Renderer* _renderer, QOpenGLContext* _context,
+                                     const Configuration& _configuration,
+                                     const QVector<QImage>& _referenceFrames)
+{
+    QVector<QImage> frames;
+    QVector<double> frameTimes = renderFrames(_renderer, _context, _configuration, frames);
+
+    Result result;
+    result.configuration = _configuration;
+    result.frameTimeStatistics = Benchmark::computeFrameTimeStatistics(frameTimes);
+    result.meanFrameTime = result.frameTimeStatistics.value("mean").toDouble();
+    result.meanPSNR = 0.0;
+    result.minPSNR = IMAGE_METRICS_MAX_PSNR;
+    result.meanSSIM = 0.0;
+    result.paretoOptimal = false;
+
+    for(int i = 0; i < frames.size(); ++i)
+    {
+        double psnr = ImageMetrics::computePSNR(frames[i], _referenceFrames[i]);
+        result.meanPSNR += psnr;
+        result.minPSNR = qMin(result.minPSNR, psnr);
+        result.meanSSIM += ImageMetrics::computeSSIM(frames[i], _referenceFrames[i]);
+    }
+
+    result.meanPSNR /= (double)qMax(1, frames.size());
+    result.meanSSIM /= (double)qMax(1, frames.size());
+
+    qDebug() << "QualityHarness:" << _configuration.name << "-" << result.meanFrameTime
+             << "ms," << result.meanPSNR << "dB," << "SSIM" << result.meanSSIM;
+
+    return result;
+}
+
+//------------------------------------------------------------------------------------------
+// a configuration is on the front if no other one is at least as fast and as accurate,
+// and strictly better in one of the two
+//------------------------------------------------------------------------------------------
+void QualityHarness::findParetoFront(QVector<Result>& _results)
+{
+    for(int i = 0; i < _results.size(); ++i)
+    {
+        _results[i].paretoOptimal = true;
+
+        for(int j = 0; j < _results.size(); ++j)
+        {
+            const Result& a = _results[i];
+            const Result& b = _results[j];
+
+            bool notWorse = (b.meanFrameTime <= a.meanFrameTime) &&
+                            (b.meanSSIM >= a.meanSSIM);
+            bool better = (b.meanFrameTime < a.meanFrameTime) || (b.meanSSIM > a.meanSSIM);
+
+            if(i != j && notWorse && better)
+            {
+                _results[i].paretoOptimal = false;
+                break;
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// sorted by frame time, the Pareto optimal configurations are marked with a '*'
+//------------------------------------------------------------------------------------------
+void QualityHarness::printTable(const QVector<Result>& _results)
+{
+    QVector<Result> results = _results;
+    std::sort(results.begin(), results.end(), [](const Result & _a, const Result & _b)
+    {
+        return _a.meanFrameTime < _b.meanFrameTime;
+    });
+
+    QTextStream out(stderr);
+    out << QString("%1 %2 %3 %4 %5 %6  %7\n").arg("", 1).arg("frame (ms)", 10)
+        .arg("p95 (ms)", 9).arg("PSNR (dB)", 9).arg("min PSNR", 9).arg("1 - SSIM", 9)
+        .arg("configuration");
+
+    for(int i = 0; i < results.size(); ++i)
+    {
+        const Result& result = results[i];
+        out << QString("%1 %2 %3 %4 %5 %6  %7\n").arg(result.paretoOptimal ? "*" : " ")
+            .arg(result.meanFrameTime, 10, 'f', 3)
+            .arg(result.frameTimeStatistics.value("p95").toDouble(), 9, 'f', 3)
+            .arg(result.meanPSNR, 9, 'f', 2).arg(result.minPSNR, 9, 'f', 2)
+            .arg(1.0 - result.meanSSIM, 9, 'f', 5).arg(result.configuration.name);
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// write the results to _outputFile, or to the standard output if it is empty
+//------------------------------------------------------------------------------------------
+bool QualityHarness::run(const QString& _outputFile)
+{
+    PROFILE_ZONE("QualityHarness::run");
+
+    if(configurations.isEmpty())
+    {
+        createDefaultConfigurations();
+    }
+
+    OffscreenContext offscreenContext;
+
+    if(!offscreenContext.create())
+    {
+        PRINT_ERROR("Cannot create the offscreen OpenGL context.");
+        return false;
+    }
+
+    Renderer renderer;
+    QOpenGLContext* context = offscreenContext.getContext();
+    renderer.initializeHeadless(context, offscreenContext.getSurface(), frameWidth,
+                                frameHeight);
+
+    QVector<QImage> referenceFrames;
+    QVector<double> referenceFrameTimes = renderFrames(&renderer, context, reference,
+                                                       referenceFrames);
+
+    QVector<Result> results;
+
+    for(int i = 0; i < configurations.size(); ++i)
+    {
+        results.append(compareConfiguration(&renderer, context, configurations[i],
+                                            referenceFrames));
+    }
+
+    findParetoFront(results);
+    printTable(results);
+
+    QJsonObject referenceObject = configurationToJson(reference);
+    referenceObject.insert("frameTimeMs",
+                           Benchmark::computeFrameTimeStatistics(referenceFrameTimes));
+
+    QJsonArray resultArray;
+
+    for(int i = 0; i < results.size(); ++i)
+    {
+        QJsonObject object = configurationToJson(results[i].configuration);
+        object.insert("frameTimeMs", results[i].frameTimeStatistics);
+        object.insert("meanPSNR", results[i].meanPSNR);
+        object.insert("minPSNR", results[i].minPSNR);
+        object.insert("meanSSIM", results[i].meanSSIM);
+        object.insert("paretoOptimal", results[i].paretoOptimal);
+        resultArray.append(object);
+    }
+
+    QJsonObject report;
+    report.insert("renderer", offscreenContext.getRendererInfo());
+    report.insert("width", frameWidth);
+    report.insert("height", frameHeight);
+    report.insert("frames", numFrames);
+    report.insert("comparedFrames", numComparedFrames);
+    report.insert("date", QDateTime::currentDateTime().toString(Qt::ISODate));
+    report.insert("reference", referenceObject);
+    report.insert("configurations", resultArray);
+
+    QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+
+    if(_outputFile.isEmpty())
+    {
+        QTextStream(stdout) << json;
+        return true;
+    }
+
+    QFile file(_outputFile);
+
+    if(!file.open(QIODevice::WriteOnly))
+    {
+        PRINT_ERROR(QString("Cannot open output file %1").arg(_outputFile));
+        return false;
+    }
+
+    file.write(json);
+    file.close();
+
+    return true;
+}
@@ -0,0 +1,113 @@
+//------------------------------------------------------------------------------------------
+// qualityharness.h
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#ifndef QUALITYHARNESS_H
+#define QUALITYHARNESS_H
+
+#include <QtGui>
+
+#include "renderer.h"
+#include "offscreencontext.h"
+#include "benchmark.h"
+#include "imagemetrics.h"
+
+//------------------------------------------------------------------------------------------
+#define DEFAULT_QUALITY_FRAMES 120
+#define DEFAULT_QUALITY_COMPARED_FRAMES 12
+#define DEFAULT_QUALITY_WARMUP_FRAMES 10
+
+//------------------------------------------------------------------------------------------
+// Render the same scripted frames (the benchmark orbit, with moving objects) with several
+// rendering configurations and compare them with a high quality reference configuration.
+// Each configuration reports its frame times and the PSNR/SSIM of some evenly spaced
+// frames against the reference; the configurations which are not beaten on both the
+// frame time and the error (1 - SSIM) by another one form the Pareto front, the
+// candidates for the production presets.
+//
+// Configuration file (all the fields are optional):
+// {
+//     "width": 1280, "height": 720, "frames": 120, "comparedFrames": 12,
+//     "reference": {"cubeMapSize": 2048, "sphereResolution": [200, 200], ...},
+//     "configurations": [
+//     {
+//         "name": "256, lod 20, every 2 frames", "cubeMapSize": 256,
+//         "sphereResolution": [20, 20], "probeUpdateInterval": 2,
+//         "floorTextureFiltering": "nearest" | "linear" | "trilinear",
+//         "anisotropicFiltering": true, "dynamicEnvMapping": true
+//     }, ...]
+// }
+//------------------------------------------------------------------------------------------
+class QualityHarness
+{
+public:
+    struct Configuration
+    {
+        Configuration():
+            cubeMapSize(CUBE_MAP_SIZE),
+            sphereNumStacks(30),
+            sphereNumSlices(30),
+            probeUpdateInterval(1),
+            floorTextureFiltering(QOpenGLTexture::LinearMipMapLinear),
+            enabledAnisotropicFiltering(true),
+            enabledDynamicEnvMapping(true) {}
+
+        QString name;
+        int cubeMapSize;
+        int sphereNumStacks;
+        int sphereNumSlices;
+        int probeUpdateInterval;
+        QOpenGLTexture::Filter floorTextureFiltering;
+        bool enabledAnisotropicFiltering;
+        bool enabledDynamicEnvMapping;
+    };
+
+    QualityHarness();
+
+    void setFrameSize(int _width, int _height);
+    bool loadConfigurations(const QString& _fileName);
+    void createDefaultConfigurations();
+    bool run(const QString& _outputFile);
+
+private:
+    struct Result
+    {
+        Configuration configuration;
+        QJsonObject frameTimeStatistics;
+        double meanFrameTime;
+        double meanPSNR;
+        double minPSNR;
+        double meanSSIM;
+        bool paretoOptimal;
+    };
+
+    QVector<double> renderFrames(Renderer* _renderer, QOpenGLContext* _context,
+                                 const Configuration& _configuration,
+                                 QVector<QImage>& _comparedFrames);
+    Result compareConfiguration(Renderer* _renderer, QOpenGLContext* _context,
+                                const Configuration& _configuration,
+                                const QVector<QImage>& _referenceFrames);
+    bool isComparedFrame(int _frame) const;
+
+    static void applyConfiguration(Renderer* _renderer,
+                                   const Configuration& _configuration);
+    static Configuration readConfiguration(const QJsonObject& _object,
+                                           const Configuration& _default);
+    static QJsonObject configurationToJson(const Configuration& _configuration);
+    static void findParetoFront(QVector<Result>& _results);
+    static void printTable(const QVector<Result>& _results);
+
+    int frameWidth;
+    int frameHeight;
+    int numFrames;
+    int numComparedFrames;
+    Configuration reference;
+    QVector<Configuration> configurations;
+    QVector<Benchmark::Keyframe> keyframes;
+};
+
+#endif // QUALITYHARNESS_H
@@ -0,0 +1,941 @@
+//------------------------------------------------------------------------------------------
+// raytracer.cpp
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#include <algorithm>
+
+#include "raytracer.h"
+#include "float4.h"
+
+#define RAYTRACER_NO_HIT 1e30f
+
+//------------------------------------------------------------------------------------------
+struct RayPacket
+{
+    Float4 ox, oy, oz;
+    Float4 dx, dy, dz;
+};
+
+//------------------------------------------------------------------------------------------
+// bilinear lookup in an RGBA8888 image, (_x, _y) in pixels
+//------------------------------------------------------------------------------------------
+static QVector4D sampleBilinear(const QImage& _image, float _x, float _y, bool _repeat)
+{
+    int width = _image.width();
+    int height = _image.height();
+    float x = _x - 0.5f;
+    float y = _y - 0.5f;
+    int x0 = (int)qFloor(x);
+    int y0 = (int)qFloor(y);
+    float fx = x - (float)x0;
+    float fy = y - (float)y0;
+
+    QVector4D texels[4];
+
+    for(int i = 0; i < 4; ++i)
+    {
+        int tx = x0 + (i & 1);
+        int ty = y0 + (i >> 1);
+
+        if(_repeat)
+        {
+            tx = ((tx % width) + width) % width;
+            ty = ((ty % height) + height) % height;
+        }
+        else
+        {
+            tx = qBound(0, tx, width - 1);
+            ty = qBound(0, ty, height - 1);
+        }
+
+        const uchar* texel = _image.constScanLine(ty) + tx * 4;
+        texels[i] = QVector4D(texel[0], texel[1], texel[2], texel[3]);
+    }
+
+    return ((texels[0] * (1.0f - fx) + texels[1] * fx) * (1.0f - fy) +
+            (texels[2] * (1.0f - fx) + texels[3] * fx) * fy) / 255.0f;
+}
+
+//------------------------------------------------------------------------------------------
+// 2D texture. The GL textures are uploaded mirrored, so t = 0 is the last image row.
+//------------------------------------------------------------------------------------------
+struct RayTracer::Texture
+{
+    Texture(const QImage& _image, bool _repeat):
+        image(_image.convertToFormat(QImage::Format_RGBA8888)),
+        repeat(_repeat) {}
+
+    QVector4D sample(const QVector2D& _texCoord) const
+    {
+        return sampleBilinear(image, _texCoord.x() * (float)image.width(),
+                              (1.0f - _texCoord.y()) * (float)image.height(), repeat);
+    }
+
+    QImage image;
+    bool repeat;
+};
+
+//------------------------------------------------------------------------------------------
+// Cube map with the faces in GL order (+X, -X, +Y, -Y, +Z, -Z), not mirrored.
+// The face and its (s, t) coordinates are selected as in the GL specification.
+//------------------------------------------------------------------------------------------
+struct RayTracer::CubeMap
+{
+    QVector3D sample(const QVector3D& _dir) const
+    {
+        float ax = qAbs(_dir.x());
+        float ay = qAbs(_dir.y());
+        float az = qAbs(_dir.z());
+        int face;
+        float sc, tc, ma;
+
+        if(ax >= ay && ax >= az)
+        {
+            ma = ax;
+            face = (_dir.x() > 0.0f) ? 0 : 1;
+            sc = (_dir.x() > 0.0f) ? -_dir.z() : _dir.z();
+            tc = -_dir.y();
+        }
+        else if(ay >= az)
+        {
+            ma = ay;
+            face = (_dir.y() > 0.0f) ? 2 : 3;
+            sc = _dir.x();
+            tc = (_dir.y() > 0.0f) ? _dir.z() : -_dir.z();
+        }
+        else
+        {
+            ma = az;
+            face = (_dir.z() > 0.0f) ? 4 : 5;
+            sc = (_dir.z() > 0.0f) ? _dir.x() : -_dir.x();
+            tc = -_dir.y();
+        }
+
+        float s = 0.5f * (sc / ma + 1.0f);
+        float t = 0.5f * (tc / ma + 1.0f);
+        const QImage& image = faces[face];
+
+        return sampleBilinear(image, s * (float)image.width(), t * (float)image.height(),
+                              false).toVector3D();
+    }
+
+    QImage faces[6];
+};
+
+//------------------------------------------------------------------------------------------
+// Intersection kernels, in object space. The ray directions are not normalized after the
+// transformation, so the distances are the same as in world space.
+// Return the distance of the nearest hit in front of the origin, RAYTRACER_NO_HIT if none.
+//------------------------------------------------------------------------------------------
+static Float4 intersectUnitSphere(const RayPacket& _rays)
+{
+    Float4 a = _rays.dx * _rays.dx + _rays.dy * _rays.dy + _rays.dz * _rays.dz;
+    Float4 b = _rays.ox * _rays.dx + _rays.oy * _rays.dy + _rays.oz * _rays.dz;
+    Float4 c = _rays.ox * _rays.ox + _rays.oy * _rays.oy + _rays.oz * _rays.oz -
+               Float4(1.0f);
+    Float4 discriminant = b * b - a * c;
+    Float4 root = sqrt4(max4(discriminant, Float4(0.0f)));
+    Float4 epsilon(RAYTRACER_EPSILON);
+
+    Float4 tNear = (Float4(0.0f) - b - root) / a;
+    Float4 tFar = (Float4(0.0f) - b + root) / a;
+    Float4 t = select4(lessThan(epsilon, tNear), tNear, tFar);
+    Float4 hit = and4(lessEqual(Float4(0.0f), discriminant), lessThan(epsilon, t));
+
+    return select4(hit, t, Float4(RAYTRACER_NO_HIT));
+}
+
+//------------------------------------------------------------------------------------------
+static Float4 intersectUnitBox(const RayPacket& _rays)
+{
+    Float4 one(1.0f);
+    Float4 minusOne(-1.0f);
+    Float4 invDx = one / _rays.dx;
+    Float4 invDy = one / _rays.dy;
+    Float4 invDz = one / _rays.dz;
+
+    Float4 tx1 = (minusOne - _rays.ox) * invDx;
+    Float4 tx2 = (one - _rays.ox) * invDx;
+    Float4 ty1 = (minusOne - _rays.oy) * invDy;
+    Float4 ty2 = (one - _rays.oy) * invDy;
+    Float4 tz1 = (minusOne - _rays.oz) * invDz;
+    Float4 tz2 = (one - _rays.oz) * invDz;
+
+    Float4 tNear = max4(max4(min4(tx1, tx2), min4(ty1, ty2)), min4(tz1, tz2));
+    Float4 tFar = min4(min4(max4(tx1, tx2), max4(ty1, ty2)), max4(tz1, tz2));
+    Float4 epsilon(RAYTRACER_EPSILON);
+
+    Float4 t = select4(lessThan(epsilon, tNear), tNear, tFar);
+    Float4 hit = and4(lessEqual(tNear, tFar), lessThan(epsilon, t));
+
+    return select4(hit, t, Float4(RAYTRACER_NO_HIT));
+}
+
+//------------------------------------------------------------------------------------------
+// the floor plane: y = 0, -1 <= x, z <= 1
+//------------------------------------------------------------------------------------------
+static Float4 intersectUnitPlane(const RayPacket& _rays)
+{
+    Float4 zero(0.0f);
+    Float4 one(1.0f);
+    Float4 t = (zero - _rays.oy) / _rays.dy;
+    Float4 x = _rays.ox + t * _rays.dx;
+    Float4 z = _rays.oz + t * _rays.dz;
+
+    Float4 hit = and4(lessThan(Float4(RAYTRACER_EPSILON), t),
+                      and4(lessEqual(max4(x, zero - x), one),
+                           lessEqual(max4(z, zero - z), one)));
+
+    return select4(hit, t, Float4(RAYTRACER_NO_HIT));
+}
+
+//------------------------------------------------------------------------------------------
+static void transformRays(const QMatrix4x4& _matrix, const RayPacket& _rays,
+                          RayPacket& _transformedRays)
+{
+    // column major
+    const float* m = _matrix.constData();
+
+    _transformedRays.ox = Float4(m[0]) * _rays.ox + Float4(m[4]) * _rays.oy +
+                          Float4(m[8]) * _rays.oz + Float4(m[12]);
+    _transformedRays.oy = Float4(m[1]) * _rays.ox + Float4(m[5]) * _rays.oy +
+                          Float4(m[9]) * _rays.oz + Float4(m[13]);
+    _transformedRays.oz = Float4(m[2]) * _rays.ox + Float4(m[6]) * _rays.oy +
+                          Float4(m[10]) * _rays.oz + Float4(m[14]);
+
+    _transformedRays.dx = Float4(m[0]) * _rays.dx + Float4(m[4]) * _rays.dy +
+                          Float4(m[8]) * _rays.dz;
+    _transformedRays.dy = Float4(m[1]) * _rays.dx + Float4(m[5]) * _rays.dy +
+                          Float4(m[9]) * _rays.dz;
+    _transformedRays.dz = Float4(m[2]) * _rays.dx + Float4(m[6]) * _rays.dy +
+                          Float4(m[10]) * _rays.dz;
+}
+
+//------------------------------------------------------------------------------------------
+static inline float getLane(const Float4& _values, int _lane)
+{
+    float values[4];
+    _values.store(values);
+
+    return values[_lane];
+}
+
+//------------------------------------------------------------------------------------------
+RayTracingScene::RayTracingScene():
+    cameraPosition(DEFAULT_CAMERA_POSITION),
+    cameraFocus(DEFAULT_CAMERA_FOCUS),
+    cameraUpDirection(0.0f, 1.0f, 0.0f),
+    floorTexCoordScale(30.0f)
+{
+    // the default scene of the renderer, see Renderer::initSharedBlockUniform() and
+    // Renderer::initSceneMatrices()
+    light.position = DEFAULT_LIGHT_POSITION;
+    light.intensity = 1.0f;
+
+    modelMatrices[RT_FLOOR].scale(floorTexCoordScale * 2.0f);
+    materials[RT_FLOOR].shininess = 50.0f;
+    materials[RT_FLOOR].setSpecular(QVector4D(0.5f, 0.5f, 0.5f, 1.0f));
+
+    modelMatrices[RT_CUBE].scale(1.5f);
+    modelMatrices[RT_CUBE].translate(DEFAULT_CUBE_POSITION);
+    materials[RT_CUBE].shininess = 50.0f;
+    materials[RT_CUBE].setDiffuse(QVector4D(0.0f, 1.0f, 0.2f, 1.0f));
+
+    modelMatrices[RT_SEMI_REFLECTIVE_SPHERE].translate(DEFAULT_SPHERE_POSITION);
+    materials[RT_SEMI_REFLECTIVE_SPHERE].shininess = 100.0f;
+    materials[RT_SEMI_REFLECTIVE_SPHERE].setDiffuse(QVector4D(0.8f, 0.8f, 0.0f, 1.0f));
+    materials[RT_SEMI_REFLECTIVE_SPHERE].setSpecular(QVector4D(0.5f, 0.5f, 0.5f, 1.0f));
+    materials[RT_SEMI_REFLECTIVE_SPHERE].setReflection(0.5f);
+
+    modelMatrices[RT_REFLECTIVE_SPHERE].translate(DEFAULT_REFLECTIVE_SPHERE_POSITION);
+    materials[RT_REFLECTIVE_SPHERE].setDiffuse(QVector4D(1.0f, 1.0f, 1.0f, 1.0f));
+    materials[RT_REFLECTIVE_SPHERE].setReflection(1.0f);
+}
+
+//------------------------------------------------------------------------------------------
+RayTracer::RayTracer():
+    skyTexture(NULL),
+    maxBounces(RAYTRACER_DEFAULT_MAX_BOUNCES),
+    samplesPerAxis(2),
+    numThreads(0),
+    numRays(0),
+    renderTime(0.0)
+{
+    for(int i = 0; i < NUM_RAY_TRACING_OBJECTS; ++i)
+    {
+        objectTextures[i] = NULL;
+    }
+
+    setSamplesPerPixel(RAYTRACER_DEFAULT_SAMPLES_PER_PIXEL);
+}
+
+//------------------------------------------------------------------------------------------
+RayTracer::~RayTracer()
+{
+    for(int i = 0; i < NUM_RAY_TRACING_OBJECTS; ++i)
+    {
+        delete objectTextures[i];
+    }
+
+    delete skyTexture;
+}
+
+//------------------------------------------------------------------------------------------
+void RayTracer::setScene(const RayTracingScene& _scene)
+{
+    scene = _scene;
+}
+
+//------------------------------------------------------------------------------------------
+void RayTracer::setMaxBounces(int _maxBounces)
+{
+    maxBounces = qMax(0, _maxBounces);
+}
+
+//------------------------------------------------------------------------------------------
+// the samples are on a regular grid, the number is rounded to a square
+//------------------------------------------------------------------------------------------
+void RayTracer::setSamplesPerPixel(int _samplesPerPixel)
+{
+    samplesPerAxis = qMax(1, qRound(qSqrt((qreal)qMax(1, _samplesPerPixel))));
+}
+
+//------------------------------------------------------------------------------------------
+void RayTracer::setNumThreads(int _numThreads)
+{
+    numThreads = _numThreads;
+}
+
+//------------------------------------------------------------------------------------------
+double RayTracer::getRenderTime() const
+{
+    return renderTime;
+}
+
+//------------------------------------------------------------------------------------------
+qint64 RayTracer::getNumRays() const
+{
+    return numRays;
+}
+
+//------------------------------------------------------------------------------------------
+QImage RayTracer::render(int _width, int _height)
+{
+    PROFILE_ZONE("RayTracer::render");
+
+    if(!prepareRendering())
+    {
+        return QImage();
+    }
+
+    // RGB32 scanlines have no padding, the tiles write directly into the pixel buffer
+    QImage image(_width, _height, QImage::Format_RGB32);
+
+    View view;
+    view.origin = scene.cameraPosition;
+    view.forward = (scene.cameraFocus - scene.cameraPosition).normalized();
+    view.right = QVector3D::crossProduct(view.forward,
+                                         scene.cameraUpDirection).normalized();
+    view.up = QVector3D::crossProduct(view.right, view.forward);
+    view.tanHalfHeight = qTan(qDegreesToRadians(CAMERA_FOVY * 0.5f));
+    view.tanHalfWidth = view.tanHalfHeight * (float)_width / (float)_height;
+    view.width = _width;
+    view.height = _height;
+    view.hiddenObject = -1;
+    view.pixels = image.bits();
+
+    renderViews(QVector<View>() << view);
+
+    return image;
+}
+
+//------------------------------------------------------------------------------------------
+// Render the six faces of each probe, in GL order (+X, -X, +Y, -Y, +Z, -Z), with the
+// texel layout of glTexImage2D: the first row is t = 0 (the images are not mirrored).
+// All the faces are rendered by the same pool, so the faces seeing nothing but the sky do
+// not leave cores idle.
+//------------------------------------------------------------------------------------------
+QVector<QImage> RayTracer::renderCubeMaps(const QVector<CubeMapProbe>& _probes,
+                                          int _faceSize)
+{
+    PROFILE_ZONE("RayTracer::renderCubeMaps");
+
+    if(!prepareRendering())
+    {
+        return QVector<QImage>();
+    }
+
+    // face basis: the direction of the texel (s, t) is forward + (2s-1) right + (1-2t) up
+    static const QVector3D forwardDirs[6] =
+    {
+        QVector3D(1.0f, 0.0f, 0.0f),
+        QVector3D(-1.0f, 0.0f, 0.0f),
+        QVector3D(0.0f, 1.0f, 0.0f),
+        QVector3D(0.0f, -1.0f, 0.0f),
+        QVector3D(0.0f, 0.0f, 1.0f),
+        QVector3D(0.0f, 0.0f, -1.0f)
+    };
+
+    static const QVector3D rightDirs[6] =
+    {
+        QVector3D(0.0f, 0.0f, -1.0f),
+        QVector3D(0.0f, 0.0f, 1.0f),
+        QVector3D(1.0f, 0.0f, 0.0f),
+        QVector3D(1.0f, 0.0f, 0.0f),
+        QVector3D(1.0f, 0.0f, 0.0f),
+        QVector3D(-1.0f, 0.0f, 0.0f)
+    };
+
+    static const QVector3D upDirs[6] =
+    {
+        QVector3D(0.0f, 1.0f, 0.0f),
+        QVector3D(0.0f, 1.0f, 0.0f),
+        QVector3D(0.0f, 0.0f, -1.0f),
+        QVector3D(0.0f, 0.0f, 1.0f),
+        QVector3D(0.0f, 1.0f, 0.0f),
+        QVector3D(0.0f, 1.0f, 0.0f)
+    };
+
+    QVector<QImage> faces;
+    QVector<View> views;
+
+    for(int i = 0; i < _probes.size(); ++i)
+    {
+        for(int face = 0; face < 6; ++face)
+        {
+            faces.append(QImage(_faceSize, _faceSize, QImage::Format_RGB32));
+
+            View view;
+            view.origin = _probes[i].position;
+            view.forward = forwardDirs[face];
+            view.right = rightDirs[face];
+            view.up = upDirs[face];
+            view.tanHalfWidth = 1.0f;
+            view.tanHalfHeight = 1.0f;
+            view.width = _faceSize;
+            view.height = _faceSize;
+            view.hiddenObject = _probes[i].hiddenObject;
+            view.pixels = faces.last().bits();
+            views.append(view);
+        }
+    }
+
+    renderViews(views);
+
+    return faces;
+}
+
+//------------------------------------------------------------------------------------------
+bool RayTracer::prepareRendering()
+{
+    if(!skyTexture && !loadTextures())
+    {
+        return false;
+    }
+
+    for(int i = 0; i < NUM_RAY_TRACING_OBJECTS; ++i)
+    {
+        worldToObject[i] = scene.modelMatrices[i].inverted();
+        normalMatrices[i] = QMatrix4x4(scene.modelMatrices[i].normalMatrix());
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+// one task per tile, the tiles of all the views are numbered one after the other
+//------------------------------------------------------------------------------------------
+void RayTracer::renderViews(const QVector<View>& _views)
+{
+    QVector<View> views = _views;
+    QVector<int> firstTasks;
+    int numTasks = 0;
+
+    for(int i = 0; i < views.size(); ++i)
+    {
+        View& view = views[i];
+        view.numTilesX = (view.width + RAYTRACER_TILE_SIZE - 1) / RAYTRACER_TILE_SIZE;
+        view.numTiles = view.numTilesX *
+                        ((view.height + RAYTRACER_TILE_SIZE - 1) / RAYTRACER_TILE_SIZE);
+
+        firstTasks.append(numTasks);
+        numTasks += view.numTiles;
+    }
+
+    WorkStealingPool pool(numThreads);
+    numRaysPerWorker.fill(0, pool.getNumWorkers());
+
+    QElapsedTimer renderTimer;
+    renderTimer.start();
+
+    const View* viewData = views.constData();
+    const int* firstTaskData = firstTasks.constData();
+    int numViews = views.size();
+
+    pool.run(numTasks, [this, viewData, firstTaskData, numViews](int _task, int _worker)
+    {
+        int viewIndex = (int)(std::upper_bound(firstTaskData, firstTaskData + numViews,
+                                               _task) - firstTaskData) - 1;
+        const View& view = viewData[viewIndex];
+        int tile = _task - firstTaskData[viewIndex];
+
+        renderTile(view, tile % view.numTilesX, tile / view.numTilesX, _worker);
+    });
+
+    renderTime = (double)renderTimer.nsecsElapsed() * 1e-9;
+    numRays = 0;
+
+    for(int i = 0; i < numRaysPerWorker.size(); ++i)
+    {
+        numRays += numRaysPerWorker[i];
+    }
+
+    int numStolenTasks = 0;
+    QVector<WorkStealingPool::WorkerStatistics> statistics = pool.getStatistics();
+
+    for(int i = 0; i < statistics.size(); ++i)
+    {
+        numStolenTasks += statistics[i].numStolenTasks;
+    }
+
+    qDebug() << "RayTracer:" << numViews << "view(s)," << numTasks << "tiles,"
+             << samplesPerAxis * samplesPerAxis << "spp," << maxBounces << "bounces,"
+             << pool.getNumWorkers() << "threads:" << renderTime << "s,"
+             << (double)numRays / renderTime * 1e-6 << "Mrays/s,"
+             << numStolenTasks << "tiles stolen";
+}
+
+//------------------------------------------------------------------------------------------
+// the same images as the GL textures, see Renderer::initTexture()
+//------------------------------------------------------------------------------------------
+bool RayTracer::loadTextures()
+{
+    PROFILE_ZONE("RayTracer::loadTextures");
+
+    QImage floorImage(":/textures/checkerboard.jpg");
+    QImage decalImage(":/textures/minion.png");
+    QImage sphereImage(":/textures/earth.jpg");
+
+    if(floorImage.isNull() || decalImage.isNull() || sphereImage.isNull())
+    {
+        PRINT_ERROR("Cannot load the ray tracer textures.");
+        return false;
+    }
+
+    objectTextures[RT_FLOOR] = new Texture(floorImage, true);
+    objectTextures[RT_CUBE] = new Texture(decalImage, false);
+    objectTextures[RT_SEMI_REFLECTIVE_SPHERE] = new Texture(sphereImage, true);
+
+    const char* faceNames[6] = {"posx", "negx", "posy", "negy", "posz", "negz"};
+    skyTexture = new CubeMap;
+
+    for(int i = 0; i < 6; ++i)
+    {
+        QImage face(QString(":/textures/sky/%1.jpg").arg(faceNames[i]));
+
+        if(face.isNull())
+        {
+            PRINT_ERROR("Cannot load the sky cube map.");
+            delete skyTexture;
+            skyTexture = NULL;
+            return false;
+        }
+
+        skyTexture->faces[i] = face.convertToFormat(QImage::Format_RGBA8888);
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+// The tile is traced by packets of 2x2 pixels, each sample of the pixels is one packet.
+// The rays of the pixels outside the image are inactive.
+//------------------------------------------------------------------------------------------
+void RayTracer::renderTile(const View& _view, int _tileX, int _tileY, int _worker)
+{
+    PROFILE_ZONE("RayTracer::renderTile");
+
+    int x0 = _tileX * RAYTRACER_TILE_SIZE;
+    int y0 = _tileY * RAYTRACER_TILE_SIZE;
+    int x1 = qMin(x0 + RAYTRACER_TILE_SIZE, _view.width);
+    int y1 = qMin(y0 + RAYTRACER_TILE_SIZE, _view.height);
+
+    float sampleWeight = 1.0f / (float)(samplesPerAxis * samplesPerAxis);
+    QRgb* image = reinterpret_cast<QRgb*>(_view.pixels);
+    qint64 numTileRays = 0;
+
+    RayPacket rays;
+    rays.ox = Float4(_view.origin.x());
+    rays.oy = Float4(_view.origin.y());
+    rays.oz = Float4(_view.origin.z());
+
+    for(int y = y0; y < y1; y += 2)
+    {
+        for(int x = x0; x < x1; x += 2)
+        {
+            int activeMask = 0;
+
+            for(int lane = 0; lane < 4; ++lane)
+            {
+                if(x + (lane & 1) < x1 && y + (lane >> 1) < y1)
+                {
+                    activeMask |= (1 << lane);
+                }
+            }
+
+            QVector3D pixelColors[4];
+
+            for(int sy = 0; sy < samplesPerAxis; ++sy)
+            {
+                for(int sx = 0; sx < samplesPerAxis; ++sx)
+                {
+                    float dirs[3][4];
+
+                    for(int lane = 0; lane < 4; ++lane)
+                    {
+                        float px = (float)(x + (lane & 1)) +
+                                   ((float)sx + 0.5f) / (float)samplesPerAxis;
+                        float py = (float)(y + (lane >> 1)) +
+                                   ((float)sy + 0.5f) / (float)samplesPerAxis;
+                        float ndcX = (2.0f * px / (float)_view.width - 1.0f) *
+                                     _view.tanHalfWidth;
+                        float ndcY = (1.0f - 2.0f * py / (float)_view.height) *
+                                     _view.tanHalfHeight;
+
+                        QVector3D dir = (_view.forward + _view.right * ndcX +
+                                         _view.up * ndcY).normalized();
+                        dirs[0][lane] = dir.x();
+                        dirs[1][lane] = dir.y();
+                        dirs[2][lane] = dir.z();
+                    }
+
+                    rays.dx = Float4(dirs[0][0], dirs[0][1], dirs[0][2], dirs[0][3]);
+                    rays.dy = Float4(dirs[1][0], dirs[1][1], dirs[1][2], dirs[1][3]);
+                    rays.dz = Float4(dirs[2][0], dirs[2][1], dirs[2][2], dirs[2][3]);
+
+                    QVector3D colors[4];
+                    trace(rays, activeMask, 0, _view.hiddenObject, colors, numTileRays);
+
+                    for(int lane = 0; lane < 4; ++lane)
+                    {
+                        pixelColors[lane] += colors[lane];
+                    }
+                }
+            }
+
+            for(int lane = 0; lane < 4; ++lane)
+            {
+                if(!(activeMask & (1 << lane)))
+                {
+                    continue;
+                }
+
+                QVector3D color = pixelColors[lane] * sampleWeight * 255.0f;
+                image[(qint64)(y + (lane >> 1)) * _view.width + x + (lane & 1)] =
+                    qRgb(qBound(0, qRound(color.x()), 255),
+                         qBound(0, qRound(color.y()), 255),
+                         qBound(0, qRound(color.z()), 255));
+            }
+        }
+    }
+
+    // one counter per worker, updated once per tile
+    numRaysPerWorker[_worker] += numTileRays;
+}
+
+//------------------------------------------------------------------------------------------
+// Intersect the active rays with all the objects at once, then shade the hits lane by lane.
+// The rays hitting a reflective object spawn the reflected rays, traced as a new packet.
+//------------------------------------------------------------------------------------------
+void RayTracer::trace(const RayPacket& _rays, int _activeMask, int _depth,
+                      int _hiddenObject, QVector3D* _colors, qint64& _numRays)
+{
+    for(int lane = 0; lane < 4; ++lane)
+    {
+        _colors[lane] = QVector3D(0.0f, 0.0f, 0.0f);
+        _numRays += (_activeMask >> lane) & 1;
+    }
+
+    RayPacket objectRays[NUM_RAY_TRACING_OBJECTS];
+    Float4 closestT(RAYTRACER_NO_HIT);
+    int hitObjects[4] = {-1, -1, -1, -1};
+
+    for(int obj = 0; obj < NUM_RAY_TRACING_OBJECTS; ++obj)
+    {
+        if(obj == _hiddenObject)
+        {
+            continue;
+        }
+
+        transformRays(worldToObject[obj], _rays, objectRays[obj]);
+
+        Float4 t;
+
+        switch(obj)
+        {
+        case RT_FLOOR:
+            t = intersectUnitPlane(objectRays[obj]);
+            break;
+
+        case RT_CUBE:
+            t = intersectUnitBox(objectRays[obj]);
+            break;
+
+        default:
+            t = intersectUnitSphere(objectRays[obj]);
+        }
+
+        Float4 closer = lessThan(t, closestT);
+        closestT = select4(closer, t, closestT);
+
+        int closerMask = moveMask(closer) & _activeMask;
+
+        for(int lane = 0; lane < 4; ++lane)
+        {
+            if(closerMask & (1 << lane))
+            {
+                hitObjects[lane] = obj;
+            }
+        }
+    }
+
+    float t[4], ox[4], oy[4], oz[4], dx[4], dy[4], dz[4];
+    closestT.store(t);
+    _rays.ox.store(ox);
+    _rays.oy.store(oy);
+    _rays.oz.store(oz);
+    _rays.dx.store(dx);
+    _rays.dy.store(dy);
+    _rays.dz.store(dz);
+
+    // reflected rays of the lanes going one bounce deeper
+    float reflectedRays[6][4] = {};
+    int reflectedMask = 0;
+    QVector3D localColors[4];
+    float reflections[4];
+
+    for(int lane = 0; lane < 4; ++lane)
+    {
+        if(!(_activeMask & (1 << lane)))
+        {
+            continue;
+        }
+
+        QVector3D rayDir = QVector3D(dx[lane], dy[lane], dz[lane]).normalized();
+        int obj = hitObjects[lane];
+
+        if(obj < 0)
+        {
+            _colors[lane] = skyTexture->sample(rayDir);
+            continue;
+        }
+
+        QVector3D worldPos = QVector3D(ox[lane], oy[lane], oz[lane]) +
+                             QVector3D(dx[lane], dy[lane], dz[lane]) * t[lane];
+        const RayPacket& objRays = objectRays[obj];
+        QVector3D objectOrigin(getLane(objRays.ox, lane), getLane(objRays.oy, lane),
+                               getLane(objRays.oz, lane));
+        QVector3D objectDir(getLane(objRays.dx, lane), getLane(objRays.dy, lane),
+                            getLane(objRays.dz, lane));
+        QVector3D objectPos = objectOrigin + objectDir * t[lane];
+
+        QVector3D normal;
+        localColors[lane] = shade(obj, objectPos, worldPos, rayDir, normal);
+        reflections[lane] = scene.materials[obj].reflection;
+
+        if(reflections[lane] <= 0.0f)
+        {
+            _colors[lane] = localColors[lane];
+            continue;
+        }
+
+        if(QVector3D::dotProduct(rayDir, normal) > 0.0f)
+        {
+            normal = -normal;
+        }
+
+        QVector3D reflectedDir = rayDir - 2.0f * QVector3D::dotProduct(rayDir, normal) *
+                                 normal;
+
+        if(_depth >= maxBounces)
+        {
+            // out of bounces: the environment is seen at infinity, as with the sky box
+            _colors[lane] = localColors[lane] * (1.0f - reflections[lane]) +
+                            skyTexture->sample(reflectedDir) * reflections[lane];
+            continue;
+        }
+
+        QVector3D reflectedOrigin = worldPos + normal * RAYTRACER_EPSILON;
+        reflectedRays[0][lane] = reflectedOrigin.x();
+        reflectedRays[1][lane] = reflectedOrigin.y();
+        reflectedRays[2][lane] = reflectedOrigin.z();
+        reflectedRays[3][lane] = reflectedDir.x();
+        reflectedRays[4][lane] = reflectedDir.y();
+        reflectedRays[5][lane] = reflectedDir.z();
+        reflectedMask |= (1 << lane);
+    }
+
+    if(!reflectedMask)
+    {
+        return;
+    }
+
+    // the inactive lanes get a valid direction, their results are ignored
+    for(int lane = 0; lane < 4; ++lane)
+    {
+        if(!(reflectedMask & (1 << lane)))
+        {
+            reflectedRays[4][lane] = 1.0f;
+        }
+    }
+
+    RayPacket reflected;
+    reflected.ox = Float4(reflectedRays[0][0], reflectedRays[0][1], reflectedRays[0][2],
+                          reflectedRays[0][3]);
+    reflected.oy = Float4(reflectedRays[1][0], reflectedRays[1][1], reflectedRays[1][2],
+                          reflectedRays[1][3]);
+    reflected.oz = Float4(reflectedRays[2][0], reflectedRays[2][1], reflectedRays[2][2],
+                          reflectedRays[2][3]);
+    reflected.dx = Float4(reflectedRays[3][0], reflectedRays[3][1], reflectedRays[3][2],
+                          reflectedRays[3][3]);
+    reflected.dy = Float4(reflectedRays[4][0], reflectedRays[4][1], reflectedRays[4][2],
+                          reflectedRays[4][3]);
+    reflected.dz = Float4(reflectedRays[5][0], reflectedRays[5][1], reflectedRays[5][2],
+                          reflectedRays[5][3]);
+
+    QVector3D reflectedColors[4];
+    trace(reflected, reflectedMask, _depth + 1, _hiddenObject, reflectedColors, _numRays);
+
+    for(int lane = 0; lane < 4; ++lane)
+    {
+        if(reflectedMask & (1 << lane))
+        {
+            _colors[lane] = localColors[lane] * (1.0f - reflections[lane]) +
+                            reflectedColors[lane] * reflections[lane];
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// the phong-shading fragment shader, without the environment lookup
+//------------------------------------------------------------------------------------------
+QVector3D RayTracer::shade(int _object, const QVector3D& _objectPosition,
+                           const QVector3D& _worldPosition, const QVector3D& _rayDir,
+                           QVector3D& _normal)
+{
+    const Material& material = scene.materials[_object];
+    QVector3D objectNormal = getObjectNormal(_object, _objectPosition);
+    _normal = normalMatrices[_object].mapVector(objectNormal).normalized();
+
+    QVector3D surfaceColor(0.0f, 0.0f, 0.0f);
+    float alpha = 1.0f;
+
+    if(objectTextures[_object])
+    {
+        QVector4D texColor = objectTextures[_object]->sample(getTexCoord(_object,
+                                                                         _objectPosition));
+        surfaceColor = texColor.toVector3D();
+        alpha = texColor.w();
+    }
+
+    // a negative diffuse color means the texture is used alone
+    if(material.diffuseColor.x() > -0.001f)
+    {
+        surfaceColor = material.diffuseColor.toVector3D() * (1.0f - alpha) +
+                       surfaceColor * alpha;
+    }
+
+    QVector3D lightDir = (scene.light.position.toVector3D() - _worldPosition).normalized();
+    QVector3D viewDir = -_rayDir;
+    QVector3D halfDir = (lightDir + viewDir).normalized();
+
+    QVector3D ambient = surfaceColor * 0.2f;
+    QVector3D diffuse = surfaceColor * qMax(QVector3D::dotProduct(_normal, lightDir), 0.0f);
+    QVector3D specular = material.specularColor.toVector3D() *
+                         qPow(qMax(QVector3D::dotProduct(halfDir, _normal), 0.0f),
+                              material.shininess);
+
+    return (ambient + diffuse + specular) * scene.light.intensity;
+}
+
+//------------------------------------------------------------------------------------------
+// the texture coordinates of the UnitPlane, UnitCube and UnitSphere meshes
+//------------------------------------------------------------------------------------------
+QVector2D RayTracer::getTexCoord(int _object, const QVector3D& _objectPosition)
+{
+    float x = _objectPosition.x();
+    float y = _objectPosition.y();
+    float z = _objectPosition.z();
+
+    if(_object == RT_FLOOR)
+    {
+        return QVector2D((x + 1.0f) * 0.5f, (z + 1.0f) * 0.5f) * scene.floorTexCoordScale;
+    }
+
+    if(_object == RT_CUBE)
+    {
+        float ax = qAbs(x);
+        float ay = qAbs(y);
+        float az = qAbs(z);
+
+        if(az >= ax && az >= ay)
+        {
+            return (z > 0.0f) ? QVector2D((x + 1.0f) * 0.5f, (y + 1.0f) * 0.5f) :
+                   QVector2D((1.0f - x) * 0.5f, (y + 1.0f) * 0.5f);
+        }
+
+        if(ax >= ay)
+        {
+            return (x > 0.0f) ? QVector2D((1.0f - z) * 0.5f, (y + 1.0f) * 0.5f) :
+                   QVector2D((z + 1.0f) * 0.5f, (y + 1.0f) * 0.5f);
+        }
+
+        return (y > 0.0f) ? QVector2D((x + 1.0f) * 0.5f, (1.0f - z) * 0.5f) :
+               QVector2D((x + 1.0f) * 0.5f, (z + 1.0f) * 0.5f);
+    }
+
+    QVector3D n = _objectPosition.normalized();
+    float theta = qAcos(qBound(-1.0f, n.y(), 1.0f));
+    float phi = qAtan2(n.z(), n.x());
+
+    if(phi < 0.0f)
+    {
+        phi += 2.0f * (float)M_PI;
+    }
+
+    return QVector2D(1.0f - phi / (2.0f * (float)M_PI), 1.0f - theta / (float)M_PI);
+}
+
+//------------------------------------------------------------------------------------------
+QVector3D RayTracer::getObjectNormal(int _object, const QVector3D& _objectPosition)
+{
+    if(_object == RT_FLOOR)
+    {
+        return QVector3D(0.0f, 1.0f, 0.0f);
+    }
+
+    if(_object == RT_CUBE)
+    {
+        float ax = qAbs(_objectPosition.x());
+        float ay = qAbs(_objectPosition.y());
+        float az = qAbs(_objectPosition.z());
+
+        if(ax >= ay && ax >= az)
+        {
+            return QVector3D(_objectPosition.x() > 0.0f ? 1.0f : -1.0f, 0.0f, 0.0f);
+        }
+
+        if(ay >= az)
+        {
+            return QVector3D(0.0f, _objectPosition.y() > 0.0f ? 1.0f : -1.0f, 0.0f);
+        }
+
+        return QVector3D(0.0f, 0.0f, _objectPosition.z() > 0.0f ? 1.0f : -1.0f);
+    }
+
+    return _objectPosition;
+}
@@ -0,0 +1,140 @@
+//------------------------------------------------------------------------------------------
+// raytracer.h
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#ifndef RAYTRACER_H
+#define RAYTRACER_H
+
+#include <QtGui>
+
+#include "renderer.h"
+#include "workstealingpool.h"
+
+//------------------------------------------------------------------------------------------
+#define RAYTRACER_TILE_SIZE 16
+#define RAYTRACER_DEFAULT_MAX_BOUNCES 4
+#define RAYTRACER_DEFAULT_SAMPLES_PER_PIXEL 4
+#define RAYTRACER_EPSILON 1e-3f
+#define DEFAULT_REFERENCE_WIDTH 1280
+#define DEFAULT_REFERENCE_HEIGHT 720
+
+//------------------------------------------------------------------------------------------
+// The scene of the renderer as plain data: the same objects, transformations, materials
+// and light, so the ray traced image can be compared with the rasterized one
+//------------------------------------------------------------------------------------------
+enum RayTracingObject
+{
+    RT_FLOOR = 0,
+    RT_CUBE,
+    RT_SEMI_REFLECTIVE_SPHERE,
+    RT_REFLECTIVE_SPHERE,
+    NUM_RAY_TRACING_OBJECTS
+};
+
+struct RayTracingScene
+{
+    RayTracingScene();
+
+    QVector3D cameraPosition;
+    QVector3D cameraFocus;
+    QVector3D cameraUpDirection;
+    Light light;
+
+    QMatrix4x4 modelMatrices[NUM_RAY_TRACING_OBJECTS];
+    Material materials[NUM_RAY_TRACING_OBJECTS];
+    float floorTexCoordScale;
+};
+
+// a cube map to render from the given position, without the object it belongs to
+struct CubeMapProbe
+{
+    CubeMapProbe(): hiddenObject(-1) {}
+    CubeMapProbe(const QVector3D& _position, int _hiddenObject):
+        position(_position), hiddenObject(_hiddenObject) {}
+
+    QVector3D position;
+    int hiddenObject;
+};
+
+struct RayPacket;
+
+//------------------------------------------------------------------------------------------
+// Multithreaded CPU ray tracer, the reference for the reflections of the GL renderer.
+// The reflections are traced for real, up to the given number of bounces, instead of
+// being looked up in cube maps rendered from the object centers. The shading is the one
+// of the phong-shading program; the sky cube map is seen by the rays leaving the scene.
+// Rays are traced in packets of 4 (2x2 pixels for the camera rays) with SSE kernels, the
+// images are split into tiles which are distributed on all the cores by a work stealing
+// pool. The cube maps of the probes are rendered the same way, all their faces at once.
+// No OpenGL is needed.
+//------------------------------------------------------------------------------------------
+class RayTracer
+{
+public:
+    RayTracer();
+    ~RayTracer();
+
+    void setScene(const RayTracingScene& _scene);
+    void setMaxBounces(int _maxBounces);
+    void setSamplesPerPixel(int _samplesPerPixel);
+    void setNumThreads(int _numThreads);
+
+    QImage render(int _width, int _height);
+    QVector<QImage> renderCubeMaps(const QVector<CubeMapProbe>& _probes, int _faceSize);
+
+    double getRenderTime() const;
+    qint64 getNumRays() const;
+
+private:
+    struct Texture;
+    struct CubeMap;
+
+    // a pinhole camera rendering one image: the main view, or one face of a cube map
+    struct View
+    {
+        QVector3D origin;
+        QVector3D forward;
+        QVector3D right;
+        QVector3D up;
+        float tanHalfWidth;
+        float tanHalfHeight;
+        int width;
+        int height;
+        int numTilesX;
+        int numTiles;
+        int hiddenObject;
+        uchar* pixels;
+    };
+
+    bool loadTextures();
+    bool prepareRendering();
+    void renderViews(const QVector<View>& _views);
+    void renderTile(const View& _view, int _tileX, int _tileY, int _worker);
+    void trace(const RayPacket& _rays, int _activeMask, int _depth, int _hiddenObject,
+               QVector3D* _colors, qint64& _numRays);
+    QVector3D shade(int _object, const QVector3D& _objectPosition,
+                    const QVector3D& _worldPosition, const QVector3D& _rayDir,
+                    QVector3D& _normal);
+    QVector2D getTexCoord(int _object, const QVector3D& _objectPosition);
+    QVector3D getObjectNormal(int _object, const QVector3D& _objectPosition);
+
+    RayTracingScene scene;
+    QMatrix4x4 worldToObject[NUM_RAY_TRACING_OBJECTS];
+    QMatrix4x4 normalMatrices[NUM_RAY_TRACING_OBJECTS];
+    Texture* objectTextures[NUM_RAY_TRACING_OBJECTS];
+    CubeMap* skyTexture;
+
+    int maxBounces;
+    int samplesPerAxis;
+    int numThreads;
+
+    QVector<qint64> numRaysPerWorker;
+    qint64 numRays;
+    double renderTime;
+};
+
+#endif // RAYTRACER_H
@@ -6,20 +6,25 @@
 //
 //------------------------------------------------------------------------------------------
 
+#include <algorithm>
+
 #include "renderer.h"
+#include "probebaker.h"
+#include "scenedescription.h"
+#include "meshimporter.h"
 
 //------------------------------------------------------------------------------------------
 Renderer::Renderer(QWidget* _parent):
     QOpenGLWidget(_parent),
+    enabledDepthTest(true),
     enabledZAxisRotation(false),
     enabledObjectTransformation(false),
     enabledDynamicEnvMapping(false),
     enabledBackgroundRendering(true),
     useGlobalEnvTexture(true),
+    frozenProbes(false),
+    useStaticProbes(false),
     enabledTextureAnisotropicFiltering(true),
-    iboPlane(QOpenGLBuffer::IndexBuffer),
-    iboCube(QOpenGLBuffer::IndexBuffer),
-    iboSphere(QOpenGLBuffer::IndexBuffer),
     specialKeyPressed(Renderer::NO_KEY),
     mouseButtonPressed(Renderer::NO_BUTTON),
     translation(0.0f, 0.0f, 0.0f),
@@ -32,20 +37,98 @@ Renderer::Renderer(QWidget* _parent):
     sphereObject(NULL),
     sphereNumStacks(30),
     sphereNumSlices(30),
+    planeSize(30),
+    initialPlaneSize(30),
+    cubeMapSize(CUBE_MAP_SIZE),
+    probeUpdateInterval(1),
+    numFramesSinceProbeUpdate(0),
     shadingMode(PHONG_SHADING),
     cameraPosition(DEFAULT_CAMERA_POSITION),
     cameraFocus(DEFAULT_CAMERA_FOCUS),
     cameraUpDirection(0.0f, 1.0f, 0.0f),
-    floorTexture(CHECKERBOARD)
+    floorTexture(CHECKERBOARD),
+    floorTextureFiltering(QOpenGLTexture::LinearMipMapLinear),
+    frameTime(1.0f / INERTIA_REFERENCE_FPS),
+    headlessContext(NULL),
+    headlessSurface(NULL),
+    headlessFBO(NULL),
+    paintingFrame(false),
+    numContextSwitches(0),
+    numFrameContextSwitches(0),
+    numFrameUploadBytes(0),
+    numDrawCalls(0),
+    numProgramSwitches(0),
+    numTextureSwitches(0),
+    inputReplayer(NULL),
+    numReplayedFrames(0),
+    quitAfterReplay(false),
+    sceneDescription(NULL),
+    sceneChanged(false),
+    sceneEnvTexture(NULL),
+    sceneInstanceBuffer(0),
+    sceneInstanceTexture(0),
+    sceneInstanceIndexTexture(0),
+    visibleInstanceBuffer(0),
+    enabledInstancing(true),
+    indirectDrawsChanged(false),
+    renderListChanged(true),
+    numMaterials(0),
+    enabledFrustumCulling(true)
 {
     retinaScale = devicePixelRatio();
     setFocusPolicy(Qt::StrongFocus);
+    probeStaticLayersChanged = false;
+    enabledProbeFaceSkipping = true;
+    numProbeFaces = 0;
+    numSkippedProbeFaces = 0;
+
+    for(int i = 0; i < NUM_REFLECTIVE_OBJECTS; ++i)
+    {
+        staticProbeTextures[i] = NULL;
+        objEnvTextureHistory[i] = NULL;
+        probeCubeMaps[i] = -1;
+        probeStaticLayers[i].color = NULL;
+        probeStaticLayers[i].depth = NULL;
+        probeOffsets[i] = QVector3D(0.0f, 0.0f, 0.0f);
+        numProbeInstances[i] = 0;
+    }
+
+    for(int i = 0; i < NUM_SCENE_BUILTIN_OBJECTS; ++i)
+    {
+        builtinSceneTextures[i] = NULL;
+    }
+
+    // the positions of the objects until a scene file is loaded
+    cubeInitialModelMatrix.scale(1.5);
+    cubeInitialModelMatrix.translate(DEFAULT_CUBE_POSITION);
+    semiReflectiveSphereInitialModelMatrix.translate(DEFAULT_SPHERE_POSITION);
+    reflectiveSphereInitialModelMatrix.translate(DEFAULT_REFLECTIVE_SPHERE_POSITION);
+
+    // the transform nodes, in the order of TransformNode: the probe of each reflective
+    // object is a child of the object
+    for(int i = 0; i < TRANSFORM_SEMI_REFLECTIVE_SPHERE_PROBE; ++i)
+    {
+        transforms.addNode();
+    }
+
+    transforms.addNode(TRANSFORM_SEMI_REFLECTIVE_SPHERE);
+    transforms.addNode(TRANSFORM_REFLECTIVE_SPHERE);
 }
 
 //------------------------------------------------------------------------------------------
 Renderer::~Renderer()
 {
+    // the GL objects of the capture are deleted with their context current
+    if(isRendererValid())
+    {
+        makeRendererCurrent();
+        frameCapture.destroy();
+        doneRendererCurrent();
+    }
 
+    delete inputReplayer;
+    delete sceneDescription;
+    qDeleteAll(sceneMeshes);
 }
 
 //------------------------------------------------------------------------------------------
@@ -57,6 +140,12 @@ void Renderer::checkOpenGLVersion()
 
     if(!(major >= 4 && minor >= 0))
     {
+        if(isHeadless())
+        {
+            PRINT_AND_DIE(QString("OpenGL version is %1.%2, OpenGL >= 4.0 is required").arg(
+                              major).arg(minor));
+        }
+
         QMessageBox::critical(this, "Error",
                               QString("Your OpenGL version is %1.%2, which does not satisfy this program requirement (OpenGL >= 4.0)").arg(
                                   major).arg(minor));
@@ -67,9 +156,126 @@ void Renderer::checkOpenGLVersion()
 //    qDebug() << verStr;
 //    TRUE_OR_DIE(major >= 4 && minor >= 0, "OpenGL version must >= 4.0");
 }
+
+//------------------------------------------------------------------------------------------
+// In headless mode the renderer is never shown: it renders with the given context into an
+// offscreen framebuffer object instead of the widget framebuffer
+//------------------------------------------------------------------------------------------
+void Renderer::initializeHeadless(QOpenGLContext* _context, QSurface* _surface,
+                                  int _width, int _height)
+{
+    headlessContext = _context;
+    headlessSurface = _surface;
+    retinaScale = 1.0;
+
+    makeRendererCurrent();
+
+    headlessFBO = new QOpenGLFramebufferObject(_width, _height,
+                                               QOpenGLFramebufferObject::CombinedDepthStencil);
+    TRUE_OR_DIE(headlessFBO->isValid(), "Cannot create the offscreen framebuffer object.");
+
+    headlessFBO->bind();
+    initializeGL();
+    resizeGL(_width, _height);
+    headlessFBO->release();
+}
+
+//------------------------------------------------------------------------------------------
+void Renderer::renderHeadlessFrame()
+{
+    makeRendererCurrent();
+    headlessFBO->bind();
+    paintGL();
+    headlessFBO->release();
+}
+
+//------------------------------------------------------------------------------------------
+QImage Renderer::grabHeadlessFrame()
+{
+    makeRendererCurrent();
+    return headlessFBO->toImage();
+}
+
+//------------------------------------------------------------------------------------------
+bool Renderer::isHeadless() const
+{
+    return (headlessContext != NULL);
+}
+
+//------------------------------------------------------------------------------------------
+bool Renderer::isRendererValid()
+{
+    return isHeadless() ? (headlessFBO != NULL) : isValid();
+}
+
+//------------------------------------------------------------------------------------------
+void Renderer::makeRendererCurrent()
+{
+    // slots applied while painting (replayed events): the context is already current
+    if(paintingFrame)
+    {
+        return;
+    }
+
+    ++numContextSwitches;
+
+    if(isHeadless())
+    {
+        headlessContext->makeCurrent(headlessSurface);
+    }
+    else
+    {
+        makeCurrent();
+    }
+}
+
+//------------------------------------------------------------------------------------------
+void Renderer::doneRendererCurrent()
+{
+    // the headless context stays current, it is used by nobody else
+    if(!isHeadless() && !paintingFrame)
+    {
+        doneCurrent();
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// rebind the framebuffer the frame is rendered into, after rendering to another one
+//------------------------------------------------------------------------------------------
+void Renderer::bindTargetFramebuffer()
+{
+    if(isHeadless())
+    {
+        headlessFBO->bind();
+    }
+    else
+    {
+        makeCurrent();
+    }
+}
+
+//------------------------------------------------------------------------------------------
+GLuint Renderer::getTargetFramebuffer()
+{
+    return isHeadless() ? headlessFBO->handle() : defaultFramebufferObject();
+}
+
+//------------------------------------------------------------------------------------------
+int Renderer::getViewportWidth()
+{
+    return isHeadless() ? headlessFBO->width() : (int)(width() * retinaScale);
+}
+
+//------------------------------------------------------------------------------------------
+int Renderer::getViewportHeight()
+{
+    return isHeadless() ? headlessFBO->height() : (int)(height() * retinaScale);
+}
 //------------------------------------------------------------------------------------------
 bool Renderer::initProgram(ShadingProgram _shadingMode)
 {
+    PROFILE_ZONE("Renderer::initProgram");
+
     QOpenGLShaderProgram* program;
     GLint location;
 
@@ -86,35 +292,51 @@ bool Renderer::initProgram(ShadingProgram _shadingMode)
                                                fragmentShaderSourceMap.value(_shadingMode));
     TRUE_OR_DIE(success, "Cannot compile shader from file.");
 
+    // the same locations in all the programs, for the single vertex array object of the
+    // geometry buffer
+    program->bindAttributeLocation("v_coord", GEOMETRY_ATTRIB_VERTEX);
+    program->bindAttributeLocation("v_normal", GEOMETRY_ATTRIB_NORMAL);
+    program->bindAttributeLocation("v_texcoord", GEOMETRY_ATTRIB_TEXCOORD);
+    program->bindAttributeLocation("i_instance", GEOMETRY_ATTRIB_INSTANCE);
+
     success = program->link();
     TRUE_OR_DIE(success, "Cannot link GLSL program.");
 
     location = program->attributeLocation("v_coord");
-    TRUE_OR_DIE(location >= 0, "Cannot bind attribute vertex coordinate.");
-    attrVertex[_shadingMode] = location;
+    TRUE_OR_DIE(location == GEOMETRY_ATTRIB_VERTEX,
+                "Cannot bind attribute vertex coordinate.");
 
     location = program->attributeLocation("v_normal");
-    TRUE_OR_DIE(location >= 0, "Cannot bind attribute vertex normal.");
-    attrNormal[_shadingMode] = location;
+    TRUE_OR_DIE(location == GEOMETRY_ATTRIB_NORMAL, "Cannot bind attribute vertex normal.");
 
     location = program->attributeLocation("v_texcoord");
-    TRUE_OR_DIE(location >= 0, "Cannot bind attribute texture coordinate.");
-    attrTexCoord[_shadingMode] = location;
+    TRUE_OR_DIE(location == GEOMETRY_ATTRIB_TEXCOORD,
+                "Cannot bind attribute texture coordinate.");
 
 
+    // the instanced program reads its matrices from the instance records
     location = glGetUniformBlockIndex(program->programId(), "Matrices");
-    TRUE_OR_DIE(location >= 0, "Cannot bind block uniform.");
+    TRUE_OR_DIE(location >= 0 || _shadingMode == INSTANCED_PHONG_SHADING,
+                "Cannot bind block uniform.");
     uniMatrices[_shadingMode] = location;
 
+    location = glGetUniformBlockIndex(program->programId(), "Camera");
+    TRUE_OR_DIE(location >= 0, "Cannot bind block uniform.");
+    uniCamera[_shadingMode] = location;
+
 
     location = glGetUniformBlockIndex(program->programId(), "Light");
     TRUE_OR_DIE(location >= 0, "Cannot bind block uniform.");
     uniLight[_shadingMode] = location;
 
 
-    location = glGetUniformBlockIndex(program->programId(), "Material");
+    location = glGetUniformBlockIndex(program->programId(), "Materials");
     TRUE_OR_DIE(location >= 0, "Cannot bind block uniform.");
-    uniMaterial[_shadingMode] = location;
+    uniMaterials[_shadingMode] = location;
+
+    location = program->uniformLocation("materialIndex");
+    TRUE_OR_DIE(location >= 0, "Cannot bind uniform materialIndex.");
+    uniMaterialIndex[_shadingMode] = location;
 
     location = program->uniformLocation("cameraPosition");
     TRUE_OR_DIE(location >= 0, "Cannot bind uniform cameraPosition.");
@@ -140,6 +362,8 @@ bool Renderer::initProgram(ShadingProgram _shadingMode)
 //------------------------------------------------------------------------------------------
 bool Renderer::initBackgroundShadingProgram()
 {
+    PROFILE_ZONE("Renderer::initBackgroundShadingProgram");
+
     GLint location;
     glslPrograms[BACKGROUND_SHADING] = new QOpenGLShaderProgram;
     QOpenGLShaderProgram* program = glslPrograms[BACKGROUND_SHADING];
@@ -153,17 +377,23 @@ bool Renderer::initBackgroundShadingProgram()
                                                fragmentShaderSourceMap.value(BACKGROUND_SHADING));
     TRUE_OR_DIE(success, "Cannot compile shader from file.");
 
+    program->bindAttributeLocation("v_coord", GEOMETRY_ATTRIB_VERTEX);
+
     success = program->link();
     TRUE_OR_DIE(success, "Cannot link GLSL program.");
 
     location = program->attributeLocation("v_coord");
-    TRUE_OR_DIE(location >= 0, "Cannot bind attribute vertex coordinate.");
-    attrVertex[BACKGROUND_SHADING] = location;
+    TRUE_OR_DIE(location == GEOMETRY_ATTRIB_VERTEX,
+                "Cannot bind attribute vertex coordinate.");
 
     location = glGetUniformBlockIndex(program->programId(), "Matrices");
     TRUE_OR_DIE(location >= 0, "Cannot bind block uniform.");
     uniMatrices[BACKGROUND_SHADING] = location;
 
+    location = glGetUniformBlockIndex(program->programId(), "Camera");
+    TRUE_OR_DIE(location >= 0, "Cannot bind block uniform.");
+    uniCamera[BACKGROUND_SHADING] = location;
+
     location = program->uniformLocation("cameraPosition");
     TRUE_OR_DIE(location >= 0, "Cannot bind uniform cameraPosition.");
     uniCameraPosition[BACKGROUND_SHADING] = location;
@@ -175,31 +405,76 @@ bool Renderer::initBackgroundShadingProgram()
     return true;
 }
 
+//------------------------------------------------------------------------------------------
+// the phong shading, with the model matrices and the material of each instance read from
+// the instance records
+//------------------------------------------------------------------------------------------
+bool Renderer::initInstancedShadingProgram()
+{
+    PROFILE_ZONE("Renderer::initInstancedShadingProgram");
+
+    if(!initProgram(INSTANCED_PHONG_SHADING))
+    {
+        return false;
+    }
+
+    QOpenGLShaderProgram* program = glslPrograms[INSTANCED_PHONG_SHADING];
+    GLint location;
+
+    location = program->attributeLocation("i_instance");
+    TRUE_OR_DIE(location == GEOMETRY_ATTRIB_INSTANCE,
+                "Cannot bind attribute instance index.");
+
+    location = program->uniformLocation("instanceData");
+    TRUE_OR_DIE(location >= 0, "Cannot bind uniform instanceData.");
+    uniInstanceData = location;
+
+    location = program->uniformLocation("instanceIndices");
+    TRUE_OR_DIE(location >= 0, "Cannot bind uniform instanceIndices.");
+    uniInstanceIndices = location;
+
+    location = program->uniformLocation("maxMaterialIndex");
+    TRUE_OR_DIE(location >= 0, "Cannot bind uniform maxMaterialIndex.");
+    uniMaxMaterialIndex = location;
+
+    return true;
+}
+
 //------------------------------------------------------------------------------------------
 bool Renderer::initShaderPrograms()
 {
+    PROFILE_ZONE("Renderer::initShaderPrograms");
+
     vertexShaderSourceMap.insert(PHONG_SHADING, ":/shaders/phong-shading.vs.glsl");
     vertexShaderSourceMap.insert(BACKGROUND_SHADING, ":/shaders/background.vs.glsl");
+    vertexShaderSourceMap.insert(INSTANCED_PHONG_SHADING,
+                                 ":/shaders/phong-shading-instanced.vs.glsl");
 
     fragmentShaderSourceMap.insert(PHONG_SHADING, ":/shaders/phong-shading.fs.glsl");
     fragmentShaderSourceMap.insert(BACKGROUND_SHADING, ":/shaders/background.fs.glsl");
+    fragmentShaderSourceMap.insert(INSTANCED_PHONG_SHADING,
+                                   ":/shaders/phong-shading.fs.glsl");
 
 
     return (initBackgroundShadingProgram() &&
-            initProgram(PHONG_SHADING));
+            initProgram(PHONG_SHADING) &&
+            initInstancedShadingProgram());
 }
 
 //------------------------------------------------------------------------------------------
 void Renderer::initRenderingData()
 {
+    PROFILE_ZONE("Renderer::initRenderingData");
+
     initTexture();
     initSceneMemory();
-    initVertexArrayObjects();
 }
 
 //------------------------------------------------------------------------------------------
 void Renderer::initSharedBlockUniform()
 {
+    PROFILE_ZONE("Renderer::initSharedBlockUniform");
+
     /////////////////////////////////////////////////////////////////
     // setup the light and material
     cameraPosition = DEFAULT_CAMERA_POSITION;
@@ -233,10 +508,19 @@ void Renderer::initSharedBlockUniform()
     // setup data for block uniform
     glGenBuffers(1, &UBOMatrices);
     glBindBuffer(GL_UNIFORM_BUFFER, UBOMatrices);
-    glBufferData(GL_UNIFORM_BUFFER, 3 * SIZE_OF_MAT4, NULL,
+    glBufferData(GL_UNIFORM_BUFFER, 2 * SIZE_OF_MAT4, NULL,
+                 GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glGenBuffers(1, &UBOCamera);
+    glBindBuffer(GL_UNIFORM_BUFFER, UBOCamera);
+    glBufferData(GL_UNIFORM_BUFFER, SIZE_OF_MAT4, NULL,
                  GL_STREAM_DRAW);
     glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
+    // the matrices of the scene objects, one slot per draw
+    renderList.initialize(this);
+
     glGenBuffers(1, &UBOLight);
     glBindBuffer(GL_UNIFORM_BUFFER, UBOLight);
     glBufferData(GL_UNIFORM_BUFFER, light.getStructSize(),
@@ -245,42 +529,52 @@ void Renderer::initSharedBlockUniform()
                     &light);
     glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
-    glGenBuffers(1, &UBOPlaneMaterial);
-    glBindBuffer(GL_UNIFORM_BUFFER, UBOPlaneMaterial);
-    glBufferData(GL_UNIFORM_BUFFER, planeMaterial.getStructSize(),
-                 NULL, GL_STREAM_DRAW);
-    glBufferSubData(GL_UNIFORM_BUFFER, 0, planeMaterial.getStructSize(),
-                    &planeMaterial);
+    materialBuffer.initialize(this, MAX_MATERIALS, MATERIAL_STRIDE);
+    uploadMaterials();
+}
 
-    glGenBuffers(1, &UBOCubeMaterial);
-    glBindBuffer(GL_UNIFORM_BUFFER, UBOCubeMaterial);
-    glBufferData(GL_UNIFORM_BUFFER, cubeMaterial.getStructSize(),
-                 NULL, GL_STREAM_DRAW);
-    glBufferSubData(GL_UNIFORM_BUFFER, 0, cubeMaterial.getStructSize(),
-                    &cubeMaterial);
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+//------------------------------------------------------------------------------------------
+// the material is uploaded by the next frame, no GL context is needed
+//------------------------------------------------------------------------------------------
+void Renderer::uploadMaterial(int _index, const Material& _material)
+{
+    materialBuffer.write(_index, &_material, Material().getStructSize());
+}
 
-    glGenBuffers(1, &UBOSemireflectiveSphereMaterial);
-    glBindBuffer(GL_UNIFORM_BUFFER, UBOSemireflectiveSphereMaterial);
-    glBufferData(GL_UNIFORM_BUFFER, semiReflectiveSphereMaterial.getStructSize(),
-                 NULL, GL_STREAM_DRAW);
-    glBufferSubData(GL_UNIFORM_BUFFER, 0, semiReflectiveSphereMaterial.getStructSize(),
-                    &semiReflectiveSphereMaterial);
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+//------------------------------------------------------------------------------------------
+// pack the materials of the built-in objects and of the scene into the material array
+//------------------------------------------------------------------------------------------
+void Renderer::uploadMaterials()
+{
+    const Material* builtinMaterials[NUM_SCENE_BUILTIN_OBJECTS] =
+    {
+        &planeMaterial, &cubeMaterial, &semiReflectiveSphereMaterial,
+        &reflectiveSphereMaterial
+    };
+    int numSceneMaterials = (sceneDescription != NULL) ?
+                            sceneDescription->getNumMaterials() : 0;
+    numMaterials = NUM_SCENE_BUILTIN_OBJECTS + numSceneMaterials;
 
-    glGenBuffers(1, &UBOReflectiveSphereMaterial);
-    glBindBuffer(GL_UNIFORM_BUFFER, UBOReflectiveSphereMaterial);
-    glBufferData(GL_UNIFORM_BUFFER, reflectiveSphereMaterial.getStructSize(),
-                 NULL, GL_STREAM_DRAW);
-    glBufferSubData(GL_UNIFORM_BUFFER, 0, reflectiveSphereMaterial.getStructSize(),
-                    &reflectiveSphereMaterial);
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    if(numMaterials > MAX_MATERIALS)
+    {
+        qDebug() << "Renderer: only" << MAX_MATERIALS - NUM_SCENE_BUILTIN_OBJECTS
+                 << "scene materials are supported," << numSceneMaterials << "given.";
+        numMaterials = MAX_MATERIALS;
+    }
 
+    for(int i = 0; i < numMaterials; ++i)
+    {
+        int sceneMaterial = i - NUM_SCENE_BUILTIN_OBJECTS;
+        uploadMaterial(i, (sceneMaterial < 0) ? *builtinMaterials[i] :
+                       sceneDescription->getMaterials()[sceneMaterial]);
+    }
 }
 
 //------------------------------------------------------------------------------------------
 void Renderer::initTexture()
 {
+    PROFILE_ZONE("Renderer::initTexture");
+
     if(QOpenGLContext::currentContext()->hasExtension("GL_EXT_texture_filter_anisotropic"))
     {
         qDebug() << "GL_EXT_texture_filter_anisotropic: enabled";
@@ -328,8 +622,13 @@ void Renderer::initTexture()
         floorTextures[tex]->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
         floorTextures[tex]->setMagnificationFilter(QOpenGLTexture::LinearMipMapLinear);
         floorTextures[tex]->setWrapMode(QOpenGLTexture::Repeat);
+        sceneTextureCache[texFile] = floorTextures[tex];
     }
 
+    // the default scene file refers to the same textures
+    sceneTextureCache[":/textures/earth.jpg"] = sphereTexture;
+    sceneTextureCache[":/textures/minion.png"] = decalTexture;
+
     ////////////////////////////////////////////////////////////////////////////////
     // environment texture
     QMap<EnvironmentTexture, QString> envTexture2StrMap;
@@ -342,57 +641,9 @@ void Renderer::initTexture()
     {
         EnvironmentTexture tex = static_cast<EnvironmentTexture>(i);
 
-        QString posXFile = QString(":/textures/%1/posx.jpg").arg(envTexture2StrMap[tex]);
-        TRUE_OR_DIE(QFile::exists(posXFile), "Cannot load texture from file.");
-
-        QString negXFile = QString(":/textures/%1/negx.jpg").arg(envTexture2StrMap[tex]);
-        TRUE_OR_DIE(QFile::exists(negXFile), "Cannot load texture from file.");
-
-        QString posYFile = QString(":/textures/%1/posy.jpg").arg(envTexture2StrMap[tex]);
-        TRUE_OR_DIE(QFile::exists(posYFile), "Cannot load texture from file.");
-
-        QString negYFile = QString(":/textures/%1/negy.jpg").arg(envTexture2StrMap[tex]);
-        TRUE_OR_DIE(QFile::exists(negYFile), "Cannot load texture from file.");
-
-        QString posZFile = QString(":/textures/%1/posz.jpg").arg(envTexture2StrMap[tex]);
-        TRUE_OR_DIE(QFile::exists(posZFile), "Cannot load texture from file.");
-
-        QString negZFile = QString(":/textures/%1/negz.jpg").arg(envTexture2StrMap[tex]);
-        TRUE_OR_DIE(QFile::exists(negZFile), "Cannot load texture from file.");
-
-        QImage posXTex = QImage(posXFile).convertToFormat(QImage::Format_RGBA8888);
-        QImage negXTex = QImage(negXFile).convertToFormat(QImage::Format_RGBA8888);
-        QImage posYTex = QImage(posYFile).convertToFormat(QImage::Format_RGBA8888);
-        QImage negYTex = QImage(negYFile).convertToFormat(QImage::Format_RGBA8888);
-        QImage posZTex = QImage(posZFile).convertToFormat(QImage::Format_RGBA8888);
-        QImage negZTex = QImage(negZFile).convertToFormat(QImage::Format_RGBA8888);
-
-
-        cubeMapEnvTexture[i] = new QOpenGLTexture(QOpenGLTexture::TargetCubeMap);
-        cubeMapEnvTexture[i]->create();
-        cubeMapEnvTexture[i]->setSize(posXTex.width(), posXTex.height());
-        cubeMapEnvTexture[i]->setFormat(QOpenGLTexture::RGBA8_UNorm);
-        cubeMapEnvTexture[i]->allocateStorage();
-
-        cubeMapEnvTexture[i]->setData(0, 0, QOpenGLTexture::CubeMapPositiveX,
-                                      QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, posXTex.constBits());
-        cubeMapEnvTexture[i]->setData(0, 0, QOpenGLTexture::CubeMapNegativeX,
-                                      QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, negXTex.constBits());
-        cubeMapEnvTexture[i]->setData(0, 0, QOpenGLTexture::CubeMapPositiveY,
-                                      QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, posYTex.constBits());
-        cubeMapEnvTexture[i]->setData(0, 0, QOpenGLTexture::CubeMapNegativeY,
-                                      QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, negYTex.constBits());
-        cubeMapEnvTexture[i]->setData(0, 0, QOpenGLTexture::CubeMapPositiveZ,
-                                      QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, posZTex.constBits());
-        cubeMapEnvTexture[i]->setData(0, 0, QOpenGLTexture::CubeMapNegativeZ,
-                                      QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, negZTex.constBits());
-
-        cubeMapEnvTexture[i]->setWrapMode(QOpenGLTexture::DirectionS,
-                                          QOpenGLTexture::ClampToEdge);
-        cubeMapEnvTexture[i]->setWrapMode(QOpenGLTexture::DirectionT,
-                                          QOpenGLTexture::ClampToEdge);
-        cubeMapEnvTexture[i]->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-        cubeMapEnvTexture[i]->setMagnificationFilter(QOpenGLTexture::LinearMipMapLinear);
+        cubeMapEnvTexture[i] = loadCubeMapTexture(QString(":/textures/%1")
+                                                  .arg(envTexture2StrMap[tex]));
+        TRUE_OR_DIE(cubeMapEnvTexture[i] != NULL, "Cannot load texture from file.");
     }
 
     if(QOpenGLContext::currentContext()->hasExtension("GL_ARB_seamless_cube_map"))
@@ -409,61 +660,65 @@ void Renderer::initTexture()
 }
 
 //------------------------------------------------------------------------------------------
-void Renderer::initDynamicCubeMapBufferObject()
+// cube map from the faces posx.jpg ... negz.jpg of a directory, NULL if one is missing
+//------------------------------------------------------------------------------------------
+QOpenGLTexture* Renderer::loadCubeMapTexture(const QString& _directory)
 {
-    useGlobalEnvTexture = true;
+    PROFILE_ZONE("Renderer::loadCubeMapTexture");
 
-    GLuint depthBuffer;
-    glGenRenderbuffers(1, &depthBuffer);
-    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, CUBE_MAP_SIZE,
-                          CUBE_MAP_SIZE);
+    static const char* faceNames[6] = {"posx", "negx", "posy", "negy", "posz", "negz"};
+    QImage faces[6];
 
-    FBOCubeMap = new QOpenGLFramebufferObject(CUBE_MAP_SIZE, CUBE_MAP_SIZE);
-    FBOCubeMap->setAttachment(QOpenGLFramebufferObject::Depth);
-    FBOCubeMap->bind();
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER,
-                              depthBuffer);
-    FBOCubeMap->release();
-
-    for(int i = 0; i < NUM_REFLECTIVE_OBJECTS; ++i)
+    for(int face = 0; face < 6; ++face)
     {
-        objEnvTexture[i] = currentEnvTexture;
+        QString faceFile = QString("%1/%2.jpg").arg(_directory).arg(faceNames[face]);
+        faces[face] = QImage(faceFile).convertToFormat(QImage::Format_RGBA8888);
 
-        objEnvTextureBuffer1[i] = new QOpenGLTexture(QOpenGLTexture::TargetCubeMap);
-        objEnvTextureBuffer1[i]->create();
-        objEnvTextureBuffer1[i]->setSize(CUBE_MAP_SIZE, CUBE_MAP_SIZE);
-        objEnvTextureBuffer1[i]->setFormat(QOpenGLTexture::RGBA8_UNorm);
-        objEnvTextureBuffer1[i]->allocateStorage();
+        if(faces[face].isNull() || faces[face].size() != faces[0].size())
+        {
+            PRINT_ERROR(QString("Cannot load texture from file %1").arg(faceFile));
+            return NULL;
+        }
+    }
 
-        objEnvTextureBuffer1[i]->setWrapMode(QOpenGLTexture::DirectionS,
-                                             QOpenGLTexture::ClampToEdge);
-        objEnvTextureBuffer1[i]->setWrapMode(QOpenGLTexture::DirectionT,
-                                             QOpenGLTexture::ClampToEdge);
-        objEnvTextureBuffer1[i]->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-        objEnvTextureBuffer1[i]->setMagnificationFilter(QOpenGLTexture::LinearMipMapLinear);
+    QOpenGLTexture* texture = new QOpenGLTexture(QOpenGLTexture::TargetCubeMap);
+    texture->create();
+    texture->setSize(faces[0].width(), faces[0].height());
+    texture->setFormat(QOpenGLTexture::RGBA8_UNorm);
+    texture->allocateStorage();
 
+    for(int face = 0; face < 6; ++face)
+    {
+        QOpenGLTexture::CubeMapFace cubeMapFace =
+            static_cast<QOpenGLTexture::CubeMapFace>(QOpenGLTexture::CubeMapPositiveX +
+                                                     face);
+        texture->setData(0, 0, cubeMapFace, QOpenGLTexture::RGBA, QOpenGLTexture::UInt8,
+                         faces[face].constBits());
+    }
 
-        objEnvTextureBuffer2[i] = new QOpenGLTexture(QOpenGLTexture::TargetCubeMap);
-        objEnvTextureBuffer2[i]->create();
-        objEnvTextureBuffer2[i]->setSize(CUBE_MAP_SIZE, CUBE_MAP_SIZE);
-        objEnvTextureBuffer2[i]->setFormat(QOpenGLTexture::RGBA8_UNorm);
-        objEnvTextureBuffer2[i]->allocateStorage();
+    texture->setWrapMode(QOpenGLTexture::DirectionS, QOpenGLTexture::ClampToEdge);
+    texture->setWrapMode(QOpenGLTexture::DirectionT, QOpenGLTexture::ClampToEdge);
+    texture->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
+    texture->setMagnificationFilter(QOpenGLTexture::LinearMipMapLinear);
 
-        objEnvTextureBuffer2[i]->setWrapMode(QOpenGLTexture::DirectionS,
-                                             QOpenGLTexture::ClampToEdge);
-        objEnvTextureBuffer2[i]->setWrapMode(QOpenGLTexture::DirectionT,
-                                             QOpenGLTexture::ClampToEdge);
-        objEnvTextureBuffer2[i]->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-        objEnvTextureBuffer2[i]->setMagnificationFilter(QOpenGLTexture::LinearMipMapLinear);
-    }
+    return texture;
 }
+
+//------------------------------------------------------------------------------------------
+// the built-in meshes are the first meshes of the geometry buffer
 //------------------------------------------------------------------------------------------
 void Renderer::initSceneMemory()
 {
+    PROFILE_ZONE("Renderer::initSceneMemory");
+
+    geometry.initialize(this);
+    geometry.resize(NUM_GEOMETRY_BUILTIN_MESHES);
+
     initPlaneMemory();
     initCubeMemory();
     initSphereMemory();
+
+    geometry.upload();
 }
 
 //------------------------------------------------------------------------------------------
@@ -474,34 +729,10 @@ void Renderer::initPlaneMemory()
         planeObject = new UnitPlane;
     }
 
-    if(vboPlane.isCreated())
-    {
-        vboPlane.destroy();
-    }
-
-    if(iboPlane.isCreated())
-    {
-        iboPlane.destroy();
-    }
-
-    ////////////////////////////////////////////////////////////////////////////////
-    // init memory for plane object
-    vboPlane.create();
-    vboPlane.bind();
-    vboPlane.allocate(2 * planeObject->getVertexOffset() + planeObject->getTexCoordOffset());
-    vboPlane.write(0, planeObject->getVertices(), planeObject->getVertexOffset());
-    vboPlane.write(planeObject->getVertexOffset(), planeObject->getNormals(),
-                   planeObject->getVertexOffset());
-    vboPlane.write(2 * planeObject->getVertexOffset(),
-                   planeObject->getTexureCoordinates(1.0f),
-                   planeObject->getTexCoordOffset());
-    vboPlane.release();
-    // indices
-    iboPlane.create();
-    iboPlane.bind();
-    iboPlane.allocate(planeObject->getIndices(), planeObject->getIndexOffset());
-    iboPlane.release();
-
+    geometry.setMesh(GEOMETRY_PLANE, planeObject->getVertices(), planeObject->getNormals(),
+                     planeObject->getTexureCoordinates((float)planeSize),
+                     planeObject->getNumVertices(), planeObject->getIndices(),
+                     planeObject->getNumIndices());
 }
 
 //------------------------------------------------------------------------------------------
@@ -512,32 +743,9 @@ void Renderer::initCubeMemory()
         cubeObject = new UnitCube;
     }
 
-    if(vboCube.isCreated())
-    {
-        vboCube.destroy();
-    }
-
-    if(iboCube.isCreated())
-    {
-        iboCube.destroy();
-    }
-
-    ////////////////////////////////////////////////////////////////////////////////
-    // init memory for cube
-    vboCube.create();
-    vboCube.bind();
-    vboCube.allocate(2 * cubeObject->getVertexOffset() + cubeObject->getTexCoordOffset());
-    vboCube.write(0, cubeObject->getVertices(), cubeObject->getVertexOffset());
-    vboCube.write(cubeObject->getVertexOffset(), cubeObject->getNormals(),
-                  cubeObject->getVertexOffset());
-    vboCube.write(2 * cubeObject->getVertexOffset(), cubeObject->getTexureCoordinates(1.0f),
-                  cubeObject->getTexCoordOffset());
-    vboCube.release();
-    // indices
-    iboCube.create();
-    iboCube.bind();
-    iboCube.allocate(cubeObject->getIndices(), cubeObject->getIndexOffset());
-    iboCube.release();
+    geometry.setMesh(GEOMETRY_CUBE, cubeObject->getVertices(), cubeObject->getNormals(),
+                     cubeObject->getTexureCoordinates(1.0f), cubeObject->getNumVertices(),
+                     cubeObject->getIndices(), cubeObject->getNumIndices());
 }
 
 //------------------------------------------------------------------------------------------
@@ -549,297 +757,233 @@ void Renderer::initSphereMemory()
         sphereObject->generateSphere(sphereNumStacks, sphereNumSlices);
     }
 
-    if(vboSphere.isCreated())
-    {
-        vboSphere.destroy();
-    }
-
-    if(iboSphere.isCreated())
-    {
-        iboSphere.destroy();
-    }
-
-    ////////////////////////////////////////////////////////////////////////////////
-    // init memory for sphere
-    vboSphere.create();
-    vboSphere.bind();
-    vboSphere.allocate(2 * sphereObject->getVertexOffset() +
-                       sphereObject->getTexCoordOffset());
-    vboSphere.write(0, sphereObject->getVertices(), sphereObject->getVertexOffset());
-    vboSphere.write(sphereObject->getVertexOffset(), sphereObject->getNormals(),
-                    sphereObject->getVertexOffset());
-    vboSphere.write(2 * sphereObject->getVertexOffset(), sphereObject->getTexureCoordinates(),
-                    sphereObject->getTexCoordOffset());
-    vboSphere.release();
-    // indices
-    iboSphere.create();
-    iboSphere.bind();
-    iboSphere.allocate(sphereObject->getIndices(), sphereObject->getIndexOffset());
-    iboSphere.release();
-
+    geometry.setMesh(GEOMETRY_SPHERE, sphereObject->getVertices(),
+                     sphereObject->getNormals(), sphereObject->getTexureCoordinates(),
+                     sphereObject->getNumVertices(), sphereObject->getIndices(),
+                     sphereObject->getNumIndices());
 }
 
 //------------------------------------------------------------------------------------------
-// record the buffer state by vertex array object
-//------------------------------------------------------------------------------------------
-void Renderer::initVertexArrayObjects()
+void Renderer::initSceneMatrices()
 {
-    initPlaneVAO(PHONG_SHADING);
+    PROFILE_ZONE("Renderer::initSceneMatrices");
+
+    /////////////////////////////////////////////////////////////////
+    // background
+    QMatrix4x4 backgroundMatrix;
+    backgroundMatrix.scale(1000.0f);
+    transforms.setLocalMatrix(TRANSFORM_BACKGROUND, backgroundMatrix);
+
+    /////////////////////////////////////////////////////////////////
+    // floor
+    changePlaneSize(initialPlaneSize);
+
+    /////////////////////////////////////////////////////////////////
+    // center cube
+    transforms.setLocalMatrix(TRANSFORM_CUBE, cubeInitialModelMatrix);
+
+    /////////////////////////////////////////////////////////////////
+    // sphere
+    transforms.setLocalMatrix(TRANSFORM_SEMI_REFLECTIVE_SPHERE,
+                              semiReflectiveSphereInitialModelMatrix);
 
-    initCubeVAO(PHONG_SHADING);
+    /////////////////////////////////////////////////////////////////
+    // reflective sphere
+    transforms.setLocalMatrix(TRANSFORM_REFLECTIVE_SPHERE,
+                              reflectiveSphereInitialModelMatrix);
 
-    initSphereVAO(PHONG_SHADING);
+    /////////////////////////////////////////////////////////////////
+    // probes, relative to their object
+    for(int i = 0; i < NUM_REFLECTIVE_OBJECTS; ++i)
+    {
+        QMatrix4x4 probeMatrix;
+        probeMatrix.translate(probeOffsets[i]);
+        transforms.setLocalMatrix(TRANSFORM_SEMI_REFLECTIVE_SPHERE_PROBE + i, probeMatrix);
+    }
 
+    transforms.update();
+    buildSceneBVH();
+    renderListChanged = true;
 }
 
 //------------------------------------------------------------------------------------------
-void Renderer::initPlaneVAO(ShadingProgram _shadingMode)
+void Renderer::changeSphereResolution(int _numStacks, int _numSlices)
 {
-    if(vaoPlane[_shadingMode].isCreated())
+    PROFILE_ZONE("Renderer::changeSphereResolution");
+
+    if(!acceptInputEvent(InputEvent(INPUT_SPHERE_RESOLUTION, _numStacks, _numSlices)))
     {
-        vaoPlane[_shadingMode].destroy();
+        return;
     }
 
-    QOpenGLShaderProgram* program = glslPrograms[_shadingMode];
+    sphereNumStacks = _numStacks;
+    sphereNumSlices = _numSlices;
 
-    vaoPlane[_shadingMode].create();
-    vaoPlane[_shadingMode].bind();
+    // uploaded with the next frame
+    sphereObject->generateSphere(sphereNumStacks, sphereNumSlices);
+    initSphereMemory();
+    indirectDrawsChanged = true;
 
-    vboPlane.bind();
-    program->enableAttributeArray(attrVertex[_shadingMode]);
-    program->setAttributeBuffer(attrVertex[_shadingMode], GL_FLOAT, 0, 3);
+    requestRedraw();
+}
 
-    program->enableAttributeArray(attrNormal[_shadingMode]);
-    program->setAttributeBuffer(attrNormal[_shadingMode], GL_FLOAT,
-                                planeObject->getVertexOffset(), 3);
+//------------------------------------------------------------------------------------------
+void Renderer::changePlaneSize(int _planeSize)
+{
+    if(!acceptInputEvent(InputEvent(INPUT_PLANE_SIZE, _planeSize)))
+    {
+        return;
+    }
 
-    program->enableAttributeArray(attrTexCoord[_shadingMode]);
-    program->setAttributeBuffer(attrTexCoord[_shadingMode], GL_FLOAT,
-                                2 * planeObject->getVertexOffset(), 2);
+    planeSize = _planeSize;
 
-    iboPlane.bind();
+    QMatrix4x4 planeMatrix;
+    planeMatrix.scale((float)_planeSize * 2.0f);
+    transforms.setLocalMatrix(TRANSFORM_FLOOR, planeMatrix);
 
-    // release vao before vbo and ibo
-    vaoPlane[_shadingMode].release();
-    vboPlane.release();
-    iboPlane.release();
+    // the texture coordinates are scaled with the plane, uploaded with the next frame
+    initPlaneMemory();
+    probeStaticLayersChanged = true;
 
+    requestRedraw();
 }
 
 //------------------------------------------------------------------------------------------
-void Renderer::initCubeVAO(ShadingProgram _shadingMode)
+void Renderer::resetObjectPositions()
 {
-    if(vaoCube[_shadingMode].isCreated())
+    if(!acceptInputEvent(InputEvent(INPUT_RESET_OBJECTS)))
     {
-        vaoCube[_shadingMode].destroy();
+        return;
     }
 
-    QOpenGLShaderProgram* program = glslPrograms[_shadingMode];
-
-    vaoCube[_shadingMode].create();
-    vaoCube[_shadingMode].bind();
+    initSceneMatrices();
+}
 
-    vboCube.bind();
-    program->enableAttributeArray(attrVertex[_shadingMode]);
-    program->setAttributeBuffer(attrVertex[_shadingMode], GL_FLOAT, 0, 3);
+//------------------------------------------------------------------------------------------
+void Renderer::changeFloorTexture(FloorTexture _texture)
+{
+    // the texture picked from the GUI replaces the one of the scene
+    floorTexture = _texture;
+    builtinSceneTextures[SCENE_FLOOR] = NULL;
+    probeStaticLayersChanged = true;
+    renderListChanged = true;
+    requestRedraw();
+}
 
-    program->enableAttributeArray(attrNormal[_shadingMode]);
-    program->setAttributeBuffer(attrNormal[_shadingMode], GL_FLOAT,
-                                cubeObject->getVertexOffset(), 3);
+//------------------------------------------------------------------------------------------
+void Renderer::changeEnvironmentTexture(EnvironmentTexture _texture)
+{
+//    envTexture = _texture;
+    currentEnvTexture = cubeMapEnvTexture[_texture];
+    probeStaticLayersChanged = true;
+    requestRedraw();
+}
 
-    program->enableAttributeArray(attrTexCoord[_shadingMode]);
-    program->setAttributeBuffer(attrTexCoord[_shadingMode], GL_FLOAT,
-                                2 * cubeObject->getVertexOffset(), 2);
+//------------------------------------------------------------------------------------------
+void Renderer::changeFloorTextureFilteringMode(QOpenGLTexture::Filter
+                                               _textureFiltering)
+{
+    if(!acceptInputEvent(InputEvent(INPUT_FLOOR_TEXTURE_FILTERING, _textureFiltering)))
+    {
+        return;
+    }
 
-    iboCube.bind();
+    floorTextureFiltering = _textureFiltering;
 
-    // release vao before vbo and ibo
-    vaoCube[_shadingMode].release();
-    vboCube.release();
-    iboCube.release();
+    for(int i = 0; i < NUM_FLOOR_TEXTURES; ++i)
+    {
+        floorTextures[i]->setMinMagFilters(_textureFiltering, _textureFiltering);
+    }
 
+    probeStaticLayersChanged = true;
+    requestRedraw();
 }
 
 //------------------------------------------------------------------------------------------
-void Renderer::initSphereVAO(ShadingProgram _shadingMode)
+void Renderer::changeSphereReflectionPercentage(int _reflectionPercentage)
 {
-    if(vaoSphere[_shadingMode].isCreated())
+    if(!acceptInputEvent(InputEvent(INPUT_SPHERE_REFLECTION, _reflectionPercentage)))
     {
-        vaoSphere[_shadingMode].destroy();
+        return;
     }
 
-    QOpenGLShaderProgram* program = glslPrograms[_shadingMode];
+    semiReflectiveSphereMaterial.setReflection((float)_reflectionPercentage / 100.0f);
+    uploadMaterial(SCENE_SEMI_REFLECTIVE_SPHERE, semiReflectiveSphereMaterial);
 
-    vaoSphere[_shadingMode].create();
-    vaoSphere[_shadingMode].bind();
-
-    vboSphere.bind();
-    program->enableAttributeArray(attrVertex[_shadingMode]);
-    program->setAttributeBuffer(attrVertex[_shadingMode], GL_FLOAT, 0, 3);
-
-    program->enableAttributeArray(attrNormal[_shadingMode]);
-    program->setAttributeBuffer(attrNormal[_shadingMode], GL_FLOAT,
-                                sphereObject->getVertexOffset(), 3);
-
-    program->enableAttributeArray(attrTexCoord[_shadingMode]);
-    program->setAttributeBuffer(attrTexCoord[_shadingMode], GL_FLOAT,
-                                2 * sphereObject->getVertexOffset(), 2);
-
-    iboSphere.bind();
-
-    // release vao before vbo and ibo
-    vaoSphere[_shadingMode].release();
-    vboSphere.release();
-    iboSphere.release();
-
-}
-
-//------------------------------------------------------------------------------------------
-void Renderer::initSceneMatrices()
-{
-    /////////////////////////////////////////////////////////////////
-    // background
-    backgroundCubeModelMatrix.setToIdentity();
-    backgroundCubeModelMatrix.scale(1000.0f);
-
-    /////////////////////////////////////////////////////////////////
-    // floor
-    changePlaneSize(30);
-    planeNormalMatrix = QMatrix4x4(planeModelMatrix.normalMatrix());
-
-    /////////////////////////////////////////////////////////////////
-    // center cube
-    cubeModelMatrix.setToIdentity();
-    cubeModelMatrix.scale(1.5);
-    cubeModelMatrix.translate(DEFAULT_CUBE_POSITION);
-    cubeNormalMatrix = QMatrix4x4(cubeModelMatrix.normalMatrix());
-
-    /////////////////////////////////////////////////////////////////
-    // sphere
-    semiReflectiveSphereModelMatrix.setToIdentity();
-    semiReflectiveSphereModelMatrix.translate(DEFAULT_SPHERE_POSITION);
-    semiReflectiveSphereNormalMatrix = QMatrix4x4(
-                                           semiReflectiveSphereModelMatrix.normalMatrix());
-    reflectiveObject2LocationMap[SEMI_REFLECTIVE_SPHERE] = DEFAULT_SPHERE_POSITION;
-    reflectiveObject2ModelMatrixMap[SEMI_REFLECTIVE_SPHERE] = semiReflectiveSphereModelMatrix;
-
-    /////////////////////////////////////////////////////////////////
-    // reflective sphere
-    reflectiveSphereModelMatrix.setToIdentity();
-    reflectiveSphereModelMatrix.translate(DEFAULT_REFLECTIVE_SPHERE_POSITION);
-    reflectiveSphereNormalMatrix = QMatrix4x4(reflectiveSphereModelMatrix.normalMatrix());
-    reflectiveObject2LocationMap[TOTAL_REFLECTIVE_SPHERE] =
-        DEFAULT_REFLECTIVE_SPHERE_POSITION;
-    reflectiveObject2ModelMatrixMap[TOTAL_REFLECTIVE_SPHERE] = reflectiveSphereModelMatrix;
+    requestRedraw();
 }
 
 //------------------------------------------------------------------------------------------
-void Renderer::changeSphereResolution(int _numStacks, int _numSlices)
+void Renderer::changeCubeColor(float _r, float _g, float _b)
 {
-    sphereNumStacks = _numStacks;
-    sphereNumSlices = _numSlices;
-
-    makeCurrent();
-    sphereObject->generateSphere(sphereNumStacks, sphereNumSlices);
-    initSphereMemory();
-
-    initSphereVAO(PHONG_SHADING);
-    doneCurrent();
-}
+    if(!acceptInputEvent(InputEvent(INPUT_CUBE_COLOR, _r, _g, _b)))
+    {
+        return;
+    }
 
-//------------------------------------------------------------------------------------------
-void Renderer::changePlaneSize(int _planeSize)
-{
-    planeModelMatrix.setToIdentity();
-    planeModelMatrix.scale((float)_planeSize * 2.0f);
+    cubeMaterial.setDiffuse(QVector4D(_r, _g, _b, 1.0f));
+    uploadMaterial(SCENE_CUBE, cubeMaterial);
 
-    vboPlane.bind();
-    vboPlane.write(2 * planeObject->getVertexOffset(),
-                   planeObject->getTexureCoordinates((float)_planeSize),
-                   planeObject->getTexCoordOffset());
-    vboPlane.release();
+    requestRedraw();
 }
 
 //------------------------------------------------------------------------------------------
-void Renderer::resetObjectPositions()
-{
-    initSceneMatrices();
-}
-
+// schedule at least _numFrames more frames
+// with dynamic environment mapping, the reflections of reflections are read from the
+// previous frame's cube maps, so a few more frames are needed to let them settle
 //------------------------------------------------------------------------------------------
-void Renderer::changeFloorTexture(FloorTexture _texture)
+void Renderer::requestRedraw(int _numFrames)
 {
-    floorTexture = _texture;
-}
+    if(enabledDynamicEnvMapping && _numFrames < NUM_REFLECTIVE_OBJECTS + 1)
+    {
+        _numFrames = NUM_REFLECTIVE_OBJECTS + 1;
+    }
 
-//------------------------------------------------------------------------------------------
-void Renderer::changeEnvironmentTexture(EnvironmentTexture _texture)
-{
-//    envTexture = _texture;
-    currentEnvTexture = cubeMapEnvTexture[_texture];
-}
+    frameScheduler.requestFrames(_numFrames);
 
-//------------------------------------------------------------------------------------------
-void Renderer::changeFloorTextureFilteringMode(QOpenGLTexture::Filter
-                                               _textureFiltering)
-{
-    for(int i = 0; i < NUM_FLOOR_TEXTURES; ++i)
+    if(!isHeadless())
     {
-        floorTextures[i]->setMinMagFilters(_textureFiltering, _textureFiltering);
+        update();
     }
 }
 
 //------------------------------------------------------------------------------------------
-void Renderer::changeSphereReflectionPercentage(int _reflectionPercentage)
+void Renderer::setContinuousRendering(bool _state)
 {
-    if(!isValid())
-    {
-        return;
-    }
-
-    semiReflectiveSphereMaterial.setReflection((float)_reflectionPercentage / 100.0f);
-    makeCurrent();
-    glBindBuffer(GL_UNIFORM_BUFFER, UBOSemireflectiveSphereMaterial);
-    glBufferSubData(GL_UNIFORM_BUFFER, 0, semiReflectiveSphereMaterial.getStructSize(),
-                    &semiReflectiveSphereMaterial);
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
-    doneCurrent();
+    frameScheduler.setContinuousRendering(_state);
+    requestRedraw();
 }
 
 //------------------------------------------------------------------------------------------
-void Renderer::changeCubeColor(float _r, float _g, float _b)
+// the camera or the objects are still moving by inertia
+//------------------------------------------------------------------------------------------
+bool Renderer::isAnimating()
 {
-    if(!isValid())
-    {
-        return;
-    }
-
-    cubeMaterial.setDiffuse(QVector4D(_r, _g, _b, 1.0f));
-    makeCurrent();
-    glBindBuffer(GL_UNIFORM_BUFFER, UBOCubeMaterial);
-    glBufferData(GL_UNIFORM_BUFFER, cubeMaterial.getStructSize(),
-                 NULL, GL_STREAM_DRAW);
-    glBufferSubData(GL_UNIFORM_BUFFER, 0, cubeMaterial.getStructSize(),
-                    &cubeMaterial);
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
-    doneCurrent();
+    return (translation.lengthSquared() >= MOVING_THRESHOLD ||
+            rotation.lengthSquared() >= MOVING_THRESHOLD ||
+            fabs(zooming) >= MOVING_THRESHOLD);
 }
 
 //------------------------------------------------------------------------------------------
 void Renderer::updateCamera()
 {
+    PROFILE_ZONE("Renderer::updateCamera");
+
     zoomCamera();
 
-    /////////////////////////////////////////////////////////////////
-    // flush camera data to uniform buffer
     viewMatrix.setToIdentity();
     viewMatrix.lookAt(cameraPosition, cameraFocus, cameraUpDirection);
 
     viewProjectionMatrix = projectionMatrix * viewMatrix;
+}
 
-    glBindBuffer(GL_UNIFORM_BUFFER, UBOMatrices);
-    glBufferSubData(GL_UNIFORM_BUFFER, 2 * SIZE_OF_MAT4, SIZE_OF_MAT4,
+//------------------------------------------------------------------------------------------
+// flush camera data to uniform buffer, overwritten by the probe faces
+//------------------------------------------------------------------------------------------
+void Renderer::uploadCamera()
+{
+    glBindBuffer(GL_UNIFORM_BUFFER, UBOCamera);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, SIZE_OF_MAT4,
                     viewProjectionMatrix.constData());
     glBindBuffer(GL_UNIFORM_BUFFER, 0);
 }
@@ -859,9 +1003,16 @@ QSize Renderer::minimumSizeHint() const
 //------------------------------------------------------------------------------------------
 void Renderer::initializeGL()
 {
+    PROFILE_ZONE("Renderer::initializeGL");
+
     initializeOpenGLFunctions();
 
     checkOpenGLVersion();
+    gpuProfiler.initialize(this);
+    occlusionCuller.initialize(this);
+    gpuCuller.initialize(QOpenGLContext::currentContext());
+    occlusionCuller.setEnabled(true);
+    frameCapture.initialize(this);
 
 
     if(!initShaderPrograms())
@@ -874,7 +1025,9 @@ void Renderer::initializeGL()
     initRenderingData();
     initSharedBlockUniform();
     initSceneMatrices();
-    initDynamicCubeMapBufferObject();
+
+    // the dynamic cube maps are allocated by the frame graph, when they are rendered
+    frameGraph.initialize(this);
 
     glEnable(GL_DEPTH_TEST);
 
@@ -886,99 +1039,121 @@ void Renderer::initializeGL()
 void Renderer::resizeGL(int w, int h)
 {
     projectionMatrix.setToIdentity();
-    projectionMatrix.perspective(45, (float)w / (float)h, 0.1f, 10000.0f);
+    projectionMatrix.perspective(CAMERA_FOVY, (float)w / (float)h, CAMERA_NEAR, CAMERA_FAR);
 }
 
 //------------------------------------------------------------------------------------------
 void Renderer::paintGL()
 {
-    createObjectCubeMapTextures();
+    PROFILE_ZONE("Renderer::paintGL");
+    paintingFrame = true;
 
-    if(enabledObjectTransformation)
+    if(!pendingRecordingFile.isEmpty())
     {
-        translateObjects();
-        rotateObjects();
+        inputRecorder.start(pendingRecordingFile, getSessionState());
+        pendingRecordingFile.clear();
     }
-    else
-    {
-        translateCamera();
-        rotateCamera();
 
+    if(inputReplayer != NULL)
+    {
+        replayInputEvents();
     }
 
-    updateCamera();
-
-    // render scene
-    glViewport(0, 0, width() * retinaScale, height() * retinaScale);
-    renderScene();
-}
-
-//-----------------------------------------------------------------------------------------
-void Renderer::mousePressEvent(QMouseEvent* _event)
-{
-    lastMousePos = QVector2D(_event->localPos());
-
-    if(_event->button() == Qt::RightButton)
+    if(sceneChanged)
     {
-        mouseButtonPressed = RIGHT_BUTTON;
+        applySceneDescription();
     }
-    else
+
+    // the parameters changed since the last frame, in one upload
+    numFrameUploadBytes = materialBuffer.flush();
+    geometry.upload();
+    numFrameContextSwitches = numContextSwitches;
+    numContextSwitches = 0;
+    numDrawCalls = 0;
+    numProgramSwitches = 0;
+    numTextureSwitches = 0;
+    numProbeFaces = 0;
+    numSkippedProbeFaces = 0;
+
+    frameTime = frameScheduler.beginFrame();
+    acceptInputEvent(InputEvent(INPUT_FRAME, frameTime));
+
+    if(frameCapture.hasPendingReads())
     {
-        mouseButtonPressed = LEFT_BUTTON;
+        frameCapture.processCompletedReads();
     }
-}
 
-//-----------------------------------------------------------------------------------------
-void Renderer::mouseMoveEvent(QMouseEvent* _event)
-{
-    QVector2D mouseMoved = QVector2D(_event->localPos()) - lastMousePos;
+    gpuProfiler.beginFrame();
+    cullingStatistics.clear();
+    occlusionCuller.collectResults();
 
-    switch(specialKeyPressed)
-    {
-    case Renderer::NO_KEY:
+    // before the frame graph: the probe faces are selected from the camera of this frame
+    moveSceneAndCamera();
+
+    buildFrameGraph();
+    frameGraph.compile();
+    frameGraph.execute();
+    keepProbeUpdates();
+
+    if(!pendingProbeCaptureFile.isEmpty())
     {
+        writeProbeFaces(pendingProbeCaptureFile);
+        pendingProbeCaptureFile.clear();
+    }
 
-        if(mouseButtonPressed == RIGHT_BUTTON)
-        {
-            translation.setX(translation.x() + mouseMoved.x() / 50.0f);
-            translation.setY(translation.y() - mouseMoved.y() / 50.0f);
-        }
-        else
-        {
-            rotation.setX(rotation.x() - mouseMoved.x() / 5.0f);
-            rotation.setY(rotation.y() - mouseMoved.y() / 5.0f);
-        }
+    gpuProfiler.endFrame();
+    paintingFrame = false;
 
+    if(isHeadless())
+    {
+        return;
     }
-    break;
 
-    case Renderer::SHIFT_KEY:
+    if(gpuProfiler.isEnabled())
     {
-        if(mouseButtonPressed == RIGHT_BUTTON)
-        {
-            QVector2D dir = mouseMoved.normalized();
-            zooming += mouseMoved.length() * dir.x() / 500.0f;
-        }
-        else
-        {
-            rotation.setX(rotation.x() + mouseMoved.x() / 5.0f);
-            rotation.setZ(rotation.z() + mouseMoved.y() / 5.0f);
-        }
+        renderOverlay();
     }
-    break;
 
-    case Renderer::CTRL_KEY:
-        break;
+    // keep rendering while capturing a stream, and until the readbacks in flight are done
+    if(frameScheduler.endFrame(isAnimating() || frameCapture.isCapturing() ||
+                               frameCapture.hasPendingReads()))
+    {
+        update();
     }
+}
+
+//-----------------------------------------------------------------------------------------
+void Renderer::mousePressEvent(QMouseEvent* _event)
+{
+    MouseButton button = (_event->button() == Qt::RightButton) ? RIGHT_BUTTON : LEFT_BUTTON;
+    processInputEvent(InputEvent(INPUT_MOUSE_PRESS, _event->localPos().x(),
+                                 _event->localPos().y(), button));
+}
 
-    lastMousePos = QVector2D(_event->localPos());
-    update();
+//-----------------------------------------------------------------------------------------
+void Renderer::mouseMoveEvent(QMouseEvent* _event)
+{
+    processInputEvent(InputEvent(INPUT_MOUSE_MOVE, _event->localPos().x(),
+                                 _event->localPos().y()));
 }
 
 //------------------------------------------------------------------------------------------
 void Renderer::mouseReleaseEvent(QMouseEvent* _event)
 {
-    mouseButtonPressed = NO_BUTTON;
+    processInputEvent(InputEvent(INPUT_MOUSE_RELEASE));
+}
+
+//------------------------------------------------------------------------------------------
+void Renderer::mouseDoubleClickEvent(QMouseEvent* _event)
+{
+    float distance;
+    int object = pickObject(_event->localPos().x(), _event->localPos().y(), distance);
+
+    if(object >= 0)
+    {
+        qDebug() << "Renderer: picked" << getObjectName(object) << "at distance"
+                 << distance;
+    }
 }
 
 //------------------------------------------------------------------------------------------
@@ -986,11 +1161,13 @@ void Renderer::wheelEvent(QWheelEvent* _event)
 {
     if(!_event->angleDelta().isNull())
     {
-        zooming +=  (_event->angleDelta().x() + _event->angleDelta().y()) / 500.0f;
+        float delta = (_event->angleDelta().x() + _event->angleDelta().y()) / 500.0f;
+        processInputEvent(InputEvent(INPUT_ZOOM, delta));
+    }
+    else
+    {
+        requestRedraw();
     }
-
-
-    update();
 }
 
 //------------------------------------------------------------------------------------------
@@ -998,22 +1175,139 @@ void Renderer::changeShadingMode(ShadingProgram _shadingMode)
 {
     shadingMode = _shadingMode;
     currentProgram = glslPrograms[shadingMode];
+    probeStaticLayersChanged = true;
 
-    update();
+    requestRedraw();
 }
 
 //------------------------------------------------------------------------------------------
 void Renderer::resetCameraPosition()
 {
+    if(!acceptInputEvent(InputEvent(INPUT_RESET_CAMERA)))
+    {
+        return;
+    }
+
     cameraPosition = DEFAULT_CAMERA_POSITION;
     cameraFocus = DEFAULT_CAMERA_FOCUS;
     cameraUpDirection = QVector3D(0.0f, 1.0f, 0.0f);
+    renderListChanged = true;
+    requestRedraw();
+}
+
+//------------------------------------------------------------------------------------------
+// place the camera directly, cancel the motion left by inertia
+//------------------------------------------------------------------------------------------
+void Renderer::setCamera(const QVector3D& _position, const QVector3D& _focus,
+                         const QVector3D& _upDirection)
+{
+    cameraPosition = _position;
+    cameraFocus = _focus;
+    cameraUpDirection = _upDirection;
+
+    translation = QVector3D(0.0f, 0.0f, 0.0f);
+    rotation = QVector3D(0.0f, 0.0f, 0.0f);
+    zooming = 0.0f;
+    renderListChanged = true;
+
+    requestRedraw();
+}
+
+//------------------------------------------------------------------------------------------
+// transform the cube and the semi-reflective sphere from their initial positions,
+// the same objects as moved by translateObjects/rotateObjects
+//------------------------------------------------------------------------------------------
+void Renderer::setObjectTransformation(const QMatrix4x4& _transformation)
+{
+    transforms.setLocalMatrix(TRANSFORM_CUBE, _transformation * cubeInitialModelMatrix);
+    transforms.setLocalMatrix(TRANSFORM_SEMI_REFLECTIVE_SPHERE,
+                              _transformation * semiReflectiveSphereInitialModelMatrix);
+
+    translation = QVector3D(0.0f, 0.0f, 0.0f);
+    rotation = QVector3D(0.0f, 0.0f, 0.0f);
+
+    requestRedraw();
+}
+
+//------------------------------------------------------------------------------------------
+// Off-axis projection covering the pixels [_tileX, _tileX + _tileWidth) x
+// [_tileY, _tileY + _tileHeight) (rows from the top) of an _imageWidth x _imageHeight
+// image rendered with the regular camera frustum.
+// The tiles of an image put side by side give the same image as one big frustum.
+//------------------------------------------------------------------------------------------
+void Renderer::setTileProjection(int _tileX, int _tileY, int _tileWidth, int _tileHeight,
+                                 int _imageWidth, int _imageHeight)
+{
+    float top = CAMERA_NEAR * qTan(qDegreesToRadians(CAMERA_FOVY * 0.5f));
+    float right = top * (float)_imageWidth / (float)_imageHeight;
+
+    float tileLeft = -right + 2.0f * right * (float)_tileX / (float)_imageWidth;
+    float tileRight = -right + 2.0f * right * (float)(_tileX + _tileWidth) /
+                      (float)_imageWidth;
+    float tileTop = top - 2.0f * top * (float)_tileY / (float)_imageHeight;
+    float tileBottom = top - 2.0f * top * (float)(_tileY + _tileHeight) /
+                       (float)_imageHeight;
+
+    projectionMatrix.setToIdentity();
+    projectionMatrix.frustum(tileLeft, tileRight, tileBottom, tileTop, CAMERA_NEAR,
+                             CAMERA_FAR);
+
+    requestRedraw();
+}
+
+//------------------------------------------------------------------------------------------
+// stop regenerating the dynamic cube maps, the frames use the last generated ones
+// (tiles of the same image must see the same reflections)
+//------------------------------------------------------------------------------------------
+void Renderer::freezeProbeUpdates(bool _state)
+{
+    frozenProbes = _state;
+    requestRedraw();
+}
+
+//------------------------------------------------------------------------------------------
+// the dynamic cube maps are regenerated with the new size from the global environment
+//------------------------------------------------------------------------------------------
+void Renderer::setCubeMapSize(int _cubeMapSize)
+{
+    if(_cubeMapSize == cubeMapSize)
+    {
+        return;
+    }
+
+    cubeMapSize = _cubeMapSize;
+
+    // the frame graph deletes the cube maps of the old size once they are unused
+    releaseProbeHistory();
+    requestRedraw(NUM_REFLECTIVE_OBJECTS + 1);
+}
+
+//------------------------------------------------------------------------------------------
+int Renderer::getCubeMapSize() const
+{
+    return cubeMapSize;
+}
+
+//------------------------------------------------------------------------------------------
+// regenerate the dynamic cube maps every _numFrames frames only, the frames in between
+// reuse the latest ones
+//------------------------------------------------------------------------------------------
+void Renderer::setProbeUpdateInterval(int _numFrames)
+{
+    probeUpdateInterval = qMax(1, _numFrames);
+    numFramesSinceProbeUpdate = 0;
 }
 
 //------------------------------------------------------------------------------------------
 void Renderer::enableDepthTest(bool _status)
 {
-    makeCurrent();
+    if(!acceptInputEvent(InputEvent(INPUT_DEPTH_TEST, _status)))
+    {
+        return;
+    }
+
+    enabledDepthTest = _status;
+    makeRendererCurrent();
 
     if(_status)
     {
@@ -1024,528 +1318,2811 @@ void Renderer::enableDepthTest(bool _status)
         glDisable(GL_DEPTH_TEST);
     }
 
-    doneCurrent();
+    doneRendererCurrent();
+    probeStaticLayersChanged = true;
+    requestRedraw();
 }
 
 //------------------------------------------------------------------------------------------
 void Renderer::enableZAxisRotation(bool _status)
 {
+    if(!acceptInputEvent(InputEvent(INPUT_Z_AXIS_ROTATION, _status)))
+    {
+        return;
+    }
+
     enabledZAxisRotation = _status;
 
     if(!enabledZAxisRotation)
     {
         cameraUpDirection = QVector3D(0.0f, 1.0f, 0.0f);
     }
+
+    requestRedraw();
 }
 
 //------------------------------------------------------------------------------------------
 void Renderer::enableObjectTransformation(bool _status)
 {
+    if(!acceptInputEvent(InputEvent(INPUT_OBJECT_TRANSFORMATION, _status)))
+    {
+        return;
+    }
+
     enabledObjectTransformation = _status;
+    requestRedraw();
 }
 
 //------------------------------------------------------------------------------------------
 void Renderer::enableDynamicEnvironmentMapping(bool _state)
 {
+    if(!acceptInputEvent(InputEvent(INPUT_DYNAMIC_ENV_MAPPING, _state)))
+    {
+        return;
+    }
+
     enabledDynamicEnvMapping = _state;
 
+    // the cube maps go back to the frame graph, which deletes them once unused
     if(!enabledDynamicEnvMapping)
     {
-        useGlobalEnvTexture = true;
+        releaseProbeHistory();
     }
+
+    requestRedraw();
 }
 
 //------------------------------------------------------------------------------------------
 void Renderer::enableBackgroundRendering(bool _state)
 {
+    if(!acceptInputEvent(InputEvent(INPUT_BACKGROUND_RENDERING, _state)))
+    {
+        return;
+    }
+
     enabledBackgroundRendering = _state;
+    probeStaticLayersChanged = true;
+    requestRedraw();
 }
 
 //------------------------------------------------------------------------------------------
 void Renderer::enableTextureAnisotropicFiltering(bool _state)
 {
+    if(!acceptInputEvent(InputEvent(INPUT_ANISOTROPIC_FILTERING, _state)))
+    {
+        return;
+    }
+
     enabledTextureAnisotropicFiltering = _state;
+    probeStaticLayersChanged = true;
+    renderListChanged = true;
+    requestRedraw();
 }
 
 //------------------------------------------------------------------------------------------
-void Renderer::keyPressEvent(QKeyEvent* _event)
+void Renderer::enableGPUProfiler(bool _state)
 {
-    switch(_event->key())
-    {
-    case Qt::Key_Shift:
-        specialKeyPressed = Renderer::SHIFT_KEY;
-        break;
+    gpuProfiler.setEnabled(_state);
 
-    case Qt::Key_Plus:
-        zooming -= 0.1f;
-        break;
+    if(_state)
+    {
+        gpuProfiler.reset();
+    }
 
-    case Qt::Key_Minus:
-        zooming += 0.1f;
-        break;
+    // fill the query ring before the first results can be shown
+    requestRedraw(GPU_PROFILER_FRAME_LATENCY + 1);
+}
 
-    default:
-        QOpenGLWidget::keyPressEvent(_event);
-    }
+//------------------------------------------------------------------------------------------
+bool Renderer::saveGPUTimings(const QString& _fileName)
+{
+    return gpuProfiler.saveCSV(_fileName);
 }
 
 //------------------------------------------------------------------------------------------
-void Renderer::keyReleaseEvent(QKeyEvent* _event)
+void Renderer::enableFrustumCulling(bool _state)
 {
-    specialKeyPressed = Renderer::NO_KEY;
+    enabledFrustumCulling = _state;
+    requestRedraw();
 }
 
 //------------------------------------------------------------------------------------------
-void Renderer::translateCamera()
+void Renderer::enableOcclusionCulling(bool _state)
 {
-    translation *= MOVING_INERTIA;
+    occlusionCuller.setEnabled(_state);
+    requestRedraw();
+}
 
-    if(translation.lengthSquared() < 1e-4)
-    {
-        return;
+//------------------------------------------------------------------------------------------
+// draw the scene instances sharing a mesh, a texture and a probe with one draw call
+//------------------------------------------------------------------------------------------
+void Renderer::enableInstancing(bool _state)
+{
+    enabledInstancing = _state;
+    renderListChanged = true;
+    requestRedraw();
+}
+
+//------------------------------------------------------------------------------------------
+// skip the dynamic objects in the faces of the probes which the camera does not see
+// reflected
+//------------------------------------------------------------------------------------------
+void Renderer::enableProbeFaceSkipping(bool _state)
+{
+    enabledProbeFaceSkipping = _state;
+    requestRedraw();
+}
+
+//------------------------------------------------------------------------------------------
+// cull the instance batches with a compute shader and draw them indirectly (GL 4.3)
+//------------------------------------------------------------------------------------------
+void Renderer::enableGPUCulling(bool _state)
+{
+    gpuCuller.setEnabled(_state);
+    requestRedraw();
+}
+
+//------------------------------------------------------------------------------------------
+// the closest object under the pixel (widget coordinates), -1 if none
+// The objects are picked by their bounding boxes.
+//------------------------------------------------------------------------------------------
+int Renderer::pickObject(int _x, int _y, float& _distance)
+{
+    float ndcX = 2.0f * ((float)_x + 0.5f) / (float)width() - 1.0f;
+    float ndcY = 1.0f - 2.0f * ((float)_y + 0.5f) / (float)height();
+
+    QMatrix4x4 invViewProjection = viewProjectionMatrix.inverted();
+    QVector3D nearPoint = invViewProjection * QVector3D(ndcX, ndcY, -1.0f);
+    QVector3D farPoint = invViewProjection * QVector3D(ndcX, ndcY, 1.0f);
+
+    sceneBVH.refit();
+
+    return sceneBVH.pickRay(nearPoint, (farPoint - nearPoint).normalized(), _distance);
+}
+
+//------------------------------------------------------------------------------------------
+QString Renderer::getObjectName(int _object) const
+{
+    if(_object < 0 || _object >= sceneBVH.getNumObjects())
+    {
+        return QString();
     }
 
-    QVector3D eyeVector = cameraFocus - cameraPosition;
-    float scale = sqrt(eyeVector.length()) * 0.01f;
+    if(_object < NUM_SCENE_BUILTIN_OBJECTS)
+    {
+        return SceneDescription::getBuiltinObjectName(
+                   static_cast<SceneBuiltinObject>(_object));
+    }
 
-    QVector3D u(0.0f, 1.0f, 0.0f);
-    QVector3D v = QVector3D::crossProduct(eyeVector, u);
-    u = QVector3D::crossProduct(v, eyeVector);
-    u.normalize();
-    v.normalize();
+    int index = sceneInstances[_object - NUM_SCENE_BUILTIN_OBJECTS];
+    const SceneInstance& instance = sceneDescription->getInstances()[index];
 
-    cameraPosition -= scale * (translation.x() * v + translation.y() * u);
-    cameraFocus -= scale * (translation.x() * v + translation.y() * u);
+    return sceneDescription->getString(instance.name);
+}
 
+//------------------------------------------------------------------------------------------
+QVector<CullingStatistics> Renderer::getCullingStatistics() const
+{
+    return cullingStatistics;
 }
 
 //------------------------------------------------------------------------------------------
-void Renderer::rotateCamera()
+void Renderer::keyPressEvent(QKeyEvent* _event)
 {
-    rotation *= MOVING_INERTIA;
+    switch(_event->key())
+    {
+    case Qt::Key_Shift:
+        processInputEvent(InputEvent(INPUT_SPECIAL_KEY, Renderer::SHIFT_KEY));
+        break;
+
+    case Qt::Key_Plus:
+        processInputEvent(InputEvent(INPUT_ZOOM, -0.1f));
+        break;
+
+    case Qt::Key_Minus:
+        processInputEvent(InputEvent(INPUT_ZOOM, 0.1f));
+        break;
+
+    default:
+        QOpenGLWidget::keyPressEvent(_event);
+    }
+}
 
-    if(rotation.lengthSquared() < 1e-4)
+//------------------------------------------------------------------------------------------
+void Renderer::keyReleaseEvent(QKeyEvent* _event)
+{
+    if(specialKeyPressed != Renderer::NO_KEY)
     {
-        return;
+        processInputEvent(InputEvent(INPUT_SPECIAL_KEY, Renderer::NO_KEY));
     }
+}
 
-    QVector3D nEyeVector = cameraPosition - cameraFocus ;
+//------------------------------------------------------------------------------------------
+void Renderer::processInputEvent(const InputEvent& _event)
+{
+    if(acceptInputEvent(_event))
+    {
+        applyInputEvent(_event);
+    }
+}
 
-    float scale = sqrt(nEyeVector.length()) * 0.02f;
-    QQuaternion qRotation = QQuaternion::fromAxisAndAngle(QVector3D(1, 0, 0),
-                                                          rotation.y() * scale) *
-                            QQuaternion::fromAxisAndAngle(QVector3D(0, 1, 0), rotation.x() * scale) *
-                            QQuaternion::fromAxisAndAngle(QVector3D(0, 0, 1), rotation.z() * scale);
-    nEyeVector = qRotation.rotatedVector(nEyeVector);
+//------------------------------------------------------------------------------------------
+// Record the event, or return false to ignore it: while a session is replayed, only the
+// events applied by the frames (the replayed ones) are accepted, the live input and the
+// GUI cannot change the replay.
+//------------------------------------------------------------------------------------------
+bool Renderer::acceptInputEvent(const InputEvent& _event)
+{
+    if(isReplaying() && !paintingFrame)
+    {
+        return false;
+    }
 
-    cameraPosition = cameraFocus + nEyeVector;
+    if(inputRecorder.isRecording())
+    {
+        inputRecorder.record(_event);
+    }
 
-    if(enabledZAxisRotation)
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+void Renderer::applyInputEvent(const InputEvent& _event)
+{
+    const float* values = _event.values;
+
+    switch(_event.type)
     {
-        cameraUpDirection = qRotation.rotatedVector(cameraUpDirection);
+    case INPUT_MOUSE_PRESS:
+        lastMousePos = QVector2D(values[0], values[1]);
+        mouseButtonPressed = static_cast<MouseButton>((int)values[2]);
+        break;
+
+    case INPUT_MOUSE_MOVE:
+    {
+        QVector2D mousePos(values[0], values[1]);
+        QVector2D mouseMoved = mousePos - lastMousePos;
+
+        switch(specialKeyPressed)
+        {
+        case Renderer::NO_KEY:
+        {
+
+            if(mouseButtonPressed == RIGHT_BUTTON)
+            {
+                translation.setX(translation.x() + mouseMoved.x() / 50.0f);
+                translation.setY(translation.y() - mouseMoved.y() / 50.0f);
+            }
+            else
+            {
+                rotation.setX(rotation.x() - mouseMoved.x() / 5.0f);
+                rotation.setY(rotation.y() - mouseMoved.y() / 5.0f);
+            }
+
+        }
+        break;
+
+        case Renderer::SHIFT_KEY:
+        {
+            if(mouseButtonPressed == RIGHT_BUTTON)
+            {
+                QVector2D dir = mouseMoved.normalized();
+                zooming += mouseMoved.length() * dir.x() / 500.0f;
+            }
+            else
+            {
+                rotation.setX(rotation.x() + mouseMoved.x() / 5.0f);
+                rotation.setZ(rotation.z() + mouseMoved.y() / 5.0f);
+            }
+        }
+        break;
+
+        case Renderer::CTRL_KEY:
+            break;
+        }
+
+        lastMousePos = mousePos;
+        requestRedraw();
+    }
+    break;
+
+    case INPUT_MOUSE_RELEASE:
+        mouseButtonPressed = NO_BUTTON;
+        break;
+
+    case INPUT_ZOOM:
+        zooming += values[0];
+        requestRedraw();
+        break;
+
+    case INPUT_SPECIAL_KEY:
+        specialKeyPressed = static_cast<SpecialKey>((int)values[0]);
+        break;
+
+    case INPUT_RESET_CAMERA:
+        resetCameraPosition();
+        break;
+
+    case INPUT_RESET_OBJECTS:
+        resetObjectPositions();
+        break;
+
+    case INPUT_DEPTH_TEST:
+        enableDepthTest(values[0] != 0.0f);
+        break;
+
+    case INPUT_Z_AXIS_ROTATION:
+        enableZAxisRotation(values[0] != 0.0f);
+        break;
+
+    case INPUT_OBJECT_TRANSFORMATION:
+        enableObjectTransformation(values[0] != 0.0f);
+        break;
+
+    case INPUT_DYNAMIC_ENV_MAPPING:
+        enableDynamicEnvironmentMapping(values[0] != 0.0f);
+        break;
+
+    case INPUT_BACKGROUND_RENDERING:
+        enableBackgroundRendering(values[0] != 0.0f);
+        break;
+
+    case INPUT_ANISOTROPIC_FILTERING:
+        enableTextureAnisotropicFiltering(values[0] != 0.0f);
+        break;
+
+    case INPUT_PLANE_SIZE:
+        changePlaneSize((int)values[0]);
+        break;
+
+    case INPUT_SPHERE_RESOLUTION:
+        changeSphereResolution((int)values[0], (int)values[1]);
+        break;
+
+    case INPUT_SPHERE_REFLECTION:
+        changeSphereReflectionPercentage((int)values[0]);
+        break;
+
+    case INPUT_CUBE_COLOR:
+        changeCubeColor(values[0], values[1], values[2]);
+        break;
+
+    case INPUT_FLOOR_TEXTURE_FILTERING:
+        changeFloorTextureFilteringMode(static_cast<QOpenGLTexture::Filter>
+                                        ((int)values[0]));
+        break;
+
+    default:
+        break;
     }
 }
 
 //------------------------------------------------------------------------------------------
-void Renderer::zoomCamera()
+InputSessionState Renderer::getSessionState()
+{
+    InputSessionState state;
+
+    state.cameraPosition = cameraPosition;
+    state.cameraFocus = cameraFocus;
+    state.cameraUpDirection = cameraUpDirection;
+    state.translation = translation;
+    state.rotation = rotation;
+    state.zooming = zooming;
+    state.cubeModelMatrix = transforms.getLocalMatrix(TRANSFORM_CUBE);
+    state.semiReflectiveSphereModelMatrix =
+        transforms.getLocalMatrix(TRANSFORM_SEMI_REFLECTIVE_SPHERE);
+    state.cubeColor = cubeMaterial.diffuseColor;
+    state.sphereReflection = semiReflectiveSphereMaterial.reflection;
+    state.planeSize = planeSize;
+    state.sphereNumStacks = sphereNumStacks;
+    state.sphereNumSlices = sphereNumSlices;
+    state.floorTextureFiltering = floorTextureFiltering;
+    state.enabledDepthTest = enabledDepthTest;
+    state.enabledZAxisRotation = enabledZAxisRotation;
+    state.enabledObjectTransformation = enabledObjectTransformation;
+    state.enabledDynamicEnvMapping = enabledDynamicEnvMapping;
+    state.enabledBackgroundRendering = enabledBackgroundRendering;
+    state.enabledTextureAnisotropicFiltering = enabledTextureAnisotropicFiltering;
+
+    return state;
+}
+
+//------------------------------------------------------------------------------------------
+// put the renderer back in the state a session was recorded from, motion included
+//------------------------------------------------------------------------------------------
+void Renderer::restoreSessionState(const InputSessionState& _state)
 {
-    zooming *= MOVING_INERTIA;
+    setCamera(_state.cameraPosition, _state.cameraFocus, _state.cameraUpDirection);
+    translation = _state.translation;
+    rotation = _state.rotation;
+    zooming = _state.zooming;
+
+    transforms.setLocalMatrix(TRANSFORM_CUBE, _state.cubeModelMatrix);
+    transforms.setLocalMatrix(TRANSFORM_SEMI_REFLECTIVE_SPHERE,
+                              _state.semiReflectiveSphereModelMatrix);
 
-    if(fabs(zooming) < 1e-4)
+    if(_state.sphereNumStacks != sphereNumStacks ||
+       _state.sphereNumSlices != sphereNumSlices)
     {
-        return;
+        changeSphereResolution(_state.sphereNumStacks, _state.sphereNumSlices);
     }
 
-    QVector3D nEyeVector = cameraPosition - cameraFocus ;
-    float len = nEyeVector.length();
-    nEyeVector.normalize();
+    changePlaneSize(_state.planeSize);
+    changeFloorTextureFilteringMode(static_cast<QOpenGLTexture::Filter>
+                                    (_state.floorTextureFiltering));
+    changeSphereReflectionPercentage(qRound(_state.sphereReflection * 100.0f));
+    changeCubeColor(_state.cubeColor.x(), _state.cubeColor.y(), _state.cubeColor.z());
+    enableDepthTest(_state.enabledDepthTest);
+    enableZAxisRotation(_state.enabledZAxisRotation);
+    enableObjectTransformation(_state.enabledObjectTransformation);
+    enableDynamicEnvironmentMapping(_state.enabledDynamicEnvMapping);
+    enableBackgroundRendering(_state.enabledBackgroundRendering);
+    enableTextureAnisotropicFiltering(_state.enabledTextureAnisotropicFiltering);
 
-    len += sqrt(len) * zooming * 0.3f;
+    specialKeyPressed = Renderer::NO_KEY;
+    mouseButtonPressed = NO_BUTTON;
+}
 
-    if(len < 0.5f)
+//------------------------------------------------------------------------------------------
+bool Renderer::startRecording(const QString& _fileName)
+{
+    if(isReplaying())
     {
-        len = 0.5f;
+        return false;
     }
 
-    cameraPosition = len * nEyeVector + cameraFocus;
+    // the initial state is only complete once the scene is initialized
+    if(!isRendererValid())
+    {
+        pendingRecordingFile = _fileName;
+        return true;
+    }
 
+    return inputRecorder.start(_fileName, getSessionState());
 }
 
 //------------------------------------------------------------------------------------------
-void Renderer::translateObjects()
+void Renderer::stopRecording()
+{
+    pendingRecordingFile.clear();
+    inputRecorder.stop();
+}
+
+//------------------------------------------------------------------------------------------
+bool Renderer::isRecording() const
+{
+    return (inputRecorder.isRecording() || !pendingRecordingFile.isEmpty());
+}
+
+//------------------------------------------------------------------------------------------
+// Replay a recorded session frame by frame: every frame applies the events recorded before
+// the same frame of the session and simulates its recorded frame time, so the rendered
+// frames do not depend on the speed of the machine.
+// The replay starts at the next frame and renders continuously until the last event has
+// been applied and the motion has stopped.
+//------------------------------------------------------------------------------------------
+bool Renderer::startReplay(const QString& _fileName, bool _quitWhenFinished)
 {
-    translation *= MOVING_INERTIA;
+    InputReplayer* replayer = new InputReplayer;
 
-    if(translation.lengthSquared() < 1e-4)
+    if(!replayer->load(_fileName))
     {
-        return;
+        delete replayer;
+        return false;
     }
 
-    QVector3D eyeVector = cameraFocus - cameraPosition;
-    float scale = sqrt(eyeVector.length()) * 0.05f;
+    stopRecording();
+    delete inputReplayer;
+    inputReplayer = replayer;
 
-    QVector3D u(0.0f, 1.0f, 0.0f);
-    QVector3D v = QVector3D::crossProduct(eyeVector, u);
-    u = QVector3D::crossProduct(v, eyeVector);
-    u.normalize();
-    v.normalize();
+    numReplayedFrames = 0;
+    quitAfterReplay = _quitWhenFinished;
 
-    QVector3D objectTrans = scale * (translation.x() * v + translation.y() * u);
-    QMatrix4x4 translationMatrix;
-    translationMatrix.setToIdentity();
-    translationMatrix.translate(objectTrans);
+    frameScheduler.setFixedFrameTime(REPLAY_FRAME_TIME);
+    frameScheduler.setContinuousRendering(true);
+    requestRedraw();
+
+    qDebug() << "Replaying" << inputReplayer->getNumEvents() << "events, session length:"
+             << (double)inputReplayer->getDuration() * 1e-9 << "s";
 
-    cubeModelMatrix = translationMatrix * cubeModelMatrix;
-    semiReflectiveSphereModelMatrix = translationMatrix * semiReflectiveSphereModelMatrix;
-    reflectiveObject2LocationMap[SEMI_REFLECTIVE_SPHERE] = semiReflectiveSphereModelMatrix *
-                                                           QVector3D(
-                                                               0.0f, 0.0f, 0.0f);
+    return true;
 }
 
 //------------------------------------------------------------------------------------------
-void Renderer::rotateObjects()
+bool Renderer::isReplaying() const
 {
-    rotation *= MOVING_INERTIA;
+    return (inputReplayer != NULL);
+}
 
-    if(rotation.lengthSquared() < 1e-4)
+//------------------------------------------------------------------------------------------
+// capture the rendered frames (without the overlay) until stopCapture()
+//------------------------------------------------------------------------------------------
+bool Renderer::startCapture(const QString& _filePrefix, FrameCapture::Format _format)
+{
+    if(!isRendererValid())
     {
-        return;
+        return false;
     }
 
-    QVector3D currentPos(0.0f, 0.0f, 0.0f);
-    currentPos = cubeModelMatrix * currentPos;
+    makeRendererCurrent();
+    bool started = frameCapture.start(_filePrefix, _format);
+    doneRendererCurrent();
 
-    float scale = -0.2f;
-    QQuaternion qRotation = QQuaternion::fromAxisAndAngle(QVector3D(0.0f, 1.0f, 0.0f),
-                                                          rotation.x() * scale) *
-                            QQuaternion::fromAxisAndAngle(QVector3D(1.0f, 0.0f, 0.0f), rotation.y() * scale);
-    //*
-    //                      QQuaternion::fromAxisAndAngle(QVector3D(0, 0, 1), rotation.z()*scale);
+    requestRedraw();
 
-    QMatrix4x4 rotationMatrix;
-    rotationMatrix.setToIdentity();
-    rotationMatrix.rotate(qRotation);
+    return started;
+}
 
-    QMatrix4x4 invTranslationMatrix, translationMatrix;
-    invTranslationMatrix.setToIdentity();
-    invTranslationMatrix.translate(-1.0f * currentPos);
-    translationMatrix.setToIdentity();
-    translationMatrix.translate(currentPos);
+//------------------------------------------------------------------------------------------
+void Renderer::stopCapture()
+{
+    if(!isRendererValid())
+    {
+        return;
+    }
 
-    cubeModelMatrix = translationMatrix * rotationMatrix * invTranslationMatrix *
-                      cubeModelMatrix;
-    semiReflectiveSphereModelMatrix = translationMatrix * rotationMatrix *
-                                      invTranslationMatrix *
-                                      semiReflectiveSphereModelMatrix;
+    makeRendererCurrent();
+    frameCapture.stop();
+    doneRendererCurrent();
+}
 
-    cubeNormalMatrix = QMatrix4x4(cubeModelMatrix.normalMatrix());
-    semiReflectiveSphereNormalMatrix = QMatrix4x4(
-                                           semiReflectiveSphereModelMatrix.normalMatrix());
-    reflectiveObject2LocationMap[SEMI_REFLECTIVE_SPHERE] = semiReflectiveSphereModelMatrix *
-                                                           QVector3D(
-                                                               0.0f, 0.0f, 0.0f);
+//------------------------------------------------------------------------------------------
+bool Renderer::isCapturing() const
+{
+    return frameCapture.isCapturing();
 }
 
+//------------------------------------------------------------------------------------------
+// the current scene, for the reference ray tracer
+//------------------------------------------------------------------------------------------
+void Renderer::getRayTracingScene(RayTracingScene& _scene) const
+{
+    _scene.cameraPosition = cameraPosition;
+    _scene.cameraFocus = cameraFocus;
+    _scene.cameraUpDirection = cameraUpDirection;
+    _scene.light = light;
+
+    _scene.modelMatrices[RT_FLOOR] = transforms.getModelMatrix(TRANSFORM_FLOOR);
+    _scene.modelMatrices[RT_CUBE] = transforms.getModelMatrix(TRANSFORM_CUBE);
+    _scene.modelMatrices[RT_SEMI_REFLECTIVE_SPHERE] =
+        transforms.getModelMatrix(TRANSFORM_SEMI_REFLECTIVE_SPHERE);
+    _scene.modelMatrices[RT_REFLECTIVE_SPHERE] =
+        transforms.getModelMatrix(TRANSFORM_REFLECTIVE_SPHERE);
+
+    _scene.materials[RT_FLOOR] = planeMaterial;
+    _scene.materials[RT_CUBE] = cubeMaterial;
+    _scene.materials[RT_SEMI_REFLECTIVE_SPHERE] = semiReflectiveSphereMaterial;
+    _scene.materials[RT_REFLECTIVE_SPHERE] = reflectiveSphereMaterial;
+    _scene.floorTexCoordScale = (float)planeSize;
+}
 
 //------------------------------------------------------------------------------------------
-void Renderer::createDynamicCubeMapTexture(ReflectiveObjects _object)
+// Use the cube maps baked by the ProbeBaker instead of rendering them every frame.
+// The faces are decoded here and uploaded by the next frame, when the context is current.
+//------------------------------------------------------------------------------------------
+bool Renderer::loadStaticProbes(const QString& _directory)
 {
-    QMatrix4x4  faceViewMatrix;
-    QMatrix4x4  faceProjectionMatrix;
-    QMatrix4x4  faceViewProjectionMatrix;
+    PROFILE_ZONE("Renderer::loadStaticProbes");
 
-    /////////////////////////////////////////////////////////////////
-    // render to buffer
-    static QVector3D upDirs[6] =
-    {
-        QVector3D(0.0f, -1.0f, 0.0f), // posX
-        QVector3D(0.0f, -1.0f, 0.0f), // negX
-        QVector3D(0.0f, 0.0f, 1.0f), // posY
-        QVector3D(0.0f, 0.0f, -1.0f), // negY
-        QVector3D(0.0f, -1.0f, 0.0f), // posZ
-        QVector3D(0.0f, -1.0f, 0.0f), // negZ
-    };
+    QVector<QImage> faces;
 
-    static QVector3D viewDirs[6] =
+    for(int i = 0; i < NUM_REFLECTIVE_OBJECTS; ++i)
     {
-        QVector3D(1.0f, 0.0f, 0.0f), // posX
-        QVector3D(-1.0f, 0.0f, 0.0f), // negX
-        QVector3D(0.0f, 1.0f, 0.0f), // posY
-        QVector3D(0.0f, -1.0f, 0.0f), // negY
-        QVector3D(0.0f, 0.0f, 1.0f), // posZ
-        QVector3D(0.0f, 0.0f, -1.0f), // negZ
-    };
+        for(int face = 0; face < 6; ++face)
+        {
+            QString fileName = ProbeBaker::getFaceFileName(_directory,
+                                                           static_cast<ReflectiveObjects>(i),
+                                                           face);
+            QImage image(fileName);
+
+            if(image.isNull() || image.width() != image.height() ||
+               image.width() != faces.value(i * 6, image).width())
+            {
+                PRINT_ERROR(QString("Invalid probe face %1").arg(fileName));
+                return false;
+            }
+
+            faces.append(image.convertToFormat(QImage::Format_RGBA8888));
+        }
+    }
+
+    staticProbeFaces = faces;
+    useStaticProbes = true;
+    requestRedraw();
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+void Renderer::unloadStaticProbes()
+{
+    staticProbeFaces.clear();
+    useStaticProbes = false;
+    requestRedraw(NUM_REFLECTIVE_OBJECTS + 1);
+}
+
+//------------------------------------------------------------------------------------------
+bool Renderer::isUsingStaticProbes() const
+{
+    return useStaticProbes;
+}
+
+//------------------------------------------------------------------------------------------
+// Replace the compiled-in scene by a scene file (JSON or binary).
+// The file is loaded here, the GL resources are created by the next frame.
+//------------------------------------------------------------------------------------------
+bool Renderer::loadScene(const QString& _fileName)
+{
+    PROFILE_ZONE("Renderer::loadScene");
+
+    SceneDescription* description = new SceneDescription;
+
+    if(!description->load(_fileName))
+    {
+        delete description;
+        return false;
+    }
+
+    delete sceneDescription;
+    sceneDescription = description;
+    sceneChanged = true;
+    requestRedraw();
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+// save the six faces of the environment texture of each reflective object as
+// <prefix>_<object>_<face>.png, read back asynchronously like the frames, from the next
+// frame
+//------------------------------------------------------------------------------------------
+void Renderer::captureProbeFaces(const QString& _filePrefix)
+{
+    pendingProbeCaptureFile = _filePrefix;
+    requestRedraw();
+}
+
+//------------------------------------------------------------------------------------------
+// called at the end of a frame, the cube maps it reflects have all their faces rendered
+// (see getVisibleProbeFaces)
+//------------------------------------------------------------------------------------------
+void Renderer::writeProbeFaces(const QString& _filePrefix)
+{
+    static const char* faceNames[6] = {"posx", "negx", "posy", "negy", "posz", "negz"};
+    static const char* objectNames[NUM_REFLECTIVE_OBJECTS] =
+    {
+        "semi_reflective_sphere",
+        "reflective_sphere"
+    };
+
+    for(int i = 0; i < NUM_REFLECTIVE_OBJECTS; ++i)
+    {
+        for(int face = 0; face < 6; ++face)
+        {
+            frameCapture.captureCubeMapFace(objEnvTexture[i]->textureId(), face,
+                                            objEnvTexture[i]->width(),
+                                            QString("%1_%2_%3.png").arg(_filePrefix)
+                                            .arg(objectNames[i]).arg(faceNames[face]));
+        }
+    }
+
+    // the readbacks are completed by the next frames
+    requestRedraw();
+}
+
+//------------------------------------------------------------------------------------------
+// called at the beginning of a frame, with the context current
+//------------------------------------------------------------------------------------------
+void Renderer::replayInputEvents()
+{
+    PROFILE_ZONE("Renderer::replayInputEvents");
+
+    if(numReplayedFrames == 0)
+    {
+        restoreSessionState(inputReplayer->getInitialState());
+        replayTimer.start();
+    }
+
+    // the events up to the next recorded frame, simulated with its frame time
+    float replayFrameTime = REPLAY_FRAME_TIME;
+    InputEvent event;
+
+    while(inputReplayer->getNextEvent(event))
+    {
+        if(event.type == INPUT_FRAME)
+        {
+            replayFrameTime = event.values[0];
+            break;
+        }
+
+        applyInputEvent(event);
+    }
+
+    frameScheduler.setFixedFrameTime(replayFrameTime);
+    ++numReplayedFrames;
+
+    if(inputReplayer->isFinished() && !isAnimating())
+    {
+        stopReplay();
+    }
+}
+
+//------------------------------------------------------------------------------------------
+void Renderer::stopReplay()
+{
+    qDebug() << "Replay finished:" << numReplayedFrames << "frames in"
+             << replayTimer.elapsed() << "ms";
+
+    delete inputReplayer;
+    inputReplayer = NULL;
+
+    frameScheduler.setFixedFrameTime(0.0f);
+    frameScheduler.setContinuousRendering(false);
+
+    if(quitAfterReplay)
+    {
+        QTimer::singleShot(0, qApp, &QCoreApplication::quit);
+    }
+}
+
+//------------------------------------------------------------------------------------------
+void Renderer::translateCamera()
+{
+    PROFILE_ZONE("Renderer::translateCamera");
+
+    translation *= FrameScheduler::damping(MOVING_INERTIA, frameTime);
+
+    if(translation.lengthSquared() < MOVING_THRESHOLD)
+    {
+        return;
+    }
+
+    QVector3D frameTranslation = translation * FrameScheduler::timeScale(frameTime);
+
+    QVector3D eyeVector = cameraFocus - cameraPosition;
+    float scale = sqrt(eyeVector.length()) * 0.01f;
+
+    QVector3D u(0.0f, 1.0f, 0.0f);
+    QVector3D v = QVector3D::crossProduct(eyeVector, u);
+    u = QVector3D::crossProduct(v, eyeVector);
+    u.normalize();
+    v.normalize();
+
+    cameraPosition -= scale * (frameTranslation.x() * v + frameTranslation.y() * u);
+    cameraFocus -= scale * (frameTranslation.x() * v + frameTranslation.y() * u);
+
+}
+
+//------------------------------------------------------------------------------------------
+void Renderer::rotateCamera()
+{
+    PROFILE_ZONE("Renderer::rotateCamera");
+
+    rotation *= FrameScheduler::damping(MOVING_INERTIA, frameTime);
+
+    if(rotation.lengthSquared() < MOVING_THRESHOLD)
+    {
+        return;
+    }
+
+    QVector3D frameRotation = rotation * FrameScheduler::timeScale(frameTime);
+
+    QVector3D nEyeVector = cameraPosition - cameraFocus ;
+
+    float scale = sqrt(nEyeVector.length()) * 0.02f;
+    QQuaternion qRotation = QQuaternion::fromAxisAndAngle(QVector3D(1, 0, 0),
+                                                          frameRotation.y() * scale) *
+                            QQuaternion::fromAxisAndAngle(QVector3D(0, 1, 0), frameRotation.x() * scale) *
+                            QQuaternion::fromAxisAndAngle(QVector3D(0, 0, 1), frameRotation.z() * scale);
+    nEyeVector = qRotation.rotatedVector(nEyeVector);
+
+    cameraPosition = cameraFocus + nEyeVector;
+
+    if(enabledZAxisRotation)
+    {
+        cameraUpDirection = qRotation.rotatedVector(cameraUpDirection);
+    }
+}
+
+//------------------------------------------------------------------------------------------
+void Renderer::zoomCamera()
+{
+    PROFILE_ZONE("Renderer::zoomCamera");
+
+    zooming *= FrameScheduler::damping(MOVING_INERTIA, frameTime);
+
+    if(fabs(zooming) < MOVING_THRESHOLD)
+    {
+        return;
+    }
+
+    float frameZooming = zooming * FrameScheduler::timeScale(frameTime);
+
+    QVector3D nEyeVector = cameraPosition - cameraFocus ;
+    float len = nEyeVector.length();
+    nEyeVector.normalize();
+
+    len += sqrt(len) * frameZooming * 0.3f;
+
+    if(len < 0.5f)
+    {
+        len = 0.5f;
+    }
+
+    cameraPosition = len * nEyeVector + cameraFocus;
+
+}
+
+//------------------------------------------------------------------------------------------
+void Renderer::translateObjects()
+{
+    PROFILE_ZONE("Renderer::translateObjects");
+
+    translation *= FrameScheduler::damping(MOVING_INERTIA, frameTime);
+
+    if(translation.lengthSquared() < MOVING_THRESHOLD)
+    {
+        return;
+    }
+
+    QVector3D frameTranslation = translation * FrameScheduler::timeScale(frameTime);
+
+    QVector3D eyeVector = cameraFocus - cameraPosition;
+    float scale = sqrt(eyeVector.length()) * 0.05f;
+
+    QVector3D u(0.0f, 1.0f, 0.0f);
+    QVector3D v = QVector3D::crossProduct(eyeVector, u);
+    u = QVector3D::crossProduct(v, eyeVector);
+    u.normalize();
+    v.normalize();
+
+    QVector3D objectTrans = scale * (frameTranslation.x() * v + frameTranslation.y() * u);
+    QMatrix4x4 translationMatrix;
+    translationMatrix.setToIdentity();
+    translationMatrix.translate(objectTrans);
+
+    transforms.applyTransformation(TRANSFORM_CUBE, translationMatrix);
+    transforms.applyTransformation(TRANSFORM_SEMI_REFLECTIVE_SPHERE, translationMatrix);
+}
+
+//------------------------------------------------------------------------------------------
+void Renderer::rotateObjects()
+{
+    PROFILE_ZONE("Renderer::rotateObjects");
+
+    rotation *= FrameScheduler::damping(MOVING_INERTIA, frameTime);
+
+    if(rotation.lengthSquared() < MOVING_THRESHOLD)
+    {
+        return;
+    }
+
+    QVector3D frameRotation = rotation * FrameScheduler::timeScale(frameTime);
+
+    QVector3D currentPos(0.0f, 0.0f, 0.0f);
+    currentPos = transforms.getLocalMatrix(TRANSFORM_CUBE) * currentPos;
+
+    float scale = -0.2f;
+    QQuaternion qRotation = QQuaternion::fromAxisAndAngle(QVector3D(0.0f, 1.0f, 0.0f),
+                                                          frameRotation.x() * scale) *
+                            QQuaternion::fromAxisAndAngle(QVector3D(1.0f, 0.0f, 0.0f), frameRotation.y() * scale);
+    //*
+    //                      QQuaternion::fromAxisAndAngle(QVector3D(0, 0, 1), rotation.z()*scale);
+
+    QMatrix4x4 rotationMatrix;
+    rotationMatrix.setToIdentity();
+    rotationMatrix.rotate(qRotation);
+
+    QMatrix4x4 invTranslationMatrix, translationMatrix;
+    invTranslationMatrix.setToIdentity();
+    invTranslationMatrix.translate(-1.0f * currentPos);
+    translationMatrix.setToIdentity();
+    translationMatrix.translate(currentPos);
+
+    QMatrix4x4 transformation = translationMatrix * rotationMatrix * invTranslationMatrix;
+    transforms.applyTransformation(TRANSFORM_CUBE, transformation);
+    transforms.applyTransformation(TRANSFORM_SEMI_REFLECTIVE_SPHERE, transformation);
+}
+
+
+//------------------------------------------------------------------------------------------
+// upload the view-projection matrix of a face of the probe of the object, the only data
+// changed between the replays of the render list
+//------------------------------------------------------------------------------------------
+QMatrix4x4 Renderer::setProbeFaceCamera(ReflectiveObjects _object, int _face)
+{
+    static QVector3D upDirs[6] =
+    {
+        QVector3D(0.0f, -1.0f, 0.0f), // posX
+        QVector3D(0.0f, -1.0f, 0.0f), // negX
+        QVector3D(0.0f, 0.0f, 1.0f), // posY
+        QVector3D(0.0f, 0.0f, -1.0f), // negY
+        QVector3D(0.0f, -1.0f, 0.0f), // posZ
+        QVector3D(0.0f, -1.0f, 0.0f), // negZ
+    };
+
+    static QVector3D viewDirs[6] =
+    {
+        QVector3D(1.0f, 0.0f, 0.0f), // posX
+        QVector3D(-1.0f, 0.0f, 0.0f), // negX
+        QVector3D(0.0f, 1.0f, 0.0f), // posY
+        QVector3D(0.0f, -1.0f, 0.0f), // negY
+        QVector3D(0.0f, 0.0f, 1.0f), // posZ
+        QVector3D(0.0f, 0.0f, -1.0f), // negZ
+    };
+
+    int probeNode = TRANSFORM_SEMI_REFLECTIVE_SPHERE_PROBE + _object;
+    QVector3D localCamera = transforms.getWorldPosition(probeNode);
+
+    QMatrix4x4  faceViewMatrix;
+    QMatrix4x4  faceProjectionMatrix;
+    faceViewMatrix.lookAt(localCamera, localCamera + viewDirs[_face], upDirs[_face]);
+    faceProjectionMatrix.perspective(90, 1.0f, 0.1f, 10000.0f);
+    QMatrix4x4 faceViewProjectionMatrix = faceProjectionMatrix * faceViewMatrix;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, UBOCamera);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, SIZE_OF_MAT4,
+                    faceViewProjectionMatrix.constData());
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    return faceViewProjectionMatrix;
+}
+
+//------------------------------------------------------------------------------------------
+// only built when the profiler is enabled: the names are shown by its overlay alone
+//------------------------------------------------------------------------------------------
+QString Renderer::getProbeFaceName(ReflectiveObjects _object, int _face) const
+{
+    static const char* faceNames[6] = {"+X", "-X", "+Y", "-Y", "+Z", "-Z"};
+    static const char* objectNames[NUM_REFLECTIVE_OBJECTS] =
+    {
+        "semi-reflective sphere",
+        "reflective sphere"
+    };
+
+    return QString("probe %1 %2").arg(objectNames[_object]).arg(faceNames[_face]);
+}
+
+//------------------------------------------------------------------------------------------
+// render the floor and the background around the probe of the object into the color and
+// depth cube maps of its static layer
+//------------------------------------------------------------------------------------------
+void Renderer::createProbeStaticLayer(ReflectiveObjects _object, int _color, int _depth,
+                                      int _framebuffer)
+{
+    PROFILE_ZONE("Renderer::createProbeStaticLayer");
+
+    ProbeStaticLayer& layer = probeStaticLayers[_object];
+    layer.color = frameGraph.getTexture(_color);
+    layer.depth = frameGraph.getTexture(_depth);
+    layer.position = transforms.getWorldPosition(TRANSFORM_SEMI_REFLECTIVE_SPHERE_PROBE +
+                                                 _object);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, frameGraph.getBufferId(_framebuffer));
+    glViewport(0, 0, cubeMapSize, cubeMapSize);
+
+    for(int face = 0; face < 6; ++face)
+    {
+        QString passName;
+
+        if(gpuProfiler.isEnabled())
+        {
+            passName = getProbeFaceName(_object, face) + " static";
+        }
+
+        gpuProfiler.beginPass(passName);
+
+        QMatrix4x4 faceViewProjectionMatrix = setProbeFaceCamera(_object, face);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                               GL_TEXTURE_CUBE_MAP_POSITIVE_X + face,
+                               layer.color->textureId(), 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                               GL_TEXTURE_CUBE_MAP_POSITIVE_X + face,
+                               layer.depth->textureId(), 0);
+        cullScene(faceViewProjectionMatrix, passName);
+        renderScene(_object, RENDER_LAYER_STATIC);
+        gpuProfiler.endPass();
+    }
+
+    bindTargetFramebuffer();
+}
+
+//------------------------------------------------------------------------------------------
+// Render the six faces of the probe of the object into the cube map, with the depth
+// buffer and the framebuffer of the frame graph. Each face starts as a copy of the static
+// layer of the probe, color and depth, read through the static framebuffer: only the
+// moving objects are drawn, depth tested against the floor. The faces which are not in
+// _faces (see getVisibleProbeFaces) keep the static layer alone.
+//------------------------------------------------------------------------------------------
+void Renderer::createDynamicCubeMapTexture(ReflectiveObjects _object, int _cubeMap,
+                                           int _depthBuffer, int _framebuffer,
+                                           int _staticFramebuffer, int _faces)
+{
+    PROFILE_ZONE("Renderer::createDynamicCubeMapTexture");
+
+    const ProbeStaticLayer& layer = probeStaticLayers[_object];
+
+    glBindFramebuffer(GL_FRAMEBUFFER, frameGraph.getBufferId(_framebuffer));
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER,
+                              frameGraph.getBufferId(_depthBuffer));
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, frameGraph.getBufferId(_staticFramebuffer));
+    glViewport(0, 0, cubeMapSize, cubeMapSize);
+
+    for(int face = 0; face < 6; ++face)
+    {
+        QString passName;
+
+        if(gpuProfiler.isEnabled())
+        {
+            passName = getProbeFaceName(_object, face);
+        }
+
+        gpuProfiler.beginPass(passName);
+
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                               GL_TEXTURE_CUBE_MAP_POSITIVE_X + face,
+                               frameGraph.getBufferId(_cubeMap), 0);
+
+        // the same format on both sides, the depth can only be copied with GL_NEAREST
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                               GL_TEXTURE_CUBE_MAP_POSITIVE_X + face,
+                               layer.color->textureId(), 0);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                               GL_TEXTURE_CUBE_MAP_POSITIVE_X + face,
+                               layer.depth->textureId(), 0);
+        glBlitFramebuffer(0, 0, cubeMapSize, cubeMapSize, 0, 0, cubeMapSize, cubeMapSize,
+                          GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        ++numProbeFaces;
+
+        if(_faces & (1 << face))
+        {
+            QMatrix4x4 faceViewProjectionMatrix = setProbeFaceCamera(_object, face);
+            cullScene(faceViewProjectionMatrix, passName);
+            renderScene(_object, RENDER_LAYER_DYNAMIC);
+        }
+        else
+        {
+            // not reflected toward the camera
+            ++numSkippedProbeFaces;
+        }
+
+        gpuProfiler.endPass();
+    }
+
+    bindTargetFramebuffer();
+}
+
+//------------------------------------------------------------------------------------------
+// The faces of the cube map of the probe which the object reflects toward the camera.
+// The normals of the visible cap of the sphere (facing the camera, up to its silhouette)
+// are sampled on rings around the axis toward the camera. The samples outside of the view
+// frustum are ignored, the others mark the face of their reflection direction and the
+// faces within PROBE_FACE_MARGIN of it.
+// All the faces are needed when the cube map is seen from elsewhere: by the scene
+// instances which reflect it, by the next frames when the updates are throttled or
+// frozen, and by a capture of the probe faces.
+//------------------------------------------------------------------------------------------
+int Renderer::getVisibleProbeFaces(ReflectiveObjects _object)
+{
+    if(!enabledProbeFaceSkipping || probeUpdateInterval > 1 || frozenProbes ||
+       !pendingProbeCaptureFile.isEmpty() ||
+       numProbeInstances[_object] > 0)
+    {
+        return ALL_CUBE_MAP_FACES;
+    }
+
+    const BoundingBox& bounds =
+        sceneBVH.getObjectBounds(SCENE_SEMI_REFLECTIVE_SPHERE + _object);
+    QVector3D center = 0.5f * (bounds.boxMin + bounds.boxMax);
+    QVector3D extent = bounds.boxMax - bounds.boxMin;
+    float radius = 0.5f * qMax(qMax(extent.x(), extent.y()), extent.z());
+    QVector3D toCamera = cameraPosition - center;
+    float distance = toCamera.length();
+
+    if(distance <= radius)
+    {
+        return ALL_CUBE_MAP_FACES;
+    }
+
+    // the basis of the cap, and the angle of its silhouette from its axis
+    QVector3D axis = toCamera / distance;
+    QVector3D side = (qAbs(axis.x()) < 0.9f) ? QVector3D(1.0f, 0.0f, 0.0f) :
+                     QVector3D(0.0f, 1.0f, 0.0f);
+    QVector3D u = QVector3D::crossProduct(axis, side).normalized();
+    QVector3D v = QVector3D::crossProduct(axis, u);
+    float capAngle = qAcos(radius / distance);
+
+    Frustum frustum(viewProjectionMatrix);
+    int faces = 0;
+
+    for(int ring = 0; ring <= PROBE_FACE_SAMPLES && faces != ALL_CUBE_MAP_FACES; ++ring)
+    {
+        float theta = capAngle * (float)ring / (float)PROBE_FACE_SAMPLES;
+        int numSamples = (ring == 0) ? 1 : 4 * PROBE_FACE_SAMPLES;
+
+        for(int i = 0; i < numSamples; ++i)
+        {
+            float phi = 2.0f * (float)M_PI * (float)i / (float)numSamples;
+            QVector3D normal = qCos(theta) * axis +
+                               qSin(theta) * (qCos(phi) * u + qSin(phi) * v);
+            QVector3D point = center + radius * normal;
+            bool inside = true;
+
+            for(int plane = 0; plane < 6 && inside; ++plane)
+            {
+                const QVector4D& frustumPlane = frustum.planes[plane];
+                inside = (QVector3D::dotProduct(frustumPlane.toVector3D(), point) +
+                          frustumPlane.w() >= 0.0f);
+            }
+
+            if(!inside)
+            {
+                continue;
+            }
+
+            QVector3D incident = (point - cameraPosition).normalized();
+            QVector3D reflection = incident -
+                                   2.0f * QVector3D::dotProduct(incident, normal) * normal;
+
+            // the faces in the order of GL_TEXTURE_CUBE_MAP_POSITIVE_X + face
+            float components[3] = {reflection.x(), reflection.y(), reflection.z()};
+            float largest = qMax(qMax(qAbs(components[0]), qAbs(components[1])),
+                                 qAbs(components[2]));
+
+            for(int k = 0; k < 3; ++k)
+            {
+                if(qAbs(components[k]) + PROBE_FACE_MARGIN >= largest)
+                {
+                    faces |= 1 << (2 * k + ((components[k] < 0.0f) ? 1 : 0));
+                }
+            }
+        }
+    }
+
+    return faces;
+}
+
+//------------------------------------------------------------------------------------------
+// Set the cube maps reflected by the objects while the probes are rendered: the static
+// probes, the environment or the cube maps of the latest update. Returns true if the
+// probes are updated by this frame.
+//------------------------------------------------------------------------------------------
+bool Renderer::beginProbeUpdate()
+{
+    if(useStaticProbes)
+    {
+        if(!staticProbeFaces.isEmpty())
+        {
+            uploadStaticProbes();
+        }
+
+        for(int i = 0; i < NUM_REFLECTIVE_OBJECTS; ++i)
+        {
+            objEnvTexture[i] = staticProbeTextures[i];
+        }
+
+        return false;
+    }
+
+    for(int i = 0; i < NUM_REFLECTIVE_OBJECTS; ++i)
+    {
+        objEnvTexture[i] = (enabledDynamicEnvMapping && !useGlobalEnvTexture &&
+                            objEnvTextureHistory[i] != NULL) ?
+                           objEnvTextureHistory[i] : currentEnvTexture;
+    }
+
+    // reuse the latest cube maps as they are
+    bool skipProbeUpdate = (++numFramesSinceProbeUpdate < probeUpdateInterval) &&
+                           !useGlobalEnvTexture;
+
+    if(frozenProbes || skipProbeUpdate)
+    {
+        return false;
+    }
+
+    numFramesSinceProbeUpdate = 0;
+
+    return enabledDynamicEnvMapping;
+}
+
+//------------------------------------------------------------------------------------------
+// The passes of the frame: the probe updates write the cube maps read by the main view,
+// which writes the target framebuffer (and the capture reads it). Nobody sees the
+// reflections of an object hidden in the last frame, the main view does not read its cube
+// map and its probe pass is culled.
+// The probe passes use the cube map, the depth buffer and the framebuffer of the graph,
+// the depth buffer and the framebuffer are shared by the two probes.
+// A probe which moved, or whose floor or background changed, renders its static layer
+// first: the cube maps of the layer are exported and kept until it is rendered again.
+//------------------------------------------------------------------------------------------
+void Renderer::buildFrameGraph()
+{
+    PROFILE_ZONE("Renderer::buildFrameGraph");
+
+    static const int objectIds[NUM_REFLECTIVE_OBJECTS] =
+    {
+        SCENE_SEMI_REFLECTIVE_SPHERE, SCENE_REFLECTIVE_SPHERE
+    };
+
+    frameGraph.reset();
+
+    int frame = frameGraph.importResource("frame");
+    frameGraph.markOutput(frame);
+
+    bool updateProbes = beginProbeUpdate();
+
+    if(probeStaticLayersChanged)
+    {
+        releaseProbeStaticLayers();
+        probeStaticLayersChanged = false;
+    }
+
+    for(int i = 0; i < NUM_REFLECTIVE_OBJECTS; ++i)
+    {
+        probeCubeMaps[i] = -1;
+
+        if(!updateProbes)
+        {
+            continue;
+        }
+
+        ReflectiveObjects object = static_cast<ReflectiveObjects>(i);
+        ProbeStaticLayer& layer = probeStaticLayers[i];
+        QVector3D position =
+            transforms.getWorldPosition(TRANSFORM_SEMI_REFLECTIVE_SPHERE_PROBE + i);
+        int staticColor = -1;
+        int staticDepth = -1;
+
+        if(layer.color == NULL || layer.position != position)
+        {
+            frameGraph.releaseTexture(layer.color);
+            frameGraph.releaseTexture(layer.depth);
+            layer.color = NULL;
+            layer.depth = NULL;
+
+            staticColor = frameGraph.createResource(QString("probe %1 static color").arg(i),
+                                                    FRAME_RESOURCE_CUBE_MAP, cubeMapSize);
+            staticDepth = frameGraph.createResource(QString("probe %1 static depth").arg(i),
+                                                    FRAME_RESOURCE_DEPTH_CUBE_MAP,
+                                                    cubeMapSize);
+            int staticTarget =
+                frameGraph.createResource(QString("probe %1 static target").arg(i),
+                                          FRAME_RESOURCE_FRAMEBUFFER, cubeMapSize);
+
+            int staticPass = frameGraph.addPass(QString("probe %1 static layer").arg(i),
+                                                [=]()
+            {
+                createProbeStaticLayer(object, staticColor, staticDepth, staticTarget);
+            });
+            frameGraph.write(staticPass, staticColor);
+            frameGraph.write(staticPass, staticDepth);
+            frameGraph.write(staticPass, staticTarget);
+            frameGraph.exportResource(staticColor);
+            frameGraph.exportResource(staticDepth);
+        }
+
+        int cubeMap = frameGraph.createResource(QString("probe %1 cube map").arg(i),
+                                                FRAME_RESOURCE_CUBE_MAP, cubeMapSize);
+        int depthBuffer = frameGraph.createResource(QString("probe %1 depth").arg(i),
+                                                    FRAME_RESOURCE_DEPTH_BUFFER,
+                                                    cubeMapSize);
+        int framebuffer = frameGraph.createResource(QString("probe %1 framebuffer").arg(i),
+                                                    FRAME_RESOURCE_FRAMEBUFFER,
+                                                    cubeMapSize);
+
+        int staticFramebuffer =
+            frameGraph.createResource(QString("probe %1 static framebuffer").arg(i),
+                                      FRAME_RESOURCE_FRAMEBUFFER, cubeMapSize);
+
+        int faces = getVisibleProbeFaces(object);
+        int pass = frameGraph.addPass(QString("probe %1").arg(i), [=]()
+        {
+            createDynamicCubeMapTexture(object, cubeMap, depthBuffer, framebuffer,
+                                        staticFramebuffer, faces);
+        });
+        frameGraph.write(pass, cubeMap);
+        frameGraph.write(pass, depthBuffer);
+        frameGraph.write(pass, framebuffer);
+        frameGraph.write(pass, staticFramebuffer);
+
+        if(staticColor >= 0)
+        {
+            frameGraph.read(pass, staticColor);
+            frameGraph.read(pass, staticDepth);
+        }
+
+        // reflected by the next frames until the next update
+        frameGraph.exportResource(cubeMap);
+        probeCubeMaps[i] = cubeMap;
+    }
+
+    int mainPass = frameGraph.addPass("main view", [=]()
+    {
+        renderMainView();
+    });
+    frameGraph.write(mainPass, frame);
+
+    for(int i = 0; i < NUM_REFLECTIVE_OBJECTS; ++i)
+    {
+        if(probeCubeMaps[i] >= 0 && !occlusionCuller.isOccluded(objectIds[i]))
+        {
+            frameGraph.read(mainPass, probeCubeMaps[i]);
+        }
+    }
+
+    if(frameCapture.isCapturing())
+    {
+        int capture = frameGraph.importResource("capture");
+        frameGraph.markOutput(capture);
+
+        int capturePass = frameGraph.addPass("capture", [=]()
+        {
+            gpuProfiler.beginPass("capture");
+            frameCapture.captureFramebuffer(getTargetFramebuffer(), getViewportWidth(),
+                                            getViewportHeight());
+            gpuProfiler.endPass();
+        });
+        frameGraph.read(capturePass, frame);
+        frameGraph.write(capturePass, capture);
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// move the objects or the camera by the input of the frame (the replayed input and the
+// scene file included)
+//------------------------------------------------------------------------------------------
+void Renderer::moveSceneAndCamera()
+{
+    QVector3D previousCameraPosition = cameraPosition;
+
+    if(enabledObjectTransformation)
+    {
+        translateObjects();
+        rotateObjects();
+    }
+    else
+    {
+        translateCamera();
+        rotateCamera();
+    }
+
+    updateTransforms();
+    updateCamera();
+
+    // the draws of the render list are sorted front to back from the camera
+    if(cameraPosition != previousCameraPosition)
+    {
+        renderListChanged = true;
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// render the scene with the cube maps updated by this frame
+//------------------------------------------------------------------------------------------
+void Renderer::renderMainView()
+{
+    PROFILE_ZONE("Renderer::renderMainView");
+
+    for(int i = 0; i < NUM_REFLECTIVE_OBJECTS; ++i)
+    {
+        if(probeCubeMaps[i] >= 0 && frameGraph.isAllocated(probeCubeMaps[i]))
+        {
+            objEnvTexture[i] = frameGraph.getTexture(probeCubeMaps[i]);
+        }
+    }
+
+    uploadCamera();
+
+    // render scene
+    glViewport(0, 0, getViewportWidth(), getViewportHeight());
+    cullScene(viewProjectionMatrix, "main camera");
+    cullingStatistics.last().numOccluded = occlusionCuller.getNumOccluded();
+    renderScene();
+}
+
+//------------------------------------------------------------------------------------------
+// the cube maps rendered by this frame replace the previous ones, which go back to the
+// frame graph
+//------------------------------------------------------------------------------------------
+void Renderer::keepProbeUpdates()
+{
+    for(int i = 0; i < NUM_REFLECTIVE_OBJECTS; ++i)
+    {
+        if(probeCubeMaps[i] >= 0 && frameGraph.isAllocated(probeCubeMaps[i]))
+        {
+            frameGraph.releaseTexture(objEnvTextureHistory[i]);
+            objEnvTextureHistory[i] = frameGraph.getTexture(probeCubeMaps[i]);
+            useGlobalEnvTexture = false;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// the objects reflect the environment until their next update
+//------------------------------------------------------------------------------------------
+void Renderer::releaseProbeHistory()
+{
+    for(int i = 0; i < NUM_REFLECTIVE_OBJECTS; ++i)
+    {
+        frameGraph.releaseTexture(objEnvTextureHistory[i]);
+        objEnvTextureHistory[i] = NULL;
+    }
+
+    useGlobalEnvTexture = true;
+    releaseProbeStaticLayers();
+}
+
+//------------------------------------------------------------------------------------------
+// the probes render their static layer again with their next update
+//------------------------------------------------------------------------------------------
+void Renderer::releaseProbeStaticLayers()
+{
+    for(int i = 0; i < NUM_REFLECTIVE_OBJECTS; ++i)
+    {
+        frameGraph.releaseTexture(probeStaticLayers[i].color);
+        frameGraph.releaseTexture(probeStaticLayers[i].depth);
+        probeStaticLayers[i].color = NULL;
+        probeStaticLayers[i].depth = NULL;
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// the faces are stored as the sky cube map faces: uploaded as they are, not mirrored
+//------------------------------------------------------------------------------------------
+void Renderer::uploadStaticProbes()
+{
+    PROFILE_ZONE("Renderer::uploadStaticProbes");
+
+    for(int i = 0; i < NUM_REFLECTIVE_OBJECTS; ++i)
+    {
+        delete staticProbeTextures[i];
+
+        int faceSize = staticProbeFaces[i * 6].width();
+        staticProbeTextures[i] = new QOpenGLTexture(QOpenGLTexture::TargetCubeMap);
+        staticProbeTextures[i]->create();
+        staticProbeTextures[i]->setSize(faceSize, faceSize);
+        staticProbeTextures[i]->setFormat(QOpenGLTexture::RGBA8_UNorm);
+        staticProbeTextures[i]->allocateStorage();
+
+        for(int face = 0; face < 6; ++face)
+        {
+            QOpenGLTexture::CubeMapFace cubeMapFace =
+                static_cast<QOpenGLTexture::CubeMapFace>(QOpenGLTexture::CubeMapPositiveX +
+                                                         face);
+            staticProbeTextures[i]->setData(0, 0, cubeMapFace, QOpenGLTexture::RGBA,
+                                            QOpenGLTexture::UInt8,
+                                            staticProbeFaces[i * 6 + face].constBits());
+        }
+
+        staticProbeTextures[i]->setWrapMode(QOpenGLTexture::DirectionS,
+                                            QOpenGLTexture::ClampToEdge);
+        staticProbeTextures[i]->setWrapMode(QOpenGLTexture::DirectionT,
+                                            QOpenGLTexture::ClampToEdge);
+        staticProbeTextures[i]->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
+        staticProbeTextures[i]->setMagnificationFilter(QOpenGLTexture::Linear);
+        staticProbeTextures[i]->generateMipMaps();
+    }
+
+    staticProbeFaces.clear();
+}
+
+//------------------------------------------------------------------------------------------
+// The instances named as the built-in objects set their transformation, material and
+// texture; the other ones are drawn by the render list.
+//------------------------------------------------------------------------------------------
+void Renderer::applySceneDescription()
+{
+    PROFILE_ZONE("Renderer::applySceneDescription");
+
+    sceneChanged = false;
+    probeStaticLayersChanged = true;
+    renderListChanged = true;
+    const SceneDescription& scene = *sceneDescription;
+
+    /////////////////////////////////////////////////////////////////
+    // textures, shared by the scenes loaded one after the other
+    sceneTextures.clear();
+
+    for(int i = 0; i < scene.getNumTextures(); ++i)
+    {
+        QString fileName = scene.getTextureFile(i);
+
+        if(!sceneTextureCache.contains(fileName))
+        {
+            QImage image(fileName);
+            QOpenGLTexture* texture = NULL;
+
+            if(image.isNull())
+            {
+                PRINT_ERROR(QString("Cannot load texture from file %1").arg(fileName));
+            }
+            else
+            {
+                texture = new QOpenGLTexture(
+                    image.mirrored().convertToFormat(QImage::Format_RGBA8888));
+                texture->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
+                texture->setMagnificationFilter(QOpenGLTexture::Linear);
+                texture->setWrapMode(QOpenGLTexture::Repeat);
+            }
+
+            sceneTextureCache[fileName] = texture;
+        }
+
+        sceneTextures.append(sceneTextureCache[fileName]);
+    }
+
+    QString environment = scene.getEnvironment();
+    delete sceneEnvTexture;
+    sceneEnvTexture = NULL;
+
+    if(!environment.isEmpty() && environment != DEFAULT_SCENE_ENVIRONMENT)
+    {
+        sceneEnvTexture = loadCubeMapTexture(environment);
+    }
+
+    currentEnvTexture = (sceneEnvTexture != NULL) ? sceneEnvTexture :
+                        cubeMapEnvTexture[SKY];
+    useGlobalEnvTexture = true;
+
+    /////////////////////////////////////////////////////////////////
+    // light
+    if(scene.getNumLights() > 0)
+    {
+        light = scene.getLights()[0];
+        glBindBuffer(GL_UNIFORM_BUFFER, UBOLight);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, light.getStructSize(), &light);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        if(scene.getNumLights() > 1)
+        {
+            qDebug() << "Renderer: only the first light of the scene is used.";
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////
+    // built-in objects
+    Material* builtinMaterials[NUM_SCENE_BUILTIN_OBJECTS] =
+    {
+        &planeMaterial, &cubeMaterial, &semiReflectiveSphereMaterial,
+        &reflectiveSphereMaterial
+    };
+    QMatrix4x4* builtinModelMatrices[NUM_SCENE_BUILTIN_OBJECTS] =
+    {
+        NULL, &cubeInitialModelMatrix, &semiReflectiveSphereInitialModelMatrix,
+        &reflectiveSphereInitialModelMatrix
+    };
+    int builtinInstances[NUM_SCENE_BUILTIN_OBJECTS] = {-1, -1, -1, -1};
+
+    const SceneInstance* instances = scene.getInstances();
+    sceneInstances.clear();
+
+    // the built-in textures are kept for the next scenes, the scene ones only override them
+    for(int i = 0; i < NUM_SCENE_BUILTIN_OBJECTS; ++i)
+    {
+        builtinSceneTextures[i] = NULL;
+    }
+
+    for(int i = 0; i < scene.getNumInstances(); ++i)
+    {
+        const SceneInstance& instance = instances[i];
+        int object = SceneDescription::findBuiltinObject(scene.getString(instance.name));
+
+        if(object < 0 || builtinInstances[object] >= 0)
+        {
+            sceneInstances.append(i);
+            continue;
+        }
+
+        builtinInstances[object] = i;
+        *builtinMaterials[object] = scene.getMaterials()[instance.material];
+
+        if(object != SCENE_REFLECTIVE_SPHERE && instance.texture != SCENE_NO_INDEX)
+        {
+            builtinSceneTextures[object] = sceneTextures[instance.texture];
+        }
+
+        QMatrix4x4 modelMatrix = SceneDescription::getMatrix(instance.modelMatrix);
+
+        if(object == SCENE_FLOOR)
+        {
+            // the floor stays centered, its scale sets the plane size
+            initialPlaneSize = qMax(1, qRound(modelMatrix.column(0).toVector3D().length() *
+                                              0.5f));
+        }
+        else
+        {
+            *builtinModelMatrices[object] = modelMatrix;
+        }
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    // all the spheres share the same mesh
+    for(int i = 0; i < scene.getNumMeshes(); ++i)
+    {
+        const SceneMesh& mesh = scene.getMeshes()[i];
+
+        if(mesh.type == SCENE_MESH_SPHERE)
+        {
+            if((int)mesh.numStacks != sphereNumStacks ||
+               (int)mesh.numSlices != sphereNumSlices)
+            {
+                changeSphereResolution(mesh.numStacks, mesh.numSlices);
+            }
+
+            break;
+        }
+    }
+
+    loadSceneMeshes();
+
+    /////////////////////////////////////////////////////////////////
+    // probes, kept at the same place on their object when it moves
+    for(int i = 0; i < NUM_REFLECTIVE_OBJECTS; ++i)
+    {
+        probeOffsets[i] = QVector3D(0.0f, 0.0f, 0.0f);
+    }
+
+    for(int i = 0; i < scene.getNumProbes(); ++i)
+    {
+        const SceneProbe& probe = scene.getProbes()[i];
+        QVector3D position(probe.position[0], probe.position[1], probe.position[2]);
+
+        if((int)probe.instance == builtinInstances[SCENE_SEMI_REFLECTIVE_SPHERE])
+        {
+            probeOffsets[SEMI_REFLECTIVE_SPHERE] =
+                semiReflectiveSphereInitialModelMatrix.inverted() * position;
+        }
+        else if((int)probe.instance == builtinInstances[SCENE_REFLECTIVE_SPHERE])
+        {
+            probeOffsets[TOTAL_REFLECTIVE_SPHERE] =
+                reflectiveSphereInitialModelMatrix.inverted() * position;
+        }
+        else
+        {
+            qDebug() << "Renderer: only the reflective spheres have a dynamic cube map,"
+                     << "probe" << i << "is ignored.";
+        }
+    }
+
+    initSceneMatrices();
+
+    uploadMaterials();
+
+    /////////////////////////////////////////////////////////////////
+    // instances, uploaded as they are from the scene (the mapped file of a binary scene)
+    if(sceneInstanceBuffer == 0)
+    {
+        glGenBuffers(1, &sceneInstanceBuffer);
+    }
+
+    glBindBuffer(GL_COPY_READ_BUFFER, sceneInstanceBuffer);
+    glBufferData(GL_COPY_READ_BUFFER, (GLsizeiptr)scene.getNumInstances() *
+                 sizeof(SceneInstance), instances, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    // the instanced draws read the same records through two buffer textures: the matrices
+    // as floats, the indices as integers (their bits would be denormal floats)
+    if(sceneInstanceTexture == 0)
+    {
+        glGenTextures(1, &sceneInstanceTexture);
+        glGenTextures(1, &sceneInstanceIndexTexture);
+        glGenBuffers(1, &visibleInstanceBuffer);
+    }
+
+    glBindTexture(GL_TEXTURE_BUFFER, sceneInstanceTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, sceneInstanceBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, sceneInstanceIndexTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32UI, sceneInstanceBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    assignInstanceProbes();
+    buildInstanceBatches();
+
+    qDebug() << "Renderer:" << sceneInstances.size()
+             << "scene instances added to the built-in objects";
+}
+
+//------------------------------------------------------------------------------------------
+// import the OBJ/PLY meshes of the scene into the geometry buffer, after the built-in
+// meshes
+//------------------------------------------------------------------------------------------
+void Renderer::loadSceneMeshes()
+{
+    PROFILE_ZONE("Renderer::loadSceneMeshes");
+
+    qDeleteAll(sceneMeshes);
+    sceneMeshes.fill(NULL, sceneDescription->getNumMeshes());
+
+    MeshImporter importer;
+    int numGeometryMeshes = NUM_GEOMETRY_BUILTIN_MESHES;
+
+    // the meshes of the previous scene are dropped
+    geometry.resize(NUM_GEOMETRY_BUILTIN_MESHES);
+
+    for(int i = 0; i < sceneDescription->getNumMeshes(); ++i)
+    {
+        if(sceneDescription->getMeshes()[i].type != SCENE_MESH_FILE)
+        {
+            continue;
+        }
+
+        if(!importer.import(sceneDescription->getMeshFile(i)))
+        {
+            PRINT_ERROR(QString("Cannot import mesh %1, its instances are not drawn.")
+                        .arg(sceneDescription->getMeshFile(i)));
+            continue;
+        }
+
+        SceneMeshGeometry* meshGeometry = new SceneMeshGeometry;
+        meshGeometry->geometryMesh = numGeometryMeshes++;
+        meshGeometry->bounds = BoundingBox(importer.getBoundsMin(),
+                                           importer.getBoundsMax());
+
+        const GLfloat* vertexData = importer.getVertexData();
+        int numVertices = importer.getNumVertices();
+        geometry.resize(numGeometryMeshes);
+        geometry.setMesh(meshGeometry->geometryMesh, vertexData,
+                         vertexData + 3 * numVertices, vertexData + 6 * numVertices,
+                         numVertices, importer.getIndices(), importer.getNumIndices());
+
+        sceneMeshes[i] = meshGeometry;
+    }
+
+    geometry.upload();
+}
+
+//------------------------------------------------------------------------------------------
+// the built-in objects, then the scene instances
+//------------------------------------------------------------------------------------------
+void Renderer::buildSceneBVH()
+{
+    PROFILE_ZONE("Renderer::buildSceneBVH");
+
+    BoundingBox unitBox(QVector3D(-1.0f, -1.0f, -1.0f), QVector3D(1.0f, 1.0f, 1.0f));
+    BoundingBox planeBox(QVector3D(-1.0f, 0.0f, -1.0f), QVector3D(1.0f, 0.0f, 1.0f));
+
+    sceneBVH.clear();
+    sceneBVH.addObject(planeBox, transforms.getModelMatrix(TRANSFORM_FLOOR));
+    sceneBVH.addObject(unitBox, transforms.getModelMatrix(TRANSFORM_CUBE));
+    sceneBVH.addObject(unitBox,
+                       transforms.getModelMatrix(TRANSFORM_SEMI_REFLECTIVE_SPHERE));
+    sceneBVH.addObject(unitBox, transforms.getModelMatrix(TRANSFORM_REFLECTIVE_SPHERE));
+
+    for(int i = 0; i < sceneInstances.size(); ++i)
+    {
+        const SceneInstance& instance = sceneDescription->getInstances()[sceneInstances[i]];
+        SceneMeshGeometry* meshGeometry = (instance.mesh < (quint32)sceneMeshes.size()) ?
+                                          sceneMeshes[instance.mesh] : NULL;
+        sceneBVH.addObject((meshGeometry != NULL) ? meshGeometry->bounds : unitBox,
+                           SceneDescription::getMatrix(instance.modelMatrix));
+    }
+
+    sceneBVH.build();
+    occlusionCuller.resize(sceneBVH.getNumObjects());
+}
+
+//------------------------------------------------------------------------------------------
+// A reflective instance within PROBE_INFLUENCE_RADIUS of the probe of a reflective object
+// reflects its cube map (the nearest one) instead of the environment. Returns true if the
+// probe of any instance changed, the batches then have to be rebuilt.
+//------------------------------------------------------------------------------------------
+bool Renderer::assignInstanceProbes()
+{
+    PROFILE_ZONE("Renderer::assignInstanceProbes");
+
+    const SceneInstance* instances = sceneDescription->getInstances();
+    const Material* materials = sceneDescription->getMaterials();
+    bool changed = (instanceProbeLayers.size() != sceneInstances.size());
+    instanceProbeLayers.resize(sceneInstances.size());
+
+    for(int j = 0; j < NUM_REFLECTIVE_OBJECTS; ++j)
+    {
+        instanceProbePositions[j] =
+            transforms.getWorldPosition(TRANSFORM_SEMI_REFLECTIVE_SPHERE_PROBE + j);
+        numProbeInstances[j] = 0;
+    }
+
+    for(int i = 0; i < sceneInstances.size(); ++i)
+    {
+        const SceneInstance& instance = instances[sceneInstances[i]];
+        int probeLayer = PROBE_LAYER_ENVIRONMENT;
+
+        if(materials[instance.material].reflection > 0.0f)
+        {
+            QVector3D position(instance.modelMatrix[12], instance.modelMatrix[13],
+                               instance.modelMatrix[14]);
+            float nearestDistance = PROBE_INFLUENCE_RADIUS;
+
+            for(int j = 0; j < NUM_REFLECTIVE_OBJECTS; ++j)
+            {
+                float distance = (instanceProbePositions[j] - position).length();
+
+                if(distance < nearestDistance)
+                {
+                    nearestDistance = distance;
+                    probeLayer = PROBE_LAYER_ENVIRONMENT + 1 + j;
+                }
+            }
+        }
+
+        if(probeLayer != PROBE_LAYER_ENVIRONMENT)
+        {
+            ++numProbeInstances[probeLayer - PROBE_LAYER_ENVIRONMENT - 1];
+        }
+
+        changed = changed || (instanceProbeLayers[i] != probeLayer);
+        instanceProbeLayers[i] = probeLayer;
+    }
+
+    return changed;
+}
+
+//------------------------------------------------------------------------------------------
+// Sort the scene instances by texture, probe and mesh, one batch per run: the batches
+// sharing their texture and probe are consecutive, for the indirect multi-draws.
+//------------------------------------------------------------------------------------------
+void Renderer::buildInstanceBatches()
+{
+    PROFILE_ZONE("Renderer::buildInstanceBatches");
+
+    const SceneInstance* instances = sceneDescription->getInstances();
+    instanceBatches.clear();
+    batchedInstances.resize(sceneInstances.size());
+
+    for(int i = 0; i < sceneInstances.size(); ++i)
+    {
+        batchedInstances[i] = i;
+    }
+
+    auto batchKey = [&](int _i)
+    {
+        const SceneInstance& instance = instances[sceneInstances[_i]];
+        return qMakePair(qMakePair(instance.texture, instanceProbeLayers[_i]),
+                         instance.mesh);
+    };
+
+    std::sort(batchedInstances.begin(), batchedInstances.end(), [&](int _a, int _b)
+    {
+        return batchKey(_a) < batchKey(_b);
+    });
+
+    for(int i = 0; i < batchedInstances.size(); ++i)
+    {
+        if(i > 0 && batchKey(batchedInstances[i]) == batchKey(batchedInstances[i - 1]))
+        {
+            ++instanceBatches.last().numInstances;
+            continue;
+        }
+
+        const SceneInstance& instance = instances[sceneInstances[batchedInstances[i]]];
+        InstanceBatch batch;
+        batch.mesh = instance.mesh;
+        batch.texture = instance.texture;
+        batch.probeLayer = instanceProbeLayers[batchedInstances[i]];
+        batch.firstInstance = i;
+        batch.numInstances = 1;
+        batch.firstVisible = 0;
+        batch.numVisible = 0;
+        instanceBatches.append(batch);
+    }
+
+    // each record is read as vec4 texels
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+
+    if((qint64)sceneDescription->getNumInstances() * sizeof(SceneInstance) >
+       (qint64)maxTexels * SIZE_OF_VEC4)
+    {
+        qDebug() << "Renderer: too many instances for the buffer texture, the instances"
+                 << "are drawn one by one.";
+        instanceBatches.clear();
+    }
+
+    indirectDrawsChanged = true;
+    renderListChanged = true;
+}
+
+//------------------------------------------------------------------------------------------
+// one indirect command per batch, with the current ranges of the geometry buffer
+//------------------------------------------------------------------------------------------
+void Renderer::buildIndirectDraws()
+{
+    PROFILE_ZONE("Renderer::buildIndirectDraws");
+
+    gpuCuller.clear();
+
+    for(int i = 0; i < instanceBatches.size(); ++i)
+    {
+        const InstanceBatch& batch = instanceBatches[i];
+        int geometryMesh = getGeometryMesh(batch.mesh);
+
+        if(geometryMesh < 0)
+        {
+            // kept, for the command indices to match the batches
+            gpuCuller.addDraw(0, 0, 0);
+            continue;
+        }
+
+        const GeometryRange& range = geometry.getRange(geometryMesh);
+        gpuCuller.addDraw(range.numIndices, range.firstIndex, range.baseVertex);
+
+        for(int j = batch.firstInstance; j < batch.firstInstance + batch.numInstances; ++j)
+        {
+            int instance = batchedInstances[j];
+            gpuCuller.addInstance(sceneInstances[instance],
+                                  sceneBVH.getObjectBounds(NUM_SCENE_BUILTIN_OBJECTS +
+                                                           instance));
+        }
+    }
+
+    gpuCuller.upload();
+    indirectDrawsChanged = false;
+}
+
+//------------------------------------------------------------------------------------------
+// recompute the world matrices of the moved objects, and refit their bounds before the
+// next culling
+//------------------------------------------------------------------------------------------
+void Renderer::updateTransforms()
+{
+    if(transforms.update() == 0)
+    {
+        return;
+    }
+
+    renderListChanged = true;
+
+    for(int i = SCENE_FLOOR; i < NUM_SCENE_BUILTIN_OBJECTS; ++i)
+    {
+        sceneBVH.updateObject(i, transforms.getModelMatrix(TRANSFORM_FLOOR + i));
+    }
+
+    // the instances near a moved probe may reflect another cube map
+    for(int j = 0; j < NUM_REFLECTIVE_OBJECTS && !sceneInstances.isEmpty(); ++j)
+    {
+        int probeNode = TRANSFORM_SEMI_REFLECTIVE_SPHERE_PROBE + j;
+
+        if(transforms.getWorldPosition(probeNode) != instanceProbePositions[j])
+        {
+            if(assignInstanceProbes())
+            {
+                buildInstanceBatches();
+            }
+
+            break;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// Set visibleObjects for the next renderScene, the background is never culled.
+// When the instances are culled by the GPU, only the built-in objects are tested here and
+// counted by the statistics.
+//------------------------------------------------------------------------------------------
+void Renderer::cullScene(const QMatrix4x4& _viewProjection, const QString& _passName)
+{
+    PROFILE_ZONE("Renderer::cullScene");
+
+    sceneBVH.refit();
+    bool gpuInstances = enabledInstancing && gpuCuller.isEnabled() &&
+                        !instanceBatches.isEmpty();
+    int numObjects = gpuInstances ? NUM_SCENE_BUILTIN_OBJECTS : sceneBVH.getNumObjects();
+    int numVisible = numObjects;
+
+    if(enabledFrustumCulling)
+    {
+        cullingFrustum = Frustum(_viewProjection);
+        numVisible = gpuInstances ?
+                     sceneBVH.cullFirstObjects(cullingFrustum, numObjects, visibleObjects) :
+                     sceneBVH.cullFrustum(cullingFrustum, visibleObjects);
+    }
+    else
+    {
+        // the null planes keep everything
+        cullingFrustum = Frustum();
+        visibleObjects.fill(1, sceneBVH.getNumObjects());
+    }
+
+    CullingStatistics statistics;
+    statistics.passName = _passName;
+    statistics.numDrawn = numVisible;
+    statistics.numCulled = numObjects - numVisible;
+    statistics.numOccluded = 0;
+    cullingStatistics.append(statistics);
+}
+
+//------------------------------------------------------------------------------------------
+// Cull the instances of the batches on the CPU (scene BVH) and on the GPU, from the camera
+// and from the faces of the probes, and compare the numbers of visible instances.
+// Returns false if they differ, or if the instances are not culled by the GPU. The scene
+// must have been rendered once.
+//------------------------------------------------------------------------------------------
+bool Renderer::checkGPUCulling()
+{
+    if(!gpuCuller.isSupported() || instanceBatches.isEmpty())
+    {
+        qDebug() << "Renderer: no instance is culled by the GPU, nothing to check.";
+        return false;
+    }
+
+    makeRendererCurrent();
+
+    if(indirectDrawsChanged)
+    {
+        buildIndirectDraws();
+    }
+
+    sceneBVH.refit();
+
+    QVector<QMatrix4x4> viewProjections;
+    viewProjections.append(viewProjectionMatrix);
+
+    for(int i = 0; i < NUM_REFLECTIVE_OBJECTS; ++i)
+    {
+        for(int face = 0; face < 6; ++face)
+        {
+            viewProjections.append(setProbeFaceCamera(static_cast<ReflectiveObjects>(i),
+                                                      face));
+        }
+    }
+
+    QVector<uchar> visible;
+    bool success = true;
+
+    for(int v = 0; v < viewProjections.size(); ++v)
+    {
+        Frustum frustum(viewProjections[v]);
+        sceneBVH.cullFrustum(frustum, visible);
+        int numCPUVisible = 0;
+
+        // the instances of the batches without geometry are not drawn by the GPU
+        for(int b = 0; b < instanceBatches.size(); ++b)
+        {
+            const InstanceBatch& batch = instanceBatches[b];
+
+            if(getGeometryMesh(batch.mesh) < 0)
+            {
+                continue;
+            }
+
+            for(int j = batch.firstInstance; j < batch.firstInstance + batch.numInstances;
+                ++j)
+            {
+                numCPUVisible += visible[NUM_SCENE_BUILTIN_OBJECTS + batchedInstances[j]];
+            }
+        }
 
-    QVector3D localCamera = reflectiveObject2LocationMap[_object];
+        gpuCuller.cull(frustum);
+        int numGPUVisible = gpuCuller.readNumVisibleInstances();
 
-    faceProjectionMatrix.setToIdentity();
-    faceProjectionMatrix.perspective(90, 1.0f, 0.1f, 10000.0f);
+        qDebug() << "Renderer: view" << v << "visible instances, CPU:" << numCPUVisible
+                 << "GPU:" << numGPUVisible;
+        success = success && (numCPUVisible == numGPUVisible);
+    }
 
-    FBOCubeMap->bind();
-    glViewport(0, 0, CUBE_MAP_SIZE, CUBE_MAP_SIZE);
+    doneRendererCurrent();
 
-    for(int face = 0; face < 6; ++face)
+    return success;
+}
+
+//------------------------------------------------------------------------------------------
+// Draw the bounds of the object in an occlusion query, without writing color or depth,
+// then start the conditional rendering of the object on it. Returns false when the object
+// is not tested (the camera is inside its bounds, where the box faces may be clipped).
+//------------------------------------------------------------------------------------------
+bool Renderer::beginOcclusionTest(int _object)
+{
+    const BoundingBox& bounds = sceneBVH.getObjectBounds(_object);
+    QVector3D margin = (bounds.boxMax - bounds.boxMin) * 0.01f +
+                       QVector3D(CAMERA_NEAR, CAMERA_NEAR, CAMERA_NEAR);
+    QVector3D boxMin = bounds.boxMin - margin;
+    QVector3D boxMax = bounds.boxMax + margin;
+
+    if(cameraPosition.x() >= boxMin.x() && cameraPosition.x() <= boxMax.x() &&
+       cameraPosition.y() >= boxMin.y() && cameraPosition.y() <= boxMax.y() &&
+       cameraPosition.z() >= boxMin.z() && cameraPosition.z() <= boxMax.z())
     {
-        faceViewMatrix.setToIdentity();
-        faceViewMatrix.lookAt(localCamera, localCamera + viewDirs[face], upDirs[face]);
-        faceViewProjectionMatrix = faceProjectionMatrix * faceViewMatrix;
+        occlusionCuller.setVisible(_object);
+        return false;
+    }
 
-        glBindBuffer(GL_UNIFORM_BUFFER, UBOMatrices);
-        glBufferSubData(GL_UNIFORM_BUFFER, 2 * SIZE_OF_MAT4, SIZE_OF_MAT4,
-                        faceViewProjectionMatrix.constData());
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    QMatrix4x4 boxMatrix;
+    boxMatrix.translate((boxMin + boxMax) * 0.5f);
+    boxMatrix.scale((boxMax - boxMin) * 0.5f);
 
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-                               GL_TEXTURE_CUBE_MAP_POSITIVE_X + face,
-                               objEnvTextureBuffer2[_object]->textureId(), 0);
-        renderScene(_object);
-    }
+    glBindBuffer(GL_UNIFORM_BUFFER, UBOMatrices);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, SIZE_OF_MAT4, boxMatrix.constData());
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, UBOBindingIndex[BINDING_MATRICES], UBOMatrices);
 
-    FBOCubeMap->release();
-    makeCurrent();
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
 
+    occlusionCuller.beginQuery(_object);
+    geometry.draw(GEOMETRY_CUBE);
+    occlusionCuller.endQuery();
+    ++numDrawCalls;
 
-    /////////////////////////////////////////////////////////////////
-    // swap texture
-    qSwap(objEnvTextureBuffer1[_object], objEnvTextureBuffer2[_object]);
-    useGlobalEnvTexture = false;
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDepthMask(GL_TRUE);
+
+    occlusionCuller.beginConditionalRender(_object);
+
+    return true;
 }
 
 //------------------------------------------------------------------------------------------
-void Renderer::createObjectCubeMapTextures()
+// Render the layers of the scene seen from the camera, or from the probe of _hiddenObj.
+// The dynamic layer alone is drawn over the static layer already in the framebuffer,
+// without clearing it.
+//------------------------------------------------------------------------------------------
+void Renderer::renderScene(ReflectiveObjects _hiddenObj, int _layers)
 {
-    for(int i = 0; i < NUM_REFLECTIVE_OBJECTS; ++i)
-    {
-        if(enabledDynamicEnvMapping)
-        {
-            if(useGlobalEnvTexture)
-            {
-                objEnvTexture[i] = currentEnvTexture;
-            }
-            else
-            {
-                objEnvTexture[i] = objEnvTextureBuffer1[i];
-            }
+    PROFILE_ZONE("Renderer::renderScene");
 
-            createDynamicCubeMapTexture(static_cast<ReflectiveObjects>(i));
-        }
-        else
-        {
-            objEnvTexture[i] = currentEnvTexture;
-        }
+    if(_layers & RENDER_LAYER_STATIC)
+    {
+        glClearColor(0.8f, 0.8f, 0.8f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     }
-}
 
-//------------------------------------------------------------------------------------------
-void Renderer::renderScene(ReflectiveObjects _hiddenObj)
-{
-    glClearColor(0.8f, 0.8f, 0.8f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // the view vectors of the shading, the static layer of a probe does not depend on the
+    // camera
+    eyePosition = (_hiddenObj == INVALID_OBJECT) ? cameraPosition :
+                  transforms.getWorldPosition(TRANSFORM_SEMI_REFLECTIVE_SPHERE_PROBE +
+                                              _hiddenObj);
+
+    // all the meshes are drawn from the geometry buffer, with a single vertex array object
+    geometry.bind();
+    glBindBufferBase(GL_UNIFORM_BUFFER, UBOBindingIndex[BINDING_CAMERA], UBOCamera);
+
+    if(renderListChanged)
+    {
+        recordRenderList();
+    }
 
     // background
-    if(enabledBackgroundRendering)
+    if(enabledBackgroundRendering && (_layers & RENDER_LAYER_STATIC))
     {
         renderBackground();
     }
 
     // set the data for rendering
     currentProgram->bind();
-    currentProgram->setUniformValue(uniCameraPosition[shadingMode], cameraPosition);
+    ++numProgramSwitches;
+    currentProgram->setUniformValue(uniCameraPosition[shadingMode], eyePosition);
     currentProgram->setUniformValue(uniObjTexture[shadingMode], 0);
     currentProgram->setUniformValue(uniEnvTexture[shadingMode], 1);
 
+    // the matrices of each draw are bound by the render list
     glUniformBlockBinding(currentProgram->programId(), uniMatrices[shadingMode],
                           UBOBindingIndex[BINDING_MATRICES]);
-    glBindBufferBase(GL_UNIFORM_BUFFER, UBOBindingIndex[BINDING_MATRICES],
-                     UBOMatrices);
+    glUniformBlockBinding(currentProgram->programId(), uniCamera[shadingMode],
+                          UBOBindingIndex[BINDING_CAMERA]);
 
     glUniformBlockBinding(currentProgram->programId(), uniLight[shadingMode],
                           UBOBindingIndex[BINDING_LIGHT]);
     glBindBufferBase(GL_UNIFORM_BUFFER, UBOBindingIndex[BINDING_LIGHT],
                      UBOLight);
 
-    renderFloor();
+    // all the materials are bound once, each draw only sets its material index
+    glUniformBlockBinding(currentProgram->programId(), uniMaterials[shadingMode],
+                          UBOBindingIndex[BINDING_MATERIALS]);
+    glBindBufferBase(GL_UNIFORM_BUFFER, UBOBindingIndex[BINDING_MATERIALS],
+                     materialBuffer.getBufferId());
 
-    renderCube();
+    // Occlusion queries in the main view only, the objects outside of the frustum are not
+    // tested and are considered visible. Without the depth test, nothing is tested: the
+    // results of the previous tests must not keep hiding the objects (and their probes).
+    bool mainView = (_hiddenObj == INVALID_OBJECT) && occlusionCuller.isEnabled();
+    bool testOcclusion = mainView && enabledDepthTest;
 
-    if(_hiddenObj != SEMI_REFLECTIVE_SPHERE)
+    for(int i = 0; mainView && i < visibleObjects.size(); ++i)
     {
-        renderSemireflectiveSphere();
+        if(!testOcclusion || !visibleObjects[i])
+        {
+            occlusionCuller.setVisible(i);
+        }
     }
 
-    if(_hiddenObj != TOTAL_REFLECTIVE_SPHERE)
+    replayRenderList(_hiddenObj, _layers, testOcclusion);
+
+    if((_layers & RENDER_LAYER_DYNAMIC) && enabledInstancing && !instanceBatches.isEmpty())
     {
-        renderReflectiveSphere();
+        renderInstanceBatches();
     }
 
     currentProgram->release();
+    geometry.release();
 }
 //------------------------------------------------------------------------------------------
 void Renderer::renderBackground()
 {
+    PROFILE_ZONE("Renderer::renderBackground");
+    gpuProfiler.beginPass("background");
+
     QOpenGLShaderProgram* program = glslPrograms[BACKGROUND_SHADING];
     program->bind();
+    ++numProgramSwitches;
 
     /////////////////////////////////////////////////////////////////
     // flush the model matrices
     glBindBuffer(GL_UNIFORM_BUFFER, UBOMatrices);
     glBufferSubData(GL_UNIFORM_BUFFER, 0, SIZE_OF_MAT4,
-                    backgroundCubeModelMatrix.constData());
+                    transforms.getMatrices(TRANSFORM_BACKGROUND).modelMatrix);
     glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
     /////////////////////////////////////////////////////////////////
     // set the uniform
-    program->setUniformValue(uniCameraPosition[BACKGROUND_SHADING], cameraPosition);
+    program->setUniformValue(uniCameraPosition[BACKGROUND_SHADING], eyePosition);
     program->setUniformValue(uniEnvTexture[BACKGROUND_SHADING], 1);
 
     glUniformBlockBinding(program->programId(), uniMatrices[BACKGROUND_SHADING],
                           UBOBindingIndex[BINDING_MATRICES]);
     glBindBufferBase(GL_UNIFORM_BUFFER, UBOBindingIndex[BINDING_MATRICES],
                      UBOMatrices);
+    glUniformBlockBinding(program->programId(), uniCamera[BACKGROUND_SHADING],
+                          UBOBindingIndex[BINDING_CAMERA]);
 
     /////////////////////////////////////////////////////////////////
     // render the background
-    vaoCube[shadingMode].bind();
     currentEnvTexture->bind(1);
-    glDrawElements(GL_TRIANGLES, cubeObject->getNumIndices(), GL_UNSIGNED_SHORT, 0);
+    ++numTextureSwitches;
+    geometry.draw(GEOMETRY_CUBE);
+    ++numDrawCalls;
     currentEnvTexture->release();
-    vaoCube[shadingMode].release();
 
     program->release();
+    gpuProfiler.endPass();
 }
 
 //------------------------------------------------------------------------------------------
-void Renderer::renderFloor()
+// The draws of the built-in objects and of the scene instances which are not instanced,
+// sorted by state: the floor and the cube are the occluders, drawn first, then the draws
+// sharing their textures are grouped, front to back from the camera.
+// Recorded again only when its input changed: the transforms, the camera position, the
+// scene, the textures or the instancing. The visibility and the occlusion tests of the
+// culling of each pass are applied when replaying.
+//------------------------------------------------------------------------------------------
+void Renderer::recordRenderList()
 {
-    /////////////////////////////////////////////////////////////////
-    // flush the model and normal matrices
-    glBindBuffer(GL_UNIFORM_BUFFER, UBOMatrices);
-    glBufferSubData(GL_UNIFORM_BUFFER, 0, SIZE_OF_MAT4,
-                    planeModelMatrix.constData());
-    glBufferSubData(GL_UNIFORM_BUFFER, SIZE_OF_MAT4, SIZE_OF_MAT4,
-                    planeNormalMatrix.constData());
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    PROFILE_ZONE("Renderer::recordRenderList");
+
+    renderList.clear();
 
     /////////////////////////////////////////////////////////////////
-    // set the uniform
-    currentProgram->setUniformValue(uniHasObjTexture[shadingMode], GL_TRUE);
+    // the built-in objects, the spheres are hidden in their own probes
+    static const int builtinMeshes[NUM_SCENE_BUILTIN_OBJECTS] =
+    {
+        GEOMETRY_PLANE, GEOMETRY_CUBE, GEOMETRY_SPHERE, GEOMETRY_SPHERE
+    };
+    QOpenGLTexture* builtinTextures[NUM_SCENE_BUILTIN_OBJECTS] =
+    {
+        floorTextures[floorTexture], decalTexture, sphereTexture, NULL
+    };
+
+    for(int i = SCENE_FLOOR; i < NUM_SCENE_BUILTIN_OBJECTS; ++i)
+    {
+        if(builtinSceneTextures[i] != NULL)
+        {
+            builtinTextures[i] = builtinSceneTextures[i];
+        }
+    }
 
-    glUniformBlockBinding(currentProgram->programId(), uniMaterial[shadingMode],
-                          UBOBindingIndex[BINDING_FLOOR_MATERIAL]);
-    glBindBufferBase(GL_UNIFORM_BUFFER, UBOBindingIndex[BINDING_FLOOR_MATERIAL],
-                     UBOPlaneMaterial);
+    for(int i = SCENE_FLOOR; i < NUM_SCENE_BUILTIN_OBJECTS; ++i)
+    {
+        const TransformMatrices& matrices = transforms.getMatrices(TRANSFORM_FLOOR + i);
+        bool reflective = (i >= SCENE_SEMI_REFLECTIVE_SPHERE);
+        int probe = i - SCENE_SEMI_REFLECTIVE_SPHERE;
+
+        RenderCommand command;
+        command.object = i;
+        command.layer = (i == SCENE_FLOOR) ? RENDER_LAYER_STATIC : RENDER_LAYER_DYNAMIC;
+        command.hiddenInProbe = reflective ? probe : -1;
+        command.geometryMesh = builtinMeshes[i];
+        command.materialIndex = i;
+        command.transformSlot = renderList.addTransform(matrices.modelMatrix);
+        command.texture = builtinTextures[i];
+        command.probeLayer = reflective ? (PROBE_LAYER_ENVIRONMENT + 1 + probe) :
+                             PROBE_LAYER_ENVIRONMENT;
+        command.testOcclusion = reflective;
+        command.sortKey = getRenderKey(command);
+        renderList.addCommand(command);
+    }
 
-    /////////////////////////////////////////////////////////////////
-    // render the floor
-    vaoPlane[shadingMode].bind();
-    floorTextures[floorTexture]->bind(0);
+    // the texture keeps its parameter, set once for all the replays
+    builtinTextures[SCENE_FLOOR]->bind(0);
+    GLfloat anisotropy = 1.0f;
 
     if(enabledTextureAnisotropicFiltering)
     {
-        GLfloat fLargest;
-        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &fLargest);
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, fLargest);
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &anisotropy);
     }
-    else
+
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy);
+    builtinTextures[SCENE_FLOOR]->release(0);
+
+    /////////////////////////////////////////////////////////////////
+    // the scene instances, the batches are drawn by renderInstanceBatches
+    bool batched = enabledInstancing && !instanceBatches.isEmpty();
+
+    for(int i = 0; !batched && i < sceneInstances.size(); ++i)
     {
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 1.0f);
+        const SceneInstance& instance = sceneDescription->getInstances()[sceneInstances[i]];
+        int geometryMesh = getGeometryMesh(instance.mesh);
+
+        if(geometryMesh < 0)
+        {
+            continue;
+        }
+
+        // the normal matrix follows the model matrix in the record
+        RenderCommand command;
+        command.object = NUM_SCENE_BUILTIN_OBJECTS + i;
+        command.layer = RENDER_LAYER_DYNAMIC;
+        command.hiddenInProbe = -1;
+        command.geometryMesh = geometryMesh;
+        command.materialIndex = qMin(NUM_SCENE_BUILTIN_OBJECTS + (int)instance.material,
+                                     numMaterials - 1);
+        command.transformSlot = renderList.addTransform(instance.modelMatrix);
+        command.texture = (instance.texture != SCENE_NO_INDEX) ?
+                          sceneTextures[instance.texture] : NULL;
+        command.probeLayer = instanceProbeLayers[i];
+        command.testOcclusion = true;
+        command.sortKey = getRenderKey(command);
+        renderList.addCommand(command);
     }
 
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
-    floorTextures[floorTexture]->release();
-    vaoPlane[shadingMode].release();
+    renderList.sort();
+    renderList.upload();
+    renderListChanged = false;
 }
 
 //------------------------------------------------------------------------------------------
-void Renderer::renderCube()
+// all the commands use the current program and the vertex array object of the geometry
+// buffer, the depth is the distance of the object bounds from the camera
+//------------------------------------------------------------------------------------------
+quint64 Renderer::getRenderKey(const RenderCommand& _command) const
 {
-    /////////////////////////////////////////////////////////////////
-    // flush the model and normal matrices
-    glBindBuffer(GL_UNIFORM_BUFFER, UBOMatrices);
-    glBufferSubData(GL_UNIFORM_BUFFER, 0, SIZE_OF_MAT4,
-                    cubeModelMatrix.constData());
-    glBufferSubData(GL_UNIFORM_BUFFER, SIZE_OF_MAT4, SIZE_OF_MAT4,
-                    cubeNormalMatrix.constData());
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    const BoundingBox& bounds = sceneBVH.getObjectBounds(_command.object);
+    float distance = (0.5f * (bounds.boxMin + bounds.boxMax) - cameraPosition).length();
+    int depthBucket = (int)(distance / CAMERA_FAR * RENDER_KEY_NUM_DEPTH_BUCKETS);
+    GLuint texture = (_command.texture != NULL) ? _command.texture->textureId() : 0;
+
+    return makeRenderKey(_command.testOcclusion ? RENDER_PASS_OCCLUDEES :
+                         RENDER_PASS_OCCLUDERS, shadingMode, 0, texture,
+                         _command.probeLayer, depthBucket);
+}
 
+//------------------------------------------------------------------------------------------
+// Draw the commands of the render list in the layers visible in the current pass (see
+// cullScene), except the object of the probe being rendered. The uniforms and the
+// textures of a draw are only set when they differ from the previous draw.
+//------------------------------------------------------------------------------------------
+void Renderer::replayRenderList(ReflectiveObjects _hiddenObj, int _layers,
+                                bool _testOcclusion)
+{
+    PROFILE_ZONE("Renderer::replayRenderList");
+    gpuProfiler.beginPass("render list");
 
-    /////////////////////////////////////////////////////////////////
-    // set the uniform
-    currentProgram->setUniformValue(uniHasObjTexture[shadingMode], GL_TRUE);
+    int boundMaterial = -1;
+    int boundHasTexture = -1;
+    QOpenGLTexture* boundTexture = NULL;
+    QOpenGLTexture* boundProbeTexture = NULL;
 
-    glUniformBlockBinding(currentProgram->programId(), uniMaterial[shadingMode],
-                          UBOBindingIndex[BINDING_CUBE_MATERIAL]);
-    glBindBufferBase(GL_UNIFORM_BUFFER, UBOBindingIndex[BINDING_CUBE_MATERIAL],
-                     UBOCubeMaterial);
+    for(int i = 0; i < renderList.size(); ++i)
+    {
+        const RenderCommand& command = renderList.getCommand(i);
 
-    /////////////////////////////////////////////////////////////////
-    // render the cube
-    vaoCube[shadingMode].bind();
-    decalTexture->bind(0);
-    glDrawElements(GL_TRIANGLES, cubeObject->getNumIndices(), GL_UNSIGNED_SHORT, 0);
-    decalTexture->release();
-    vaoCube[shadingMode].release();
+        if(command.hiddenInProbe == _hiddenObj || !(command.layer & _layers) ||
+           !visibleObjects[command.object])
+        {
+            continue;
+        }
+
+        bool conditional = _testOcclusion && command.testOcclusion &&
+                           beginOcclusionTest(command.object);
+
+        // the occlusion test draws its box with its own matrices
+        renderList.bindTransform(UBOBindingIndex[BINDING_MATRICES], command.transformSlot);
+
+        if(boundMaterial != command.materialIndex)
+        {
+            boundMaterial = command.materialIndex;
+            currentProgram->setUniformValue(uniMaterialIndex[shadingMode], boundMaterial);
+        }
+
+        int hasTexture = (command.texture != NULL) ? 1 : 0;
+
+        if(boundHasTexture != hasTexture)
+        {
+            boundHasTexture = hasTexture;
+            currentProgram->setUniformValue(uniHasObjTexture[shadingMode],
+                                            hasTexture ? GL_TRUE : GL_FALSE);
+        }
+
+        if(command.texture != NULL && boundTexture != command.texture)
+        {
+            boundTexture = command.texture;
+            boundTexture->bind(0);
+            ++numTextureSwitches;
+        }
+
+        QOpenGLTexture* probeTexture = getProbeTexture(command.probeLayer);
+
+        if(boundProbeTexture != probeTexture)
+        {
+            boundProbeTexture = probeTexture;
+            boundProbeTexture->bind(1);
+            ++numTextureSwitches;
+        }
+
+        geometry.draw(command.geometryMesh);
+        ++numDrawCalls;
+
+        if(conditional)
+        {
+            occlusionCuller.endConditionalRender();
+        }
+    }
+
+    if(boundTexture != NULL)
+    {
+        boundTexture->release(0);
+    }
+
+    if(boundProbeTexture != NULL)
+    {
+        boundProbeTexture->release(1);
+    }
+
+    gpuProfiler.endPass();
 }
 
 //------------------------------------------------------------------------------------------
-void Renderer::renderSemireflectiveSphere()
+// One glDrawElementsInstanced per batch: the indices of the visible instances of all the
+// batches are uploaded at once, each batch points its instance attribute to its own range.
+// The instances are not tested for occlusion.
+//------------------------------------------------------------------------------------------
+void Renderer::renderInstanceBatches()
 {
-    /////////////////////////////////////////////////////////////////
-    // flush the model and normal matrices
-    glBindBuffer(GL_UNIFORM_BUFFER, UBOMatrices);
-    glBufferSubData(GL_UNIFORM_BUFFER, 0, SIZE_OF_MAT4,
-                    semiReflectiveSphereModelMatrix.constData());
-    glBufferSubData(GL_UNIFORM_BUFFER, SIZE_OF_MAT4, SIZE_OF_MAT4,
-                    semiReflectiveSphereNormalMatrix.constData());
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    if(gpuCuller.isEnabled())
+    {
+        renderIndirectInstanceBatches();
+        return;
+    }
+
+    PROFILE_ZONE("Renderer::renderInstanceBatches");
+    gpuProfiler.beginPass("instanced scene instances");
 
     /////////////////////////////////////////////////////////////////
-    // set the uniform
-    currentProgram->setUniformValue(uniHasObjTexture[shadingMode], GL_TRUE);
+    // compact the visible instances of each batch
+    visibleInstances.resize(0);
+
+    for(int i = 0; i < instanceBatches.size(); ++i)
+    {
+        InstanceBatch& batch = instanceBatches[i];
+        batch.firstVisible = visibleInstances.size();
+
+        for(int j = batch.firstInstance; j < batch.firstInstance + batch.numInstances; ++j)
+        {
+            int instance = batchedInstances[j];
+
+            if(visibleObjects[NUM_SCENE_BUILTIN_OBJECTS + instance])
+            {
+                visibleInstances.append(sceneInstances[instance]);
+            }
+        }
+
+        batch.numVisible = visibleInstances.size() - batch.firstVisible;
+    }
+
+    if(visibleInstances.isEmpty())
+    {
+        gpuProfiler.endPass();
+        return;
+    }
 
-    glUniformBlockBinding(currentProgram->programId(), uniMaterial[shadingMode],
-                          UBOBindingIndex[BINDING_SEMIREFLECTIVE_SPHERE_MATERIAL]);
-    glBindBufferBase(GL_UNIFORM_BUFFER,
-                     UBOBindingIndex[BINDING_SEMIREFLECTIVE_SPHERE_MATERIAL],
-                     UBOSemireflectiveSphereMaterial);
+    glBindBuffer(GL_ARRAY_BUFFER, visibleInstanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, visibleInstances.size() * sizeof(GLuint),
+                 visibleInstances.constData(), GL_STREAM_DRAW);
 
     /////////////////////////////////////////////////////////////////
-    // render the sphere
-    vaoSphere[shadingMode].bind();
-    sphereTexture->bind(0);
-    objEnvTexture[SEMI_REFLECTIVE_SPHERE]->bind(1);
-    glDrawElements(GL_TRIANGLES, sphereObject->getNumIndices(), GL_UNSIGNED_SHORT, 0);
-    sphereTexture->release();
-    objEnvTexture[SEMI_REFLECTIVE_SPHERE]->release();
-    vaoSphere[shadingMode].release();
+    // render the batches
+    QOpenGLShaderProgram* program = beginInstancedShading(visibleInstanceBuffer);
+    QOpenGLTexture* boundTexture = NULL;
+    QOpenGLTexture* boundProbeTexture = NULL;
+
+    for(int i = 0; i < instanceBatches.size(); ++i)
+    {
+        const InstanceBatch& batch = instanceBatches[i];
+        int geometryMesh = getGeometryMesh(batch.mesh);
+
+        if(batch.numVisible == 0 || geometryMesh < 0)
+        {
+            continue;
+        }
+
+        QOpenGLTexture* texture = (batch.texture != SCENE_NO_INDEX) ?
+                                  sceneTextures[batch.texture] : NULL;
+        QOpenGLTexture* probeTexture = getProbeTexture(batch.probeLayer);
+
+        // one index per instance, from the range of the batch
+        glVertexAttribIPointer(GEOMETRY_ATTRIB_INSTANCE, 1, GL_UNSIGNED_INT, 0,
+                               (const GLvoid*)(batch.firstVisible * sizeof(GLuint)));
+
+        program->setUniformValue(uniHasObjTexture[INSTANCED_PHONG_SHADING],
+                                 (texture != NULL) ? GL_TRUE : GL_FALSE);
+
+        if(texture != NULL && boundTexture != texture)
+        {
+            boundTexture = texture;
+            boundTexture->bind(0);
+            ++numTextureSwitches;
+        }
+
+        if(boundProbeTexture != probeTexture)
+        {
+            boundProbeTexture = probeTexture;
+            boundProbeTexture->bind(1);
+            ++numTextureSwitches;
+        }
+
+        geometry.drawInstanced(geometryMesh, batch.numVisible);
+        ++numDrawCalls;
+    }
+
+    if(boundTexture != NULL)
+    {
+        boundTexture->release(0);
+    }
+
+    if(boundProbeTexture != NULL)
+    {
+        boundProbeTexture->release(1);
+    }
+
+    endInstancedShading();
+    gpuProfiler.endPass();
 }
 
 //------------------------------------------------------------------------------------------
-void Renderer::renderReflectiveSphere()
+// The batches are culled by the compute shader into one indirect command each, then the
+// consecutive batches with the same texture and probe are submitted with a single
+// glMultiDrawElementsIndirect (they differ by their mesh only).
+//------------------------------------------------------------------------------------------
+void Renderer::renderIndirectInstanceBatches()
 {
-    /////////////////////////////////////////////////////////////////
-    // flush the model and normal matrices
-    glBindBuffer(GL_UNIFORM_BUFFER, UBOMatrices);
-    glBufferSubData(GL_UNIFORM_BUFFER, 0, SIZE_OF_MAT4,
-                    reflectiveSphereModelMatrix.constData());
-    glBufferSubData(GL_UNIFORM_BUFFER, SIZE_OF_MAT4, SIZE_OF_MAT4,
-                    reflectiveSphereNormalMatrix.constData());
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    PROFILE_ZONE("Renderer::renderIndirectInstanceBatches");
+    gpuProfiler.beginPass("indirect scene instances");
 
-    /////////////////////////////////////////////////////////////////
-    // set the uniform
-    currentProgram->setUniformValue(uniHasObjTexture[shadingMode], GL_FALSE);
+    if(indirectDrawsChanged)
+    {
+        buildIndirectDraws();
+    }
+
+    gpuCuller.cull(cullingFrustum);
+
+    QOpenGLShaderProgram* program =
+        beginInstancedShading(gpuCuller.getVisibleInstanceBuffer());
+    QOpenGLTexture* boundTexture = NULL;
+    QOpenGLTexture* boundProbeTexture = NULL;
+
+    // the base instance of each command selects its range
+    glVertexAttribIPointer(GEOMETRY_ATTRIB_INSTANCE, 1, GL_UNSIGNED_INT, 0, 0);
+
+    for(int first = 0; first < instanceBatches.size();)
+    {
+        const InstanceBatch& batch = instanceBatches[first];
+        int last = first + 1;
+
+        while(last < instanceBatches.size() &&
+              instanceBatches[last].texture == batch.texture &&
+              instanceBatches[last].probeLayer == batch.probeLayer)
+        {
+            ++last;
+        }
+
+        QOpenGLTexture* texture = (batch.texture != SCENE_NO_INDEX) ?
+                                  sceneTextures[batch.texture] : NULL;
+        QOpenGLTexture* probeTexture = getProbeTexture(batch.probeLayer);
+
+        program->setUniformValue(uniHasObjTexture[INSTANCED_PHONG_SHADING],
+                                 (texture != NULL) ? GL_TRUE : GL_FALSE);
+
+        if(texture != NULL && boundTexture != texture)
+        {
+            boundTexture = texture;
+            boundTexture->bind(0);
+            ++numTextureSwitches;
+        }
+
+        if(boundProbeTexture != probeTexture)
+        {
+            boundProbeTexture = probeTexture;
+            boundProbeTexture->bind(1);
+            ++numTextureSwitches;
+        }
 
-    glUniformBlockBinding(currentProgram->programId(), uniMaterial[shadingMode],
-                          UBOBindingIndex[BINDING_REFLECTIVE_SPHERE_MATERIAL]);
-    glBindBufferBase(GL_UNIFORM_BUFFER, UBOBindingIndex[BINDING_REFLECTIVE_SPHERE_MATERIAL],
-                     UBOReflectiveSphereMaterial);
+        gpuCuller.multiDraw(first, last - first);
+        ++numDrawCalls;
 
+        first = last;
+    }
+
+    if(boundTexture != NULL)
+    {
+        boundTexture->release(0);
+    }
+
+    if(boundProbeTexture != NULL)
+    {
+        boundProbeTexture->release(1);
+    }
+
+    endInstancedShading();
+    gpuProfiler.endPass();
+}
+
+//------------------------------------------------------------------------------------------
+// bind the instanced program and its data, the per instance attribute reads _instances
+//------------------------------------------------------------------------------------------
+QOpenGLShaderProgram* Renderer::beginInstancedShading(GLuint _instances)
+{
     /////////////////////////////////////////////////////////////////
-    // render the sphere
-    vaoSphere[shadingMode].bind();
-    objEnvTexture[TOTAL_REFLECTIVE_SPHERE]->bind(1);
-    glDrawElements(GL_TRIANGLES, sphereObject->getNumIndices(), GL_UNSIGNED_SHORT, 0);
-    objEnvTexture[TOTAL_REFLECTIVE_SPHERE]->release();
-    vaoSphere[shadingMode].release();
+    // set the uniform, the uniform buffers are already bound by renderScene
+    QOpenGLShaderProgram* program = glslPrograms[INSTANCED_PHONG_SHADING];
+    program->bind();
+    ++numProgramSwitches;
+    program->setUniformValue(uniCameraPosition[INSTANCED_PHONG_SHADING], eyePosition);
+    program->setUniformValue(uniObjTexture[INSTANCED_PHONG_SHADING], 0);
+    program->setUniformValue(uniEnvTexture[INSTANCED_PHONG_SHADING], 1);
+    program->setUniformValue(uniInstanceData, 2);
+    program->setUniformValue(uniInstanceIndices, 3);
+    program->setUniformValue(uniMaterialIndex[INSTANCED_PHONG_SHADING],
+                             (int)NUM_SCENE_BUILTIN_OBJECTS);
+    program->setUniformValue(uniMaxMaterialIndex, numMaterials - 1);
+
+    glUniformBlockBinding(program->programId(), uniCamera[INSTANCED_PHONG_SHADING],
+                          UBOBindingIndex[BINDING_CAMERA]);
+    glUniformBlockBinding(program->programId(), uniLight[INSTANCED_PHONG_SHADING],
+                          UBOBindingIndex[BINDING_LIGHT]);
+    glUniformBlockBinding(program->programId(), uniMaterials[INSTANCED_PHONG_SHADING],
+                          UBOBindingIndex[BINDING_MATERIALS]);
+
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_BUFFER, sceneInstanceTexture);
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_BUFFER, sceneInstanceIndexTexture);
+    glActiveTexture(GL_TEXTURE0);
+
+    // the geometry buffer VAO is bound by renderScene, the instance attribute is only
+    // enabled for the batches
+    glBindBuffer(GL_ARRAY_BUFFER, _instances);
+    glEnableVertexAttribArray(GEOMETRY_ATTRIB_INSTANCE);
+    glVertexAttribDivisor(GEOMETRY_ATTRIB_INSTANCE, 1);
+
+    return program;
+}
+
+//------------------------------------------------------------------------------------------
+void Renderer::endInstancedShading()
+{
+    glDisableVertexAttribArray(GEOMETRY_ATTRIB_INSTANCE);
+    glVertexAttribDivisor(GEOMETRY_ATTRIB_INSTANCE, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE0);
+
+    // renderScene goes on with its own program
+    currentProgram->bind();
+    ++numProgramSwitches;
+}
+
+//------------------------------------------------------------------------------------------
+// the cube map reflected by the scene instances with this probe layer
+//------------------------------------------------------------------------------------------
+QOpenGLTexture* Renderer::getProbeTexture(int _probeLayer)
+{
+    return (_probeLayer == PROBE_LAYER_ENVIRONMENT) ? currentEnvTexture :
+           objEnvTexture[_probeLayer - PROBE_LAYER_ENVIRONMENT - 1];
+}
+
+//------------------------------------------------------------------------------------------
+// the mesh of the geometry buffer drawn for a scene mesh, -1 if it could not be imported
+//------------------------------------------------------------------------------------------
+int Renderer::getGeometryMesh(quint32 _sceneMesh) const
+{
+    static const int builtinMeshes[NUM_SCENE_MESH_TYPES] =
+    {
+        GEOMETRY_PLANE, GEOMETRY_CUBE, GEOMETRY_SPHERE, -1
+    };
+
+    if(sceneMeshes[_sceneMesh] != NULL)
+    {
+        return sceneMeshes[_sceneMesh]->geometryMesh;
+    }
+
+    return builtinMeshes[sceneDescription->getMeshes()[_sceneMesh].type];
+}
+
+//------------------------------------------------------------------------------------------
+// draw the profiling results on top of the rendered frame
+// QPainter changes the GL states, restore the ones the scene rendering relies on
+//------------------------------------------------------------------------------------------
+void Renderer::renderOverlay()
+{
+    PROFILE_ZONE("Renderer::renderOverlay");
+
+    QStringList lines = gpuProfiler.getSummary();
+    lines.append(QString("%1 %2 %3 %4").arg("culling", -32).arg("drawn", 7)
+                 .arg("culled", 7).arg("occluded", 8));
+
+    for(int i = 0; i < cullingStatistics.size(); ++i)
+    {
+        lines.append(QString("%1 %2 %3 %4").arg(cullingStatistics[i].passName, -32)
+                     .arg(cullingStatistics[i].numDrawn, 7)
+                     .arg(cullingStatistics[i].numCulled, 7)
+                     .arg(cullingStatistics[i].numOccluded, 8));
+    }
+
+    lines.append(QString("%1 %2").arg("context switches", -32)
+                 .arg(numFrameContextSwitches, 7));
+    lines.append(QString("%1 %2").arg("uniform upload (bytes)", -32)
+                 .arg(numFrameUploadBytes, 7));
+    lines.append(QString("%1 %2").arg("draw calls", -32).arg(numDrawCalls, 7));
+    lines.append(QString("%1 %2").arg("program switches", -32).arg(numProgramSwitches, 7));
+    lines.append(QString("%1 %2").arg("texture switches", -32).arg(numTextureSwitches, 7));
+    lines.append(QString("%1 %2 %3").arg("probe faces (skipped)", -32)
+                 .arg(numProbeFaces, 7).arg(numSkippedProbeFaces, 7));
+    lines.append(QString("%1 %2 %3").arg("frame graph passes (culled)", -32)
+                 .arg(frameGraph.getNumPasses(), 7)
+                 .arg(frameGraph.getNumCulledPasses(), 7));
+    lines.append(QString("%1 %2 %3").arg("transient resources (physical)", -32)
+                 .arg(frameGraph.getNumTransientResources(), 7)
+                 .arg(frameGraph.getNumPhysicalResources(), 7));
+
+    QFont font("Courier");
+    font.setStyleHint(QFont::Monospace);
+    font.setPointSize(9);
+    QFontMetrics fontMetrics(font);
+    int lineHeight = fontMetrics.height();
+    int boxWidth = 0;
+
+    for(int i = 0; i < lines.size(); ++i)
+    {
+        boxWidth = qMax(boxWidth, fontMetrics.width(lines[i]));
+    }
+
+    QPainter painter(this);
+    painter.setFont(font);
+    painter.fillRect(5, 5, boxWidth + 10, lineHeight * lines.size() + 10,
+                     QColor(0, 0, 0, 160));
+    painter.setPen(Qt::white);
+
+    for(int i = 0; i < lines.size(); ++i)
+    {
+        painter.drawText(10, 10 + lineHeight * i + fontMetrics.ascent(), lines[i]);
+    }
+
+    painter.end();
+
+    glDisable(GL_BLEND);
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_STENCIL_TEST);
+    glDepthMask(GL_TRUE);
+
+    if(enabledDepthTest)
+    {
+        glEnable(GL_DEPTH_TEST);
+    }
+    else
+    {
+        glDisable(GL_DEPTH_TEST);
+    }
 }
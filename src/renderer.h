@@ -16,6 +16,19 @@
 #include "unitcube.h"
 #include "unitsphere.h"
 #include "unitplane.h"
+#include "framescheduler.h"
+#include "gpuprofiler.h"
+#include "cpuprofiler.h"
+#include "inputrecorder.h"
+#include "framecapture.h"
+#include "scenebvh.h"
+#include "occlusionculler.h"
+#include "transformstore.h"
+#include "uniformshadowbuffer.h"
+#include "geometrybuffer.h"
+#include "gpuculler.h"
+#include "renderlist.h"
+#include "framegraph.h"
 
 //------------------------------------------------------------------------------------------
 #define PRINT_ERROR(_errStr) \
@@ -43,9 +56,26 @@
 
 #define SIZE_OF_MAT4 (4 * 4 *sizeof(GLfloat))
 #define SIZE_OF_VEC4 (4 * sizeof(GLfloat))
+// size of the material array of phong-shading.fs.glsl, and its std140 element stride
+#define MAX_MATERIALS 256
+#define MATERIAL_STRIDE (3 * SIZE_OF_VEC4)
+// the cube map reflected by a scene instance: the environment, or 1 + ReflectiveObjects
+#define PROBE_LAYER_ENVIRONMENT 0
+#define PROBE_INFLUENCE_RADIUS 10.0f
+// the reflections of a sphere seen from the camera are sampled on this many rings of its
+// visible cap, a face of its cube map is skipped if no sample is within PROBE_FACE_MARGIN
+// of it (in cube map coordinates)
+#define PROBE_FACE_SAMPLES 16
+#define PROBE_FACE_MARGIN 0.25f
+#define ALL_CUBE_MAP_FACES 0x3F
 //------------------------------------------------------------------------------------------
+// decay factor of the camera/object motion per reference frame (see framescheduler.h)
 #define MOVING_INERTIA 0.9f
+#define MOVING_THRESHOLD 1e-4
 #define CUBE_MAP_SIZE 512
+#define CAMERA_FOVY 45.0f
+#define CAMERA_NEAR 0.1f
+#define CAMERA_FAR 10000.0f
 #define DEFAULT_CAMERA_POSITION QVector3D(-4.0f,  5.0f, 15.0f)
 #define DEFAULT_CAMERA_FOCUS QVector3D(-4.0f,  2.0f, 0.0f)
 #define DEFAULT_LIGHT_POSITION QVector3D(0.0f, 100.0f, 100.0f)
@@ -120,19 +150,54 @@ enum ShadingProgram
 {
     PHONG_SHADING = 0,
     BACKGROUND_SHADING,
+    INSTANCED_PHONG_SHADING,
     NUM_SHADING_MODE
 };
 
+// the built-in meshes in the geometry buffer, the scene meshes loaded from files follow
+enum GeometryMesh
+{
+    GEOMETRY_PLANE = 0,
+    GEOMETRY_CUBE,
+    GEOMETRY_SPHERE,
+    NUM_GEOMETRY_BUILTIN_MESHES
+};
+
+
+// a mesh imported from a file, in the geometry buffer
+struct SceneMeshGeometry
+{
+    int geometryMesh;
+    BoundingBox bounds;
+};
+
+// scene instances sharing their mesh, texture and probe, drawn by one instanced draw call
+struct InstanceBatch
+{
+    quint32 mesh;
+    quint32 texture;
+    int probeLayer;
+    int firstInstance; // in batchedInstances
+    int numInstances;
+    int firstVisible;  // in visibleInstances, for the pass being rendered
+    int numVisible;
+};
+
+// objects drawn and culled by one render pass
+struct CullingStatistics
+{
+    QString passName;
+    int numDrawn;
+    int numCulled;
+    int numOccluded; // by the occlusion queries of the previous frame
+};
 
 enum UBOBinding
 {
     BINDING_MATRICES = 0,
+    BINDING_CAMERA,
     BINDING_LIGHT,
-    BINDING_BACKGROUND_MATERIAL,
-    BINDING_FLOOR_MATERIAL,
-    BINDING_CUBE_MATERIAL,
-    BINDING_SEMIREFLECTIVE_SPHERE_MATERIAL,
-    BINDING_REFLECTIVE_SPHERE_MATERIAL,
+    BINDING_MATERIALS,
     NUM_BINDING_POINTS
 };
 
@@ -144,6 +209,32 @@ enum ReflectiveObjects
     INVALID_OBJECT
 };
 
+// the nodes of the transform store, the probes are children of their object
+enum TransformNode
+{
+    TRANSFORM_BACKGROUND = 0,
+    TRANSFORM_FLOOR,
+    TRANSFORM_CUBE,
+    TRANSFORM_SEMI_REFLECTIVE_SPHERE,
+    TRANSFORM_REFLECTIVE_SPHERE,
+    TRANSFORM_SEMI_REFLECTIVE_SPHERE_PROBE,
+    TRANSFORM_REFLECTIVE_SPHERE_PROBE,
+    NUM_TRANSFORM_NODES
+};
+
+// The floor and the background seen by a probe, color and depth, rendered again only when
+// the probe moves or they change. The updates of the probe copy it, then draw the moving
+// objects over it.
+struct ProbeStaticLayer
+{
+    QOpenGLTexture* color; // exported by the frame graph, NULL if not rendered
+    QOpenGLTexture* depth;
+    QVector3D position;    // of the probe when rendered
+};
+
+struct RayTracingScene;
+class SceneDescription;
+
 //------------------------------------------------------------------------------------------
 class Renderer : public QOpenGLWidget, QOpenGLFunctions_4_0_Core// QOpenGLFunctions
 {
@@ -178,6 +269,50 @@ public:
     void changeFloorTextureFilteringMode(QOpenGLTexture::Filter _textureFiltering);
     void changeSphereReflectionPercentage(int _reflectionPercentage);
     void changeCubeColor(float _r, float _g, float _b);
+    void requestRedraw(int _numFrames = 1);
+    void setContinuousRendering(bool _state);
+    bool saveGPUTimings(const QString& _fileName);
+
+    void initializeHeadless(QOpenGLContext* _context, QSurface* _surface, int _width,
+                            int _height);
+    void renderHeadlessFrame();
+    QImage grabHeadlessFrame();
+    bool isHeadless() const;
+    void setCamera(const QVector3D& _position, const QVector3D& _focus,
+                   const QVector3D& _upDirection);
+    void setObjectTransformation(const QMatrix4x4& _transformation);
+    void setTileProjection(int _tileX, int _tileY, int _tileWidth, int _tileHeight,
+                           int _imageWidth, int _imageHeight);
+    void freezeProbeUpdates(bool _state);
+    void setCubeMapSize(int _cubeMapSize);
+    int getCubeMapSize() const;
+    void setProbeUpdateInterval(int _numFrames);
+
+    bool startRecording(const QString& _fileName);
+    void stopRecording();
+    bool isRecording() const;
+    bool startReplay(const QString& _fileName, bool _quitWhenFinished = false);
+    bool isReplaying() const;
+
+    bool startCapture(const QString& _filePrefix, FrameCapture::Format _format);
+    void stopCapture();
+    bool isCapturing() const;
+    void captureProbeFaces(const QString& _filePrefix);
+
+    void getRayTracingScene(RayTracingScene& _scene) const;
+    bool loadStaticProbes(const QString& _directory);
+    void unloadStaticProbes();
+    bool isUsingStaticProbes() const;
+    bool loadScene(const QString& _fileName);
+    void enableFrustumCulling(bool _state);
+    void enableOcclusionCulling(bool _state);
+    void enableInstancing(bool _state);
+    void enableGPUCulling(bool _state);
+    void enableProbeFaceSkipping(bool _state);
+    int pickObject(int _x, int _y, float& _distance);
+    QString getObjectName(int _object) const;
+    QVector<CullingStatistics> getCullingStatistics() const;
+    bool checkGPUCulling();
 
 public slots:
     void enableDepthTest(bool _status);
@@ -189,6 +324,7 @@ public slots:
     void resetCameraPosition();
     void changePlaneSize(int _planeSize);
     void resetObjectPositions();
+    void enableGPUProfiler(bool _state);
 
 protected:
     void initializeGL();
@@ -198,27 +334,43 @@ protected:
     void mousePressEvent(QMouseEvent* _event);
     void mouseMoveEvent(QMouseEvent* _event);
     void mouseReleaseEvent(QMouseEvent* _event);
+    void mouseDoubleClickEvent(QMouseEvent* _event);
 
 private:
     void checkOpenGLVersion();
+    bool isRendererValid();
+    void makeRendererCurrent();
+    void doneRendererCurrent();
+    void bindTargetFramebuffer();
+    int getViewportWidth();
+    int getViewportHeight();
+    GLuint getTargetFramebuffer();
     bool initShaderPrograms();
     bool initProgram(ShadingProgram _shadingMode);
     bool initBackgroundShadingProgram();
+    bool initInstancedShadingProgram();
     void initRenderingData();
     void initSharedBlockUniform();
     void initTexture();
-    void initDynamicCubeMapBufferObject();
+    QOpenGLTexture* loadCubeMapTexture(const QString& _directory);
     void initSceneMemory();
     void initPlaneMemory();
     void initCubeMemory();
     void initSphereMemory();
-    void initVertexArrayObjects();
-    void initPlaneVAO(ShadingProgram _shadingMode);
-    void initCubeVAO(ShadingProgram _shadingMode);
-    void initSphereVAO(ShadingProgram _shadingMode);
     void initSceneMatrices();
-
+    void uploadMaterial(int _index, const Material& _material);
+    void uploadMaterials();
+
+    bool isAnimating();
+    void processInputEvent(const InputEvent& _event);
+    bool acceptInputEvent(const InputEvent& _event);
+    void applyInputEvent(const InputEvent& _event);
+    InputSessionState getSessionState();
+    void restoreSessionState(const InputSessionState& _state);
+    void replayInputEvents();
+    void stopReplay();
     void updateCamera();
+    void uploadCamera();
     void translateCamera();
     void rotateCamera();
     void zoomCamera();
@@ -226,15 +378,46 @@ private:
     void translateObjects();
     void rotateObjects();
 
-    void createDynamicCubeMapTexture(ReflectiveObjects _object);
-    void createObjectCubeMapTextures();
-
-    void renderScene(ReflectiveObjects _hiddenObj = INVALID_OBJECT);
+    QMatrix4x4 setProbeFaceCamera(ReflectiveObjects _object, int _face);
+    QString getProbeFaceName(ReflectiveObjects _object, int _face) const;
+    void createProbeStaticLayer(ReflectiveObjects _object, int _color, int _depth,
+                                int _framebuffer);
+    void createDynamicCubeMapTexture(ReflectiveObjects _object, int _cubeMap,
+                                     int _depthBuffer, int _framebuffer,
+                                     int _staticFramebuffer, int _faces);
+    int getVisibleProbeFaces(ReflectiveObjects _object);
+    bool beginProbeUpdate();
+    void buildFrameGraph();
+    void moveSceneAndCamera();
+    void renderMainView();
+    void keepProbeUpdates();
+    void releaseProbeHistory();
+    void releaseProbeStaticLayers();
+    void uploadStaticProbes();
+    void writeProbeFaces(const QString& _filePrefix);
+    void applySceneDescription();
+    void loadSceneMeshes();
+    void buildSceneBVH();
+    bool assignInstanceProbes();
+    void buildInstanceBatches();
+    void buildIndirectDraws();
+    void updateTransforms();
+    void recordRenderList();
+    quint64 getRenderKey(const RenderCommand& _command) const;
+    void cullScene(const QMatrix4x4& _viewProjection, const QString& _passName);
+
+    void renderScene(ReflectiveObjects _hiddenObj = INVALID_OBJECT,
+                     int _layers = RENDER_ALL_LAYERS);
     void renderBackground();
-    void renderFloor();
-    void renderCube();
-    void renderSemireflectiveSphere();
-    void renderReflectiveSphere();
+    void replayRenderList(ReflectiveObjects _hiddenObj, int _layers, bool _testOcclusion);
+    void renderInstanceBatches();
+    void renderIndirectInstanceBatches();
+    QOpenGLShaderProgram* beginInstancedShading(GLuint _instances);
+    void endInstancedShading();
+    QOpenGLTexture* getProbeTexture(int _probeLayer);
+    int getGeometryMesh(quint32 _sceneMesh) const;
+    bool beginOcclusionTest(int _object);
+    void renderOverlay();
 
     QOpenGLTexture* floorTextures[NUM_FLOOR_TEXTURES];
     QOpenGLTexture* sphereTexture;
@@ -246,44 +429,48 @@ private:
     UnitSphere* sphereObject;
     int sphereNumStacks;
     int sphereNumSlices;
+    int planeSize;
+    int initialPlaneSize;
 
     QOpenGLTexture* objEnvTexture[NUM_REFLECTIVE_OBJECTS];
-    QOpenGLTexture* objEnvTextureBuffer1[NUM_REFLECTIVE_OBJECTS];
-    QOpenGLTexture* objEnvTextureBuffer2[NUM_REFLECTIVE_OBJECTS];
-    QOpenGLFramebufferObject* FBOCubeMap;
+    QOpenGLTexture* objEnvTextureHistory[NUM_REFLECTIVE_OBJECTS]; // the latest updates
+    int probeCubeMaps[NUM_REFLECTIVE_OBJECTS]; // updated by this frame, in the frame graph
+    ProbeStaticLayer probeStaticLayers[NUM_REFLECTIVE_OBJECTS];
+    bool probeStaticLayersChanged; // the floor or the background changed since rendered
+    QOpenGLTexture* staticProbeTextures[NUM_REFLECTIVE_OBJECTS];
+    QVector<QImage> staticProbeFaces; // loaded, not yet uploaded
+    bool useStaticProbes;
+    FrameGraph frameGraph;
+    int cubeMapSize;
+    int probeUpdateInterval;
+    bool enabledProbeFaceSkipping;
+    int numFramesSinceProbeUpdate;
 
     QMap<ShadingProgram, QString> vertexShaderSourceMap;
     QMap<ShadingProgram, QString> fragmentShaderSourceMap;
     QOpenGLShaderProgram* glslPrograms[NUM_SHADING_MODE];
     QOpenGLShaderProgram* currentProgram;
     GLuint UBOBindingIndex[NUM_BINDING_POINTS];
-    GLuint UBOMatrices;
+    GLuint UBOMatrices; // the background and the occlusion boxes, see renderList
+    GLuint UBOCamera;
     GLuint UBOLight;
-    GLuint UBOPlaneMaterial;
-    GLuint UBOCubeMaterial;
-    GLuint UBOSemireflectiveSphereMaterial;
-    GLuint UBOReflectiveSphereMaterial;
-    GLint attrVertex[NUM_SHADING_MODE];
-    GLint attrNormal[NUM_SHADING_MODE];
-    GLint attrTexCoord[NUM_SHADING_MODE];
+    UniformShadowBuffer materialBuffer;
 
     GLint uniMatrices[NUM_SHADING_MODE];
+    GLint uniCamera[NUM_SHADING_MODE];
     GLint uniCameraPosition[NUM_SHADING_MODE];
     GLint uniLight[NUM_SHADING_MODE];
-    GLint uniMaterial[NUM_SHADING_MODE];
+    GLint uniMaterials[NUM_SHADING_MODE];
+    GLint uniMaterialIndex[NUM_SHADING_MODE];
     GLint uniObjTexture[NUM_SHADING_MODE];
     GLint uniEnvTexture[NUM_SHADING_MODE];
     GLint uniHasObjTexture[NUM_SHADING_MODE];
+    GLint uniInstanceData;     // INSTANCED_PHONG_SHADING only
+    GLint uniInstanceIndices;  // INSTANCED_PHONG_SHADING only
+    GLint uniMaxMaterialIndex; // INSTANCED_PHONG_SHADING only
 
-    QOpenGLVertexArrayObject vaoPlane[NUM_SHADING_MODE];
-    QOpenGLVertexArrayObject vaoCube[NUM_SHADING_MODE];
-    QOpenGLVertexArrayObject vaoSphere[NUM_SHADING_MODE];
-    QOpenGLBuffer vboPlane;
-    QOpenGLBuffer vboCube;
-    QOpenGLBuffer vboSphere;
-    QOpenGLBuffer iboPlane;
-    QOpenGLBuffer iboSphere;
-    QOpenGLBuffer iboCube;
+    GeometryBuffer geometry;
+    RenderList renderList;
 
     Material planeMaterial;
     Material cubeMaterial;
@@ -295,21 +482,81 @@ private:
     QMatrix4x4 viewMatrix;
     QMatrix4x4 projectionMatrix;
     QMatrix4x4 viewProjectionMatrix;
-    QMatrix4x4 backgroundCubeModelMatrix;
-    QMatrix4x4 planeModelMatrix;
-    QMatrix4x4 planeNormalMatrix;
-    QMatrix4x4 cubeModelMatrix;
-    QMatrix4x4 cubeNormalMatrix;
-    QMatrix4x4 semiReflectiveSphereModelMatrix;
-    QMatrix4x4 semiReflectiveSphereNormalMatrix;
-    QMatrix4x4 reflectiveSphereModelMatrix;
-    QMatrix4x4 reflectiveSphereNormalMatrix;
-    QMap<ReflectiveObjects, QVector3D> reflectiveObject2LocationMap;
-    QMap<ReflectiveObjects, QMatrix4x4> reflectiveObject2ModelMatrixMap;
+    TransformStore transforms;
+    QMatrix4x4 cubeInitialModelMatrix;
+    QMatrix4x4 semiReflectiveSphereInitialModelMatrix;
+    QMatrix4x4 reflectiveSphereInitialModelMatrix;
+    QVector3D probeOffsets[NUM_REFLECTIVE_OBJECTS]; // probe position in object space
+
+    SceneDescription* sceneDescription;
+    bool sceneChanged;
+    QVector<QOpenGLTexture*> sceneTextures;
+    QOpenGLTexture* builtinSceneTextures[NUM_SCENE_BUILTIN_OBJECTS]; // NULL: its own
+    QMap<QString, QOpenGLTexture*> sceneTextureCache;
+    QOpenGLTexture* sceneEnvTexture;
+    QVector<int> sceneInstances; // the instances added to the built-in objects
+    QVector<SceneMeshGeometry*> sceneMeshes; // per scene mesh, NULL if not a file
+    GLuint sceneInstanceBuffer;
+    GLuint sceneInstanceTexture;      // buffer texture over sceneInstanceBuffer, as floats
+    GLuint sceneInstanceIndexTexture; // the same, as unsigned integers
+    QVector<int> instanceProbeLayers; // per scene instance, in the order of sceneInstances
+    QVector3D instanceProbePositions[NUM_REFLECTIVE_OBJECTS]; // when last assigned
+    int numProbeInstances[NUM_REFLECTIVE_OBJECTS]; // the instances reflecting each probe
+
+    // the scene instances sorted by batch (their positions in sceneInstances), and the
+    // indices of the visible ones, read by the instanced draws
+    QVector<InstanceBatch> instanceBatches;
+    QVector<int> batchedInstances;
+    QVector<GLuint> visibleInstances;
+    GLuint visibleInstanceBuffer;
+    bool enabledInstancing;
+    GPUCuller gpuCuller;
+    bool indirectDrawsChanged; // the batches or the geometry ranges changed
+    bool renderListChanged;    // an input of the render list changed since recorded
+
+    // the materials of the built-in objects in the order of SceneBuiltinObject, then the
+    // scene materials
+    int numMaterials;
+
+    // objects 0 to NUM_SCENE_BUILTIN_OBJECTS - 1 are the built-in objects, then the
+    // scene instances in the order of sceneInstances
+    SceneBVH sceneBVH;
+    QVector<uchar> visibleObjects; // of the pass being rendered
+    Frustum cullingFrustum;        // of the pass being rendered
+    QVector<CullingStatistics> cullingStatistics; // of the last frame
+    bool enabledFrustumCulling;
+    OcclusionCuller occlusionCuller;
+
+    FrameScheduler frameScheduler;
+    float frameTime;
+    GPUProfiler gpuProfiler;
+    FrameCapture frameCapture;
+
+    QOpenGLContext* headlessContext;
+    QSurface* headlessSurface;
+    QOpenGLFramebufferObject* headlessFBO;
+    bool paintingFrame;
+    int numContextSwitches;      // outside of paintGL, since the beginning of the frame
+    int numFrameContextSwitches; // between the last two frames
+    int numFrameUploadBytes;     // uniform data flushed by the last frame
+    int numDrawCalls;            // of the frame being rendered
+    int numProgramSwitches;      // of the frame being rendered
+    int numTextureSwitches;      // of the frame being rendered
+    int numProbeFaces;           // updated by the frame being rendered
+    int numSkippedProbeFaces;    // copied from the static layer only
+
+    InputRecorder inputRecorder;
+    QString pendingRecordingFile;
+    QString pendingProbeCaptureFile; // written after the probe update of the next frame
+    InputReplayer* inputReplayer;
+    int numReplayedFrames;
+    QElapsedTimer replayTimer;
+    bool quitAfterReplay;
 
     qreal retinaScale;
     float zooming;
     QVector3D cameraPosition;
+    QVector3D eyePosition; // of the pass being rendered, the camera or a probe
     QVector3D cameraFocus;
     QVector3D cameraUpDirection;
 
@@ -324,12 +571,15 @@ private:
 
     ShadingProgram shadingMode;
     FloorTexture floorTexture;
+    QOpenGLTexture::Filter floorTextureFiltering;
+    bool enabledDepthTest;
     bool enabledZAxisRotation;
     bool enabledObjectTransformation;
     bool enabledDynamicEnvMapping;
     bool enabledBackgroundRendering;
     bool enabledTextureAnisotropicFiltering;
     bool useGlobalEnvTexture;
+    bool frozenProbes;
 };
 
 #endif // GLRENDERER_H
@@ -0,0 +1,165 @@
+//------------------------------------------------------------------------------------------
+// renderlist.cpp
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#include "renderlist.h"
+#include "cpuprofiler.h"
+
+//------------------------------------------------------------------------------------------
+// the fields are truncated to their number of bits
+//------------------------------------------------------------------------------------------
+quint64 makeRenderKey(int _pass, int _program, int _vao, GLuint _texture, int _probe,
+                      int _depthBucket)
+{
+    return ((quint64)(_pass & 0xF) << RENDER_KEY_PASS_SHIFT) |
+           ((quint64)(_program & 0xFF) << RENDER_KEY_PROGRAM_SHIFT) |
+           ((quint64)(_vao & 0xFF) << RENDER_KEY_VAO_SHIFT) |
+           ((quint64)(_texture & 0xFFFF) << RENDER_KEY_TEXTURE_SHIFT) |
+           ((quint64)(_probe & 0xFFF) << RENDER_KEY_PROBE_SHIFT) |
+           (quint64)qBound(0, _depthBucket, RENDER_KEY_NUM_DEPTH_BUCKETS - 1);
+}
+
+//------------------------------------------------------------------------------------------
+RenderList::RenderList():
+    glFuncs(NULL),
+    transformBuffer(0),
+    transformStride(RENDER_LIST_TRANSFORM_SIZE)
+{
+}
+
+//------------------------------------------------------------------------------------------
+void RenderList::initialize(QOpenGLFunctions_4_0_Core* _glFuncs)
+{
+    destroy();
+
+    glFuncs = _glFuncs;
+    glFuncs->glGenBuffers(1, &transformBuffer);
+
+    // the slots are bound with glBindBufferRange, their offsets must be aligned
+    GLint alignment;
+    glFuncs->glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    alignment = qMax(alignment, 1);
+    int size = (int)RENDER_LIST_TRANSFORM_SIZE;
+    transformStride = ((size + alignment - 1) / alignment) * alignment;
+}
+
+//------------------------------------------------------------------------------------------
+void RenderList::destroy()
+{
+    if(transformBuffer != 0)
+    {
+        glFuncs->glDeleteBuffers(1, &transformBuffer);
+        transformBuffer = 0;
+    }
+}
+
+//------------------------------------------------------------------------------------------
+void RenderList::clear()
+{
+    commands.resize(0);
+    transforms.resize(0);
+}
+
+//------------------------------------------------------------------------------------------
+int RenderList::addTransform(const GLfloat* _matrices)
+{
+    int slot = transforms.size() / transformStride;
+    transforms.resize((slot + 1) * transformStride);
+    memcpy(transforms.data() + slot * transformStride, _matrices,
+           RENDER_LIST_TRANSFORM_SIZE);
+
+    return slot;
+}
+
+//------------------------------------------------------------------------------------------
+void RenderList::addCommand(const RenderCommand& _command)
+{
+    commands.append(_command);
+}
+
+//------------------------------------------------------------------------------------------
+// Stable LSD radix sort of the commands by their key, one byte per pass. The passes where
+// all the keys have the same byte are skipped: most of the key is constant in practice.
+// The transform slots are not moved, the commands keep their slot index.
+//------------------------------------------------------------------------------------------
+void RenderList::sort()
+{
+    int numCommands = commands.size();
+
+    if(numCommands < 2)
+    {
+        return;
+    }
+
+    PROFILE_ZONE("RenderList::sort");
+
+    sortedCommands.resize(numCommands);
+
+    for(int shift = 0; shift < 64; shift += 8)
+    {
+        int offsets[257] = {0};
+
+        for(int i = 0; i < numCommands; ++i)
+        {
+            ++offsets[((commands[i].sortKey >> shift) & 0xFF) + 1];
+        }
+
+        if(offsets[((commands[0].sortKey >> shift) & 0xFF) + 1] == numCommands)
+        {
+            continue;
+        }
+
+        for(int i = 0; i < 256; ++i)
+        {
+            offsets[i + 1] += offsets[i];
+        }
+
+        for(int i = 0; i < numCommands; ++i)
+        {
+            sortedCommands[offsets[(commands[i].sortKey >> shift) & 0xFF]++] = commands[i];
+        }
+
+        commands.swap(sortedCommands);
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// all the slots in one glBufferData
+//------------------------------------------------------------------------------------------
+void RenderList::upload()
+{
+    if(transforms.isEmpty())
+    {
+        return;
+    }
+
+    PROFILE_ZONE("RenderList::upload");
+
+    glFuncs->glBindBuffer(GL_UNIFORM_BUFFER, transformBuffer);
+    glFuncs->glBufferData(GL_UNIFORM_BUFFER, transforms.size(), transforms.constData(),
+                          GL_STREAM_DRAW);
+    glFuncs->glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+//------------------------------------------------------------------------------------------
+int RenderList::size() const
+{
+    return commands.size();
+}
+
+//------------------------------------------------------------------------------------------
+const RenderCommand& RenderList::getCommand(int _index) const
+{
+    return commands[_index];
+}
+
+//------------------------------------------------------------------------------------------
+void RenderList::bindTransform(GLuint _bindingPoint, int _slot)
+{
+    glFuncs->glBindBufferRange(GL_UNIFORM_BUFFER, _bindingPoint, transformBuffer,
+                               _slot * transformStride, RENDER_LIST_TRANSFORM_SIZE);
+}
@@ -0,0 +1,101 @@
+//------------------------------------------------------------------------------------------
+// renderlist.h
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#ifndef RENDERLIST_H
+#define RENDERLIST_H
+
+#include <QtGui>
+#include <QOpenGLFunctions_4_0_Core>
+
+//------------------------------------------------------------------------------------------
+// the model and normal matrices of a draw
+#define RENDER_LIST_TRANSFORM_SIZE (2 * 4 * 4 * sizeof(GLfloat))
+
+// The sort key of a draw, from the most significant bits: pass (4), program (8), vertex
+// array object (8), object texture (16), probe cube map (12) and depth bucket (16). The
+// draws sharing their state are consecutive, front to back.
+#define RENDER_KEY_PASS_SHIFT 60
+#define RENDER_KEY_PROGRAM_SHIFT 52
+#define RENDER_KEY_VAO_SHIFT 44
+#define RENDER_KEY_TEXTURE_SHIFT 28
+#define RENDER_KEY_PROBE_SHIFT 16
+#define RENDER_KEY_NUM_DEPTH_BUCKETS 65536
+
+enum RenderListPass
+{
+    RENDER_PASS_OCCLUDERS = 0, // drawn first, they fill the depth buffer
+    RENDER_PASS_OCCLUDEES,     // tested by the occlusion queries in the main view
+    NUM_RENDER_PASSES
+};
+
+// the static layer (the floor and the background) never moves, the probes cache it
+enum RenderLayer
+{
+    RENDER_LAYER_STATIC = 1,
+    RENDER_LAYER_DYNAMIC = 2,
+    RENDER_ALL_LAYERS = RENDER_LAYER_STATIC | RENDER_LAYER_DYNAMIC
+};
+
+// one draw of the list, with the current program and the vertex array object of the
+// geometry buffer
+struct RenderCommand
+{
+    quint64 sortKey;
+    int object;              // in the scene BVH, for the visibility of the pass
+    int layer;               // RenderLayer
+    int hiddenInProbe;       // the probe which does not see the object, -1 if none
+    int geometryMesh;
+    int materialIndex;
+    int transformSlot;
+    QOpenGLTexture* texture; // NULL if not textured
+    int probeLayer;          // the cube map it reflects
+    bool testOcclusion;      // in the main view
+};
+
+quint64 makeRenderKey(int _pass, int _program, int _vao, GLuint _texture, int _probe,
+                      int _depthBucket);
+
+//------------------------------------------------------------------------------------------
+// The draws of a frame, recorded once and replayed by every pass which sees the same
+// objects (the cube map faces and the main view).
+// The model and normal matrices of all the draws are uploaded together into one uniform
+// buffer, one slot per draw: replaying a draw binds the range of its slot instead of
+// uploading its matrices. The view-projection matrix lives in its own uniform buffer, it
+// is the only data written between two replays.
+// Before the replays, the commands are sorted by state with a radix sort on their keys.
+//------------------------------------------------------------------------------------------
+class RenderList
+{
+public:
+    RenderList();
+
+    void initialize(QOpenGLFunctions_4_0_Core* _glFuncs);
+    void destroy();
+
+    void clear();
+    // the model and normal matrices, contiguous, returns the slot
+    int addTransform(const GLfloat* _matrices);
+    void addCommand(const RenderCommand& _command);
+    void sort();
+    void upload();
+
+    int size() const;
+    const RenderCommand& getCommand(int _index) const;
+    void bindTransform(GLuint _bindingPoint, int _slot);
+
+private:
+    QOpenGLFunctions_4_0_Core* glFuncs;
+    GLuint transformBuffer;
+    int transformStride;     // aligned to the uniform buffer offset alignment
+
+    QVector<RenderCommand> commands;
+    QVector<RenderCommand> sortedCommands; // scratch of the radix sort
+    QByteArray transforms;
+};
+
+#endif // RENDERLIST_H
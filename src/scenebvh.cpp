@@ -0,0 +1,594 @@
+//------------------------------------------------------------------------------------------
+// scenebvh.cpp
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#include <algorithm>
+
+#include "scenebvh.h"
+#include "cpuprofiler.h"
+
+//------------------------------------------------------------------------------------------
+// 0: outside, 1: intersecting, 2: inside
+//------------------------------------------------------------------------------------------
+static int classifyBox(const Frustum& _frustum, const BoundingBox& _box)
+{
+    int result = 2;
+
+    for(int i = 0; i < 6; ++i)
+    {
+        const QVector4D& plane = _frustum.planes[i];
+
+        // the corners the farthest along and against the plane normal
+        QVector3D positive(plane.x() >= 0.0f ? _box.boxMax.x() : _box.boxMin.x(),
+                           plane.y() >= 0.0f ? _box.boxMax.y() : _box.boxMin.y(),
+                           plane.z() >= 0.0f ? _box.boxMax.z() : _box.boxMin.z());
+        QVector3D negative(plane.x() >= 0.0f ? _box.boxMin.x() : _box.boxMax.x(),
+                           plane.y() >= 0.0f ? _box.boxMin.y() : _box.boxMax.y(),
+                           plane.z() >= 0.0f ? _box.boxMin.z() : _box.boxMax.z());
+
+        if(QVector3D::dotProduct(plane.toVector3D(), positive) + plane.w() < 0.0f)
+        {
+            return 0;
+        }
+
+        if(QVector3D::dotProduct(plane.toVector3D(), negative) + plane.w() < 0.0f)
+        {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+//------------------------------------------------------------------------------------------
+// slab test, the entry distance if the ray hits the box before _maxDistance
+//------------------------------------------------------------------------------------------
+static bool intersectRay(const BoundingBox& _box, const QVector3D& _origin,
+                         const QVector3D& _invDirection, float _maxDistance,
+                         float& _distance)
+{
+    float tMin = 0.0f;
+    float tMax = _maxDistance;
+
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        float t0 = (_box.boxMin[axis] - _origin[axis]) * _invDirection[axis];
+        float t1 = (_box.boxMax[axis] - _origin[axis]) * _invDirection[axis];
+
+        if(t0 > t1)
+        {
+            qSwap(t0, t1);
+        }
+
+        tMin = qMax(tMin, t0);
+        tMax = qMin(tMax, t1);
+
+        if(tMin > tMax)
+        {
+            return false;
+        }
+    }
+
+    _distance = tMin;
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+bool BoundingBox::isEmpty() const
+{
+    return (boxMin.x() > boxMax.x() || boxMin.y() > boxMax.y() || boxMin.z() > boxMax.z());
+}
+
+//------------------------------------------------------------------------------------------
+void BoundingBox::expand(const QVector3D& _point)
+{
+    boxMin = QVector3D(qMin(boxMin.x(), _point.x()), qMin(boxMin.y(), _point.y()),
+                       qMin(boxMin.z(), _point.z()));
+    boxMax = QVector3D(qMax(boxMax.x(), _point.x()), qMax(boxMax.y(), _point.y()),
+                       qMax(boxMax.z(), _point.z()));
+}
+
+//------------------------------------------------------------------------------------------
+void BoundingBox::expand(const BoundingBox& _box)
+{
+    if(_box.isEmpty())
+    {
+        return;
+    }
+
+    expand(_box.boxMin);
+    expand(_box.boxMax);
+}
+
+//------------------------------------------------------------------------------------------
+QVector3D BoundingBox::getCenter() const
+{
+    return (boxMin + boxMax) * 0.5f;
+}
+
+//------------------------------------------------------------------------------------------
+float BoundingBox::getSurfaceArea() const
+{
+    if(isEmpty())
+    {
+        return 0.0f;
+    }
+
+    QVector3D size = boxMax - boxMin;
+
+    return 2.0f * (size.x() * size.y() + size.y() * size.z() + size.z() * size.x());
+}
+
+//------------------------------------------------------------------------------------------
+bool BoundingBox::intersects(const BoundingBox& _box) const
+{
+    return (boxMin.x() <= _box.boxMax.x() && boxMax.x() >= _box.boxMin.x() &&
+            boxMin.y() <= _box.boxMax.y() && boxMax.y() >= _box.boxMin.y() &&
+            boxMin.z() <= _box.boxMax.z() && boxMax.z() >= _box.boxMin.z());
+}
+
+//------------------------------------------------------------------------------------------
+// the box of the 8 transformed corners
+//------------------------------------------------------------------------------------------
+BoundingBox BoundingBox::transformed(const QMatrix4x4& _matrix) const
+{
+    BoundingBox box;
+
+    if(isEmpty())
+    {
+        return box;
+    }
+
+    for(int i = 0; i < 8; ++i)
+    {
+        QVector3D corner((i & 1) ? boxMax.x() : boxMin.x(),
+                         (i & 2) ? boxMax.y() : boxMin.y(),
+                         (i & 4) ? boxMax.z() : boxMin.z());
+        box.expand(_matrix * corner);
+    }
+
+    return box;
+}
+
+//------------------------------------------------------------------------------------------
+// Gribb-Hartmann: the planes are sums of the rows of the matrix
+//------------------------------------------------------------------------------------------
+Frustum::Frustum(const QMatrix4x4& _viewProjection)
+{
+    QVector4D rows[4];
+
+    for(int i = 0; i < 4; ++i)
+    {
+        rows[i] = _viewProjection.row(i);
+    }
+
+    planes[0] = rows[3] + rows[0]; // left
+    planes[1] = rows[3] - rows[0]; // right
+    planes[2] = rows[3] + rows[1]; // bottom
+    planes[3] = rows[3] - rows[1]; // top
+    planes[4] = rows[3] + rows[2]; // near
+    planes[5] = rows[3] - rows[2]; // far
+}
+
+//------------------------------------------------------------------------------------------
+SceneBVH::SceneBVH():
+    builtSurfaceArea(0.0f)
+{
+}
+
+//------------------------------------------------------------------------------------------
+void SceneBVH::clear()
+{
+    nodes.clear();
+    objectIndices.clear();
+    localBounds.clear();
+    worldBounds.clear();
+    objectLeaves.clear();
+    dirtyLeaves.clear();
+    dirtyLeafFlags.clear();
+    builtSurfaceArea = 0.0f;
+}
+
+//------------------------------------------------------------------------------------------
+// the object is part of the tree after the next build()
+//------------------------------------------------------------------------------------------
+int SceneBVH::addObject(const BoundingBox& _localBounds, const QMatrix4x4& _modelMatrix)
+{
+    localBounds.append(_localBounds);
+    worldBounds.append(_localBounds.transformed(_modelMatrix));
+    objectLeaves.append(-1);
+
+    return localBounds.size() - 1;
+}
+
+//------------------------------------------------------------------------------------------
+// the nodes above the object are refitted by the next refit()
+//------------------------------------------------------------------------------------------
+void SceneBVH::updateObject(int _object, const QMatrix4x4& _modelMatrix)
+{
+    if(_object < 0 || _object >= localBounds.size())
+    {
+        return;
+    }
+
+    worldBounds[_object] = localBounds[_object].transformed(_modelMatrix);
+    int leaf = objectLeaves[_object];
+
+    if(leaf >= 0 && !dirtyLeafFlags[leaf])
+    {
+        dirtyLeafFlags[leaf] = 1;
+        dirtyLeaves.append(leaf);
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// top-down, median split of the centroids along the largest axis
+//------------------------------------------------------------------------------------------
+void SceneBVH::build()
+{
+    PROFILE_ZONE("SceneBVH::build");
+
+    nodes.clear();
+    dirtyLeaves.clear();
+    objectIndices.resize(localBounds.size());
+
+    for(int i = 0; i < objectIndices.size(); ++i)
+    {
+        objectIndices[i] = i;
+    }
+
+    if(!objectIndices.isEmpty())
+    {
+        nodes.reserve(2 * (objectIndices.size() / BVH_MAX_LEAF_SIZE + 1));
+        nodes.append(Node());
+        nodes[0].parent = -1;
+        subdivide(0, 0, objectIndices.size());
+    }
+
+    dirtyLeafFlags.fill(0, nodes.size());
+    builtSurfaceArea = nodes.isEmpty() ? 0.0f : nodes[0].bounds.getSurfaceArea();
+}
+
+//------------------------------------------------------------------------------------------
+// bottom-up from the moved objects, stopping where the bounds do not change
+//------------------------------------------------------------------------------------------
+void SceneBVH::refit()
+{
+    if(dirtyLeaves.isEmpty())
+    {
+        return;
+    }
+
+    PROFILE_ZONE("SceneBVH::refit");
+
+    for(int i = 0; i < dirtyLeaves.size(); ++i)
+    {
+        int node = dirtyLeaves[i];
+        dirtyLeafFlags[node] = 0;
+
+        while(node >= 0)
+        {
+            BoundingBox oldBounds = nodes[node].bounds;
+            updateNodeBounds(node);
+
+            if(nodes[node].bounds.boxMin == oldBounds.boxMin &&
+               nodes[node].bounds.boxMax == oldBounds.boxMax)
+            {
+                break;
+            }
+
+            node = nodes[node].parent;
+        }
+    }
+
+    dirtyLeaves.clear();
+
+    if(nodes[0].bounds.getSurfaceArea() > BVH_REBUILD_RATIO * builtSurfaceArea)
+    {
+        build();
+    }
+}
+
+//------------------------------------------------------------------------------------------
+int SceneBVH::getNumObjects() const
+{
+    return localBounds.size();
+}
+
+//------------------------------------------------------------------------------------------
+int SceneBVH::getNumNodes() const
+{
+    return nodes.size();
+}
+
+//------------------------------------------------------------------------------------------
+const BoundingBox& SceneBVH::getObjectBounds(int _object) const
+{
+    return worldBounds[_object];
+}
+
+//------------------------------------------------------------------------------------------
+// the subtrees fully inside the frustum are accepted without testing their objects
+//------------------------------------------------------------------------------------------
+int SceneBVH::cullFrustum(const Frustum& _frustum, QVector<uchar>& _visible) const
+{
+    _visible.fill(0, localBounds.size());
+
+    if(nodes.isEmpty())
+    {
+        return 0;
+    }
+
+    int numVisible = 0;
+    QVarLengthArray<int, 64> stack;
+    stack.append(0);
+
+    while(!stack.isEmpty())
+    {
+        int nodeIndex = stack.last();
+        stack.removeLast();
+
+        const Node& node = nodes[nodeIndex];
+        int classification = classifyBox(_frustum, node.bounds);
+
+        if(classification == 0)
+        {
+            continue;
+        }
+
+        if(classification == 2)
+        {
+            collectObjects(nodeIndex, _visible, numVisible);
+        }
+        else if(node.count > 0)
+        {
+            for(int i = node.first; i < node.first + node.count; ++i)
+            {
+                int object = objectIndices[i];
+
+                if(classifyBox(_frustum, worldBounds[object]) != 0)
+                {
+                    _visible[object] = 1;
+                    ++numVisible;
+                }
+            }
+        }
+        else
+        {
+            stack.append(node.first);
+            stack.append(node.first + 1);
+        }
+    }
+
+    return numVisible;
+}
+
+//------------------------------------------------------------------------------------------
+int SceneBVH::cullFirstObjects(const Frustum& _frustum, int _numObjects,
+                               QVector<uchar>& _visible) const
+{
+    _visible.fill(0, localBounds.size());
+    int numVisible = 0;
+
+    for(int i = 0; i < qMin(_numObjects, localBounds.size()); ++i)
+    {
+        if(classifyBox(_frustum, worldBounds[i]) != 0)
+        {
+            _visible[i] = 1;
+            ++numVisible;
+        }
+    }
+
+    return numVisible;
+}
+
+//------------------------------------------------------------------------------------------
+// the closest object whose bounds are hit by the ray, -1 if none
+//------------------------------------------------------------------------------------------
+int SceneBVH::pickRay(const QVector3D& _origin, const QVector3D& _direction,
+                      float& _distance) const
+{
+    int closestObject = -1;
+    _distance = FLT_MAX;
+
+    if(nodes.isEmpty())
+    {
+        return -1;
+    }
+
+    QVector3D invDirection(1.0f / _direction.x(), 1.0f / _direction.y(),
+                           1.0f / _direction.z());
+    QVarLengthArray<int, 64> stack;
+    stack.append(0);
+
+    while(!stack.isEmpty())
+    {
+        const Node& node = nodes[stack.last()];
+        stack.removeLast();
+
+        float distance;
+
+        if(!intersectRay(node.bounds, _origin, invDirection, _distance, distance))
+        {
+            continue;
+        }
+
+        if(node.count == 0)
+        {
+            stack.append(node.first);
+            stack.append(node.first + 1);
+            continue;
+        }
+
+        for(int i = node.first; i < node.first + node.count; ++i)
+        {
+            int object = objectIndices[i];
+
+            if(intersectRay(worldBounds[object], _origin, invDirection, _distance,
+                            distance))
+            {
+                _distance = distance;
+                closestObject = object;
+            }
+        }
+    }
+
+    return closestObject;
+}
+
+//------------------------------------------------------------------------------------------
+void SceneBVH::queryBox(const BoundingBox& _box, QVector<int>& _objects) const
+{
+    _objects.clear();
+
+    if(nodes.isEmpty())
+    {
+        return;
+    }
+
+    QVarLengthArray<int, 64> stack;
+    stack.append(0);
+
+    while(!stack.isEmpty())
+    {
+        const Node& node = nodes[stack.last()];
+        stack.removeLast();
+
+        if(!node.bounds.intersects(_box))
+        {
+            continue;
+        }
+
+        if(node.count == 0)
+        {
+            stack.append(node.first);
+            stack.append(node.first + 1);
+            continue;
+        }
+
+        for(int i = node.first; i < node.first + node.count; ++i)
+        {
+            if(worldBounds[objectIndices[i]].intersects(_box))
+            {
+                _objects.append(objectIndices[i]);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// the objects whose bounds are closer than _radius to _center
+//------------------------------------------------------------------------------------------
+void SceneBVH::querySphere(const QVector3D& _center, float _radius,
+                           QVector<int>& _objects) const
+{
+    QVector3D extent(_radius, _radius, _radius);
+    queryBox(BoundingBox(_center - extent, _center + extent), _objects);
+
+    for(int i = _objects.size() - 1; i >= 0; --i)
+    {
+        const BoundingBox& box = worldBounds[_objects[i]];
+        QVector3D closest(qBound(box.boxMin.x(), _center.x(), box.boxMax.x()),
+                          qBound(box.boxMin.y(), _center.y(), box.boxMax.y()),
+                          qBound(box.boxMin.z(), _center.z(), box.boxMax.z()));
+
+        if((closest - _center).lengthSquared() > _radius * _radius)
+        {
+            _objects.remove(i);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// the children of a node are allocated together, the right one follows the left one
+//------------------------------------------------------------------------------------------
+void SceneBVH::subdivide(int _node, int _begin, int _end)
+{
+    BoundingBox centroidBounds;
+
+    for(int i = _begin; i < _end; ++i)
+    {
+        nodes[_node].bounds.expand(worldBounds[objectIndices[i]]);
+        centroidBounds.expand(worldBounds[objectIndices[i]].getCenter());
+    }
+
+    if(_end - _begin <= BVH_MAX_LEAF_SIZE)
+    {
+        nodes[_node].first = _begin;
+        nodes[_node].count = _end - _begin;
+
+        for(int i = _begin; i < _end; ++i)
+        {
+            objectLeaves[objectIndices[i]] = _node;
+        }
+
+        return;
+    }
+
+    QVector3D size = centroidBounds.boxMax - centroidBounds.boxMin;
+    int axis = (size.x() > size.y()) ? ((size.x() > size.z()) ? 0 : 2) :
+               ((size.y() > size.z()) ? 1 : 2);
+    int middle = (_begin + _end) / 2;
+    const QVector<BoundingBox>& bounds = worldBounds;
+
+    std::nth_element(objectIndices.begin() + _begin, objectIndices.begin() + middle,
+                     objectIndices.begin() + _end, [&](int _a, int _b)
+    {
+        return bounds[_a].getCenter()[axis] < bounds[_b].getCenter()[axis];
+    });
+
+    int left = nodes.size();
+    Node child;
+    child.parent = _node;
+    nodes.append(child);
+    nodes.append(child);
+    nodes[_node].first = left;
+    nodes[_node].count = 0;
+
+    subdivide(left, _begin, middle);
+    subdivide(left + 1, middle, _end);
+}
+
+//------------------------------------------------------------------------------------------
+void SceneBVH::updateNodeBounds(int _node)
+{
+    Node& node = nodes[_node];
+    node.bounds = BoundingBox();
+
+    if(node.count == 0)
+    {
+        node.bounds.expand(nodes[node.first].bounds);
+        node.bounds.expand(nodes[node.first + 1].bounds);
+        return;
+    }
+
+    for(int i = node.first; i < node.first + node.count; ++i)
+    {
+        node.bounds.expand(worldBounds[objectIndices[i]]);
+    }
+}
+
+//------------------------------------------------------------------------------------------
+void SceneBVH::collectObjects(int _node, QVector<uchar>& _visible, int& _numVisible) const
+{
+    const Node& node = nodes[_node];
+
+    if(node.count == 0)
+    {
+        collectObjects(node.first, _visible, _numVisible);
+        collectObjects(node.first + 1, _visible, _numVisible);
+        return;
+    }
+
+    for(int i = node.first; i < node.first + node.count; ++i)
+    {
+        _visible[objectIndices[i]] = 1;
+    }
+
+    _numVisible += node.count;
+}
@@ -0,0 +1,108 @@
+//------------------------------------------------------------------------------------------
+// scenebvh.h
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#ifndef SCENEBVH_H
+#define SCENEBVH_H
+
+#include <QtGui>
+#include <cfloat>
+
+//------------------------------------------------------------------------------------------
+#define BVH_MAX_LEAF_SIZE 4
+// rebuild instead of refitting when the root surface area grew by this factor
+#define BVH_REBUILD_RATIO 2.0f
+
+//------------------------------------------------------------------------------------------
+struct BoundingBox
+{
+    BoundingBox():
+        boxMin(FLT_MAX, FLT_MAX, FLT_MAX),
+        boxMax(-FLT_MAX, -FLT_MAX, -FLT_MAX) {}
+
+    BoundingBox(const QVector3D& _boxMin, const QVector3D& _boxMax):
+        boxMin(_boxMin),
+        boxMax(_boxMax) {}
+
+    bool isEmpty() const;
+    void expand(const QVector3D& _point);
+    void expand(const BoundingBox& _box);
+    QVector3D getCenter() const;
+    float getSurfaceArea() const;
+    bool intersects(const BoundingBox& _box) const;
+    BoundingBox transformed(const QMatrix4x4& _matrix) const;
+
+    QVector3D boxMin;
+    QVector3D boxMax;
+};
+
+//------------------------------------------------------------------------------------------
+// the 6 planes of a view-projection matrix, pointing inside
+//------------------------------------------------------------------------------------------
+struct Frustum
+{
+    Frustum() {}
+    explicit Frustum(const QMatrix4x4& _viewProjection);
+
+    QVector4D planes[6];
+};
+
+//------------------------------------------------------------------------------------------
+// Bounding volume hierarchy over the world space bounds of the scene objects.
+// The objects are identified by the index returned by addObject. Moving an object only
+// refits the nodes above its leaf; the tree is rebuilt when the refitted bounds become
+// too loose.
+//------------------------------------------------------------------------------------------
+class SceneBVH
+{
+public:
+    SceneBVH();
+
+    void clear();
+    int addObject(const BoundingBox& _localBounds, const QMatrix4x4& _modelMatrix);
+    void updateObject(int _object, const QMatrix4x4& _modelMatrix);
+    void build();
+    void refit();
+
+    int getNumObjects() const;
+    int getNumNodes() const;
+    const BoundingBox& getObjectBounds(int _object) const;
+
+    // _visible[object] is set to 1 for the objects intersecting the frustum, 0 otherwise
+    int cullFrustum(const Frustum& _frustum, QVector<uchar>& _visible) const;
+    // the same for the objects [0, _numObjects) alone, tested one by one, the others are 0
+    int cullFirstObjects(const Frustum& _frustum, int _numObjects,
+                         QVector<uchar>& _visible) const;
+    int pickRay(const QVector3D& _origin, const QVector3D& _direction,
+                float& _distance) const;
+    void queryBox(const BoundingBox& _box, QVector<int>& _objects) const;
+    void querySphere(const QVector3D& _center, float _radius, QVector<int>& _objects) const;
+
+private:
+    struct Node
+    {
+        BoundingBox bounds;
+        int parent;
+        int first; // first object of a leaf, or the left child (right child is first + 1)
+        int count; // 0 for the internal nodes
+    };
+
+    void subdivide(int _node, int _begin, int _end);
+    void updateNodeBounds(int _node);
+    void collectObjects(int _node, QVector<uchar>& _visible, int& _numVisible) const;
+
+    QVector<Node> nodes;
+    QVector<int> objectIndices; // the objects of the leaves, in node order
+    QVector<BoundingBox> localBounds;
+    QVector<BoundingBox> worldBounds;
+    QVector<int> objectLeaves;
+    QVector<int> dirtyLeaves;
+    QVector<uchar> dirtyLeafFlags;
+    float builtSurfaceArea;
+};
+
+#endif // SCENEBVH_H
@@ -0,0 +1,1049 @@
+//------------------------------------------------------------------------------------------
+// scenedescription.cpp
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#include "scenedescription.h"
+
+// the records are written and mapped as they are
+Q_STATIC_ASSERT(sizeof(SceneMesh) == 16);
+Q_STATIC_ASSERT(sizeof(SceneInstance) == 144);
+Q_STATIC_ASSERT(sizeof(SceneProbe) == 16);
+Q_STATIC_ASSERT(sizeof(Material) == 40);
+Q_STATIC_ASSERT(sizeof(Light) == 36);
+
+static const char* meshTypeNames[NUM_SCENE_MESH_TYPES] =
+{
+    "plane", "cube", "sphere", "file"
+};
+
+static const char* builtinObjectNames[NUM_SCENE_BUILTIN_OBJECTS] =
+{
+    "floor",
+    "cube",
+    "semi_reflective_sphere",
+    "reflective_sphere"
+};
+
+//------------------------------------------------------------------------------------------
+static quint32 alignOffset(quint32 _offset)
+{
+    return (_offset + SCENE_SECTION_ALIGNMENT - 1) & ~(SCENE_SECTION_ALIGNMENT - 1);
+}
+
+//------------------------------------------------------------------------------------------
+template<class T>
+static void copySection(QVector<T>& _storage, const uchar* _data, quint32 _count)
+{
+    _storage.resize(_count);
+
+    if(_count > 0)
+    {
+        memcpy(_storage.data(), _data, _count * sizeof(T));
+    }
+}
+
+//------------------------------------------------------------------------------------------
+static QVector4D readVector(const QJsonValue& _value, const QVector4D& _default)
+{
+    QJsonArray array = _value.toArray();
+    QVector4D vector = _default;
+
+    for(int i = 0; i < qMin(array.size(), 4); ++i)
+    {
+        vector[i] = (float)array[i].toDouble();
+    }
+
+    return vector;
+}
+
+//------------------------------------------------------------------------------------------
+static QJsonArray writeVector(const float* _data, int _size)
+{
+    QJsonArray array;
+
+    for(int i = 0; i < _size; ++i)
+    {
+        array.append((double)_data[i]);
+    }
+
+    return array;
+}
+
+//------------------------------------------------------------------------------------------
+static quint32 readIndex(const QJsonValue& _value)
+{
+    int index = _value.toInt(-1);
+
+    return (index < 0) ? SCENE_NO_INDEX : (quint32)index;
+}
+
+//------------------------------------------------------------------------------------------
+// "matrix" (column major), or translation * rotation * scale
+//------------------------------------------------------------------------------------------
+static QMatrix4x4 readMatrix(const QJsonObject& _instance)
+{
+    QMatrix4x4 matrix;
+
+    if(_instance.contains("matrix"))
+    {
+        QJsonArray array = _instance.value("matrix").toArray();
+        float data[16];
+
+        for(int i = 0; i < 16; ++i)
+        {
+            data[i] = (float)array.at(i).toDouble((i % 5 == 0) ? 1.0 : 0.0);
+        }
+
+        return SceneDescription::getMatrix(data);
+    }
+
+    QVector4D translation = readVector(_instance.value("translation"), QVector4D());
+    QVector4D rotation = readVector(_instance.value("rotation"),
+                                    QVector4D(0.0f, 1.0f, 0.0f, 0.0f));
+    QJsonValue scale = _instance.value("scale");
+    QVector4D scaling = scale.isArray() ?
+                        readVector(scale, QVector4D(1.0f, 1.0f, 1.0f, 1.0f)) :
+                        QVector4D(1.0f, 1.0f, 1.0f, 1.0f) * (float)scale.toDouble(1.0);
+
+    matrix.translate(translation.toVector3D());
+    matrix.rotate(rotation.w(), rotation.toVector3D());
+    matrix.scale(scaling.toVector3D());
+
+    return matrix;
+}
+
+//------------------------------------------------------------------------------------------
+SceneDescription::SceneDescription():
+    mappedFile(NULL),
+    mappedData(NULL),
+    environment(SCENE_NO_INDEX)
+{
+    updatePointers();
+}
+
+//------------------------------------------------------------------------------------------
+SceneDescription::~SceneDescription()
+{
+    clear();
+}
+
+//------------------------------------------------------------------------------------------
+void SceneDescription::clear()
+{
+    if(mappedFile != NULL)
+    {
+        mappedFile->unmap(mappedData);
+        delete mappedFile;
+        mappedFile = NULL;
+        mappedData = NULL;
+    }
+
+    meshStorage.clear();
+    materialStorage.clear();
+    instanceStorage.clear();
+    lightStorage.clear();
+    probeStorage.clear();
+    textureStorage.clear();
+    stringStorage.clear();
+    environment = SCENE_NO_INDEX;
+
+    updatePointers();
+}
+
+//------------------------------------------------------------------------------------------
+// the scene compiled in the renderer
+//------------------------------------------------------------------------------------------
+void SceneDescription::createDefaultScene()
+{
+    clear();
+    setEnvironment(DEFAULT_SCENE_ENVIRONMENT);
+
+    Light light;
+    light.position = QVector4D(DEFAULT_LIGHT_POSITION, 1.0f);
+    light.intensity = 1.0f;
+    addLight(light);
+
+    quint32 checkerboardTexture = addTexture(":/textures/checkerboard.jpg");
+    quint32 decalTexture = addTexture(":/textures/minion.png");
+    quint32 earthTexture = addTexture(":/textures/earth.jpg");
+
+    Material planeMaterial;
+    planeMaterial.shininess = 50.0f;
+    planeMaterial.setSpecular(QVector4D(0.5f, 0.5f, 0.5f, 1.0f));
+
+    Material cubeMaterial;
+    cubeMaterial.shininess = 50.0f;
+    cubeMaterial.setDiffuse(QVector4D(0.0f, 1.0f, 0.2f, 1.0f));
+
+    Material semiReflectiveSphereMaterial;
+    semiReflectiveSphereMaterial.shininess = 100.0f;
+    semiReflectiveSphereMaterial.setDiffuse(QVector4D(0.8f, 0.8f, 0.0f, 1.0f));
+    semiReflectiveSphereMaterial.setSpecular(QVector4D(0.5f, 0.5f, 0.5f, 1.0f));
+    semiReflectiveSphereMaterial.setReflection(0.5f);
+
+    Material reflectiveSphereMaterial;
+    reflectiveSphereMaterial.setDiffuse(QVector4D(1.0f, 1.0f, 1.0f, 1.0f));
+    reflectiveSphereMaterial.setReflection(1.0f);
+
+    quint32 planeMesh = addMesh(SCENE_MESH_PLANE);
+    quint32 cubeMesh = addMesh(SCENE_MESH_CUBE);
+    quint32 sphereMesh = addMesh(SCENE_MESH_SPHERE, 30, 30);
+
+    QMatrix4x4 planeModelMatrix;
+    planeModelMatrix.scale(60.0f);
+    addInstance(builtinObjectNames[SCENE_FLOOR], planeMesh, addMaterial(planeMaterial),
+                checkerboardTexture, planeModelMatrix);
+
+    QMatrix4x4 cubeModelMatrix;
+    cubeModelMatrix.scale(1.5);
+    cubeModelMatrix.translate(DEFAULT_CUBE_POSITION);
+    addInstance(builtinObjectNames[SCENE_CUBE], cubeMesh, addMaterial(cubeMaterial),
+                decalTexture, cubeModelMatrix);
+
+    QMatrix4x4 sphereModelMatrix;
+    sphereModelMatrix.translate(DEFAULT_SPHERE_POSITION);
+    quint32 sphere = addInstance(builtinObjectNames[SCENE_SEMI_REFLECTIVE_SPHERE],
+                                 sphereMesh, addMaterial(semiReflectiveSphereMaterial),
+                                 earthTexture, sphereModelMatrix);
+    addProbe(DEFAULT_SPHERE_POSITION, sphere);
+
+    QMatrix4x4 reflectiveSphereModelMatrix;
+    reflectiveSphereModelMatrix.translate(DEFAULT_REFLECTIVE_SPHERE_POSITION);
+    quint32 reflectiveSphere = addInstance(builtinObjectNames[SCENE_REFLECTIVE_SPHERE],
+                                           sphereMesh,
+                                           addMaterial(reflectiveSphereMaterial),
+                                           SCENE_NO_INDEX, reflectiveSphereModelMatrix);
+    addProbe(DEFAULT_REFLECTIVE_SPHERE_POSITION, reflectiveSphere);
+}
+
+//------------------------------------------------------------------------------------------
+// _numSpheres small spheres sharing one mesh, on a grid over the floor around the built-in
+// objects, with a few materials (some of them reflective)
+//------------------------------------------------------------------------------------------
+void SceneDescription::addSpherePopulation(int _numSpheres)
+{
+    static const QVector4D colors[] =
+    {
+        QVector4D(0.9f, 0.2f, 0.2f, 1.0f),
+        QVector4D(0.2f, 0.8f, 0.3f, 1.0f),
+        QVector4D(0.2f, 0.4f, 0.9f, 1.0f),
+        QVector4D(0.9f, 0.8f, 0.2f, 1.0f),
+        QVector4D(0.8f, 0.3f, 0.9f, 1.0f),
+        QVector4D(0.2f, 0.9f, 0.9f, 1.0f),
+        QVector4D(1.0f, 1.0f, 1.0f, 1.0f),
+        QVector4D(0.6f, 0.6f, 0.6f, 1.0f)
+    };
+    const int numColors = sizeof(colors) / sizeof(colors[0]);
+
+    if(_numSpheres <= 0)
+    {
+        return;
+    }
+
+    quint32 sphereMesh = addMesh(SCENE_MESH_SPHERE, 16, 16);
+    quint32 firstMaterial = getNumMaterials();
+
+    for(int i = 0; i < numColors; ++i)
+    {
+        Material material;
+        material.shininess = 50.0f;
+        material.setDiffuse(colors[i]);
+        material.setSpecular(QVector4D(0.5f, 0.5f, 0.5f, 1.0f));
+        material.setReflection((i >= numColors - 2) ? 0.8f : 0.0f);
+        addMaterial(material);
+    }
+
+    /////////////////////////////////////////////////////////////////
+    // the cells around the built-in objects (at most 20x10) are skipped
+    int gridSize = qCeil(qSqrt(_numSpheres + 200.0));
+    float origin = -0.5f * SPHERE_POPULATION_SPACING * (gridSize - 1);
+    int numAdded = 0;
+
+    for(int row = 0; row < gridSize && numAdded < _numSpheres; ++row)
+    {
+        for(int col = 0; col < gridSize && numAdded < _numSpheres; ++col)
+        {
+            QVector3D position(origin + col * SPHERE_POPULATION_SPACING,
+                               SPHERE_POPULATION_RADIUS + 0.001f,
+                               origin + row * SPHERE_POPULATION_SPACING);
+
+            if(qAbs(position.x()) < 12.0f && qAbs(position.z()) < 6.0f)
+            {
+                continue;
+            }
+
+            QMatrix4x4 modelMatrix;
+            modelMatrix.translate(position);
+            modelMatrix.scale(SPHERE_POPULATION_RADIUS);
+            addInstance(QString("sphere_%1").arg(numAdded), sphereMesh,
+                        firstMaterial + (numAdded % numColors), SCENE_NO_INDEX, modelMatrix);
+            ++numAdded;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// binary or JSON, from the first bytes of the file
+//------------------------------------------------------------------------------------------
+bool SceneDescription::load(const QString& _fileName)
+{
+    QFile file(_fileName);
+
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        PRINT_ERROR(QString("Cannot open scene file %1").arg(_fileName));
+        return false;
+    }
+
+    quint32 magic = 0;
+    bool binary = (file.read(reinterpret_cast<char*>(&magic), sizeof(magic)) ==
+                   sizeof(magic) && magic == SCENE_FILE_MAGIC);
+    file.close();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    if(!(binary ? loadBinary(_fileName) : loadJson(_fileName)))
+    {
+        return false;
+    }
+
+    qDebug() << "SceneDescription: loaded" << _fileName << "with" << getNumInstances()
+             << "instances in" << (double)timer.nsecsElapsed() * 1e-6 << "ms";
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+bool SceneDescription::loadJson(const QString& _fileName)
+{
+    QFile file(_fileName);
+
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        PRINT_ERROR(QString("Cannot open scene file %1").arg(_fileName));
+        return false;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+
+    if(document.isNull())
+    {
+        PRINT_ERROR(QString("Cannot parse scene file %1: %2").arg(_fileName)
+                    .arg(parseError.errorString()));
+        return false;
+    }
+
+    clear();
+
+    QJsonObject root = document.object();
+    setEnvironment(root.value("environment").toString(DEFAULT_SCENE_ENVIRONMENT));
+
+    QJsonArray lightArray = root.value("lights").toArray();
+
+    for(int i = 0; i < lightArray.size(); ++i)
+    {
+        QJsonObject object = lightArray[i].toObject();
+        Light light;
+        light.position = readVector(object.value("position"), light.position);
+        light.position.setW(1.0f);
+        light.color = readVector(object.value("color"), light.color);
+        light.intensity = (float)object.value("intensity").toDouble(light.intensity);
+        addLight(light);
+    }
+
+    QJsonArray textureArray = root.value("textures").toArray();
+
+    for(int i = 0; i < textureArray.size(); ++i)
+    {
+        addTexture(textureArray[i].toString());
+    }
+
+    QJsonArray materialArray = root.value("materials").toArray();
+
+    for(int i = 0; i < materialArray.size(); ++i)
+    {
+        QJsonObject object = materialArray[i].toObject();
+        Material material;
+        material.diffuseColor = readVector(object.value("diffuse"), material.diffuseColor);
+        material.specularColor = readVector(object.value("specular"),
+                                            material.specularColor);
+        material.reflection = (float)object.value("reflection")
+                              .toDouble(material.reflection);
+        material.shininess = (float)object.value("shininess").toDouble(material.shininess);
+        addMaterial(material);
+    }
+
+    QJsonArray meshArray = root.value("meshes").toArray();
+
+    for(int i = 0; i < meshArray.size(); ++i)
+    {
+        QJsonObject object = meshArray[i].toObject();
+        QString type = object.value("type").toString();
+        int meshType = 0;
+
+        while(meshType < NUM_SCENE_MESH_TYPES && type != meshTypeNames[meshType])
+        {
+            ++meshType;
+        }
+
+        if(meshType == NUM_SCENE_MESH_TYPES)
+        {
+            PRINT_ERROR(QString("Unknown mesh type %1 in scene file %2").arg(type)
+                        .arg(_fileName));
+            return false;
+        }
+
+        if(meshType == SCENE_MESH_FILE)
+        {
+            // relative to the scene file
+            QString meshFile = object.value("file").toString();
+
+            if(QFileInfo(meshFile).isRelative() && !meshFile.startsWith(":"))
+            {
+                meshFile = QFileInfo(_fileName).dir().filePath(meshFile);
+            }
+
+            addMeshFile(meshFile);
+        }
+        else
+        {
+            addMesh(static_cast<SceneMeshType>(meshType), object.value("stacks").toInt(30),
+                    object.value("slices").toInt(30));
+        }
+    }
+
+    QJsonArray instanceArray = root.value("instances").toArray();
+
+    for(int i = 0; i < instanceArray.size(); ++i)
+    {
+        QJsonObject object = instanceArray[i].toObject();
+        addInstance(object.value("name").toString(), readIndex(object.value("mesh")),
+                    readIndex(object.value("material")), readIndex(object.value("texture")),
+                    readMatrix(object));
+    }
+
+    QJsonArray probeArray = root.value("probes").toArray();
+
+    for(int i = 0; i < probeArray.size(); ++i)
+    {
+        QJsonObject object = probeArray[i].toObject();
+        addProbe(readVector(object.value("position"), QVector4D()).toVector3D(),
+                 readIndex(object.value("instance")));
+    }
+
+    return validate();
+}
+
+//------------------------------------------------------------------------------------------
+// map the file, the records are used in place
+//------------------------------------------------------------------------------------------
+bool SceneDescription::loadBinary(const QString& _fileName)
+{
+    QFile* file = new QFile(_fileName);
+
+    if(!file->open(QIODevice::ReadOnly))
+    {
+        PRINT_ERROR(QString("Cannot open scene file %1").arg(_fileName));
+        delete file;
+        return false;
+    }
+
+    qint64 fileSize = file->size();
+    uchar* data = (fileSize >= (qint64)sizeof(SceneFileHeader)) ?
+                  file->map(0, fileSize) : NULL;
+
+    if(data == NULL)
+    {
+        PRINT_ERROR(QString("Cannot map scene file %1").arg(_fileName));
+        delete file;
+        return false;
+    }
+
+    const SceneFileHeader* header = reinterpret_cast<const SceneFileHeader*>(data);
+    bool valid = (header->magic == SCENE_FILE_MAGIC &&
+                  header->version == SCENE_FILE_VERSION);
+
+    for(int i = 0; i < NUM_SCENE_SECTIONS && valid; ++i)
+    {
+        SceneSection section = static_cast<SceneSection>(i);
+        quint64 sectionEnd = (quint64)header->offsets[i] +
+                             (quint64)header->counts[i] * getRecordSize(section);
+        valid = (header->offsets[i] % SCENE_SECTION_ALIGNMENT == 0 &&
+                 sectionEnd <= (quint64)fileSize);
+    }
+
+    if(!valid)
+    {
+        PRINT_ERROR(QString("Invalid scene file %1").arg(_fileName));
+        file->unmap(data);
+        delete file;
+        return false;
+    }
+
+    clear();
+    mappedFile = file;
+    mappedData = data;
+    environment = header->environment;
+
+    for(int i = 0; i < NUM_SCENE_SECTIONS; ++i)
+    {
+        counts[i] = header->counts[i];
+        sections[i] = data + header->offsets[i];
+    }
+
+    return validate();
+}
+
+//------------------------------------------------------------------------------------------
+bool SceneDescription::save(const QString& _fileName) const
+{
+    return _fileName.endsWith(".json", Qt::CaseInsensitive) ?
+           saveJson(_fileName) : saveBinary(_fileName);
+}
+
+//------------------------------------------------------------------------------------------
+bool SceneDescription::saveJson(const QString& _fileName) const
+{
+    QJsonObject root;
+    root["environment"] = getEnvironment();
+
+    QJsonArray lightArray;
+
+    for(int i = 0; i < getNumLights(); ++i)
+    {
+        const Light& light = getLights()[i];
+        QJsonObject object;
+        object["position"] = writeVector(&light.position[0], 3);
+        object["color"] = writeVector(&light.color[0], 3);
+        object["intensity"] = light.intensity;
+        lightArray.append(object);
+    }
+
+    root["lights"] = lightArray;
+
+    QJsonArray textureArray;
+
+    for(int i = 0; i < getNumTextures(); ++i)
+    {
+        textureArray.append(getTextureFile(i));
+    }
+
+    root["textures"] = textureArray;
+
+    QJsonArray materialArray;
+
+    for(int i = 0; i < getNumMaterials(); ++i)
+    {
+        const Material& material = getMaterials()[i];
+        QJsonObject object;
+        object["diffuse"] = writeVector(&material.diffuseColor[0], 4);
+        object["specular"] = writeVector(&material.specularColor[0], 4);
+        object["reflection"] = material.reflection;
+        object["shininess"] = material.shininess;
+        materialArray.append(object);
+    }
+
+    root["materials"] = materialArray;
+
+    QJsonArray meshArray;
+
+    for(int i = 0; i < getNumMeshes(); ++i)
+    {
+        const SceneMesh& mesh = getMeshes()[i];
+        QJsonObject object;
+        object["type"] = meshTypeNames[mesh.type];
+
+        if(mesh.type == SCENE_MESH_SPHERE)
+        {
+            object["stacks"] = (int)mesh.numStacks;
+            object["slices"] = (int)mesh.numSlices;
+        }
+        else if(mesh.type == SCENE_MESH_FILE)
+        {
+            object["file"] = getMeshFile(i);
+        }
+
+        meshArray.append(object);
+    }
+
+    root["meshes"] = meshArray;
+
+    QJsonArray instanceArray;
+
+    for(int i = 0; i < getNumInstances(); ++i)
+    {
+        const SceneInstance& instance = getInstances()[i];
+        QJsonObject object;
+
+        if(instance.name != SCENE_NO_INDEX)
+        {
+            object["name"] = getString(instance.name);
+        }
+
+        object["mesh"] = (int)instance.mesh;
+        object["material"] = (int)instance.material;
+
+        if(instance.texture != SCENE_NO_INDEX)
+        {
+            object["texture"] = (int)instance.texture;
+        }
+
+        object["matrix"] = writeVector(instance.modelMatrix, 16);
+        instanceArray.append(object);
+    }
+
+    root["instances"] = instanceArray;
+
+    QJsonArray probeArray;
+
+    for(int i = 0; i < getNumProbes(); ++i)
+    {
+        const SceneProbe& probe = getProbes()[i];
+        QJsonObject object;
+        object["position"] = writeVector(probe.position, 3);
+        object["instance"] = (int)probe.instance;
+        probeArray.append(object);
+    }
+
+    root["probes"] = probeArray;
+
+    QFile file(_fileName);
+
+    if(!file.open(QIODevice::WriteOnly))
+    {
+        PRINT_ERROR(QString("Cannot write scene file %1").arg(_fileName));
+        return false;
+    }
+
+    file.write(QJsonDocument(root).toJson());
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+bool SceneDescription::saveBinary(const QString& _fileName) const
+{
+    SceneFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = SCENE_FILE_MAGIC;
+    header.version = SCENE_FILE_VERSION;
+    header.environment = environment;
+
+    quint32 offset = alignOffset(sizeof(SceneFileHeader));
+
+    for(int i = 0; i < NUM_SCENE_SECTIONS; ++i)
+    {
+        header.counts[i] = counts[i];
+        header.offsets[i] = offset;
+        offset = alignOffset(offset + counts[i] *
+                             getRecordSize(static_cast<SceneSection>(i)));
+    }
+
+    QFile file(_fileName);
+
+    if(!file.open(QIODevice::WriteOnly))
+    {
+        PRINT_ERROR(QString("Cannot write scene file %1").arg(_fileName));
+        return false;
+    }
+
+    QByteArray padding(SCENE_SECTION_ALIGNMENT, '\0');
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for(int i = 0; i < NUM_SCENE_SECTIONS; ++i)
+    {
+        file.write(padding.constData(), header.offsets[i] - file.pos());
+        file.write(reinterpret_cast<const char*>(sections[i]),
+                   (qint64)counts[i] * getRecordSize(static_cast<SceneSection>(i)));
+    }
+
+    file.write(padding.constData(), offset - file.pos());
+
+    return (file.error() == QFileDevice::NoError);
+}
+
+//------------------------------------------------------------------------------------------
+quint32 SceneDescription::addMesh(SceneMeshType _type, int _numStacks, int _numSlices)
+{
+    detach();
+
+    SceneMesh mesh;
+    mesh.type = _type;
+    mesh.numStacks = _numStacks;
+    mesh.numSlices = _numSlices;
+    mesh.fileName = SCENE_NO_INDEX;
+    meshStorage.append(mesh);
+    updatePointers();
+
+    return meshStorage.size() - 1;
+}
+
+//------------------------------------------------------------------------------------------
+// OBJ or PLY file, imported by the renderer
+//------------------------------------------------------------------------------------------
+quint32 SceneDescription::addMeshFile(const QString& _fileName)
+{
+    quint32 fileName = addString(_fileName);
+    quint32 mesh = addMesh(SCENE_MESH_FILE, 0, 0);
+    meshStorage[mesh].fileName = fileName;
+    updatePointers();
+
+    return mesh;
+}
+
+//------------------------------------------------------------------------------------------
+quint32 SceneDescription::addMaterial(const Material& _material)
+{
+    detach();
+    materialStorage.append(_material);
+    updatePointers();
+
+    return materialStorage.size() - 1;
+}
+
+//------------------------------------------------------------------------------------------
+quint32 SceneDescription::addInstance(const QString& _name, quint32 _mesh,
+                                      quint32 _material, quint32 _texture,
+                                      const QMatrix4x4& _modelMatrix)
+{
+    detach();
+
+    SceneInstance instance;
+    QMatrix4x4 normalMatrix(_modelMatrix.normalMatrix());
+    memcpy(instance.modelMatrix, _modelMatrix.constData(), sizeof(instance.modelMatrix));
+    memcpy(instance.normalMatrix, normalMatrix.constData(), sizeof(instance.normalMatrix));
+    instance.mesh = _mesh;
+    instance.material = _material;
+    instance.texture = _texture;
+    instance.name = addString(_name);
+    instanceStorage.append(instance);
+    updatePointers();
+
+    return instanceStorage.size() - 1;
+}
+
+//------------------------------------------------------------------------------------------
+quint32 SceneDescription::addLight(const Light& _light)
+{
+    detach();
+    lightStorage.append(_light);
+    updatePointers();
+
+    return lightStorage.size() - 1;
+}
+
+//------------------------------------------------------------------------------------------
+quint32 SceneDescription::addProbe(const QVector3D& _position, quint32 _instance)
+{
+    detach();
+
+    SceneProbe probe;
+    probe.position[0] = _position.x();
+    probe.position[1] = _position.y();
+    probe.position[2] = _position.z();
+    probe.instance = _instance;
+    probeStorage.append(probe);
+    updatePointers();
+
+    return probeStorage.size() - 1;
+}
+
+//------------------------------------------------------------------------------------------
+quint32 SceneDescription::addTexture(const QString& _fileName)
+{
+    detach();
+    textureStorage.append(addString(_fileName));
+    updatePointers();
+
+    return textureStorage.size() - 1;
+}
+
+//------------------------------------------------------------------------------------------
+void SceneDescription::setEnvironment(const QString& _directory)
+{
+    detach();
+    environment = addString(_directory);
+    updatePointers();
+}
+
+//------------------------------------------------------------------------------------------
+int SceneDescription::getNumMeshes() const
+{
+    return counts[SCENE_MESHES];
+}
+
+//------------------------------------------------------------------------------------------
+int SceneDescription::getNumMaterials() const
+{
+    return counts[SCENE_MATERIALS];
+}
+
+//------------------------------------------------------------------------------------------
+int SceneDescription::getNumInstances() const
+{
+    return counts[SCENE_INSTANCES];
+}
+
+//------------------------------------------------------------------------------------------
+int SceneDescription::getNumLights() const
+{
+    return counts[SCENE_LIGHTS];
+}
+
+//------------------------------------------------------------------------------------------
+int SceneDescription::getNumProbes() const
+{
+    return counts[SCENE_PROBES];
+}
+
+//------------------------------------------------------------------------------------------
+int SceneDescription::getNumTextures() const
+{
+    return counts[SCENE_TEXTURES];
+}
+
+//------------------------------------------------------------------------------------------
+const SceneMesh* SceneDescription::getMeshes() const
+{
+    return reinterpret_cast<const SceneMesh*>(sections[SCENE_MESHES]);
+}
+
+//------------------------------------------------------------------------------------------
+const Material* SceneDescription::getMaterials() const
+{
+    return reinterpret_cast<const Material*>(sections[SCENE_MATERIALS]);
+}
+
+//------------------------------------------------------------------------------------------
+const SceneInstance* SceneDescription::getInstances() const
+{
+    return reinterpret_cast<const SceneInstance*>(sections[SCENE_INSTANCES]);
+}
+
+//------------------------------------------------------------------------------------------
+const Light* SceneDescription::getLights() const
+{
+    return reinterpret_cast<const Light*>(sections[SCENE_LIGHTS]);
+}
+
+//------------------------------------------------------------------------------------------
+const SceneProbe* SceneDescription::getProbes() const
+{
+    return reinterpret_cast<const SceneProbe*>(sections[SCENE_PROBES]);
+}
+
+//------------------------------------------------------------------------------------------
+QString SceneDescription::getTextureFile(int _texture) const
+{
+    return getString(reinterpret_cast<const quint32*>(sections[SCENE_TEXTURES])[_texture]);
+}
+
+//------------------------------------------------------------------------------------------
+QString SceneDescription::getMeshFile(int _mesh) const
+{
+    return getString(getMeshes()[_mesh].fileName);
+}
+
+//------------------------------------------------------------------------------------------
+QString SceneDescription::getEnvironment() const
+{
+    return getString(environment);
+}
+
+//------------------------------------------------------------------------------------------
+// the string table ends with a null character (checked by validate)
+//------------------------------------------------------------------------------------------
+QString SceneDescription::getString(quint32 _offset) const
+{
+    if(_offset >= counts[SCENE_STRINGS])
+    {
+        return QString();
+    }
+
+    return QString::fromUtf8(reinterpret_cast<const char*>(sections[SCENE_STRINGS]) +
+                             _offset);
+}
+
+//------------------------------------------------------------------------------------------
+QMatrix4x4 SceneDescription::getMatrix(const float* _data)
+{
+    QMatrix4x4 matrix;
+    memcpy(matrix.data(), _data, 16 * sizeof(float));
+
+    return matrix;
+}
+
+//------------------------------------------------------------------------------------------
+const char* SceneDescription::getBuiltinObjectName(SceneBuiltinObject _object)
+{
+    return builtinObjectNames[_object];
+}
+
+//------------------------------------------------------------------------------------------
+// -1 for the instances added to the scene
+//------------------------------------------------------------------------------------------
+int SceneDescription::findBuiltinObject(const QString& _name)
+{
+    for(int i = 0; i < NUM_SCENE_BUILTIN_OBJECTS; ++i)
+    {
+        if(_name == builtinObjectNames[i])
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+//------------------------------------------------------------------------------------------
+quint32 SceneDescription::addString(const QString& _str)
+{
+    if(_str.isEmpty())
+    {
+        return SCENE_NO_INDEX;
+    }
+
+    quint32 offset = stringStorage.size();
+    stringStorage.append(_str.toUtf8());
+    stringStorage.append('\0');
+
+    return offset;
+}
+
+//------------------------------------------------------------------------------------------
+// copy the mapped sections before modifying the scene
+//------------------------------------------------------------------------------------------
+void SceneDescription::detach()
+{
+    if(mappedFile == NULL)
+    {
+        return;
+    }
+
+    copySection(meshStorage, sections[SCENE_MESHES], counts[SCENE_MESHES]);
+    copySection(materialStorage, sections[SCENE_MATERIALS], counts[SCENE_MATERIALS]);
+    copySection(instanceStorage, sections[SCENE_INSTANCES], counts[SCENE_INSTANCES]);
+    copySection(lightStorage, sections[SCENE_LIGHTS], counts[SCENE_LIGHTS]);
+    copySection(probeStorage, sections[SCENE_PROBES], counts[SCENE_PROBES]);
+    copySection(textureStorage, sections[SCENE_TEXTURES], counts[SCENE_TEXTURES]);
+    stringStorage = QByteArray(reinterpret_cast<const char*>(sections[SCENE_STRINGS]),
+                               counts[SCENE_STRINGS]);
+
+    mappedFile->unmap(mappedData);
+    delete mappedFile;
+    mappedFile = NULL;
+    mappedData = NULL;
+
+    updatePointers();
+}
+
+//------------------------------------------------------------------------------------------
+void SceneDescription::updatePointers()
+{
+    counts[SCENE_MESHES] = meshStorage.size();
+    counts[SCENE_MATERIALS] = materialStorage.size();
+    counts[SCENE_INSTANCES] = instanceStorage.size();
+    counts[SCENE_LIGHTS] = lightStorage.size();
+    counts[SCENE_PROBES] = probeStorage.size();
+    counts[SCENE_TEXTURES] = textureStorage.size();
+    counts[SCENE_STRINGS] = stringStorage.size();
+
+    sections[SCENE_MESHES] = reinterpret_cast<const uchar*>(meshStorage.constData());
+    sections[SCENE_MATERIALS] = reinterpret_cast<const uchar*>(materialStorage.constData());
+    sections[SCENE_INSTANCES] = reinterpret_cast<const uchar*>(instanceStorage.constData());
+    sections[SCENE_LIGHTS] = reinterpret_cast<const uchar*>(lightStorage.constData());
+    sections[SCENE_PROBES] = reinterpret_cast<const uchar*>(probeStorage.constData());
+    sections[SCENE_TEXTURES] = reinterpret_cast<const uchar*>(textureStorage.constData());
+    sections[SCENE_STRINGS] = reinterpret_cast<const uchar*>(stringStorage.constData());
+}
+
+//------------------------------------------------------------------------------------------
+// the indices are checked once here, the renderer uses them as they are
+//------------------------------------------------------------------------------------------
+bool SceneDescription::validate()
+{
+    const char* strings = reinterpret_cast<const char*>(sections[SCENE_STRINGS]);
+
+    if(counts[SCENE_STRINGS] > 0 && strings[counts[SCENE_STRINGS] - 1] != '\0')
+    {
+        PRINT_ERROR("Invalid string table in the scene.");
+        return false;
+    }
+
+    for(int i = 0; i < getNumMeshes(); ++i)
+    {
+        const SceneMesh& mesh = getMeshes()[i];
+
+        if(mesh.type >= NUM_SCENE_MESH_TYPES)
+        {
+            PRINT_ERROR(QString("Invalid type of mesh %1 in the scene.").arg(i));
+            return false;
+        }
+
+        if(mesh.type == SCENE_MESH_FILE && getMeshFile(i).isEmpty())
+        {
+            PRINT_ERROR(QString("No file for mesh %1 in the scene.").arg(i));
+            return false;
+        }
+
+        // the sphere is generated with this resolution
+        if(mesh.type == SCENE_MESH_SPHERE &&
+           (mesh.numStacks < SCENE_MIN_SPHERE_STACKS ||
+            mesh.numStacks > SCENE_MAX_SPHERE_RESOLUTION ||
+            mesh.numSlices < SCENE_MIN_SPHERE_SLICES ||
+            mesh.numSlices > SCENE_MAX_SPHERE_RESOLUTION))
+        {
+            PRINT_ERROR(QString("Invalid resolution of mesh %1 in the scene.").arg(i));
+            return false;
+        }
+    }
+
+    const SceneInstance* instances = getInstances();
+
+    for(int i = 0; i < getNumInstances(); ++i)
+    {
+        if(instances[i].mesh >= counts[SCENE_MESHES] ||
+           instances[i].material >= counts[SCENE_MATERIALS] ||
+           (instances[i].texture != SCENE_NO_INDEX &&
+            instances[i].texture >= counts[SCENE_TEXTURES]))
+        {
+            PRINT_ERROR(QString("Invalid mesh, material or texture of instance %1 in the "
+                                "scene.").arg(i));
+            return false;
+        }
+    }
+
+    for(int i = 0; i < getNumProbes(); ++i)
+    {
+        if(getProbes()[i].instance >= counts[SCENE_INSTANCES])
+        {
+            PRINT_ERROR(QString("Invalid instance of probe %1 in the scene.").arg(i));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+int SceneDescription::getRecordSize(SceneSection _section)
+{
+    static const int recordSizes[NUM_SCENE_SECTIONS] =
+    {
+        sizeof(SceneMesh),
+        sizeof(Material),
+        sizeof(SceneInstance),
+        sizeof(Light),
+        sizeof(SceneProbe),
+        sizeof(quint32),
+        sizeof(char)
+    };
+
+    return recordSizes[_section];
+}
@@ -0,0 +1,195 @@
+//------------------------------------------------------------------------------------------
+// scenedescription.h
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#ifndef SCENEDESCRIPTION_H
+#define SCENEDESCRIPTION_H
+
+#include <QtCore>
+
+#include "renderer.h"
+
+//------------------------------------------------------------------------------------------
+#define SCENE_FILE_MAGIC 0x4e435352 // "RSCN"
+#define SCENE_FILE_VERSION 1
+#define SCENE_SECTION_ALIGNMENT 16
+#define SCENE_NO_INDEX 0xffffffffu
+#define SCENE_MIN_SPHERE_STACKS 2
+#define SCENE_MIN_SPHERE_SLICES 3
+#define SCENE_MAX_SPHERE_RESOLUTION 1024
+#define DEFAULT_SCENE_ENVIRONMENT ":/textures/sky"
+#define SPHERE_POPULATION_RADIUS 0.4f
+#define SPHERE_POPULATION_SPACING 1.2f
+
+enum SceneMeshType
+{
+    SCENE_MESH_PLANE = 0,
+    SCENE_MESH_CUBE,
+    SCENE_MESH_SPHERE,
+    SCENE_MESH_FILE,
+    NUM_SCENE_MESH_TYPES
+};
+
+// the objects of the renderer, configured by the instances with the same name
+enum SceneBuiltinObject
+{
+    SCENE_FLOOR = 0,
+    SCENE_CUBE,
+    SCENE_SEMI_REFLECTIVE_SPHERE,
+    SCENE_REFLECTIVE_SPHERE,
+    NUM_SCENE_BUILTIN_OBJECTS
+};
+
+enum SceneSection
+{
+    SCENE_MESHES = 0,
+    SCENE_MATERIALS,
+    SCENE_INSTANCES,
+    SCENE_LIGHTS,
+    SCENE_PROBES,
+    SCENE_TEXTURES,
+    SCENE_STRINGS,
+    NUM_SCENE_SECTIONS
+};
+
+//------------------------------------------------------------------------------------------
+// Records of the binary file, used as they are from the mapped file (little endian).
+// The strings are offsets in the string table, SCENE_NO_INDEX for none.
+//------------------------------------------------------------------------------------------
+struct SceneMesh
+{
+    quint32 type;
+    quint32 numStacks; // sphere resolution
+    quint32 numSlices;
+    quint32 fileName;  // SCENE_MESH_FILE only
+};
+
+// std140 compatible, the matrices are the first two of the Matrices uniform block
+struct SceneInstance
+{
+    float modelMatrix[16];
+    float normalMatrix[16];
+    quint32 mesh;
+    quint32 material;
+    quint32 texture;
+    quint32 name;
+};
+
+// the point a cube map is rendered from, without the instance it belongs to
+struct SceneProbe
+{
+    float position[3];
+    quint32 instance;
+};
+
+struct SceneFileHeader
+{
+    quint32 magic;
+    quint32 version;
+    quint32 environment;
+    quint32 reserved;
+    quint32 counts[NUM_SCENE_SECTIONS];
+    quint32 offsets[NUM_SCENE_SECTIONS];
+};
+
+//------------------------------------------------------------------------------------------
+// Scene file: the meshes, materials, instances, lights, textures, environment map and
+// probes of the scene, instead of the positions and materials compiled in the renderer.
+//
+// The JSON form is the one to write by hand:
+// {
+//     "environment": ":/textures/sky",   // directory of posx.jpg ... negz.jpg
+//     "lights": [{"position": [0, 100, 100], "color": [1, 1, 1], "intensity": 1}],
+//     "textures": [":/textures/checkerboard.jpg"],
+//     "materials": [{"diffuse": [r, g, b, a], "specular": [r, g, b, a],
+//                    "reflection": 0.5, "shininess": 100}],
+//     "meshes": [{"type": "plane" | "cube" | "sphere", "stacks": 30, "slices": 30},
+//                {"type": "file", "file": "bunny.obj"}],   // OBJ or binary PLY
+//     "instances": [{"name": "cube", "mesh": 1, "material": 1, "texture": 0,
+//                    "translation": [x, y, z], "rotation": [x, y, z, degrees],
+//                    "scale": s | [x, y, z]}],   // or "matrix": 16 floats, column major
+//     "probes": [{"position": [x, y, z], "instance": 2}]
+// }
+// The instances named "floor", "cube", "semi_reflective_sphere" and "reflective_sphere"
+// configure the objects of the renderer; all the other instances are added to the scene.
+// The mesh files are relative to the scene file.
+//
+// The binary form is a header followed by the sections, each one an array of the records
+// above aligned to 16 bytes. It is mapped, not read: the instances are uploaded to the GPU
+// straight from the mapped file, so large scenes load in a few milliseconds.
+//------------------------------------------------------------------------------------------
+class SceneDescription
+{
+public:
+    SceneDescription();
+    ~SceneDescription();
+
+    void clear();
+    void createDefaultScene();
+    void addSpherePopulation(int _numSpheres);
+    bool load(const QString& _fileName);
+    bool loadJson(const QString& _fileName);
+    bool loadBinary(const QString& _fileName);
+    bool save(const QString& _fileName) const;
+    bool saveJson(const QString& _fileName) const;
+    bool saveBinary(const QString& _fileName) const;
+
+    quint32 addMesh(SceneMeshType _type, int _numStacks = 30, int _numSlices = 30);
+    quint32 addMeshFile(const QString& _fileName);
+    quint32 addMaterial(const Material& _material);
+    quint32 addInstance(const QString& _name, quint32 _mesh, quint32 _material,
+                        quint32 _texture, const QMatrix4x4& _modelMatrix);
+    quint32 addLight(const Light& _light);
+    quint32 addProbe(const QVector3D& _position, quint32 _instance);
+    quint32 addTexture(const QString& _fileName);
+    void setEnvironment(const QString& _directory);
+
+    int getNumMeshes() const;
+    int getNumMaterials() const;
+    int getNumInstances() const;
+    int getNumLights() const;
+    int getNumProbes() const;
+    int getNumTextures() const;
+    const SceneMesh* getMeshes() const;
+    const Material* getMaterials() const;
+    const SceneInstance* getInstances() const;
+    const Light* getLights() const;
+    const SceneProbe* getProbes() const;
+    QString getMeshFile(int _mesh) const;
+    QString getTextureFile(int _texture) const;
+    QString getEnvironment() const;
+    QString getString(quint32 _offset) const;
+
+    static QMatrix4x4 getMatrix(const float* _data);
+    static const char* getBuiltinObjectName(SceneBuiltinObject _object);
+    static int findBuiltinObject(const QString& _name);
+
+private:
+    quint32 addString(const QString& _str);
+    void detach();
+    void updatePointers();
+    bool validate();
+    static int getRecordSize(SceneSection _section);
+
+    // either the storage or the mapped file
+    QVector<SceneMesh> meshStorage;
+    QVector<Material> materialStorage;
+    QVector<SceneInstance> instanceStorage;
+    QVector<Light> lightStorage;
+    QVector<SceneProbe> probeStorage;
+    QVector<quint32> textureStorage;
+    QByteArray stringStorage;
+
+    QFile* mappedFile;
+    uchar* mappedData;
+
+    quint32 counts[NUM_SCENE_SECTIONS];
+    const uchar* sections[NUM_SCENE_SECTIONS];
+    quint32 environment;
+};
+
+#endif // SCENEDESCRIPTION_H
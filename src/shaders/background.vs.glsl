@@ -9,6 +9,10 @@ layout(std140) uniform Matrices
 {
     mat4 modelMatrix;
     mat4 normalMatrix;
+};
+
+layout(std140) uniform Camera
+{
     mat4 viewProjectionMatrix;
 };
 
@@ -0,0 +1,72 @@
+#version 430 core
+//------------------------------------------------------------------------------------------
+// compute shader, frustum culling of the instances into indirect draw commands
+//------------------------------------------------------------------------------------------
+
+layout(local_size_x = 64) in;          // GPU_CULLING_GROUP_SIZE
+
+//------------------------------------------------------------------------------------------
+// buffers
+struct DrawElementsIndirectCommand
+{
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout(std430, binding = 0) readonly buffer InstanceSlots
+{
+    uvec2 instanceSlots[];              // draw, record
+};
+
+layout(std430, binding = 1) readonly buffer InstanceBounds
+{
+    vec4 instanceBounds[];              // world min, world max
+};
+
+layout(std430, binding = 2) buffer Commands
+{
+    DrawElementsIndirectCommand commands[];
+};
+
+layout(std430, binding = 3) writeonly buffer VisibleInstances
+{
+    uint visibleInstances[];
+};
+
+//------------------------------------------------------------------------------------------
+// uniforms
+uniform vec4 frustumPlanes[6];
+uniform int numInstances;
+
+//------------------------------------------------------------------------------------------
+void main()
+{
+    int instance = int(gl_GlobalInvocationID.x);
+
+    if(instance >= numInstances)
+    {
+        return;
+    }
+
+    vec3 boxMin = instanceBounds[2 * instance].xyz;
+    vec3 boxMax = instanceBounds[2 * instance + 1].xyz;
+
+    for(int i = 0; i < 6; ++i)
+    {
+        // the corner the farthest along the plane normal
+        vec4 plane = frustumPlanes[i];
+        vec3 positive = mix(boxMin, boxMax, greaterThanEqual(plane.xyz, vec3(0.0)));
+
+        if(dot(plane.xyz, positive) + plane.w < 0.0)
+        {
+            return;
+        }
+    }
+
+    uvec2 slot = instanceSlots[instance];
+    uint index = atomicAdd(commands[slot.x].instanceCount, 1u);
+    visibleInstances[commands[slot.x].baseInstance + index] = slot.y;
+}
@@ -0,0 +1,76 @@
+#version 410 core
+//------------------------------------------------------------------------------------------
+// vertex shader, phong shading of the instanced scene objects
+//------------------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------------------
+// uniforms
+layout(std140) uniform Camera
+{
+    mat4 viewProjectionMatrix;
+};
+
+layout(std140) uniform Light
+{
+    vec4 position;
+    vec4 color;
+    float intensity;
+} light;
+
+uniform vec3 cameraPosition;
+uniform int materialIndex;          // of the first scene material
+uniform int maxMaterialIndex;       // of the last material uploaded
+uniform samplerBuffer instanceData;     // the SceneInstance records, 9 texels each
+uniform usamplerBuffer instanceIndices; // the same records, read as integers
+
+//------------------------------------------------------------------------------------------
+// in variables
+in vec3 v_coord;
+in vec3 v_color;
+in vec3 v_normal;
+in vec2 v_texcoord;
+in uint i_instance;                 // per instance: the index of its record
+
+//------------------------------------------------------------------------------------------
+// out variables
+out VS_OUT
+{
+    vec3 f_color;
+    vec3 f_normal;
+    vec3 f_lightDir;
+    vec3 f_viewDir;
+    vec2 f_texcoord;
+    flat int f_materialIndex;
+};
+
+//------------------------------------------------------------------------------------------
+const int recordSize = 9;
+
+//------------------------------------------------------------------------------------------
+void main()
+{
+    int record = int(i_instance) * recordSize;
+    mat4 instanceModelMatrix = mat4(texelFetch(instanceData, record),
+                                    texelFetch(instanceData, record + 1),
+                                    texelFetch(instanceData, record + 2),
+                                    texelFetch(instanceData, record + 3));
+    mat3 instanceNormalMatrix = mat3(texelFetch(instanceData, record + 4).xyz,
+                                     texelFetch(instanceData, record + 5).xyz,
+                                     texelFetch(instanceData, record + 6).xyz);
+    // mesh, material, texture, name
+    uint material = texelFetch(instanceIndices, record + 8).y;
+
+    vec4 worldCoord = instanceModelMatrix * vec4(v_coord, 1.0);
+
+    /////////////////////////////////////////////////////////////////
+    // output
+    f_color = v_color;
+    f_normal = instanceNormalMatrix * v_normal;
+    f_lightDir = vec3(light.position) - vec3(worldCoord);
+    f_viewDir = vec3(cameraPosition) - vec3(worldCoord);
+    f_texcoord = v_texcoord;
+    f_materialIndex = min(materialIndex + int(material), maxMaterialIndex);
+
+
+    gl_Position = viewProjectionMatrix * worldCoord;
+}
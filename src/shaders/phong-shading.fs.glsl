@@ -12,13 +12,19 @@ layout(std140) uniform Light
     float intensity;
 } light;
 
-layout(std140) uniform Material
+struct Material
 {
     vec4 diffuseColor;
     vec4 specularColor;
     float reflection;
     float shininess;
-} material;
+};
+
+// the materials of all the objects, MAX_MATERIALS in renderer.h
+layout(std140) uniform Materials
+{
+    Material materials[256];
+};
 
 uniform samplerCube envTex;
 uniform sampler2D objTex;
@@ -33,6 +39,7 @@ in VS_OUT
     vec3 f_lightDir;
     vec3 f_viewDir;
     vec2 f_texcoord;
+    flat int f_materialIndex;
 };
 
 //----------------------------------------------------------`--------------------------------
@@ -49,6 +56,7 @@ const vec3 ambientLight = vec3(0.2);
 //------------------------------------------------------------------------------------------
 void main()
 {
+    Material material = materials[f_materialIndex];
     vec3 normal = normalize(f_normal);
     vec3 lightDir = normalize(f_lightDir);
     vec3 viewDir = normalize(f_viewDir);
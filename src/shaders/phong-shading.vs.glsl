@@ -9,6 +9,10 @@ layout(std140) uniform Matrices
 {
     mat4 modelMatrix;
     mat4 normalMatrix;
+};
+
+layout(std140) uniform Camera
+{
     mat4 viewProjectionMatrix;
 };
 
@@ -20,6 +24,7 @@ layout(std140) uniform Light
 } light;
 
 uniform vec3 cameraPosition;
+uniform int materialIndex;
 
 //------------------------------------------------------------------------------------------
 // in variables
@@ -37,6 +42,7 @@ out VS_OUT
     vec3 f_lightDir;
     vec3 f_viewDir;
     vec2 f_texcoord;
+    flat int f_materialIndex;
 };
 
 //------------------------------------------------------------------------------------------
@@ -51,6 +57,7 @@ void main()
     f_lightDir = vec3(light.position) - vec3(worldCoord);
     f_viewDir = vec3(cameraPosition) - vec3(worldCoord);
     f_texcoord = v_texcoord;
+    f_materialIndex = materialIndex;
 
 
     gl_Position = viewProjectionMatrix * worldCoord;
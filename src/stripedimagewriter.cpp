@@ -0,0 +1,229 @@
+//------------------------------------------------------------------------------------------
+// stripedimagewriter.cpp
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#include "stripedimagewriter.h"
+
+//------------------------------------------------------------------------------------------
+// TIFF tags and field types used by the baseline RGB image
+//------------------------------------------------------------------------------------------
+enum TIFFTag
+{
+    TIFF_IMAGE_WIDTH = 256,
+    TIFF_IMAGE_LENGTH = 257,
+    TIFF_BITS_PER_SAMPLE = 258,
+    TIFF_COMPRESSION = 259,
+    TIFF_PHOTOMETRIC_INTERPRETATION = 262,
+    TIFF_STRIP_OFFSETS = 273,
+    TIFF_SAMPLES_PER_PIXEL = 277,
+    TIFF_ROWS_PER_STRIP = 278,
+    TIFF_STRIP_BYTE_COUNTS = 279,
+    TIFF_X_RESOLUTION = 282,
+    TIFF_Y_RESOLUTION = 283,
+    TIFF_PLANAR_CONFIGURATION = 284,
+    TIFF_RESOLUTION_UNIT = 296
+};
+
+enum TIFFType
+{
+    TIFF_SHORT = 3,
+    TIFF_LONG = 4,
+    TIFF_RATIONAL = 5
+};
+
+#define TIFF_NUM_TAGS 13
+
+//------------------------------------------------------------------------------------------
+StripedImageWriter::StripedImageWriter():
+    isTIFF(true),
+    width(0),
+    height(0),
+    rowsPerStrip(0),
+    numWrittenRows(0)
+{
+}
+
+//------------------------------------------------------------------------------------------
+StripedImageWriter::~StripedImageWriter()
+{
+    if(file.isOpen())
+    {
+        close();
+    }
+}
+
+//------------------------------------------------------------------------------------------
+bool StripedImageWriter::open(const QString& _fileName, int _width, int _height,
+                              int _rowsPerStrip)
+{
+    width = _width;
+    height = _height;
+    rowsPerStrip = qMin(_rowsPerStrip, _height);
+    numWrittenRows = 0;
+
+    QString suffix = QFileInfo(_fileName).suffix().toLower();
+
+    if(suffix == "ppm")
+    {
+        isTIFF = false;
+    }
+    else if(suffix == "tif" || suffix == "tiff")
+    {
+        isTIFF = true;
+    }
+    else
+    {
+        qDebug() << "StripedImageWriter: unsupported file type, use .tif or .ppm:"
+                 << _fileName;
+        return false;
+    }
+
+    // classic TIFF uses 32 bit offsets
+    if(isTIFF && (qint64)width * (qint64)height * 3 > (qint64)0xFFFF0000)
+    {
+        qDebug() << "StripedImageWriter: image too large for a TIFF file, use .ppm.";
+        return false;
+    }
+
+    file.setFileName(_fileName);
+
+    if(!file.open(QIODevice::WriteOnly))
+    {
+        qDebug() << "StripedImageWriter: cannot open file for writing:" << _fileName;
+        return false;
+    }
+
+    if(isTIFF)
+    {
+        return writeTIFFHeader();
+    }
+
+    file.write(QString("P6\n%1 %2\n255\n").arg(width).arg(height).toLatin1());
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+// Layout: header, IFD, out-of-line tag values, then the strips in order
+//------------------------------------------------------------------------------------------
+bool StripedImageWriter::writeTIFFHeader()
+{
+    int numStrips = (height + rowsPerStrip - 1) / rowsPerStrip;
+    quint32 stripSize = (quint32)width * (quint32)rowsPerStrip * 3;
+
+    quint32 ifdOffset = 8;
+    quint32 bitsPerSampleOffset = ifdOffset + 2 + TIFF_NUM_TAGS * 12 + 4;
+    quint32 xResolutionOffset = bitsPerSampleOffset + 8;
+    quint32 yResolutionOffset = xResolutionOffset + 8;
+    quint32 stripOffsetsOffset = yResolutionOffset + 8;
+    quint32 stripByteCountsOffset = stripOffsetsOffset + 4 * numStrips;
+    quint32 imageOffset = stripByteCountsOffset + 4 * numStrips;
+
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+
+    // header
+    stream << (quint8)'I' << (quint8)'I' << (quint16)42 << ifdOffset;
+
+    // IFD: the entries must be sorted by tag
+    // a value fitting in 4 bytes is stored in the entry, left-justified
+    stream << (quint16)TIFF_NUM_TAGS;
+    stream << (quint16)TIFF_IMAGE_WIDTH << (quint16)TIFF_LONG << (quint32)1
+           << (quint32)width;
+    stream << (quint16)TIFF_IMAGE_LENGTH << (quint16)TIFF_LONG << (quint32)1
+           << (quint32)height;
+    stream << (quint16)TIFF_BITS_PER_SAMPLE << (quint16)TIFF_SHORT << (quint32)3
+           << bitsPerSampleOffset;
+    stream << (quint16)TIFF_COMPRESSION << (quint16)TIFF_SHORT << (quint32)1
+           << (quint16)1 << (quint16)0;
+    stream << (quint16)TIFF_PHOTOMETRIC_INTERPRETATION << (quint16)TIFF_SHORT << (quint32)1
+           << (quint16)2 << (quint16)0;
+    stream << (quint16)TIFF_STRIP_OFFSETS << (quint16)TIFF_LONG << (quint32)numStrips
+           << ((numStrips == 1) ? imageOffset : stripOffsetsOffset);
+    stream << (quint16)TIFF_SAMPLES_PER_PIXEL << (quint16)TIFF_SHORT << (quint32)1
+           << (quint16)3 << (quint16)0;
+    stream << (quint16)TIFF_ROWS_PER_STRIP << (quint16)TIFF_LONG << (quint32)1
+           << (quint32)rowsPerStrip;
+    stream << (quint16)TIFF_STRIP_BYTE_COUNTS << (quint16)TIFF_LONG << (quint32)numStrips
+           << ((numStrips == 1) ? (quint32)width * (quint32)height * 3 :
+               stripByteCountsOffset);
+    stream << (quint16)TIFF_X_RESOLUTION << (quint16)TIFF_RATIONAL << (quint32)1
+           << xResolutionOffset;
+    stream << (quint16)TIFF_Y_RESOLUTION << (quint16)TIFF_RATIONAL << (quint32)1
+           << yResolutionOffset;
+    stream << (quint16)TIFF_PLANAR_CONFIGURATION << (quint16)TIFF_SHORT << (quint32)1
+           << (quint16)1 << (quint16)0;
+    stream << (quint16)TIFF_RESOLUTION_UNIT << (quint16)TIFF_SHORT << (quint32)1
+           << (quint16)2 << (quint16)0;
+    stream << (quint32)0; // no next IFD
+
+    // out-of-line values
+    stream << (quint16)8 << (quint16)8 << (quint16)8 << (quint16)0;
+    stream << (quint32)72 << (quint32)1;
+    stream << (quint32)72 << (quint32)1;
+
+    for(int i = 0; i < numStrips; ++i)
+    {
+        stream << (quint32)(imageOffset + i * stripSize);
+    }
+
+    for(int i = 0; i < numStrips; ++i)
+    {
+        int numRows = qMin(rowsPerStrip, height - i * rowsPerStrip);
+        stream << (quint32)width * (quint32)numRows * 3;
+    }
+
+    return (stream.status() == QDataStream::Ok && file.pos() == imageOffset);
+}
+
+//------------------------------------------------------------------------------------------
+// _rgbRows: the next rows of the image, top-down, 3 bytes per pixel
+// every strip but the last one must have _rowsPerStrip rows
+//------------------------------------------------------------------------------------------
+bool StripedImageWriter::writeStrip(const QByteArray& _rgbRows)
+{
+    int numRows = _rgbRows.size() / (width * 3);
+
+    if(numRows * width * 3 != _rgbRows.size() || numWrittenRows + numRows > height ||
+       (numRows != rowsPerStrip && numWrittenRows + numRows != height))
+    {
+        qDebug() << "StripedImageWriter: invalid strip size.";
+        return false;
+    }
+
+    if(file.write(_rgbRows) != _rgbRows.size())
+    {
+        qDebug() << "StripedImageWriter: cannot write to" << file.fileName();
+        return false;
+    }
+
+    numWrittenRows += numRows;
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+bool StripedImageWriter::close()
+{
+    bool complete = (numWrittenRows == height);
+
+    if(!complete)
+    {
+        qDebug() << "StripedImageWriter: only" << numWrittenRows << "of" << height
+                 << "rows written to" << file.fileName();
+    }
+
+    file.close();
+
+    return complete;
+}
+
+//------------------------------------------------------------------------------------------
+int StripedImageWriter::getNumWrittenRows() const
+{
+    return numWrittenRows;
+}
@@ -0,0 +1,44 @@
+//------------------------------------------------------------------------------------------
+// stripedimagewriter.h
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#ifndef STRIPEDIMAGEWRITER_H
+#define STRIPEDIMAGEWRITER_H
+
+#include <QtGui>
+
+//------------------------------------------------------------------------------------------
+// Write a large RGB image strip by strip (top to bottom), without holding the whole image
+// in memory.
+// .tif/.tiff: uncompressed baseline TIFF, one strip per call of writeStrip() (the strip
+// offsets are known in advance, so the header is written first)
+// .ppm: binary PPM
+//------------------------------------------------------------------------------------------
+class StripedImageWriter
+{
+public:
+    StripedImageWriter();
+    ~StripedImageWriter();
+
+    bool open(const QString& _fileName, int _width, int _height, int _rowsPerStrip);
+    bool writeStrip(const QByteArray& _rgbRows);
+    bool close();
+
+    int getNumWrittenRows() const;
+
+private:
+    bool writeTIFFHeader();
+
+    QFile file;
+    bool isTIFF;
+    int width;
+    int height;
+    int rowsPerStrip;
+    int numWrittenRows;
+};
+
+#endif // STRIPEDIMAGEWRITER_H
@@ -0,0 +1,149 @@
+//------------------------------------------------------------------------------------------
+// tiledrenderer.cpp
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#include "tiledrenderer.h"
+
+//------------------------------------------------------------------------------------------
+TiledRenderer::TiledRenderer():
+    imageWidth(DEFAULT_TILE_SIZE),
+    imageHeight(DEFAULT_TILE_SIZE),
+    tileSize(DEFAULT_TILE_SIZE),
+    cameraPosition(DEFAULT_CAMERA_POSITION),
+    cameraFocus(DEFAULT_CAMERA_FOCUS),
+    enabledDynamicEnvMapping(true)
+{
+}
+
+//------------------------------------------------------------------------------------------
+void TiledRenderer::setImageSize(int _width, int _height)
+{
+    imageWidth = _width;
+    imageHeight = _height;
+}
+
+//------------------------------------------------------------------------------------------
+void TiledRenderer::setTileSize(int _tileSize)
+{
+    tileSize = _tileSize;
+}
+
+//------------------------------------------------------------------------------------------
+void TiledRenderer::setCamera(const QVector3D& _position, const QVector3D& _focus)
+{
+    cameraPosition = _position;
+    cameraFocus = _focus;
+}
+
+//------------------------------------------------------------------------------------------
+void TiledRenderer::enableDynamicEnvironmentMapping(bool _state)
+{
+    enabledDynamicEnvMapping = _state;
+}
+
+//------------------------------------------------------------------------------------------
+bool TiledRenderer::render(const QString& _fileName)
+{
+    PROFILE_ZONE("TiledRenderer::render");
+
+    OffscreenContext offscreenContext;
+
+    if(!offscreenContext.create())
+    {
+        PRINT_ERROR("Cannot create the offscreen OpenGL context.");
+        return false;
+    }
+
+    GLint maxSize;
+    offscreenContext.getContext()->functions()->glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE,
+                                                              &maxSize);
+
+    if(tileSize > maxSize)
+    {
+        qDebug() << "TiledRenderer: tile size reduced to the maximum renderbuffer size"
+                 << maxSize;
+        tileSize = maxSize;
+    }
+
+    StripedImageWriter writer;
+
+    if(!writer.open(_fileName, imageWidth, imageHeight, tileSize))
+    {
+        return false;
+    }
+
+    Renderer renderer;
+    renderer.initializeHeadless(offscreenContext.getContext(), offscreenContext.getSurface(),
+                                tileSize, tileSize);
+    renderer.enableDynamicEnvironmentMapping(enabledDynamicEnvMapping);
+    // the cube maps are kept for all the tiles, not only for the first one
+    renderer.enableProbeFaceSkipping(false);
+    renderer.setCamera(cameraPosition, cameraFocus, QVector3D(0.0f, 1.0f, 0.0f));
+
+    // the reflections of reflections need a few frames to settle, then the cube maps are
+    // kept for all the tiles
+    int numProbeFrames = enabledDynamicEnvMapping ? NUM_REFLECTIVE_OBJECTS + 1 : 1;
+    renderer.setTileProjection(0, 0, tileSize, tileSize, imageWidth, imageHeight);
+
+    for(int i = 0; i < numProbeFrames; ++i)
+    {
+        renderer.renderHeadlessFrame();
+    }
+
+    renderer.freezeProbeUpdates(true);
+
+    int numTilesX = (imageWidth + tileSize - 1) / tileSize;
+    int numTilesY = (imageHeight + tileSize - 1) / tileSize;
+    QElapsedTimer renderTimer;
+    renderTimer.start();
+
+    QByteArray strip;
+
+    for(int tileY = 0; tileY < numTilesY; ++tileY)
+    {
+        int stripHeight = qMin(tileSize, imageHeight - tileY * tileSize);
+        strip.resize(imageWidth * stripHeight * 3);
+
+        for(int tileX = 0; tileX < numTilesX; ++tileX)
+        {
+            // the tiles at the right and bottom borders extend past the image, their
+            // frustum is extended accordingly and the extra pixels are dropped
+            renderer.setTileProjection(tileX * tileSize, tileY * tileSize, tileSize, tileSize,
+                                       imageWidth, imageHeight);
+            renderer.renderHeadlessFrame();
+            copyTile(renderer.grabHeadlessFrame(), tileX, strip, stripHeight);
+        }
+
+        if(!writer.writeStrip(strip))
+        {
+            return false;
+        }
+
+        qDebug() << "TiledRenderer: tile row" << tileY + 1 << "/" << numTilesY;
+    }
+
+    qDebug() << "TiledRenderer:" << imageWidth << "x" << imageHeight << "image,"
+             << numTilesX * numTilesY << "tiles rendered in"
+             << (double)renderTimer.elapsed() * 1e-3 << "s, saved to" << _fileName;
+
+    return writer.close();
+}
+
+//------------------------------------------------------------------------------------------
+void TiledRenderer::copyTile(const QImage& _tile, int _tileX, QByteArray& _strip,
+                             int _stripHeight)
+{
+    QImage tile = _tile.convertToFormat(QImage::Format_RGB888);
+    int x0 = _tileX * tileSize;
+    int numBytes = qMin(tileSize, imageWidth - x0) * 3;
+
+    for(int y = 0; y < _stripHeight; ++y)
+    {
+        memcpy(_strip.data() + ((qint64)y * imageWidth + x0) * 3, tile.constScanLine(y),
+               numBytes);
+    }
+}
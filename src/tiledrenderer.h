@@ -0,0 +1,52 @@
+//------------------------------------------------------------------------------------------
+// tiledrenderer.h
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#ifndef TILEDRENDERER_H
+#define TILEDRENDERER_H
+
+#include <QtGui>
+
+#include "renderer.h"
+#include "offscreencontext.h"
+#include "stripedimagewriter.h"
+
+//------------------------------------------------------------------------------------------
+#define DEFAULT_TILE_SIZE 1024
+
+//------------------------------------------------------------------------------------------
+// Render an image of any size offscreen, tile by tile.
+// Each tile is rendered with an off-axis sub-frustum of the camera frustum of the whole
+// image. The dynamic cube maps are generated once, before the first tile, then reused by
+// all the tiles so that the reflections are seamless.
+// A row of tiles is assembled into one strip and streamed to the output file: only one
+// strip is held in memory.
+//------------------------------------------------------------------------------------------
+class TiledRenderer
+{
+public:
+    TiledRenderer();
+
+    void setImageSize(int _width, int _height);
+    void setTileSize(int _tileSize);
+    void setCamera(const QVector3D& _position, const QVector3D& _focus);
+    void enableDynamicEnvironmentMapping(bool _state);
+
+    bool render(const QString& _fileName);
+
+private:
+    void copyTile(const QImage& _tile, int _tileX, QByteArray& _strip, int _stripHeight);
+
+    int imageWidth;
+    int imageHeight;
+    int tileSize;
+    QVector3D cameraPosition;
+    QVector3D cameraFocus;
+    bool enabledDynamicEnvMapping;
+};
+
+#endif // TILEDRENDERER_H
@@ -0,0 +1,322 @@
+//------------------------------------------------------------------------------------------
+// transformstore.cpp
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#include "transformstore.h"
+#include "float4.h"
+#include "cpuprofiler.h"
+
+//------------------------------------------------------------------------------------------
+static const GLfloat identityMatrix[16] =
+{
+    1.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 1.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 1.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 1.0f
+};
+
+//------------------------------------------------------------------------------------------
+TransformStore::TransformStore():
+    dirty(false)
+{
+}
+
+//------------------------------------------------------------------------------------------
+void TransformStore::clear()
+{
+    for(int c = 0; c < 16; ++c)
+    {
+        localComponents[c].clear();
+    }
+
+    parents.clear();
+    levels.clear();
+    dirtyFlags.clear();
+    updatedFlags.clear();
+    matrices.clear();
+    positionX.clear();
+    positionY.clear();
+    positionZ.clear();
+    dirty = false;
+}
+
+//------------------------------------------------------------------------------------------
+// the parent must already exist, the new node has the identity transform
+//------------------------------------------------------------------------------------------
+int TransformStore::addNode(int _parent)
+{
+    int node = parents.size();
+    int depth = 0;
+
+    if(_parent != TRANSFORM_NO_PARENT)
+    {
+        Q_ASSERT(_parent >= 0 && _parent < node);
+
+        while(levels[depth].indexOf(_parent) < 0)
+        {
+            ++depth;
+        }
+
+        ++depth;
+    }
+
+    if(depth == levels.size())
+    {
+        levels.append(QVector<int>());
+    }
+
+    levels[depth].append(node);
+    parents.append(_parent);
+
+    for(int c = 0; c < 16; ++c)
+    {
+        localComponents[c].append(identityMatrix[c]);
+    }
+
+    TransformMatrices nodeMatrices;
+    memcpy(nodeMatrices.modelMatrix, identityMatrix, sizeof(identityMatrix));
+    memcpy(nodeMatrices.normalMatrix, identityMatrix, sizeof(identityMatrix));
+    matrices.append(nodeMatrices);
+    positionX.append(0.0f);
+    positionY.append(0.0f);
+    positionZ.append(0.0f);
+    dirtyFlags.append(1);
+    updatedFlags.append(0);
+    dirty = true;
+
+    return node;
+}
+
+//------------------------------------------------------------------------------------------
+int TransformStore::getNumNodes() const
+{
+    return parents.size();
+}
+
+//------------------------------------------------------------------------------------------
+void TransformStore::setLocalMatrix(int _node, const QMatrix4x4& _matrix)
+{
+    const float* data = _matrix.constData();
+
+    for(int c = 0; c < 16; ++c)
+    {
+        localComponents[c][_node] = data[c];
+    }
+
+    markDirty(_node);
+}
+
+//------------------------------------------------------------------------------------------
+// local = _transformation * local
+//------------------------------------------------------------------------------------------
+void TransformStore::applyTransformation(int _node, const QMatrix4x4& _transformation)
+{
+    setLocalMatrix(_node, _transformation * getLocalMatrix(_node));
+}
+
+//------------------------------------------------------------------------------------------
+QMatrix4x4 TransformStore::getLocalMatrix(int _node) const
+{
+    QMatrix4x4 matrix;
+    float* data = matrix.data();
+
+    for(int c = 0; c < 16; ++c)
+    {
+        data[c] = localComponents[c][_node];
+    }
+
+    return matrix;
+}
+
+//------------------------------------------------------------------------------------------
+// returns the number of updated nodes
+//------------------------------------------------------------------------------------------
+int TransformStore::update()
+{
+    if(!dirty)
+    {
+        return 0;
+    }
+
+    PROFILE_ZONE("TransformStore::update");
+
+    int numUpdated = 0;
+
+    for(int depth = 0; depth < levels.size(); ++depth)
+    {
+        const QVector<int>& level = levels[depth];
+        batchNodes.clear();
+
+        for(int i = 0; i < level.size(); ++i)
+        {
+            int node = level[i];
+            int parent = parents[node];
+
+            if(dirtyFlags[node] || (parent != TRANSFORM_NO_PARENT && updatedFlags[parent]))
+            {
+                batchNodes.append(node);
+                updatedFlags[node] = 1;
+            }
+        }
+
+        for(int i = 0; i < batchNodes.size(); i += 4)
+        {
+            updateBatch(batchNodes.constData() + i, qMin(4, batchNodes.size() - i));
+        }
+
+        numUpdated += batchNodes.size();
+    }
+
+    dirtyFlags.fill(0);
+    updatedFlags.fill(0);
+    dirty = false;
+
+    return numUpdated;
+}
+
+//------------------------------------------------------------------------------------------
+QMatrix4x4 TransformStore::getModelMatrix(int _node) const
+{
+    QMatrix4x4 matrix;
+    memcpy(matrix.data(), matrices[_node].modelMatrix, sizeof(matrices[_node].modelMatrix));
+
+    return matrix;
+}
+
+//------------------------------------------------------------------------------------------
+QVector3D TransformStore::getWorldPosition(int _node) const
+{
+    return QVector3D(positionX[_node], positionY[_node], positionZ[_node]);
+}
+
+//------------------------------------------------------------------------------------------
+const TransformMatrices& TransformStore::getMatrices(int _node) const
+{
+    return matrices[_node];
+}
+
+//------------------------------------------------------------------------------------------
+void TransformStore::markDirty(int _node)
+{
+    dirtyFlags[_node] = 1;
+    dirty = true;
+}
+
+//------------------------------------------------------------------------------------------
+// One node per lane: the components are gathered from the arrays, the unused lanes repeat
+// the last node. The normal matrix is the cofactor matrix of the 3x3 part divided by its
+// determinant (identity for a singular matrix, |determinant| <= 1e-12 as
+// QMatrix4x4::normalMatrix).
+//------------------------------------------------------------------------------------------
+void TransformStore::updateBatch(const int* _nodes, int _numNodes)
+{
+    int nodes[4];
+    const GLfloat* parentMatrices[4];
+
+    for(int lane = 0; lane < 4; ++lane)
+    {
+        nodes[lane] = _nodes[qMin(lane, _numNodes - 1)];
+        int parentNode = parents[nodes[lane]];
+        parentMatrices[lane] = (parentNode != TRANSFORM_NO_PARENT) ?
+                               matrices[parentNode].modelMatrix : identityMatrix;
+    }
+
+    Float4 local[16];
+    Float4 parent[16];
+
+    for(int c = 0; c < 16; ++c)
+    {
+        const float* component = localComponents[c].constData();
+        local[c] = Float4(component[nodes[0]], component[nodes[1]], component[nodes[2]],
+                          component[nodes[3]]);
+        parent[c] = Float4(parentMatrices[0][c], parentMatrices[1][c],
+                           parentMatrices[2][c], parentMatrices[3][c]);
+    }
+
+    /////////////////////////////////////////////////////////////////
+    // world = parent * local, column major: world[col * 4 + row]
+    Float4 world[16];
+
+    for(int col = 0; col < 4; ++col)
+    {
+        for(int row = 0; row < 4; ++row)
+        {
+            world[col * 4 + row] = parent[row] * local[col * 4] +
+                                   parent[4 + row] * local[col * 4 + 1] +
+                                   parent[8 + row] * local[col * 4 + 2] +
+                                   parent[12 + row] * local[col * 4 + 3];
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////
+    // normal matrix, m(r, c) = world[c * 4 + r]
+    const Float4& m00 = world[0];
+    const Float4& m10 = world[1];
+    const Float4& m20 = world[2];
+    const Float4& m01 = world[4];
+    const Float4& m11 = world[5];
+    const Float4& m21 = world[6];
+    const Float4& m02 = world[8];
+    const Float4& m12 = world[9];
+    const Float4& m22 = world[10];
+
+    Float4 cofactors[9] =
+    {
+        m11 * m22 - m12 * m21, m12 * m20 - m10 * m22, m10 * m21 - m11 * m20,
+        m02 * m21 - m01 * m22, m00 * m22 - m02 * m20, m01 * m20 - m00 * m21,
+        m01 * m12 - m02 * m11, m02 * m10 - m00 * m12, m00 * m11 - m01 * m10
+    };
+    Float4 determinant = m00 * cofactors[0] + m01 * cofactors[1] + m02 * cofactors[2];
+    Float4 absDeterminant = max4(determinant, Float4(0.0f) - determinant);
+    Float4 invertible = lessThan(Float4(1e-12f), absDeterminant);
+    Float4 invDeterminant = Float4(1.0f) / select4(invertible, determinant, Float4(1.0f));
+
+    Float4 normal[16];
+
+    for(int c = 0; c < 16; ++c)
+    {
+        normal[c] = Float4(identityMatrix[c]);
+    }
+
+    for(int r = 0; r < 3; ++r)
+    {
+        for(int c = 0; c < 3; ++c)
+        {
+            normal[c * 4 + r] = select4(invertible, cofactors[r * 3 + c] * invDeterminant,
+                                        Float4(identityMatrix[c * 4 + r]));
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////
+    // scatter the lanes
+    float values[4];
+
+    for(int c = 0; c < 16; ++c)
+    {
+        world[c].store(values);
+
+        for(int lane = 0; lane < _numNodes; ++lane)
+        {
+            matrices[nodes[lane]].modelMatrix[c] = values[lane];
+        }
+
+        normal[c].store(values);
+
+        for(int lane = 0; lane < _numNodes; ++lane)
+        {
+            matrices[nodes[lane]].normalMatrix[c] = values[lane];
+        }
+    }
+
+    for(int lane = 0; lane < _numNodes; ++lane)
+    {
+        const GLfloat* modelMatrix = matrices[nodes[lane]].modelMatrix;
+        positionX[nodes[lane]] = modelMatrix[12];
+        positionY[nodes[lane]] = modelMatrix[13];
+        positionZ[nodes[lane]] = modelMatrix[14];
+    }
+}
@@ -0,0 +1,69 @@
+//------------------------------------------------------------------------------------------
+// transformstore.h
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#ifndef TRANSFORMSTORE_H
+#define TRANSFORMSTORE_H
+
+#include <QtGui>
+
+//------------------------------------------------------------------------------------------
+#define TRANSFORM_NO_PARENT -1
+
+// the model and normal matrices of a node, in the layout of the Matrices uniform block
+struct TransformMatrices
+{
+    GLfloat modelMatrix[16];
+    GLfloat normalMatrix[16];
+};
+
+//------------------------------------------------------------------------------------------
+// Structure-of-arrays store of the object transforms.
+// Each node has a local matrix (16 arrays, one per component) and an optional parent.
+// update() recomputes, for the dirty nodes and their descendants only, the world model
+// matrix (parent * local), the normal matrix (inverse transpose of the 3x3 part) and the
+// world position, 4 nodes at a time with SSE. The nodes are processed level by level, so
+// the parents are always up to date before their children.
+// The model and normal matrices of a node are contiguous and are uploaded as they are.
+//------------------------------------------------------------------------------------------
+class TransformStore
+{
+public:
+    TransformStore();
+
+    void clear();
+    int addNode(int _parent = TRANSFORM_NO_PARENT);
+    int getNumNodes() const;
+
+    void setLocalMatrix(int _node, const QMatrix4x4& _matrix);
+    void applyTransformation(int _node, const QMatrix4x4& _transformation);
+    QMatrix4x4 getLocalMatrix(int _node) const;
+    int update();
+
+    QMatrix4x4 getModelMatrix(int _node) const;
+    QVector3D getWorldPosition(int _node) const;
+    const TransformMatrices& getMatrices(int _node) const;
+
+private:
+    void markDirty(int _node);
+    void updateBatch(const int* _nodes, int _numNodes);
+
+    QVector<float> localComponents[16]; // column major, localComponents[c][node]
+    QVector<int> parents;
+    QVector<QVector<int> > levels;      // the nodes of each depth
+    QVector<uchar> dirtyFlags;
+    QVector<uchar> updatedFlags;
+    QVector<int> batchNodes;
+    bool dirty;
+
+    QVector<TransformMatrices> matrices;
+    QVector<float> positionX;
+    QVector<float> positionY;
+    QVector<float> positionZ;
+};
+
+#endif // TRANSFORMSTORE_H
@@ -0,0 +1,119 @@
+//------------------------------------------------------------------------------------------
+// uniformshadowbuffer.cpp
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#include "uniformshadowbuffer.h"
+#include "cpuprofiler.h"
+
+//------------------------------------------------------------------------------------------
+UniformShadowBuffer::UniformShadowBuffer():
+    glFuncs(NULL),
+    buffer(0),
+    slotStride(0),
+    firstDirtySlot(-1),
+    lastDirtySlot(-1)
+{
+}
+
+//------------------------------------------------------------------------------------------
+// the buffer storage is allocated once, all the slots start dirty (zero filled)
+//------------------------------------------------------------------------------------------
+void UniformShadowBuffer::initialize(QOpenGLFunctions_4_0_Core* _glFuncs, int _numSlots,
+                                     int _slotStride)
+{
+    destroy();
+
+    glFuncs = _glFuncs;
+    slotStride = _slotStride;
+    shadowData.fill('\0', _numSlots * _slotStride);
+    dirtySlots.fill(1, _numSlots);
+    firstDirtySlot = 0;
+    lastDirtySlot = _numSlots - 1;
+
+    glFuncs->glGenBuffers(1, &buffer);
+    glFuncs->glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glFuncs->glBufferData(GL_UNIFORM_BUFFER, shadowData.size(), NULL, GL_DYNAMIC_DRAW);
+    glFuncs->glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+//------------------------------------------------------------------------------------------
+void UniformShadowBuffer::destroy()
+{
+    if(buffer != 0)
+    {
+        glFuncs->glDeleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// writes before initialize() are dropped, the owner fills all the slots after it
+//------------------------------------------------------------------------------------------
+void UniformShadowBuffer::write(int _slot, const void* _data, int _size)
+{
+    if(_slot < 0 || _slot >= dirtySlots.size())
+    {
+        return;
+    }
+
+    Q_ASSERT(_size <= slotStride);
+    memcpy(shadowData.data() + _slot * slotStride, _data, _size);
+
+    if(dirtySlots[_slot])
+    {
+        return;
+    }
+
+    dirtySlots[_slot] = 1;
+    firstDirtySlot = (firstDirtySlot < 0) ? _slot : qMin(firstDirtySlot, _slot);
+    lastDirtySlot = qMax(lastDirtySlot, _slot);
+}
+
+//------------------------------------------------------------------------------------------
+bool UniformShadowBuffer::isDirty() const
+{
+    return (firstDirtySlot >= 0);
+}
+
+//------------------------------------------------------------------------------------------
+// upload the dirty slots (and the clean ones in between), returns the number of bytes
+//------------------------------------------------------------------------------------------
+int UniformShadowBuffer::flush()
+{
+    if(!isDirty() || buffer == 0)
+    {
+        return 0;
+    }
+
+    PROFILE_ZONE("UniformShadowBuffer::flush");
+
+    int offset = firstDirtySlot * slotStride;
+    int size = (lastDirtySlot - firstDirtySlot + 1) * slotStride;
+
+    glFuncs->glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glFuncs->glBufferSubData(GL_UNIFORM_BUFFER, offset, size,
+                             shadowData.constData() + offset);
+    glFuncs->glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    dirtySlots.fill(0);
+    firstDirtySlot = -1;
+    lastDirtySlot = -1;
+
+    return size;
+}
+
+//------------------------------------------------------------------------------------------
+GLuint UniformShadowBuffer::getBufferId() const
+{
+    return buffer;
+}
+
+//------------------------------------------------------------------------------------------
+int UniformShadowBuffer::getNumSlots() const
+{
+    return dirtySlots.size();
+}
@@ -0,0 +1,48 @@
+//------------------------------------------------------------------------------------------
+// uniformshadowbuffer.h
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#ifndef UNIFORMSHADOWBUFFER_H
+#define UNIFORMSHADOWBUFFER_H
+
+#include <QtGui>
+#include <QOpenGLFunctions_4_0_Core>
+
+//------------------------------------------------------------------------------------------
+// A uniform buffer made of fixed size slots, with a CPU shadow copy.
+// write() only updates the shadow copy and marks the slot dirty, so it can be called at
+// any time without the GL context (e.g. by the GUI slots, many times between two frames).
+// flush() uploads the range spanning the dirty slots with a single glBufferSubData; it is
+// called once per frame with the context current.
+//------------------------------------------------------------------------------------------
+class UniformShadowBuffer
+{
+public:
+    UniformShadowBuffer();
+
+    void initialize(QOpenGLFunctions_4_0_Core* _glFuncs, int _numSlots, int _slotStride);
+    void destroy();
+
+    void write(int _slot, const void* _data, int _size);
+    bool isDirty() const;
+    int flush();
+
+    GLuint getBufferId() const;
+    int getNumSlots() const;
+
+private:
+    QOpenGLFunctions_4_0_Core* glFuncs;
+    GLuint buffer;
+    int slotStride;
+
+    QByteArray shadowData;
+    QVector<uchar> dirtySlots;
+    int firstDirtySlot;
+    int lastDirtySlot;
+};
+
+#endif // UNIFORMSHADOWBUFFER_H
@@ -7,6 +7,7 @@
 //------------------------------------------------------------------------------------------
 
 #include "unitcube.h"
+#include "cpuprofiler.h"
 
 #include <QMatrix4x4>
 
@@ -33,6 +34,8 @@ UnitCube::UnitCube():
     normals(NULL),
     negNormals(NULL)
 {
+    PROFILE_ZONE("UnitCube::UnitCube");
+
     // Vertex data for face 0
     // v0
     vertexList.append(QVector3D(-1.0f, -1.0f,  1.0f));
@@ -8,6 +8,7 @@
 #include <QMatrix4x4>
 
 #include "unitplane.h"
+#include "cpuprofiler.h"
 
 GLushort UnitPlane::indices[] = {0,  1,  2,
                                  2, 3, 0
@@ -24,6 +25,8 @@ UnitPlane::UnitPlane():
     texCoord(NULL),
     normals(NULL)
 {
+    PROFILE_ZONE("UnitPlane::UnitPlane");
+
     // v0
     vertexList.append(QVector3D(-1.0f, 0.0f,  -1.0f));
     colorList.append(QVector3D(rand_float(), rand_float(), rand_float()));
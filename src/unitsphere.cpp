@@ -8,6 +8,7 @@
 #define _USE_MATH_DEFINES
 #include <cmath>
 #include "unitsphere.h"
+#include "cpuprofiler.h"
 
 #include <QMatrix4x4>
 #include <QVector2D>
@@ -28,6 +29,8 @@ UnitSphere::~UnitSphere()
 //------------------------------------------------------------------------------------------
 void UnitSphere::generateSphere(int _numStacks, int _numSlices)
 {
+    PROFILE_ZONE("UnitSphere::generateSphere");
+
     numStacks = _numStacks;
     numSlices = _numSlices;
 
@@ -0,0 +1,200 @@
+//------------------------------------------------------------------------------------------
+// workstealingpool.cpp
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#include "workstealingpool.h"
+
+//------------------------------------------------------------------------------------------
+WorkStealingPool::WorkStealingPool(int _numWorkers):
+    numWorkers(_numWorkers > 0 ? _numWorkers : qMax(1, QThread::idealThreadCount())),
+    batchIndex(0),
+    numBusyWorkers(0),
+    quitting(false),
+    taskFunction(NULL),
+    workerStatistics(NULL)
+{
+    for(int i = 0; i < numWorkers; ++i)
+    {
+        queues.append(new TaskQueue);
+    }
+
+    for(int i = 1; i < numWorkers; ++i)
+    {
+        workers.append(new Worker(this, i));
+        workers.last()->start();
+    }
+}
+
+//------------------------------------------------------------------------------------------
+WorkStealingPool::~WorkStealingPool()
+{
+    batchMutex.lock();
+    quitting = true;
+    batchStarted.wakeAll();
+    batchMutex.unlock();
+
+    for(int i = 0; i < workers.size(); ++i)
+    {
+        workers[i]->wait();
+    }
+
+    qDeleteAll(workers);
+    qDeleteAll(queues);
+}
+
+//------------------------------------------------------------------------------------------
+int WorkStealingPool::getNumWorkers() const
+{
+    return numWorkers;
+}
+
+//------------------------------------------------------------------------------------------
+// execute _function for the tasks [0, _numTasks), return when all of them are done
+//------------------------------------------------------------------------------------------
+void WorkStealingPool::run(int _numTasks, const TaskFunction& _function)
+{
+    taskFunction = &_function;
+    statistics.fill(WorkerStatistics(), numWorkers);
+    workerStatistics = statistics.data();
+
+    for(int i = 0; i < numWorkers; ++i)
+    {
+        queues[i]->head = (int)((qint64)_numTasks * i / numWorkers);
+        queues[i]->tail = (int)((qint64)_numTasks * (i + 1) / numWorkers);
+    }
+
+    // wake the workers, the queues are published by the mutex
+    batchMutex.lock();
+    numBusyWorkers = workers.size();
+    ++batchIndex;
+    batchStarted.wakeAll();
+    batchMutex.unlock();
+
+    workerLoop(0);
+
+    batchMutex.lock();
+
+    while(numBusyWorkers > 0)
+    {
+        batchFinished.wait(&batchMutex);
+    }
+
+    batchMutex.unlock();
+
+    taskFunction = NULL;
+    workerStatistics = NULL;
+}
+
+//------------------------------------------------------------------------------------------
+QVector<WorkStealingPool::WorkerStatistics> WorkStealingPool::getStatistics() const
+{
+    return statistics;
+}
+
+//------------------------------------------------------------------------------------------
+bool WorkStealingPool::popTask(int _worker, int& _task)
+{
+    TaskQueue* queue = queues[_worker];
+    QMutexLocker locker(&queue->mutex);
+
+    if(queue->head >= queue->tail)
+    {
+        return false;
+    }
+
+    _task = queue->head++;
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------
+// visit the other queues starting from the next worker, take the last task of the first
+// non-empty one
+//------------------------------------------------------------------------------------------
+bool WorkStealingPool::stealTask(int _worker, int& _task)
+{
+    for(int i = 1; i < numWorkers; ++i)
+    {
+        TaskQueue* queue = queues[(_worker + i) % numWorkers];
+        QMutexLocker locker(&queue->mutex);
+
+        if(queue->head < queue->tail)
+        {
+            _task = --queue->tail;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------------------
+// no task is added while running: the worker is done when nothing is left to steal
+//------------------------------------------------------------------------------------------
+void WorkStealingPool::workerLoop(int _worker)
+{
+    WorkerStatistics& stats = workerStatistics[_worker];
+    int task;
+
+    while(true)
+    {
+        if(popTask(_worker, task))
+        {
+            (*taskFunction)(task, _worker);
+        }
+        else if(stealTask(_worker, task))
+        {
+            (*taskFunction)(task, _worker);
+            ++stats.numStolenTasks;
+        }
+        else
+        {
+            break;
+        }
+
+        ++stats.numExecutedTasks;
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// run the tasks of each batch, sleep in between until the next one or the destruction of
+// the pool
+//------------------------------------------------------------------------------------------
+void WorkStealingPool::workerThread(int _worker)
+{
+    int lastBatch = 0;
+
+    while(true)
+    {
+        batchMutex.lock();
+
+        while(batchIndex == lastBatch && !quitting)
+        {
+            batchStarted.wait(&batchMutex);
+        }
+
+        lastBatch = batchIndex;
+        bool quit = quitting;
+        batchMutex.unlock();
+
+        if(quit)
+        {
+            return;
+        }
+
+        workerLoop(_worker);
+
+        batchMutex.lock();
+
+        if(--numBusyWorkers == 0)
+        {
+            batchFinished.wakeAll();
+        }
+
+        batchMutex.unlock();
+    }
+}
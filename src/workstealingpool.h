@@ -0,0 +1,91 @@
+//------------------------------------------------------------------------------------------
+// workstealingpool.h
+//
+// Created on: 10/18/2026
+//     Author: Nghia Truong
+//
+//------------------------------------------------------------------------------------------
+
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <functional>
+#include <QtCore>
+
+//------------------------------------------------------------------------------------------
+// Run a batch of independent tasks on all the cores.
+// The tasks are split into contiguous blocks, one per worker (neighboring tiles stay on the
+// same core). A worker takes its own tasks from the front of its queue; once its queue is
+// empty it steals from the back of the other queues, so the work stays balanced when some
+// tasks are much more expensive than others (e.g. tiles covering the reflective spheres).
+// The calling thread is worker 0, the other workers are started with the pool and sleep
+// between the batches.
+//------------------------------------------------------------------------------------------
+class WorkStealingPool
+{
+public:
+    typedef std::function<void(int _task, int _worker)> TaskFunction;
+
+    struct WorkerStatistics
+    {
+        WorkerStatistics(): numExecutedTasks(0), numStolenTasks(0) {}
+
+        int numExecutedTasks;
+        int numStolenTasks;
+    };
+
+    WorkStealingPool(int _numWorkers = 0);
+    ~WorkStealingPool();
+
+    int getNumWorkers() const;
+    void run(int _numTasks, const TaskFunction& _function);
+    QVector<WorkerStatistics> getStatistics() const;
+
+private:
+    struct TaskQueue
+    {
+        QMutex mutex;
+        int head;
+        int tail;
+    };
+
+    class Worker : public QThread
+    {
+    public:
+        Worker(WorkStealingPool* _pool, int _workerId):
+            pool(_pool), workerId(_workerId) {}
+
+    protected:
+        void run()
+        {
+            pool->workerThread(workerId);
+        }
+
+    private:
+        WorkStealingPool* pool;
+        int workerId;
+    };
+
+    bool popTask(int _worker, int& _task);
+    bool stealTask(int _worker, int& _task);
+    void workerLoop(int _worker);
+    void workerThread(int _worker);
+
+    int numWorkers;
+    QVector<TaskQueue*> queues;
+    QVector<Worker*> workers;
+
+    // a batch is started by incrementing batchIndex, finished when no worker is busy
+    QMutex batchMutex;
+    QWaitCondition batchStarted;
+    QWaitCondition batchFinished;
+    int batchIndex;
+    int numBusyWorkers;
+    bool quitting;
+
+    const TaskFunction* taskFunction;
+    QVector<WorkerStatistics> statistics;
+    WorkerStatistics* workerStatistics; // detached once before the workers start
+};
+
+#endif // WORKSTEALINGPOOL_H